@@ -0,0 +1,265 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "bqueue.h"
+#include "dequeue.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Number of items handed from the producers to the consumers in every run.
+ */
+#define ITEMS 2000000
+
+/**
+ * Capacity of the queues.
+ */
+#define CAPACITY 1024
+
+/**
+ * Most items a batching consumer takes per wakeup.
+ */
+#define BATCH 64
+
+/**
+ * @struct cvqueue
+ * @brief The usual blocking wrapper around a dequeue: one mutex, two
+ *        condition variables, and a signal for every item.
+ */
+typedef struct cvqueue_t {
+    dequeue_t ring;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    bool closed;
+} cvqueue_t;
+
+static void cvqueue_new(cvqueue_t * queue) {
+    dequeue_new_with_storage(&queue->ring, CAPACITY, sizeof(uint64_t),
+                             DEQUEUE_STORAGE_INLINE);
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    queue->closed = false;
+}
+
+static void cvqueue_push(cvqueue_t * queue, uint64_t value) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->ring.len == CAPACITY) {
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    dequeue_push_back(&queue->ring, &value);
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static bool cvqueue_pop(cvqueue_t * queue, uint64_t * value) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->ring.len == 0 && !queue->closed) {
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+    bool ok = DEQUEUE_ERROR_IS_OK(dequeue_pop_front_into(&queue->ring, value));
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return ok;
+}
+
+static void cvqueue_close(cvqueue_t * queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void cvqueue_free(cvqueue_t * queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    dequeue_free(&queue->ring);
+}
+
+/**
+ * The queues compared.
+ */
+typedef enum kind_t {
+    KIND_CVQUEUE,
+    KIND_BQUEUE,
+    KIND_BQUEUE_BATCH,
+} kind_t;
+
+static const char * kind_names[] = {
+    "mutex+condvar",
+    "bqueue pop",
+    "bqueue pop_batch",
+};
+
+typedef struct run_t {
+    kind_t kind;
+    cvqueue_t cvqueue;
+    bqueue_t bqueue;
+    size_t items_per_producer;
+} run_t;
+
+typedef struct consumer_result_t {
+    uint64_t sum;
+} consumer_result_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+typedef struct producer_arg_t {
+    run_t * run;
+    uint64_t first;
+} producer_arg_t;
+
+static void * producer(void * arg) {
+    producer_arg_t * producer = arg;
+    run_t * run = producer->run;
+    uint64_t last = producer->first + run->items_per_producer;
+    for (uint64_t i = producer->first; i < last; i++) {
+        if (run->kind == KIND_CVQUEUE) {
+            cvqueue_push(&run->cvqueue, i);
+        } else {
+            bqueue_push(&run->bqueue, &i, BQUEUE_WAIT_FOREVER);
+        }
+    }
+    return NULL;
+}
+
+static void * consumer(void * arg) {
+    run_t * run = arg;
+    uint64_t sum = 0;
+    uint64_t batch[BATCH];
+    size_t count;
+    switch (run->kind) {
+    case KIND_CVQUEUE:
+        while (cvqueue_pop(&run->cvqueue, &batch[0])) {
+            sum += batch[0];
+        }
+        break;
+    case KIND_BQUEUE:
+        while (BQUEUE_ERROR_IS_OK(bqueue_pop(&run->bqueue, &batch[0],
+                                             BQUEUE_WAIT_FOREVER))) {
+            sum += batch[0];
+        }
+        break;
+    case KIND_BQUEUE_BATCH:
+        while (BQUEUE_ERROR_IS_OK(bqueue_pop_batch(&run->bqueue, batch, BATCH,
+                                                   &count,
+                                                   BQUEUE_WAIT_FOREVER))) {
+            for (size_t i = 0; i < count; i++) {
+                sum += batch[i];
+            }
+        }
+        break;
+    }
+    consumer_result_t * result = malloc(sizeof(consumer_result_t));
+    result->sum = sum;
+    return result;
+}
+
+/**
+ * Hand ITEMS items from `producers` producers to `consumers` consumers and
+ * report the throughput.
+ */
+static void bench(kind_t kind, size_t producers, size_t consumers) {
+    run_t run;
+    run.kind = kind;
+    run.items_per_producer = ITEMS / producers;
+    if (kind == KIND_CVQUEUE) {
+        cvqueue_new(&run.cvqueue);
+    } else {
+        bqueue_new(&run.bqueue, CAPACITY, sizeof(uint64_t), NULL);
+    }
+    pthread_t * producer_threads = malloc(producers * sizeof(pthread_t));
+    pthread_t * consumer_threads = malloc(consumers * sizeof(pthread_t));
+    producer_arg_t * args = malloc(producers * sizeof(producer_arg_t));
+
+    double start = now_ns();
+    for (size_t i = 0; i < consumers; i++) {
+        pthread_create(&consumer_threads[i], NULL, consumer, &run);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        args[i].run = &run;
+        args[i].first = i * run.items_per_producer;
+        pthread_create(&producer_threads[i], NULL, producer, &args[i]);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+    }
+    if (kind == KIND_CVQUEUE) {
+        cvqueue_close(&run.cvqueue);
+    } else {
+        bqueue_close(&run.bqueue);
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < consumers; i++) {
+        consumer_result_t * result;
+        pthread_join(consumer_threads[i], (void **) &result);
+        sum += result->sum;
+        free(result);
+    }
+    double elapsed = now_ns() - start;
+
+    uint64_t total = run.items_per_producer * producers;
+    if (sum != total * (total - 1) / 2) {
+        fprintf(stderr, "%s: wrong checksum\n", kind_names[kind]);
+        exit(1);
+    }
+    printf("%3zu:%-3zu %-18s %10.2f\n",
+           producers, consumers, kind_names[kind], total / elapsed * 1e3);
+
+    free(producer_threads);
+    free(consumer_threads);
+    free(args);
+    if (kind == KIND_CVQUEUE) {
+        cvqueue_free(&run.cvqueue);
+    } else {
+        bqueue_free(&run.bqueue);
+    }
+}
+
+int main(int argc, char ** argv) {
+    size_t threads = argc > 1 ? (size_t) atol(argv[1]) : 4;
+    if (threads == 0) {
+        threads = 1;
+    }
+    printf("%-7s %-18s %10s\n", "P:C", "queue", "Mops/sec");
+    for (kind_t kind = KIND_CVQUEUE; kind <= KIND_BQUEUE_BATCH; kind++) {
+        bench(kind, 1, threads);
+    }
+    for (kind_t kind = KIND_CVQUEUE; kind <= KIND_BQUEUE_BATCH; kind++) {
+        bench(kind, threads, threads);
+    }
+    return 0;
+}
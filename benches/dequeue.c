@@ -0,0 +1,357 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dequeue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Number of push_back + pop_front pairs measured for each length.
+ */
+#define OPS 1000000
+
+/**
+ * Number of elements walked by the iterator benchmark.
+ */
+#define WALK_LEN 10000000
+
+/**
+ * Number of records pushed at once by the bulk ingest benchmark.
+ */
+#define BATCH 4096
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/**
+ * Measure the cost of using a dequeue of `len` elements as a FIFO queue.
+ */
+static double bench_fifo(size_t len) {
+    static int value = 0;
+    dequeue_t dequeue;
+    dequeue_new_with_capacity(&dequeue, len + 1, sizeof(int));
+    for (size_t i = 0; i < len; i++) {
+        dequeue_push_back(&dequeue, &value);
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < OPS; i++) {
+        dequeue_push_back(&dequeue, dequeue_pop_front(&dequeue));
+    }
+    double elapsed = now_ns() - start;
+    // the elements are not owned by the dequeue
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+    return elapsed / OPS;
+}
+
+/**
+ * Measure the cost of pushing and popping at the front of a dequeue of `len`
+ * elements.
+ */
+static double bench_front(size_t len) {
+    static int value = 0;
+    dequeue_t dequeue;
+    dequeue_new_with_capacity(&dequeue, len + 1, sizeof(int));
+    for (size_t i = 0; i < len; i++) {
+        dequeue_push_back(&dequeue, &value);
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < OPS; i++) {
+        dequeue_push_front(&dequeue, &value);
+        dequeue_pop_front(&dequeue);
+    }
+    double elapsed = now_ns() - start;
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+    return elapsed / OPS;
+}
+
+/**
+ * Measure the cost of filling an empty dequeue with `len` elements.
+ */
+static double bench_fill(size_t len) {
+    static int value = 0;
+    dequeue_t dequeue;
+    dequeue_new(&dequeue, sizeof(int));
+    double start = now_ns();
+    for (size_t i = 0; i < len; i++) {
+        dequeue_push_back(&dequeue, &value);
+    }
+    double elapsed = now_ns() - start;
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+    return elapsed / len;
+}
+
+/**
+ * Measure the cost of summing `len` ints stored in a dequeue.
+ */
+static double bench_scan(size_t len, dequeue_storage_t storage) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, len, sizeof(int), storage);
+    for (size_t i = 0; i < len; i++) {
+        int value = (int) i;
+        dequeue_push_back_copy(&dequeue, &value);
+    }
+    double start = now_ns();
+    volatile long sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += *((int *) dequeue_get(&dequeue, i));
+    }
+    double elapsed = now_ns() - start;
+    dequeue_free(&dequeue);
+    return elapsed / len;
+}
+
+/**
+ * Measure the cost of copying `len` ints into a dequeue and throwing it away,
+ * with the copies taken either from the heap or from an arena.
+ */
+static double bench_copies(size_t len, arena_ptr arena) {
+    dequeue_t dequeue;
+    double start = now_ns();
+    dequeue_new_with_capacity(&dequeue, len, sizeof(int));
+    dequeue_set_arena(&dequeue, arena);
+    for (size_t i = 0; i < len; i++) {
+        int value = (int) i;
+        dequeue_push_back_copy(&dequeue, &value);
+    }
+    dequeue_free(&dequeue);
+    return (now_ns() - start) / len;
+}
+
+/**
+ * Measure the cost of a steady-state push_back_copy + pop_front loop over a
+ * dequeue of `len` elements, with the copies taken either from the heap or
+ * from a pool owned by the dequeue.
+ */
+static double bench_recycle(size_t len, int use_pool) {
+    dequeue_t dequeue;
+    dequeue_new_with_capacity(&dequeue, len + 1, sizeof(int));
+    if (use_pool) {
+        dequeue_use_pool(&dequeue);
+    }
+    for (size_t i = 0; i < len; i++) {
+        int value = (int) i;
+        dequeue_push_back_copy(&dequeue, &value);
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < OPS; i++) {
+        int value = (int) i;
+        dequeue_push_back_copy(&dequeue, &value);
+        dequeue_element_free(&dequeue, dequeue_pop_front(&dequeue));
+    }
+    double elapsed = now_ns() - start;
+    dequeue_free(&dequeue);
+    return elapsed / OPS;
+}
+
+/**
+ * Measure the cost of summing the elements of a dequeue, either with a raw
+ * loop over dequeue_get (mode 0), one iter_next call per element (mode 1), or
+ * the spans handed out by iter_next_span (mode 2).
+ */
+static double bench_walk(int mode) {
+    static int value = 1;
+    dequeue_t dequeue;
+    dequeue_new_with_capacity(&dequeue, WALK_LEN, sizeof(int));
+    for (size_t i = 0; i < WALK_LEN; i++) {
+        dequeue_push_back(&dequeue, &value);
+    }
+    volatile long sum = 0;
+    long local = 0;
+    double start = now_ns();
+    if (mode == 0) {
+        for (size_t i = 0; i < dequeue.len; i++) {
+            local += *((int *) dequeue_get(&dequeue, i));
+        }
+    } else {
+        dequeue_iter_t state;
+        iter_t iter = dequeue_iter(&dequeue, &state);
+        if (mode == 1) {
+            void * elem;
+            while ((elem = iter_next(&iter)) != NULL) {
+                local += *((int *) elem);
+            }
+        } else {
+            void * buffer[ITER_BATCH_SIZE];
+            void ** span;
+            size_t len;
+            while ((len = iter_next_span(&iter, buffer, SIZE_MAX, &span))
+                   != 0) {
+                for (size_t i = 0; i < len; i++) {
+                    local += *((int *) span[i]);
+                }
+            }
+        }
+    }
+    sum = local;
+    double elapsed = now_ns() - start;
+    (void) sum;
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+    return elapsed / WALK_LEN;
+}
+
+/**
+ * Measure the cost of ingesting `len` ints into an inline dequeue and draining
+ * it again, one element per call or BATCH elements per call.
+ */
+static double bench_ingest(size_t len, int bulk) {
+    static int batch[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        batch[i] = i;
+    }
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 0, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    double start = now_ns();
+    for (size_t done = 0; done < len; done += BATCH) {
+        size_t n = len - done < BATCH ? len - done : BATCH;
+        if (bulk) {
+            dequeue_push_back_n(&dequeue, batch, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                dequeue_push_back_copy(&dequeue, &batch[i]);
+            }
+        }
+    }
+    for (size_t done = 0; done < len; done += BATCH) {
+        if (bulk) {
+            dequeue_pop_front_n(&dequeue, batch, BATCH, NULL);
+        } else {
+            size_t n = len - done < BATCH ? len - done : BATCH;
+            for (size_t i = 0; i < n; i++) {
+                dequeue_pop_front_into(&dequeue, &batch[i]);
+            }
+        }
+    }
+    double elapsed = now_ns() - start;
+    dequeue_free(&dequeue);
+    return elapsed / len;
+}
+
+/**
+ * Measure the time in milliseconds to bring back a dequeue of `len` ints on
+ * restart: pushed one by one with dequeue_push_back_copy, read back from a
+ * snapshot, or served from a mapped snapshot. The snapshot is in the page
+ * cache, as after a restart of the service alone.
+ */
+static double bench_restart(size_t len, int mode) {
+    char path[] = "/tmp/unilib-bench-XXXXXX";
+    close(mkstemp(path));
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue,
+                             len,
+                             sizeof(int),
+                             DEQUEUE_STORAGE_INLINE);
+    for (size_t i = 0; i < len; i++) {
+        int value = (int) i;
+        dequeue_push_back(&dequeue, &value);
+    }
+    dequeue_save(&dequeue, path);
+    dequeue_t restored;
+    double start = now_ns();
+    if (mode == 0) {
+        dequeue_new(&restored, sizeof(int));
+        for (size_t i = 0; i < len; i++) {
+            dequeue_push_back_copy(&restored, dequeue_get(&dequeue, i));
+        }
+    } else if (mode == 1) {
+        dequeue_load(&restored, path, sizeof(int));
+    } else {
+        dequeue_load_mapped(&restored, path, sizeof(int), false);
+    }
+    // serve both ends, as a consumer and a producer would right away
+    volatile int ends = *((int *) dequeue_front(&restored))
+                        + *((int *) dequeue_back(&restored));
+    (void) ends;
+    double elapsed = now_ns() - start;
+    dequeue_free(&restored);
+    dequeue_free(&dequeue);
+    unlink(path);
+    return elapsed / 1e6;
+}
+
+int main() {
+    printf("%10s %16s %16s %16s\n",
+           "len", "fifo (ns/op)", "front (ns/op)", "fill (ns/op)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        printf("%10zu %16.2f %16.2f %16.2f\n",
+               len, bench_fifo(len), bench_front(len), bench_fill(len));
+    }
+
+    printf("\n%10s %16s %16s\n", "len", "ptrs (ns/elem)", "inline (ns/elem)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        printf("%10zu %16.2f %16.2f\n",
+               len,
+               bench_scan(len, DEQUEUE_STORAGE_POINTERS),
+               bench_scan(len, DEQUEUE_STORAGE_INLINE));
+    }
+
+    arena_t arena;
+    arena_new(&arena, ARENA_DEFAULT_BLOCK_SIZE, NULL);
+    printf("\n%10s %16s %16s\n", "len", "heap (ns/elem)", "arena (ns/elem)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        // warm the arena up, as a long-lived request handler would
+        bench_copies(len, &arena);
+        printf("%10zu %16.2f %16.2f\n",
+               len, bench_copies(len, NULL), bench_copies(len, &arena));
+    }
+    arena_free(&arena);
+
+    printf("\n%10s %16s %16s\n", "len", "heap (ns/op)", "pool (ns/op)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        printf("%10zu %16.2f %16.2f\n",
+               len, bench_recycle(len, 0), bench_recycle(len, 1));
+    }
+
+    printf("\n%10s %16s %16s\n", "len", "loop (ns/elem)", "bulk (ns/elem)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        printf("%10zu %16.2f %16.2f\n",
+               len, bench_ingest(len, 0), bench_ingest(len, 1));
+    }
+
+    printf("\n%16s %16s %16s\n",
+           "get (ns/elem)", "next (ns/elem)", "span (ns/elem)");
+    printf("%16.2f %16.2f %16.2f\n",
+           bench_walk(0), bench_walk(1), bench_walk(2));
+
+    printf("\n%10s %16s %16s %16s\n",
+           "len", "rebuild (ms)", "load (ms)", "mapped (ms)");
+    for (size_t len = 100000; len <= 10000000; len *= 10) {
+        printf("%10zu %16.3f %16.3f %16.3f\n",
+               len,
+               bench_restart(len, 0),
+               bench_restart(len, 1),
+               bench_restart(len, 2));
+    }
+    return 0;
+}
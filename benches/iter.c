@@ -0,0 +1,144 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "iter.h"
+#include "iter_inline.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Number of elements walked by every form of the pipeline. Configure with
+ * -DCMAKE_BUILD_TYPE=Release to let the compiler vectorize the inline forms.
+ */
+#define LEN 10000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int is_odd(void * elem, void * ctx) {
+    (void) ctx;
+    return *((int32_t *) elem) & 1;
+}
+
+static void * square(void * elem, void * ctx) {
+    int64_t * out = ctx;
+    int64_t value = *((int32_t *) elem);
+    *out = value * value;
+    return out;
+}
+
+/**
+ * The pipeline is the sum of the squares of the odd elements, run through:
+ * 0. fused iter_filter + iter_map adapters, one iter_next call per element,
+ * 1. batches from the runtime dequeue iterator with the stages inlined,
+ * 2. the header-only dequeue cursor,
+ * 3. the header-only DEQUEUE_FOR_EACH loop.
+ */
+static int64_t run(dequeue_ptr dequeue, int form) {
+    int64_t sum = 0;
+    if (form == 0) {
+        dequeue_iter_t state;
+        iter_stages_t stages;
+        int64_t squared;
+        iter_t iter = dequeue_iter(dequeue, &state);
+        iter = iter_filter(&iter, is_odd, NULL, &stages);
+        iter = iter_map(&iter, square, &squared, &stages);
+        void * elem;
+        while ((elem = iter_next(&iter)) != NULL) {
+            sum += *((int64_t *) elem);
+        }
+    } else if (form == 1) {
+        dequeue_iter_t state;
+        iter_t iter = dequeue_iter(dequeue, &state);
+        void * buffer[ITER_BATCH_SIZE];
+        size_t len;
+        while ((len = iter_next_batch(&iter, buffer, ITER_BATCH_SIZE)) != 0) {
+            for (size_t i = 0; i < len; i++) {
+                int64_t value = *((int32_t *) buffer[i]);
+                if (value & 1) {
+                    sum += value * value;
+                }
+            }
+        }
+    } else if (form == 2) {
+        dequeue_cursor_t cursor = dequeue_cursor(dequeue);
+        void * elem;
+        while ((elem = dequeue_cursor_next(&cursor)) != NULL) {
+            int64_t value = *((int32_t *) elem);
+            if (value & 1) {
+                sum += value * value;
+            }
+        }
+    } else {
+        DEQUEUE_FOR_EACH(int32_t, elem, dequeue) {
+            int64_t value = *elem;
+            if (value & 1) {
+                sum += value * value;
+            }
+        }
+    }
+    return sum;
+}
+
+int main() {
+    static const char * forms[] = {"adapters", "batches", "cursor", "for_each"};
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue,
+                             LEN,
+                             sizeof(int32_t),
+                             DEQUEUE_STORAGE_INLINE);
+    // start the elements mid-ring so every form crosses the wrap
+    for (int32_t i = 0; i < LEN / 2; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    for (int32_t i = 0; i < LEN / 2; i++) {
+        int32_t value;
+        dequeue_pop_front_into(&dequeue, &value);
+    }
+    for (int32_t i = 0; i < LEN; i++) {
+        int32_t value = i % 1000;
+        dequeue_push_back_copy(&dequeue, &value);
+    }
+
+    int64_t expected = run(&dequeue, 3);
+    printf("%10s %16s\n", "form", "ns/elem");
+    for (int form = 0; form < 4; form++) {
+        double start = now_ns();
+        int64_t sum = run(&dequeue, form);
+        double elapsed = now_ns() - start;
+        if (sum != expected) {
+            fprintf(stderr, "%s: wrong sum\n", forms[form]);
+            return 1;
+        }
+        printf("%10s %16.2f\n", forms[form], elapsed / LEN);
+    }
+    dequeue_free(&dequeue);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "mpmc.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Number of items handed from the producers to the consumers, for every
+ * thread count.
+ */
+#define ITEMS 2000000
+
+static double * push_times;
+static double * latencies;
+static atomic_size_t popped;
+static size_t items_per_producer;
+static size_t total_items;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int compare_doubles(const void * a, const void * b) {
+    double x = *((const double *) a);
+    double y = *((const double *) b);
+    return (x > y) - (x < y);
+}
+
+typedef struct producer_arg_t {
+    mpmc_ptr mpmc;
+    size_t first;
+} producer_arg_t;
+
+static void * producer(void * arg) {
+    producer_arg_t * producer = arg;
+    for (size_t i = producer->first; i < producer->first + items_per_producer; i++) {
+        push_times[i] = now_ns();
+        while (!MPMC_ERROR_IS_OK(mpmc_try_push(producer->mpmc, (void *) (uintptr_t) i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void * consumer(void * arg) {
+    mpmc_ptr mpmc = arg;
+    while (atomic_load_explicit(&popped, memory_order_relaxed) < total_items) {
+        void * elem;
+        if (!MPMC_ERROR_IS_OK(mpmc_try_pop(mpmc, &elem))) {
+            sched_yield();
+            continue;
+        }
+        size_t i = (size_t) (uintptr_t) elem;
+        latencies[i] = now_ns() - push_times[i];
+        atomic_fetch_add_explicit(&popped, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+/**
+ * Run `threads` producers against `threads` consumers and report the
+ * throughput and the push-to-pop latency percentiles.
+ */
+static void bench(size_t threads) {
+    mpmc_t mpmc;
+    mpmc_new(&mpmc, 1024, NULL);
+    items_per_producer = ITEMS / threads;
+    size_t total = items_per_producer * threads;
+    total_items = total;
+    atomic_store(&popped, 0);
+
+    pthread_t * producers = malloc(threads * sizeof(pthread_t));
+    pthread_t * consumers = malloc(threads * sizeof(pthread_t));
+    producer_arg_t * args = malloc(threads * sizeof(producer_arg_t));
+    double start = now_ns();
+    for (size_t i = 0; i < threads; i++) {
+        args[i].mpmc = &mpmc;
+        args[i].first = i * items_per_producer;
+        pthread_create(&consumers[i], NULL, consumer, &mpmc);
+        pthread_create(&producers[i], NULL, producer, &args[i]);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+    }
+    double elapsed = now_ns() - start;
+
+    qsort(latencies, total, sizeof(double), compare_doubles);
+    printf("%8zu %14.2f %12.0f %12.0f %12.0f\n",
+           threads,
+           total / elapsed * 1e3,
+           latencies[total / 2],
+           latencies[total / 100 * 99],
+           latencies[total / 1000 * 999]);
+
+    free(producers);
+    free(consumers);
+    free(args);
+    mpmc_free(&mpmc);
+}
+
+int main(int argc, char ** argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 1 ? (size_t) atol(argv[1]) : (size_t) cpus;
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+    push_times = malloc(ITEMS * sizeof(double));
+    latencies = malloc(ITEMS * sizeof(double));
+    printf("%8s %14s %12s %12s %12s\n",
+           "threads", "Mops/sec", "p50 (ns)", "p99 (ns)", "p99.9 (ns)");
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        bench(threads);
+    }
+    free(push_times);
+    free(latencies);
+    return 0;
+}
@@ -0,0 +1,202 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "notify.h"
+#include "spsc.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Number of messages sent one at a time to measure the handoff latency.
+ */
+#define MESSAGES 2000
+
+/**
+ * Pause between two messages, in nanoseconds.
+ */
+#define MESSAGE_GAP_NS 200000L
+
+/**
+ * Period of the timer the polling consumer wakes up on, in nanoseconds.
+ */
+#define POLL_PERIOD_NS 1000000L
+
+/**
+ * Number of items pushed back to back to measure the cost of a push.
+ */
+#define ITEMS 2000000
+
+static atomic_bool done;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int compare_doubles(const void * a, const void * b) {
+    double x = *((const double *) a);
+    double y = *((const double *) b);
+    return (x > y) - (x < y);
+}
+
+typedef struct run_t {
+    spsc_t spsc;
+    notify_t notify;
+    // whether the consumer waits on the notifier rather than a timer
+    int notified;
+    // the number of items the consumer expects
+    size_t items;
+    // the push-to-pop latency of every item, or NULL
+    double * latencies;
+    // the number of times the consumer woke up
+    size_t wakeups;
+} run_t;
+
+/**
+ * Wait for items, either on the notifier or on the next timer tick.
+ */
+static void consumer_wait(run_t * run) {
+    if (run->notified) {
+        struct pollfd fd = {notify_fd(&run->notify), POLLIN, 0};
+        poll(&fd, 1, -1);
+        notify_consume(&run->notify);
+    } else {
+        struct timespec period = {0, POLL_PERIOD_NS};
+        nanosleep(&period, NULL);
+    }
+}
+
+static void * consumer(void * arg) {
+    run_t * run = arg;
+    size_t popped = 0;
+    while (popped < run->items) {
+        consumer_wait(run);
+        run->wakeups++;
+        void * elem;
+        while (SPSC_ERROR_IS_OK(spsc_try_pop(&run->spsc, &elem))) {
+            if (run->latencies != NULL) {
+                double sent = (double) (uintptr_t) elem;
+                run->latencies[popped] = now_ns() - sent;
+            }
+            popped++;
+        }
+    }
+    atomic_store(&done, 1);
+    return NULL;
+}
+
+static void run_init(run_t * run, int notified, size_t items) {
+    spsc_new(&run->spsc, 4096, NULL);
+    run->notified = notified;
+    if (notified) {
+        notify_new(&run->notify);
+        spsc_set_notify(&run->spsc, &run->notify);
+    }
+    run->items = items;
+    run->latencies = NULL;
+    run->wakeups = 0;
+    atomic_store(&done, 0);
+}
+
+static void run_free(run_t * run) {
+    if (run->notified) {
+        notify_free(&run->notify);
+    }
+    spsc_free(&run->spsc);
+}
+
+/**
+ * Send MESSAGES timestamps one at a time and report the percentiles of the
+ * time they took to reach the consumer.
+ */
+static void bench_latency(int notified) {
+    run_t run;
+    run_init(&run, notified, MESSAGES);
+    run.latencies = malloc(MESSAGES * sizeof(double));
+    pthread_t thread;
+    pthread_create(&thread, NULL, consumer, &run);
+    struct timespec gap = {0, MESSAGE_GAP_NS};
+    for (size_t i = 0; i < MESSAGES; i++) {
+        nanosleep(&gap, NULL);
+        spsc_try_push(&run.spsc, (void *) (uintptr_t) now_ns());
+    }
+    pthread_join(thread, NULL);
+    qsort(run.latencies, MESSAGES, sizeof(double), compare_doubles);
+    printf("%-10s %12.1f %12.1f %12.1f\n",
+           notified ? "eventfd" : "timer",
+           run.latencies[MESSAGES / 2] / 1e3,
+           run.latencies[MESSAGES / 100 * 99] / 1e3,
+           run.latencies[MESSAGES - 1] / 1e3);
+    free(run.latencies);
+    run_free(&run);
+}
+
+/**
+ * Push ITEMS items back to back and report the cost of a push and how many
+ * times the consumer was woken.
+ */
+static void bench_throughput(int notified) {
+    run_t run;
+    run_init(&run, notified, ITEMS);
+    pthread_t thread;
+    pthread_create(&thread, NULL, consumer, &run);
+    double start = now_ns();
+    for (uintptr_t i = 0; i < ITEMS; i++) {
+        while (!SPSC_ERROR_IS_OK(spsc_try_push(&run.spsc, (void *) i))) {
+            sched_yield();
+        }
+    }
+    double elapsed = now_ns() - start;
+    pthread_join(thread, NULL);
+    printf("%-10s %12.2f %12zu %12.5f\n",
+           notified ? "eventfd" : "timer",
+           elapsed / ITEMS,
+           run.wakeups,
+           (double) run.wakeups / ITEMS);
+    run_free(&run);
+}
+
+int main() {
+    printf("handoff latency, one message every %ld us\n",
+           MESSAGE_GAP_NS / 1000);
+    printf("%-10s %12s %12s %12s\n", "wait", "p50 (us)", "p99 (us)",
+           "max (us)");
+    bench_latency(0);
+    bench_latency(1);
+    printf("\n%d pushes back to back\n", ITEMS);
+    printf("%-10s %12s %12s %12s\n", "wait", "ns/push", "wakeups",
+           "wakeups/push");
+    bench_throughput(0);
+    bench_throughput(1);
+    return 0;
+}
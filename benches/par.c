@@ -0,0 +1,123 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "par.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Number of elements reduced, for every thread count.
+ */
+#define ELEMENTS 20000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int is_odd(const void * elem, void * ctx) {
+    (void) ctx;
+    return *((const size_t *) elem) & 1;
+}
+
+static void square(void * out, const void * elem, void * ctx) {
+    (void) ctx;
+    uint64_t value = *((const size_t *) elem);
+    *((uint64_t *) out) = value * value;
+}
+
+static void sum_reduce(void * acc, const void * value, void * ctx) {
+    (void) ctx;
+    *((uint64_t *) acc) += *((const uint64_t *) value);
+}
+
+static void sum_combine(void * acc, const void * other, void * ctx) {
+    (void) ctx;
+    *((uint64_t *) acc) += *((const uint64_t *) other);
+}
+
+int main(int argc, char ** argv) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 1 ? (size_t) atol(argv[1])
+                                  : (size_t) (online > 0 ? online : 1);
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+
+    uint64_t zero = 0;
+    par_ops_t ops = {
+        .filter = is_odd,
+        .map = square,
+        .mapped_size = sizeof(uint64_t),
+        .reduce = sum_reduce,
+        .combine = sum_combine,
+        .identity = &zero,
+        .acc_size = sizeof(uint64_t),
+    };
+
+    // the sequential baseline runs the same stages in a plain loop
+    double start = now_ns();
+    uint64_t expected = 0;
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        if (is_odd(&i, NULL)) {
+            uint64_t mapped;
+            square(&mapped, &i, NULL);
+            sum_reduce(&expected, &mapped, NULL);
+        }
+    }
+    double serial = now_ns() - start;
+    printf("%-10s %8.2f ms\n", "serial", serial / 1e6);
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        threadpool_t pool;
+        if (!THREADPOOL_ERROR_IS_OK(threadpool_new(&pool, threads, NULL))) {
+            fprintf(stderr, "failed to start %zu threads\n", threads);
+            return 1;
+        }
+        par_iter_t iter = par_iter_range(0, ELEMENTS);
+        uint64_t sum;
+        start = now_ns();
+        par_reduce(&pool, &iter, &ops, NULL, &sum);
+        double elapsed = now_ns() - start;
+        threadpool_free(&pool);
+        if (sum != expected) {
+            fprintf(stderr, "wrong sum with %zu threads\n", threads);
+            return 1;
+        }
+        printf("%2zu threads %8.2f ms  %5.2fx\n",
+               threads,
+               elapsed / 1e6,
+               serial / elapsed);
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "pqueue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Number of expire + re-arm operations measured for each queue length.
+ */
+#define OPS 200000
+
+/**
+ * Longest queue measured with sorted insertion, which is O(n) per operation.
+ */
+#define SORTED_MAX_LEN 100000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int compare_u64(const void * a, const void * b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t next_delay(uint64_t * state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (*state >> 33) % 1000000;
+}
+
+/**
+ * Keep `len` timers pending in a heap of the given arity: expire the
+ * earliest one and re-arm it, OPS times. Returns nanoseconds per operation.
+ */
+static double bench_heap(size_t len, size_t arity) {
+    uint64_t state = 1;
+    pqueue_t pqueue;
+    pqueue_new(&pqueue, sizeof(uint64_t), arity, compare_u64);
+    for (size_t i = 0; i < len; i++) {
+        uint64_t deadline = next_delay(&state);
+        pqueue_push(&pqueue, &deadline, NULL);
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < OPS; i++) {
+        uint64_t now;
+        pqueue_pop(&pqueue, &now);
+        uint64_t deadline = now + next_delay(&state);
+        pqueue_push(&pqueue, &deadline, NULL);
+    }
+    double elapsed = now_ns() - start;
+    pqueue_free(&pqueue);
+    return elapsed / OPS;
+}
+
+/**
+ * The same workload on an array kept sorted by inserting in place, latest
+ * deadline first so that expiring is a pop from the end.
+ */
+static double bench_sorted(size_t len) {
+    uint64_t state = 1;
+    uint64_t * deadlines = malloc((len + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < len; i++) {
+        deadlines[i] = next_delay(&state);
+    }
+    qsort(deadlines, len, sizeof(uint64_t), compare_u64);
+    for (size_t i = 0; i < len / 2; i++) {
+        uint64_t tmp = deadlines[i];
+        deadlines[i] = deadlines[len - 1 - i];
+        deadlines[len - 1 - i] = tmp;
+    }
+    double start = now_ns();
+    for (size_t i = 0; i < OPS; i++) {
+        uint64_t deadline = deadlines[len - 1] + next_delay(&state);
+        // binary search the insertion point in the descending array
+        size_t lo = 0;
+        size_t hi = len - 1;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (deadlines[mid] > deadline) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        memmove(deadlines + lo + 1,
+                deadlines + lo,
+                (len - 1 - lo) * sizeof(uint64_t));
+        deadlines[lo] = deadline;
+    }
+    double elapsed = now_ns() - start;
+    free(deadlines);
+    return elapsed / OPS;
+}
+
+int main() {
+    printf("%10s %16s %16s %16s\n",
+           "len", "sorted (ns/op)", "binary (ns/op)", "4-ary (ns/op)");
+    for (size_t len = 1000; len <= 1000000; len *= 10) {
+        if (len <= SORTED_MAX_LEN) {
+            printf("%10zu %16.2f", len, bench_sorted(len));
+        } else {
+            printf("%10zu %16s", len, "-");
+        }
+        printf(" %16.2f %16.2f\n",
+               bench_heap(len, PQUEUE_BINARY_ARITY),
+               bench_heap(len, PQUEUE_DEFAULT_ARITY));
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "dequeue.h"
+#include "segdeque.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * Default number of elements pushed through each queue.
+ */
+#define DEFAULT_LEN 20000000
+
+/**
+ * Pushes slower than this many nanoseconds are counted as stalls.
+ */
+#define STALL_NS 50000
+
+/**
+ * Allocator context that tracks the live and peak number of bytes.
+ */
+typedef struct usage_t {
+    // bytes currently allocated
+    size_t live;
+    // most bytes allocated at once
+    size_t peak;
+} usage_t;
+
+static void usage_add(usage_t * usage, size_t size) {
+    usage->live += size;
+    if (usage->live > usage->peak) {
+        usage->peak = usage->live;
+    }
+}
+
+static void * usage_alloc(void * ctx, size_t size) {
+    void * mem = malloc(size);
+    if (mem != NULL) {
+        usage_add(ctx, size);
+    }
+    return mem;
+}
+
+static void * usage_realloc(void * ctx, void * mem, size_t old_size,
+                            size_t new_size) {
+    void * new_mem = realloc(mem, new_size);
+    if (new_mem != NULL) {
+        ((usage_t *) ctx)->live -= old_size;
+        usage_add(ctx, new_size);
+    }
+    return new_mem;
+}
+
+static void usage_free(void * ctx, void * mem, size_t size) {
+    free(mem);
+    ((usage_t *) ctx)->live -= size;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static void report(const char * name, size_t len, double push_ns,
+                   double worst_ns, size_t stalls, double pop_ns,
+                   const usage_t * usage) {
+    printf("%-9s push %6.2f ns/op  worst %8.0f us  stalls %4zu"
+           "  pop %5.2f ns/op  peak %6.1f MiB\n",
+           name, push_ns / len, worst_ns / 1e3, stalls, pop_ns / len,
+           (double) usage->peak / (1 << 20));
+}
+
+/**
+ * Time every push individually, so that the cost of the occasional ring
+ * resize shows up as the worst single-push latency and as stalls; on a busy
+ * machine both also catch preemptions, so compare them across runs.
+ */
+static void bench_dequeue(size_t len) {
+    usage_t usage = {0};
+    allocator_t allocator = allocator_new(&usage, usage_alloc, usage_realloc,
+                                          usage_free);
+    dequeue_t dequeue;
+    dequeue_new_with_allocator(&dequeue, 16, sizeof(uint64_t),
+                               DEQUEUE_STORAGE_INLINE, &allocator);
+    double worst = 0;
+    size_t stalls = 0;
+    double start = now_ns();
+    for (uint64_t i = 0; i < len; i++) {
+        double before = now_ns();
+        dequeue_push_back(&dequeue, &i);
+        double took = now_ns() - before;
+        if (took > worst) {
+            worst = took;
+        }
+        if (took > STALL_NS) {
+            stalls++;
+        }
+    }
+    double push = now_ns() - start;
+    uint64_t sum = 0;
+    start = now_ns();
+    for (size_t i = 0; i < len; i++) {
+        uint64_t value;
+        dequeue_pop_front_into(&dequeue, &value);
+        sum += value;
+    }
+    double pop = now_ns() - start;
+    dequeue_free(&dequeue);
+    if (sum != (uint64_t) len * (len - 1) / 2) {
+        fprintf(stderr, "dequeue: wrong checksum\n");
+        exit(1);
+    }
+    report("dequeue", len, push, worst, stalls, pop, &usage);
+}
+
+static void bench_segdeque(size_t len) {
+    usage_t usage = {0};
+    allocator_t allocator = allocator_new(&usage, usage_alloc, usage_realloc,
+                                          usage_free);
+    segdeque_t segdeque;
+    segdeque_new_with_block_len(&segdeque, sizeof(uint64_t),
+                                SEGDEQUE_DEFAULT_BLOCK_SIZE / sizeof(uint64_t),
+                                &allocator);
+    double worst = 0;
+    size_t stalls = 0;
+    double start = now_ns();
+    for (uint64_t i = 0; i < len; i++) {
+        double before = now_ns();
+        segdeque_push_back(&segdeque, &i);
+        double took = now_ns() - before;
+        if (took > worst) {
+            worst = took;
+        }
+        if (took > STALL_NS) {
+            stalls++;
+        }
+    }
+    double push = now_ns() - start;
+    uint64_t sum = 0;
+    start = now_ns();
+    for (size_t i = 0; i < len; i++) {
+        uint64_t value;
+        segdeque_pop_front(&segdeque, &value);
+        sum += value;
+    }
+    double pop = now_ns() - start;
+    segdeque_free(&segdeque);
+    if (sum != (uint64_t) len * (len - 1) / 2) {
+        fprintf(stderr, "segdeque: wrong checksum\n");
+        exit(1);
+    }
+    report("segdeque", len, push, worst, stalls, pop, &usage);
+}
+
+int main(int argc, char ** argv) {
+    size_t len = DEFAULT_LEN;
+    if (argc > 1) {
+        len = strtoull(argv[1], NULL, 10);
+    }
+    printf("%zu uint64_t elements, push_back then pop_front\n", len);
+    bench_dequeue(len);
+    bench_segdeque(len);
+    return 0;
+}
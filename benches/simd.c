@@ -0,0 +1,148 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "dequeue.h"
+#include "simd.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Number of elements scanned by every kernel, small enough to stay in the
+ * last level cache.
+ */
+#define LEN 262144
+
+/**
+ * Number of scans measured for each kernel.
+ */
+#define ROUNDS 200
+
+static const char * level_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static int32_t elems[LEN];
+static uint8_t bytes[LEN];
+static int32_t scratch[LEN / 2];
+
+/**
+ * Keeps the compiler from dropping the measured calls.
+ */
+static volatile int64_t sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/**
+ * Measure one kernel, in nanoseconds per element.
+ */
+static double bench_kernel(int kernel) {
+    double start = now_ns();
+    for (int round = 0; round < ROUNDS; round++) {
+        switch (kernel) {
+            case 0:
+                sink += simd_sum_i32(elems, LEN);
+                break;
+            case 1: {
+                int32_t min;
+                int32_t max;
+                simd_min_max_i32(elems, LEN, &min, &max);
+                sink += min + max;
+                break;
+            }
+            case 2:
+                sink += (int64_t) simd_count_eq_i32(elems, LEN, 7);
+                break;
+            case 3:
+                // the value is absent, so the whole array is scanned
+                sink += (int64_t) simd_find_i32(elems, LEN, -1);
+                break;
+            default:
+                sink += (int64_t) simd_find_byte(bytes, LEN, 0xff);
+                break;
+        }
+    }
+    return (now_ns() - start) / ((double) ROUNDS * LEN);
+}
+
+/**
+ * Measure memchr on the same bytes as the byte search kernel.
+ */
+static double bench_memchr(void) {
+    double start = now_ns();
+    for (int round = 0; round < ROUNDS; round++) {
+        sink += memchr(bytes, 0xff, LEN) == NULL;
+    }
+    return (now_ns() - start) / ((double) ROUNDS * LEN);
+}
+
+/**
+ * Measure the sum of a dequeue whose elements wrap around its ring.
+ */
+static double bench_dequeue_sum(void) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue,
+                             LEN,
+                             sizeof(int32_t),
+                             DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, elems, LEN / 2);
+    dequeue_pop_front_n(&dequeue, scratch, LEN / 2, NULL);
+    dequeue_push_back_n(&dequeue, elems, LEN);
+    double start = now_ns();
+    for (int round = 0; round < ROUNDS; round++) {
+        int64_t sum;
+        dequeue_sum_i32(&dequeue, &sum);
+        sink += sum;
+    }
+    double elapsed = now_ns() - start;
+    dequeue_free(&dequeue);
+    return elapsed / ((double) ROUNDS * LEN);
+}
+
+int main() {
+    for (size_t i = 0; i < LEN; i++) {
+        elems[i] = (int32_t) (i * 2654435761u % 1000);
+        bytes[i] = (uint8_t) (i % 255);
+    }
+    simd_level_t supported = simd_detect();
+
+    printf("%10s %10s %10s %10s %10s %10s %10s\n", "level", "sum", "min_max",
+           "count_eq", "find", "find_byte", "dequeue");
+    for (int level = SIMD_LEVEL_SCALAR; level <= (int) supported; level++) {
+        simd_set_level((simd_level_t) level);
+        printf("%10s", level_names[level]);
+        for (int kernel = 0; kernel < 5; kernel++) {
+            printf(" %10.3f", bench_kernel(kernel));
+        }
+        printf(" %10.3f\n", bench_dequeue_sum());
+    }
+    printf("%10s %10s %10s %10s %10s %10.3f\n",
+           "memchr", "", "", "", "", bench_memchr());
+    printf("(ns/elem)\n");
+    return 0;
+}
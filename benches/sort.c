@@ -0,0 +1,113 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "dequeue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Largest number of elements sorted by default; pass a larger one as the
+ * first argument, e.g. 100000000.
+ */
+#define DEFAULT_MAX_LEN 10000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int compare_int(const void * a, const void * b) {
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Fill a dequeue with pseudo-random values wrapping around its ring.
+ */
+static void fill(dequeue_ptr dequeue, size_t len) {
+    uint32_t state = 12345;
+    dequeue_new_with_storage(dequeue, len, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    int * values = malloc(len * sizeof(int));
+    for (size_t i = 0; i < len; i++) {
+        state = state * 1103515245u + 12345u;
+        values[i] = (int) (state >> 1);
+    }
+    // start the ring in the middle, so the sorts have to deal with the wrap
+    dequeue_push_back_n(dequeue, values, len / 2);
+    dequeue_pop_front_n(dequeue, values + len / 2, len / 2, NULL);
+    dequeue_push_back_n(dequeue, values, len);
+    free(values);
+}
+
+/**
+ * Measure one way of sorting a dequeue of `len` ints, in nanoseconds per
+ * element.
+ */
+static double bench_sort(size_t len, int method) {
+    dequeue_t dequeue;
+    fill(&dequeue, len);
+    double start = now_ns();
+    if (method == 0) {
+        // what callers did before: copy out, qsort, copy back
+        int * values = malloc(len * sizeof(int));
+        dequeue_pop_front_n(&dequeue, values, len, NULL);
+        qsort(values, len, sizeof(int), compare_int);
+        dequeue_push_back_n(&dequeue, values, len);
+        free(values);
+    } else if (method == 1) {
+        dequeue_sort(&dequeue, compare_int);
+    } else if (method == 2) {
+        dequeue_stable_sort(&dequeue, compare_int);
+    } else {
+        dequeue_radix_sort(&dequeue, DEQUEUE_KEY_SIGNED);
+    }
+    double elapsed = now_ns() - start;
+    for (size_t i = 1; i < len; i++) {
+        if (*(int *) dequeue_get(&dequeue, i - 1)
+            > *(int *) dequeue_get(&dequeue, i)) {
+            fprintf(stderr, "method %d left the dequeue unsorted\n", method);
+            exit(1);
+        }
+    }
+    dequeue_free(&dequeue);
+    return elapsed / (double) len;
+}
+
+int main(int argc, char ** argv) {
+    size_t max_len = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_MAX_LEN;
+    printf("%10s %16s %16s %16s %16s\n", "len", "qsort (ns/elem)",
+           "sort (ns/elem)", "stable (ns/elem)", "radix (ns/elem)");
+    for (size_t len = 1000000; len <= max_len; len *= 10) {
+        printf("%10zu %16.2f %16.2f %16.2f %16.2f\n", len,
+               bench_sort(len, 0), bench_sort(len, 1),
+               bench_sort(len, 2), bench_sort(len, 3));
+    }
+    return 0;
+}
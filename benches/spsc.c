@@ -0,0 +1,100 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "spsc.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Number of items handed from the producer to the consumer.
+ */
+#define ITEMS 10000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/**
+ * Pin the calling thread to a CPU, if there is such a CPU.
+ */
+static void pin_to_cpu(int cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void * producer(void * arg) {
+    spsc_ptr spsc = arg;
+    pin_to_cpu(0);
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        while (!SPSC_ERROR_IS_OK(spsc_try_push(spsc, (void *) i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void * consumer(void * arg) {
+    spsc_ptr spsc = arg;
+    pin_to_cpu(1);
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        void * elem;
+        while (!SPSC_ERROR_IS_OK(spsc_try_pop(spsc, &elem))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    printf("%10s %16s\n", "capacity", "Mops/sec");
+    for (size_t capacity = 64; capacity <= 65536; capacity *= 16) {
+        spsc_t spsc;
+        spsc_new(&spsc, capacity, NULL);
+        pthread_t producer_thread;
+        pthread_t consumer_thread;
+        double start = now_ns();
+        pthread_create(&consumer_thread, NULL, consumer, &spsc);
+        pthread_create(&producer_thread, NULL, producer, &spsc);
+        pthread_join(producer_thread, NULL);
+        pthread_join(consumer_thread, NULL);
+        double elapsed = now_ns() - start;
+        printf("%10zu %16.2f\n", capacity, ITEMS / elapsed * 1e3);
+        spsc_free(&spsc);
+    }
+    return 0;
+}
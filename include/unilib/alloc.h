@@ -0,0 +1,123 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#ifndef UNILIB_ALLOC_H
+#define UNILIB_ALLOC_H
+
+/**
+ * Pointer to the `alloc` function of an allocator.
+ * @details Receives the allocator context and the number of bytes to allocate
+ *          and returns the new memory, or NULL on failure.
+ */
+typedef void * (* alloc_alloc_ptr)(void *, size_t);
+
+/**
+ * Pointer to the `realloc` function of an allocator.
+ * @details Receives the allocator context, the memory to resize, its current
+ *          size and the new size and returns the resized memory, or NULL on
+ *          failure (in which case the old memory is left untouched).
+ */
+typedef void * (* alloc_realloc_ptr)(void *, void *, size_t, size_t);
+
+/**
+ * Pointer to the `free` function of an allocator.
+ * @details Receives the allocator context, the memory to release and its
+ *          size.
+ */
+typedef void (* alloc_free_ptr)(void *, void *, size_t);
+
+/**
+ * @struct allocator
+ * @brief A memory allocator.
+ * @details The sizes passed to `realloc` and `free` are the ones the memory
+ *          was requested with, so that allocators which do not keep track of
+ *          block sizes (arenas, pools) can be plugged in.
+ */
+typedef struct allocator_t {
+    // pointer to the context of the allocator
+    void * ctx;
+    // pointer to the `alloc` function of the allocator
+    alloc_alloc_ptr alloc;
+    // pointer to the `realloc` function of the allocator
+    alloc_realloc_ptr realloc;
+    // pointer to the `free` function of the allocator
+    alloc_free_ptr free;
+} allocator_t;
+
+/**
+ * Pointer to an allocator.
+ */
+typedef allocator_t * allocator_ptr;
+
+/**
+ * @brief Create a new allocator.
+ * @param ctx pointer to the context of the allocator
+ * @param alloc pointer to the `alloc` function of the allocator
+ * @param realloc pointer to the `realloc` function of the allocator
+ * @param free pointer to the `free` function of the allocator
+ * @return a new allocator
+ */
+allocator_t allocator_new(void * ctx,
+                          alloc_alloc_ptr alloc,
+                          alloc_realloc_ptr realloc,
+                          alloc_free_ptr free);
+
+/**
+ * @brief Get the default allocator, backed by malloc, realloc and free.
+ * @return the default allocator
+ */
+allocator_t allocator_default();
+
+/**
+ * @brief Allocate memory.
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ * @param size the number of bytes to allocate
+ * @return pointer to the memory, or NULL if memory could not be allocated
+ */
+void * allocator_alloc(allocator_ptr allocator, size_t size);
+
+/**
+ * @brief Resize memory.
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ * @param ptr the memory to resize
+ * @param old_size the current size of the memory
+ * @param new_size the new size of the memory
+ * @return pointer to the resized memory, or NULL if memory could not be
+ *         allocated
+ */
+void * allocator_realloc(allocator_ptr allocator,
+                         void * ptr,
+                         size_t old_size,
+                         size_t new_size);
+
+/**
+ * @brief Release memory.
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ * @param ptr the memory to release, can be NULL
+ * @param size the size of the memory
+ */
+void allocator_free(allocator_ptr allocator, void * ptr, size_t size);
+
+#endif //UNILIB_ALLOC_H
@@ -0,0 +1,190 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+
+#ifndef UNILIB_ARENA_H
+#define UNILIB_ARENA_H
+
+/**
+ * @brief Default size of an arena block.
+ */
+#define ARENA_DEFAULT_BLOCK_SIZE 65536
+
+/**
+ * @brief Alignment of every allocation made from an arena.
+ */
+#define ARENA_ALIGNMENT 16
+
+/**
+ * Error type return by arena functions.
+ */
+typedef uint8_t arena_error_t;
+
+/**
+ * No error.
+ */
+#define ARENA_ERROR_OK                    ((arena_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define ARENA_ERROR_NULL_POINTER_RECEIVED ((arena_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define ARENA_ERROR_ALLOC_FAILED          ((arena_error_t) 2)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define ARENA_ERROR_IS_OK(err) (err == ARENA_ERROR_OK)
+
+/**
+ * @struct arena_block
+ * @brief A block of memory allocations are carved out of.
+ */
+typedef struct arena_block_t {
+    // the next block in the chain
+    struct arena_block_t * next;
+    // the number of bytes available in the block
+    size_t size;
+    // the number of bytes already handed out
+    size_t used;
+} arena_block_t;
+
+/**
+ * @struct arena
+ * @brief A bump allocator.
+ * @details Memory is handed out from a chain of large blocks by bumping an
+ *          offset, and is only given back all at once by resetting or
+ *          rewinding the arena. Blocks are kept around after a reset, so a
+ *          reused arena stops allocating once it has warmed up.
+ */
+typedef struct arena_t {
+    // the first block in the chain
+    arena_block_t * first;
+    // the block allocations are currently made from
+    arena_block_t * current;
+    // the size of a new block
+    size_t block_size;
+    // the allocator the blocks are allocated from
+    allocator_t allocator;
+} arena_t;
+
+/**
+ * @brief Pointer to an arena.
+ */
+typedef arena_t * arena_ptr;
+
+/**
+ * @struct arena_mark
+ * @brief A position in an arena, that the arena can be rewound to.
+ */
+typedef struct arena_mark_t {
+    // the block that was current when the mark was taken
+    arena_block_t * block;
+    // the number of bytes used in that block
+    size_t used;
+} arena_mark_t;
+
+/**
+ * @brief Create a new arena.
+ * @details No memory is allocated until the first allocation.
+ *
+ * @param arena address to the arena that should be created
+ * @param block_size the size of the blocks allocated by the arena
+ * @param allocator pointer to the allocator the blocks are allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return ARENA_ERROR_OK on success,
+ *         ARENA_ERROR_NULL_POINTER_RECEIVED if arena is a NULL pointer
+ */
+arena_error_t arena_new(arena_ptr arena,
+                        size_t block_size,
+                        allocator_ptr allocator);
+
+/**
+ * @brief Allocate memory from the arena.
+ * @details The memory is aligned to ARENA_ALIGNMENT bytes.
+ *
+ * @param arena pointer to the arena
+ * @param size the number of bytes to allocate
+ *
+ * @return pointer to the memory, or NULL if memory could not be allocated
+ */
+void * arena_alloc(arena_ptr arena, size_t size);
+
+/**
+ * @brief Get the current position of the arena.
+ *
+ * @param arena pointer to the arena
+ *
+ * @return a mark that the arena can later be rewound to
+ */
+arena_mark_t arena_mark(arena_ptr arena);
+
+/**
+ * @brief Rewind the arena to a previous position.
+ * @details Everything allocated after the mark was taken is given back at
+ *          once. This does not release any block.
+ *
+ * @param arena pointer to the arena
+ * @param mark a mark taken from this arena
+ */
+void arena_rewind(arena_ptr arena, arena_mark_t mark);
+
+/**
+ * @brief Give back everything allocated from the arena.
+ * @details This does not release any block.
+ *
+ * @param arena pointer to the arena
+ */
+void arena_reset(arena_ptr arena);
+
+/**
+ * @brief Get an allocator that allocates from the arena.
+ * @details Freeing through the allocator does nothing, the memory is given
+ *          back when the arena is reset or rewound.
+ *
+ * @param arena pointer to the arena
+ *
+ * @return an allocator backed by the arena
+ */
+allocator_t arena_allocator(arena_ptr arena);
+
+/**
+ * @brief Release the memory used by the arena.
+ * @details If the arena was allocated on the heap, it must be de-allocated
+ *          manually.
+ *
+ * @param arena pointer to the arena
+ *
+ * @return ARENA_ERROR_OK on success,
+ *         ARENA_ERROR_NULL_POINTER_RECEIVED if arena is a NULL pointer
+ */
+arena_error_t arena_free(arena_ptr arena);
+
+#endif //UNILIB_ARENA_H
@@ -0,0 +1,251 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "config.h"
+#include "dequeue.h"
+#include "notify.h"
+
+#ifndef UNILIB_BQUEUE_H
+#define UNILIB_BQUEUE_H
+
+/**
+ * Timeout that makes the blocking functions wait for as long as it takes.
+ */
+#define BQUEUE_WAIT_FOREVER ((int64_t) -1)
+
+/**
+ * Error type return by bqueue functions.
+ */
+typedef uint8_t bqueue_error_t;
+
+/**
+ * No error.
+ */
+#define BQUEUE_ERROR_OK                    ((bqueue_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define BQUEUE_ERROR_NULL_POINTER_RECEIVED ((bqueue_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define BQUEUE_ERROR_ALLOC_FAILED          ((bqueue_error_t) 2)
+/**
+ * The queue cannot be created with a capacity of 0.
+ */
+#define BQUEUE_ERROR_CAPACITY_TOO_SMALL    ((bqueue_error_t) 3)
+/**
+ * The timeout expired before the queue had room or items.
+ */
+#define BQUEUE_ERROR_TIMEOUT               ((bqueue_error_t) 4)
+/**
+ * The queue was closed: nothing can be pushed any more, and every item has
+ * already been popped.
+ */
+#define BQUEUE_ERROR_CLOSED                ((bqueue_error_t) 5)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define BQUEUE_ERROR_IS_OK(err) (err == BQUEUE_ERROR_OK)
+
+/**
+ * @struct bqueue
+ * @brief A bounded, blocking, multi-producer multi-consumer queue.
+ * @details The elements are copied into a dequeue ring guarded by a lock.
+ *          Producers block while the queue is full and consumers while it is
+ *          empty. Waiting threads spin for a short while, then park on a
+ *          futex word, which is only bumped and woken when someone is
+ *          actually waiting; a push wakes one consumer and a pop of `n`
+ *          items wakes at most `n` producers, so there is no thundering
+ *          herd. The lock is a futex word as well, and on systems without
+ *          futexes parked threads yield and poll instead.
+ */
+typedef struct bqueue_t {
+    // the elements, stored inline in a ring that never grows
+    dequeue_t ring;
+    // the most items the queue holds
+    size_t capacity;
+    // consumers waiting for items and not woken yet, guarded by the lock
+    size_t pop_waiters;
+    // producers waiting for room and not woken yet, guarded by the lock
+    size_t push_waiters;
+    // set once the queue is closed, guarded by the lock
+    bool closed;
+    char pad_lock[UNILIB_CACHE_LINE_SIZE];
+    // 0 when unlocked, 1 when locked, 2 when locked with threads parked on it
+    atomic_uint lock;
+    char pad_not_empty[UNILIB_CACHE_LINE_SIZE];
+    // bumped when items are pushed while consumers wait
+    atomic_uint not_empty;
+    char pad_not_full[UNILIB_CACHE_LINE_SIZE];
+    // bumped when items are popped while producers wait
+    atomic_uint not_full;
+    char pad_end[UNILIB_CACHE_LINE_SIZE];
+} bqueue_t;
+
+/**
+ * @brief Pointer to a blocking queue.
+ */
+typedef bqueue_t * bqueue_ptr;
+
+/**
+ * @brief Create a new blocking queue.
+ *
+ * @param bqueue address to the queue that should be created
+ * @param capacity the most items the queue holds, at least 1
+ * @param element_size the size of an element
+ * @param allocator pointer to the allocator the ring is allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue is a NULL pointer,
+ *         BQUEUE_ERROR_CAPACITY_TOO_SMALL if capacity is 0,
+ *         BQUEUE_ERROR_ALLOC_FAILED if the queue failed to allocate
+ */
+bqueue_error_t bqueue_new(bqueue_ptr bqueue,
+                          size_t capacity,
+                          size_t element_size,
+                          allocator_ptr allocator);
+
+/**
+ * @brief Push an item at the back of the queue, waiting for room.
+ * @details The element is copied into the queue. Any number of threads may
+ *          push at the same time.
+ *
+ * @param bqueue pointer to the queue
+ * @param elem the element to be copied into the queue
+ * @param timeout_ns how long to wait for room, in nanoseconds: 0 to give up
+ *        straight away, or BQUEUE_WAIT_FOREVER
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue or elem is a NULL
+ *         pointer,
+ *         BQUEUE_ERROR_TIMEOUT if the queue stayed full until the timeout,
+ *         BQUEUE_ERROR_CLOSED if the queue is closed
+ */
+bqueue_error_t bqueue_push(bqueue_ptr bqueue,
+                           const void * elem,
+                           int64_t timeout_ns);
+
+/**
+ * @brief Pop an item from the front of the queue, waiting for one.
+ * @details Any number of threads may pop at the same time. Items pushed
+ *          before the queue was closed can still be popped after.
+ *
+ * @param bqueue pointer to the queue
+ * @param dst address the element is copied to
+ * @param timeout_ns how long to wait for an item, in nanoseconds: 0 to give
+ *        up straight away, or BQUEUE_WAIT_FOREVER
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue or dst is a NULL
+ *         pointer,
+ *         BQUEUE_ERROR_TIMEOUT if the queue stayed empty until the timeout,
+ *         BQUEUE_ERROR_CLOSED if the queue is closed and empty
+ */
+bqueue_error_t bqueue_pop(bqueue_ptr bqueue, void * dst, int64_t timeout_ns);
+
+/**
+ * @brief Pop up to `n` items from the front of the queue, waiting for at
+ *        least one.
+ * @details Everything available, up to `n` items, is taken under a single
+ *          acquisition of the lock, so a consumer pays for one wakeup per
+ *          batch rather than one per item.
+ *
+ * @param bqueue pointer to the queue
+ * @param dst buffer for at least `n` packed elements
+ * @param n the maximum number of items to pop; nothing is popped or waited
+ *        for if it is 0
+ * @param popped address the number of popped items is written to, or NULL
+ * @param timeout_ns how long to wait for an item, in nanoseconds: 0 to give
+ *        up straight away, or BQUEUE_WAIT_FOREVER
+ *
+ * @return the same errors as bqueue_pop
+ */
+bqueue_error_t bqueue_pop_batch(bqueue_ptr bqueue,
+                                void * dst,
+                                size_t n,
+                                size_t * popped,
+                                int64_t timeout_ns);
+
+/**
+ * @brief Close the queue.
+ * @details Wakes every waiting thread. Pushes fail from then on, while pops
+ *          keep succeeding until the queue is empty.
+ *
+ * @param bqueue pointer to the queue
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue is a NULL pointer
+ */
+bqueue_error_t bqueue_close(bqueue_ptr bqueue);
+
+/**
+ * @brief Signal a notifier whenever a push finds the queue empty, and when
+ *        the queue is closed.
+ * @details This lets an event loop wait for items on the descriptor of the
+ *          notifier and pop them with a timeout of 0, following the protocol
+ *          described in notify_t. The notifier is signalled right away if
+ *          the queue already holds items or is closed, and it must outlive
+ *          the queue.
+ * @see notify_t
+ *
+ * @param bqueue pointer to the queue
+ * @param notify pointer to the notifier, or NULL to stop signalling
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue is a NULL pointer
+ */
+bqueue_error_t bqueue_set_notify(bqueue_ptr bqueue, notify_ptr notify);
+
+/**
+ * @brief Get the number of items in the queue.
+ * @details The result is only a snapshot if the queue is being used by other
+ *          threads.
+ *
+ * @param bqueue pointer to the queue
+ *
+ * @return the number of items in the queue, or 0 if bqueue is a NULL pointer
+ */
+size_t bqueue_len(bqueue_ptr bqueue);
+
+/**
+ * @brief Release the memory used by the queue.
+ * @details No thread may be using the queue any more. If the queue was
+ *          allocated on the heap, it must be de-allocated manually.
+ *
+ * @param bqueue pointer to the queue
+ *
+ * @return BQUEUE_ERROR_OK on success,
+ *         BQUEUE_ERROR_NULL_POINTER_RECEIVED if bqueue is a NULL pointer
+ */
+bqueue_error_t bqueue_free(bqueue_ptr bqueue);
+
+#endif //UNILIB_BQUEUE_H
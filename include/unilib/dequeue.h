@@ -21,9 +21,17 @@
  * SOFTWARE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "alloc.h"
+#include "arena.h"
+#include "iter.h"
+#include "notify.h"
+#include "pool.h"
+#include "simd.h"
+
 #ifndef UNILIB_DEQUEUE_H
 #define UNILIB_DEQUEUE_H
 
@@ -32,6 +40,22 @@
  */
 #define DEQUEUE_DEFAULT_CAPACITY 1
 
+/**
+ * @brief Default factor by which a full dequeue grows its capacity.
+ */
+#define DEQUEUE_DEFAULT_GROWTH_FACTOR 2.0
+
+/**
+ * @brief Maximum capacity value meaning that the dequeue can grow unbounded.
+ */
+#define DEQUEUE_UNBOUNDED_CAPACITY 0
+
+/**
+ * @brief Size of the header of a snapshot file, which keeps the elements of a
+ *        mapped snapshot aligned to 64 bytes.
+ */
+#define DEQUEUE_SNAPSHOT_HEADER_SIZE 64
+
 /**
  * Error type return by dequeue functions.
  */
@@ -53,25 +77,116 @@ typedef uint8_t dequeue_error_t;
  * The dequeue cannot be resized to a capacity of 0.
  */
 #define DEQUEUE_ERROR_ZERO_CAPACITY_RESIZE  ((dequeue_error_t) 3)
+/**
+ * The growth factor of the dequeue must be greater than 1.
+ */
+#define DEQUEUE_ERROR_INVALID_GROWTH_FACTOR ((dequeue_error_t) 4)
+/**
+ * The dequeue cannot grow past its maximum capacity.
+ */
+#define DEQUEUE_ERROR_CAPACITY_EXCEEDED     ((dequeue_error_t) 5)
+/**
+ * There are no items in the dequeue.
+ */
+#define DEQUEUE_ERROR_EMPTY                 ((dequeue_error_t) 6)
+/**
+ * The operation requires the dequeue to be empty.
+ */
+#define DEQUEUE_ERROR_NOT_EMPTY             ((dequeue_error_t) 7)
+/**
+ * The elements are not stored inline or do not have the expected size.
+ */
+#define DEQUEUE_ERROR_ELEMENT_MISMATCH      ((dequeue_error_t) 8)
+/**
+ * A system call on a snapshot file failed; errno tells why.
+ */
+#define DEQUEUE_ERROR_IO                    ((dequeue_error_t) 9)
+/**
+ * The file is not a snapshot written by dequeue_save, is truncated, or does
+ * not match its checksum.
+ */
+#define DEQUEUE_ERROR_BAD_SNAPSHOT          ((dequeue_error_t) 10)
 
 /**
  * Check whether the result of a function is okay or not.
  */
 #define DEQUEUE_ERROR_IS_OK(err) (err == DEQUEUE_ERROR_OK)
 
+/**
+ * How the elements of a dequeue are stored.
+ */
+typedef enum dequeue_storage_t {
+    // the ring holds pointers to elements allocated separately
+    DEQUEUE_STORAGE_POINTERS = 0,
+    // the ring holds the elements themselves, packed one after the other
+    DEQUEUE_STORAGE_INLINE = 1,
+} dequeue_storage_t;
+
+/**
+ * Compare two elements of a dequeue, as with qsort.
+ * The elements are passed as returned by dequeue_get: the element pointers,
+ * or the addresses of the elements if they are stored inline.
+ * Must return a negative value if the first element orders before the
+ * second, 0 if they are equivalent, and a positive value otherwise.
+ */
+typedef int (* dequeue_compare_ptr)(const void *, const void *);
+
+/**
+ * How the inline elements of a dequeue are read as integer keys by
+ * dequeue_radix_sort.
+ */
+typedef enum dequeue_key_t {
+    // the elements are unsigned integers
+    DEQUEUE_KEY_UNSIGNED = 0,
+    // the elements are two's complement signed integers
+    DEQUEUE_KEY_SIGNED = 1,
+} dequeue_key_t;
+
 /**
  * @struct dequeue
  * @brief A generic dequeue.
+ * @details The elements are kept in a circular ring: the front of the dequeue
+ *          lives at `elements[head]` and the following items wrap around the
+ *          end of the ring, so pushing and popping at either end never moves
+ *          the other elements.
+ *          With DEQUEUE_STORAGE_INLINE, `elements` is a packed buffer of
+ *          `capacity * element_size` bytes rather than an array of pointers.
  */
 typedef struct dequeue_t {
-    // inner list of elements
+    // inner ring of elements
     void ** elements;
+    // how the elements are stored in the ring
+    dequeue_storage_t storage;
+    // the index of the first element in the ring
+    size_t head;
     // the length of the dequeue
     size_t len;
     // the capacity of the dequeue (NOT THE SAME AS LENGTH!)
     size_t capacity;
     // the size of an element
     size_t element_size;
+    // the factor by which the capacity grows when the dequeue is full
+    double growth_factor;
+    // the capacity the dequeue may not grow past, or
+    // DEQUEUE_UNBOUNDED_CAPACITY
+    size_t max_capacity;
+    // the allocator used for the ring and for the elements
+    allocator_t allocator;
+    // the arena element copies are taken from, or NULL
+    arena_ptr arena;
+    // the position of the arena when it was attached to the dequeue
+    arena_mark_t arena_mark;
+    // the pool owned by the dequeue that element copies are taken from, or
+    // NULL
+    pool_ptr pool;
+    // the notifier signalled when a push makes the dequeue non-empty, or
+    // NULL
+    notify_ptr notify;
+    // the snapshot file mapping the ring lives in, or NULL if the ring comes
+    // from the allocator
+    void * mapping;
+    // the size of the mapping
+    size_t mapping_size;
 } dequeue_t;
 
 /**
@@ -145,8 +260,117 @@ dequeue_error_t dequeue_new_ptr_with_capacity(dequeue_ptr * dequeue,
                                               size_t capacity,
                                               size_t element_size);
 
+/**
+ * @brief Create a new dequeue.
+ * @details This creates a new dequeue with the specified capacity, element
+ *          size and storage mode. With DEQUEUE_STORAGE_INLINE, the elements
+ *          are copied into one contiguous buffer instead of being allocated
+ *          one by one, which suits small, plain-data elements.
+ * @see dequeue_storage_t
+ *
+ * @param dequeue address to return value
+ * @param capacity the capacity of the dequeue
+ * @param element_size the size of an element in the dequeue
+ * @param storage how the elements are stored
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate
+ */
+dequeue_error_t dequeue_new_with_storage(dequeue_ptr dequeue,
+                                         size_t capacity,
+                                         size_t element_size,
+                                         dequeue_storage_t storage);
+
+/**
+ * @brief Create a new dequeue.
+ * @details This creates a new dequeue with the specified capacity, element
+ *          size and storage mode. This function is used for allocating the
+ *          dequeue entirely on the heap.
+ * @see dequeue_new_with_storage
+ *
+ * @param dequeue address to return value
+ * @param capacity the capacity of the dequeue
+ * @param element_size the size of an element in the dequeue
+ * @param storage how the elements are stored
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate
+ */
+dequeue_error_t dequeue_new_ptr_with_storage(dequeue_ptr * dequeue,
+                                             size_t capacity,
+                                             size_t element_size,
+                                             dequeue_storage_t storage);
+
+/**
+ * @brief Create a new dequeue.
+ * @details This creates a new dequeue with the specified capacity, element
+ *          size and storage mode, which allocates its ring and its element
+ *          copies from the given allocator. Elements pushed without copying
+ *          must have been allocated from the same allocator, since the dequeue
+ *          releases them through it.
+ * @see allocator_t
+ *
+ * @param dequeue address to return value
+ * @param capacity the capacity of the dequeue
+ * @param element_size the size of an element in the dequeue
+ * @param storage how the elements are stored
+ * @param allocator pointer to the allocator, or NULL for the default
+ *        allocator; the allocator is copied into the dequeue
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate
+ */
+dequeue_error_t dequeue_new_with_allocator(dequeue_ptr dequeue,
+                                           size_t capacity,
+                                           size_t element_size,
+                                           dequeue_storage_t storage,
+                                           allocator_ptr allocator);
+
+/**
+ * @brief Create a new dequeue.
+ * @details This creates a new dequeue with the specified capacity, element
+ *          size, storage mode and allocator. The dequeue itself is also
+ *          allocated from the allocator, so it must be released with
+ *          allocator_free after calling dequeue_free.
+ * @see dequeue_new_with_allocator
+ *
+ * @param dequeue address to return value
+ * @param capacity the capacity of the dequeue
+ * @param element_size the size of an element in the dequeue
+ * @param storage how the elements are stored
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate
+ */
+dequeue_error_t dequeue_new_ptr_with_allocator(dequeue_ptr * dequeue,
+                                               size_t capacity,
+                                               size_t element_size,
+                                               dequeue_storage_t storage,
+                                               allocator_ptr allocator);
+
+/**
+ * @brief Get the element at a position in the dequeue.
+ * @details With DEQUEUE_STORAGE_INLINE, the returned pointer points into the
+ *          dequeue and is only valid until the dequeue is modified.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param pos the position of the element, 0 being the front of the dequeue
+ *
+ * @return pointer to the element on success,
+ *         NULL if dequeue is a NULL pointer,
+ *         NULL if pos is out of bounds
+ */
+void * dequeue_get(dequeue_ptr dequeue, size_t pos);
+
 /**
  * @brief Get the first element in the dequeue.
+ * @details With DEQUEUE_STORAGE_INLINE, the returned pointer points into the
+ *          dequeue and is only valid until the dequeue is modified.
  *
  * @param dequeue pointer to the dequeue
  *
@@ -159,6 +383,8 @@ void * dequeue_front(dequeue_ptr dequeue);
 /**
  * @brief Push an item at the front of the dequeue.
  * @details This function assumes ownership of the data pointed by elem.
+ *          With DEQUEUE_STORAGE_INLINE, the element is copied into the
+ *          dequeue instead and ownership stays with the caller.
  * @see dequeue_push_front_copy
  *
  * @param dequeue pointer to the dequeue
@@ -168,7 +394,9 @@ void * dequeue_front(dequeue_ptr dequeue);
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if elem is a NULL pointer,
  *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate more
- *         memory for the new item
+ *         memory for the new item,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the dequeue is full and already
+ *         at its maximum capacity
  */
 dequeue_error_t dequeue_push_front(dequeue_ptr dequeue, void * elem);
 
@@ -186,7 +414,9 @@ dequeue_error_t dequeue_push_front(dequeue_ptr dequeue, void * elem);
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if elem is a NULL pointer,
  *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate more
- *         memory for the new item
+ *         memory for the new item,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the dequeue is full and already
+ *         at its maximum capacity
  */
 dequeue_error_t dequeue_push_front_copy(dequeue_ptr dequeue, void * elem);
 
@@ -194,18 +424,37 @@ dequeue_error_t dequeue_push_front_copy(dequeue_ptr dequeue, void * elem);
  * @brief Pop an item from the front of the dequeue.
  * @details This function does not decrease the capacity of the dequeue.
  *          The dequeue gives up ownership over the memory of the element, so it
- *          should be deallocated when no longer used.
+ *          should be deallocated with dequeue_element_free when no longer
+ *          used.
  *
  * @param dequeue pointer to the dequeue
  *
  * @return pointer to the element removed from the dequeue on success,
  *         NULL if dequeue is a NULL pointer,
- *         NULL if there are no items in the dequeue
+ *         NULL if there are no items in the dequeue,
+ *         NULL if the elements are stored inline (use dequeue_pop_front_into)
  */
 void * dequeue_pop_front(dequeue_ptr dequeue);
 
+/**
+ * @brief Pop an item from the front of the dequeue into a buffer.
+ * @details The element is copied into dst. If the dequeue holds pointers to
+ *          elements, the memory of the popped element is deallocated.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param dst buffer of at least element_size bytes
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dst is a NULL pointer,
+ *         DEQUEUE_ERROR_EMPTY if there are no items in the dequeue
+ */
+dequeue_error_t dequeue_pop_front_into(dequeue_ptr dequeue, void * dst);
+
 /**
  * @brief Get the last element in the dequeue.
+ * @details With DEQUEUE_STORAGE_INLINE, the returned pointer points into the
+ *          dequeue and is only valid until the dequeue is modified.
  *
  * @param dequeue pointer to the dequeue
  *
@@ -218,6 +467,8 @@ void * dequeue_back(dequeue_ptr dequeue);
 /**
  * @brief Push an item at the back of the dequeue.
  * @details This function assumes ownership of the data pointed by elem.
+ *          With DEQUEUE_STORAGE_INLINE, the element is copied into the
+ *          dequeue instead and ownership stays with the caller.
  * @see dequeue_push_back_copy
  *
  * @param dequeue pointer to the dequeue
@@ -227,7 +478,9 @@ void * dequeue_back(dequeue_ptr dequeue);
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if elem is a NULL pointer,
  *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate more
- *         memory for the new item
+ *         memory for the new item,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the dequeue is full and already
+ *         at its maximum capacity
  */
 dequeue_error_t dequeue_push_back(dequeue_ptr dequeue, void * elem);
 
@@ -245,7 +498,9 @@ dequeue_error_t dequeue_push_back(dequeue_ptr dequeue, void * elem);
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if elem is a NULL pointer,
  *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to allocate more
- *         memory for the new item
+ *         memory for the new item,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the dequeue is full and already
+ *         at its maximum capacity
  */
 dequeue_error_t dequeue_push_back_copy(dequeue_ptr dequeue, void * elem);
 
@@ -253,16 +508,223 @@ dequeue_error_t dequeue_push_back_copy(dequeue_ptr dequeue, void * elem);
  * @brief Pop an item from the back of the dequeue.
  * @details This function does not decrease the capacity of the dequeue.
  *          The dequeue gives up ownership over the memory of the element, so it
- *          should be deallocated when no longer used.
+ *          should be deallocated with dequeue_element_free when no longer
+ *          used.
  *
  * @param dequeue pointer to the dequeue
  *
  * @return pointer to the element removed from the dequeue on success,
  *         NULL if dequeue is a NULL pointer,
- *         NULL if there are no items in the dequeue
+ *         NULL if there are no items in the dequeue,
+ *         NULL if the elements are stored inline (use dequeue_pop_back_into)
  */
 void * dequeue_pop_back(dequeue_ptr dequeue);
 
+/**
+ * @brief Pop an item from the back of the dequeue into a buffer.
+ * @details The element is copied into dst. If the dequeue holds pointers to
+ *          elements, the memory of the popped element is deallocated.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param dst buffer of at least element_size bytes
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dst is a NULL pointer,
+ *         DEQUEUE_ERROR_EMPTY if there are no items in the dequeue
+ */
+dequeue_error_t dequeue_pop_back_into(dequeue_ptr dequeue, void * dst);
+
+/**
+ * @brief Push several items at the back of the dequeue.
+ * @details The capacity is reserved once and the slots are filled with one
+ *          copy per contiguous run of the ring. With pointer storage, `elems`
+ *          is an array of element pointers whose ownership moves to the
+ *          dequeue; with inline storage, it is a packed array of elements.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param elems the array of items, in front to back order
+ * @param n the number of items
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if elems is a NULL pointer and
+ *         n is not 0, or if one of the element pointers is NULL with
+ *         pointer storage, in which case nothing is pushed,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the dequeue failed to grow,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the items do not fit in the
+ *         maximum capacity of the dequeue
+ */
+dequeue_error_t dequeue_push_back_n(dequeue_ptr dequeue,
+                                    const void * elems,
+                                    size_t n);
+
+/**
+ * @brief Push several items at the front of the dequeue.
+ * @details The items keep their order: `elems[0]` becomes the front element.
+ * @see dequeue_push_back_n
+ *
+ * @param dequeue pointer to the dequeue
+ * @param elems the array of items, in front to back order
+ * @param n the number of items
+ *
+ * @return the same errors as dequeue_push_back_n
+ */
+dequeue_error_t dequeue_push_front_n(dequeue_ptr dequeue,
+                                     const void * elems,
+                                     size_t n);
+
+/**
+ * @brief Copy several elements at the back of the dequeue.
+ * @details `elems` is a packed array of elements in both storage modes. With
+ *          pointer storage, every element is copied into memory owned by the
+ *          dequeue, as with dequeue_push_back_copy; if one of the copies fails
+ *          to allocate, nothing is pushed.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param elems the packed array of elements, in front to back order
+ * @param n the number of elements
+ *
+ * @return the same errors as dequeue_push_back_n
+ */
+dequeue_error_t dequeue_push_back_copy_n(dequeue_ptr dequeue,
+                                         const void * elems,
+                                         size_t n);
+
+/**
+ * @brief Pop several items from the front of the dequeue.
+ * @details Up to `n` items are copied into dst with one copy per contiguous
+ *          run of the ring. With pointer storage, dst receives the element
+ *          pointers and their ownership, as with dequeue_pop_front; with
+ *          inline storage, it receives the packed elements.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param dst buffer for at least `n` items
+ * @param n the maximum number of items to pop
+ * @param popped address the number of popped items is written to, or NULL
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dst is a NULL pointer and n
+ *         is not 0
+ */
+dequeue_error_t dequeue_pop_front_n(dequeue_ptr dequeue,
+                                    void * dst,
+                                    size_t n,
+                                    size_t * popped);
+
+/**
+ * @brief Pop several items from the back of the dequeue.
+ * @details The items are written in front to back order, so dst holds what
+ *          was the tail of the dequeue.
+ * @see dequeue_pop_front_n
+ *
+ * @param dequeue pointer to the dequeue
+ * @param dst buffer for at least `n` items
+ * @param n the maximum number of items to pop
+ * @param popped address the number of popped items is written to, or NULL
+ *
+ * @return the same errors as dequeue_pop_front_n
+ */
+dequeue_error_t dequeue_pop_back_n(dequeue_ptr dequeue,
+                                   void * dst,
+                                   size_t n,
+                                   size_t * popped);
+
+/**
+ * @brief Copy every element of an iterator at the back of the dequeue.
+ * @details Room for the lower bound of the size hint of the iterator is
+ *          reserved upfront, and the elements are pulled in spans. Each
+ *          element is copied as with dequeue_push_back_copy. On error, the
+ *          elements pushed so far stay in the dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param iter pointer to the iterator
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or iter is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the elements do not fit in the
+ *         maximum capacity of the dequeue
+ */
+dequeue_error_t dequeue_extend(dequeue_ptr dequeue, iter_ptr iter);
+
+/**
+ * @brief Take the element copies of the dequeue from an arena.
+ * @details Elements pushed with the `_copy` functions are then bump-allocated
+ *          from the arena, and emptying or freeing the dequeue rewinds the
+ *          arena to where it was when it was attached, instead of releasing
+ *          the elements one by one. Elements pushed without copying must have
+ *          been allocated from the arena as well. Popped elements stay valid
+ *          until the dequeue is emptied or freed, and anything else allocated
+ *          from the arena after it was attached is given back along with them.
+ *          The arena must outlive the dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param arena pointer to the arena, or NULL to go back to the allocator of
+ *        the dequeue
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_NOT_EMPTY if there are items in the dequeue
+ */
+dequeue_error_t dequeue_set_arena(dequeue_ptr dequeue, arena_ptr arena);
+
+/**
+ * @brief Take the element copies of the dequeue from a pool of its own.
+ * @details The dequeue creates a pool of `element_size` objects, allocating
+ *          its slabs from the allocator of the dequeue, and takes the element
+ *          copies from it. Elements pushed without copying must have been
+ *          allocated from the pool as well. Popped elements should be given
+ *          back with dequeue_element_free, which recycles them for the next
+ *          pushes. They become invalid once the dequeue is freed. While an
+ *          arena is attached to the dequeue, the arena takes precedence.
+ * @see pool_t
+ *
+ * @param dequeue pointer to the dequeue
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the pool failed to allocate,
+ *         DEQUEUE_ERROR_NOT_EMPTY if there are items in the dequeue
+ */
+dequeue_error_t dequeue_use_pool(dequeue_ptr dequeue);
+
+/**
+ * @brief Signal a notifier whenever a push makes the dequeue non-empty.
+ * @details This lets an event loop wait for items on the descriptor of the
+ *          notifier instead of polling the dequeue. Every push function
+ *          signals it on the empty to non-empty transition only; pushes onto
+ *          a dequeue that already holds items cost nothing extra. If the
+ *          dequeue is shared between threads, it must be pushed to and
+ *          drained under the same lock, and the consumer must follow the
+ *          protocol described in notify_t. The notifier is signalled right
+ *          away if the dequeue already holds items, and it must outlive the
+ *          dequeue.
+ * @see notify_t
+ *
+ * @param dequeue pointer to the dequeue
+ * @param notify pointer to the notifier, or NULL to stop signalling
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer
+ */
+dequeue_error_t dequeue_set_notify(dequeue_ptr dequeue, notify_ptr notify);
+
+/**
+ * @brief Release an element popped from the dequeue.
+ * @details The element is released through the allocator of the dequeue, so
+ *          this should be used instead of free when the dequeue does not use
+ *          the default allocator. If the dequeue uses a pool, the element is
+ *          given back to the pool. This does nothing if the dequeue takes its
+ *          elements from an arena.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param elem the element to release, can be NULL
+ */
+void dequeue_element_free(dequeue_ptr dequeue, void * elem);
+
 /**
  * Resize a dequeue for the specified capacity.
  * @details Capacity must be at least 1.
@@ -279,8 +741,63 @@ void * dequeue_pop_back(dequeue_ptr dequeue);
  */
 dequeue_error_t dequeue_resize(dequeue_ptr dequeue, size_t capacity);
 
+/**
+ * @brief Configure how a full dequeue grows.
+ * @details When an item is pushed into a full dequeue, its capacity is
+ *          multiplied by the growth factor (at least one slot is always added)
+ *          and then clamped to the maximum capacity. Growing the capacity
+ *          geometrically makes filling a dequeue with N items take O(log N)
+ *          reallocations.
+ * @see DEQUEUE_DEFAULT_GROWTH_FACTOR
+ * @see DEQUEUE_UNBOUNDED_CAPACITY
+ *
+ * @param dequeue pointer to the dequeue
+ * @param growth_factor the factor by which the capacity grows, must be
+ *        greater than 1
+ * @param max_capacity the capacity the dequeue may not grow past, or
+ *        DEQUEUE_UNBOUNDED_CAPACITY
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_INVALID_GROWTH_FACTOR if growth_factor is not greater
+ *         than 1
+ */
+dequeue_error_t dequeue_set_growth(dequeue_ptr dequeue,
+                                   double growth_factor,
+                                   size_t max_capacity);
+
+/**
+ * @brief Reserve capacity for at least `additional` more items.
+ * @details Pushing up to `additional` items after this call will not
+ *          reallocate the dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param additional the number of items to reserve capacity for
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the required capacity is larger
+ *         than the maximum capacity of the dequeue
+ */
+dequeue_error_t dequeue_reserve(dequeue_ptr dequeue, size_t additional);
+
+/**
+ * @brief Shrink the capacity of the dequeue to its length.
+ * @details The capacity never drops below 1. No element is deallocated.
+ *
+ * @param dequeue pointer to the dequeue
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated
+ */
+dequeue_error_t dequeue_shrink_to_fit(dequeue_ptr dequeue);
+
 /**
  * @brief Empty a dequeue.
+ * @details The elements in the dequeue are deallocated. This function does
+ *          not decrease the capacity of the dequeue.
  *
  * @param dequeue pointer to the dequeue
  *
@@ -301,4 +818,377 @@ dequeue_error_t dequeue_empty(dequeue_ptr dequeue);
  */
 dequeue_error_t dequeue_free(dequeue_ptr dequeue);
 
+/**
+ * @brief Write the elements of a dequeue to a snapshot file.
+ * @details The file starts with a header of DEQUEUE_SNAPSHOT_HEADER_SIZE
+ *          bytes holding a magic number, a format version, the element size,
+ *          the length and a 64-bit checksum of the elements, followed by the
+ *          elements packed in order from the front, in the byte order of the
+ *          machine. With pointer storage, the elements pointed to are
+ *          written. An existing file is overwritten; the file is not synced
+ *          to disk.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param path the path of the file
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or path is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_IO if the file could not be written
+ */
+dequeue_error_t dequeue_save(dequeue_ptr dequeue, const char * path);
+
+/**
+ * @brief Create a dequeue from a snapshot file, copying its elements.
+ * @details The dequeue stores its elements inline, uses the default
+ *          allocator and has the length of the snapshot as capacity. The
+ *          checksum is always verified.
+ *
+ * @param dequeue address to the dequeue that should be created
+ * @param path the path of a file written by dequeue_save
+ * @param element_size the size of an element, which must match the one of
+ *        the snapshot
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or path is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_IO if the file could not be read,
+ *         DEQUEUE_ERROR_BAD_SNAPSHOT if the file is not a valid snapshot,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the element sizes differ,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the ring could not be allocated
+ */
+dequeue_error_t dequeue_load(dequeue_ptr dequeue,
+                             const char * path,
+                             size_t element_size);
+
+/**
+ * @brief Create a dequeue that serves its elements from a snapshot file
+ *        mapped in memory.
+ * @details The file is mapped privately and the ring of the dequeue points
+ *          right past the header, so nothing is copied and pages are only
+ *          read from disk as the elements are accessed. Writes to the ring
+ *          stay private to the process and never reach the file. The first
+ *          time the ring is resized, the elements are copied into a ring
+ *          taken from the default allocator and the file is unmapped;
+ *          otherwise it is unmapped by dequeue_free. The file may be removed
+ *          or replaced as soon as this returns, but must not be truncated
+ *          while mapped.
+ *
+ *          Verifying the checksum reads the whole file, which takes away
+ *          most of the benefit of mapping it; without it, only the header
+ *          and the file size are checked.
+ *
+ * @param dequeue address to the dequeue that should be created
+ * @param path the path of a file written by dequeue_save
+ * @param element_size the size of an element, which must match the one of
+ *        the snapshot
+ * @param verify whether to verify the checksum of the elements
+ *
+ * @return the same errors as dequeue_load
+ */
+dequeue_error_t dequeue_load_mapped(dequeue_ptr dequeue,
+                                    const char * path,
+                                    size_t element_size,
+                                    bool verify);
+
+/**
+ * @struct dequeue_iter
+ * @brief The state of an iterator over a dequeue.
+ */
+typedef struct dequeue_iter_t {
+    // the dequeue being iterated
+    dequeue_ptr dequeue;
+    // the position of the next element taken from the front
+    size_t front;
+    // the position past the next element taken from the back
+    size_t back;
+} dequeue_iter_t;
+
+/**
+ * @brief Pointer to the state of an iterator over a dequeue.
+ */
+typedef dequeue_iter_t * dequeue_iter_ptr;
+
+/**
+ * @brief Create an iterator over the elements of a dequeue, front to back.
+ * @details The state of the iterator lives in `state`, usually on the stack
+ *          of the caller, so nothing is allocated and the iterator needs no
+ *          freeing. The iterator is double-ended, knows its exact length, skips
+ *          in constant time and hands out batches; with pointer storage, it
+ *          lends spans of the ring itself. The dequeue must not be modified
+ *          while the iterator is in use.
+ *
+ * @param dequeue pointer to the dequeue, or NULL for an empty iterator
+ * @param state the state of the iterator, which must outlive it
+ *
+ * @return a new iterator
+ */
+iter_t dequeue_iter(dequeue_ptr dequeue, dequeue_iter_ptr state);
+
+/**
+ * @brief Create an iterator over the elements of a dequeue, back to front.
+ * @see dequeue_iter
+ *
+ * @param dequeue pointer to the dequeue, or NULL for an empty iterator
+ * @param state the state of the iterator, which must outlive it
+ *
+ * @return a new iterator
+ */
+iter_t dequeue_iter_rev(dequeue_ptr dequeue, dequeue_iter_ptr state);
+
+/**
+ * @brief Sum the int32_t elements of a dequeue.
+ * @details The dequeue must store its elements inline. The two contiguous
+ *          segments of the ring are handed to the SIMD kernels of the
+ *          running CPU.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param sum where to store the sum, 0 for an empty dequeue
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or sum is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the elements are not stored inline
+ *         or are not the size of an int32_t
+ */
+dequeue_error_t dequeue_sum_i32(dequeue_ptr dequeue, int64_t * sum);
+
+/**
+ * @see dequeue_sum_i32
+ */
+dequeue_error_t dequeue_sum_i64(dequeue_ptr dequeue, int64_t * sum);
+
+/**
+ * @see dequeue_sum_i32
+ */
+dequeue_error_t dequeue_sum_f32(dequeue_ptr dequeue, float * sum);
+
+/**
+ * @see dequeue_sum_i32
+ */
+dequeue_error_t dequeue_sum_f64(dequeue_ptr dequeue, double * sum);
+
+/**
+ * @brief Find the smallest and the largest int32_t elements of a dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param min where to store the smallest element
+ * @param max where to store the largest element
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue, min or max is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the elements are not stored inline
+ *         or are not the size of an int32_t,
+ *         DEQUEUE_ERROR_EMPTY if there are no items in the dequeue
+ */
+dequeue_error_t dequeue_min_max_i32(dequeue_ptr dequeue,
+                                    int32_t * min,
+                                    int32_t * max);
+
+/**
+ * @see dequeue_min_max_i32
+ */
+dequeue_error_t dequeue_min_max_i64(dequeue_ptr dequeue,
+                                    int64_t * min,
+                                    int64_t * max);
+
+/**
+ * @see dequeue_min_max_i32
+ */
+dequeue_error_t dequeue_min_max_f32(dequeue_ptr dequeue,
+                                    float * min,
+                                    float * max);
+
+/**
+ * @see dequeue_min_max_i32
+ */
+dequeue_error_t dequeue_min_max_f64(dequeue_ptr dequeue,
+                                    double * min,
+                                    double * max);
+
+/**
+ * @brief Count the int32_t elements of a dequeue equal to a value.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param value the value to count
+ * @param count where to store the number of matching elements
+ *
+ * @return the same errors as dequeue_sum_i32
+ */
+dequeue_error_t dequeue_count_eq_i32(dequeue_ptr dequeue,
+                                     int32_t value,
+                                     size_t * count);
+
+/**
+ * @see dequeue_count_eq_i32
+ */
+dequeue_error_t dequeue_count_eq_i64(dequeue_ptr dequeue,
+                                     int64_t value,
+                                     size_t * count);
+
+/**
+ * @see dequeue_count_eq_i32
+ */
+dequeue_error_t dequeue_count_eq_f32(dequeue_ptr dequeue,
+                                     float value,
+                                     size_t * count);
+
+/**
+ * @see dequeue_count_eq_i32
+ */
+dequeue_error_t dequeue_count_eq_f64(dequeue_ptr dequeue,
+                                     double value,
+                                     size_t * count);
+
+/**
+ * @brief Find the first int32_t element of a dequeue equal to a value.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param value the value to look for
+ * @param pos where to store the position of the element from the front, or
+ *        the length of the dequeue if no element matches
+ *
+ * @return the same errors as dequeue_sum_i32
+ */
+dequeue_error_t dequeue_find_i32(dequeue_ptr dequeue,
+                                 int32_t value,
+                                 size_t * pos);
+
+/**
+ * @see dequeue_find_i32
+ */
+dequeue_error_t dequeue_find_i64(dequeue_ptr dequeue,
+                                 int64_t value,
+                                 size_t * pos);
+
+/**
+ * @see dequeue_find_i32
+ */
+dequeue_error_t dequeue_find_f32(dequeue_ptr dequeue,
+                                 float value,
+                                 size_t * pos);
+
+/**
+ * @see dequeue_find_i32
+ */
+dequeue_error_t dequeue_find_f64(dequeue_ptr dequeue,
+                                 double value,
+                                 size_t * pos);
+
+/**
+ * @brief Find the first byte of a dequeue of bytes equal to a value.
+ * @details The dequeue must store elements of one byte inline.
+ *
+ * @see dequeue_find_i32
+ */
+dequeue_error_t dequeue_find_byte(dequeue_ptr dequeue,
+                                  uint8_t byte,
+                                  size_t * pos);
+
+/**
+ * @brief Move the elements of a dequeue to the start of its ring.
+ * @details A wrapped ring is rotated in place with three reversals, so no
+ *          memory is allocated. Afterwards the elements fill the slots of the
+ *          ring in order from `elements`, and they keep doing so while items
+ *          are only pushed and popped at the back.
+ *
+ * @param dequeue pointer to the dequeue
+ *
+ * @return the address of the first slot of the ring, or NULL if dequeue is a
+ *         NULL pointer
+ */
+void * dequeue_make_contiguous(dequeue_ptr dequeue);
+
+/**
+ * @brief Sort the elements of a dequeue in place.
+ * @details An introsort: quicksort with median-of-three pivots, insertion
+ *          sort for short ranges, and heapsort once the recursion gets too
+ *          deep, so the worst case stays O(n log n). A wrapped ring is first
+ *          rotated so that the elements are contiguous; no memory is
+ *          allocated. The sort is not stable.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param compare the comparison function
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or compare is a NULL
+ *         pointer
+ */
+dequeue_error_t dequeue_sort(dequeue_ptr dequeue, dequeue_compare_ptr compare);
+
+/**
+ * @brief Sort the elements of a dequeue, keeping equivalent elements in
+ *        order.
+ * @details A bottom-up merge sort over runs first sorted by insertion. It
+ *          takes a buffer as large as the elements from the allocator of the
+ *          dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param compare the comparison function
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue or compare is a NULL
+ *         pointer,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the buffer could not be allocated
+ */
+dequeue_error_t dequeue_stable_sort(dequeue_ptr dequeue,
+                                    dequeue_compare_ptr compare);
+
+/**
+ * @brief Sort a dequeue of integers in ascending order without comparisons.
+ * @details A least significant digit radix sort, one byte per pass. Passes
+ *          over bytes that all the keys share are skipped. The dequeue must
+ *          store integers of 1, 2, 4 or 8 bytes inline. It takes a buffer as
+ *          large as the elements from the allocator of the dequeue. The sort
+ *          is stable.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param key whether the integers are signed
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue is a NULL pointer,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the elements are not stored inline
+ *         or are not 1, 2, 4 or 8 bytes long,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if the buffer could not be allocated
+ */
+dequeue_error_t dequeue_radix_sort(dequeue_ptr dequeue, dequeue_key_t key);
+
+/**
+ * @brief Find the first element of a sorted dequeue not ordered before a key.
+ * @details A binary search over the positions of the dequeue, which works on
+ *          wrapped rings as well.
+ *
+ * @param dequeue pointer to the sorted dequeue
+ * @param key the key, passed to compare the same way as the elements
+ * @param compare the comparison function the dequeue is sorted by
+ * @param pos where to store the position of the element, or the length of
+ *        the dequeue if every element orders before the key
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if dequeue, compare or pos is a
+ *         NULL pointer
+ */
+dequeue_error_t dequeue_lower_bound(dequeue_ptr dequeue,
+                                    const void * key,
+                                    dequeue_compare_ptr compare,
+                                    size_t * pos);
+
+/**
+ * @brief Find the first element of a sorted dequeue ordered after a key.
+ * @see dequeue_lower_bound
+ *
+ * @param dequeue pointer to the sorted dequeue
+ * @param key the key, passed to compare the same way as the elements
+ * @param compare the comparison function the dequeue is sorted by
+ * @param pos where to store the position of the element, or the length of
+ *        the dequeue if no element orders after the key
+ *
+ * @return the same errors as dequeue_lower_bound
+ */
+dequeue_error_t dequeue_upper_bound(dequeue_ptr dequeue,
+                                    const void * key,
+                                    dequeue_compare_ptr compare,
+                                    size_t * pos);
+
 #endif //UNILIB_DEQUEUE_H
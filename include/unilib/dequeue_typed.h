@@ -0,0 +1,375 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "dequeue.h"
+
+#ifndef UNILIB_DEQUEUE_TYPED_H
+#define UNILIB_DEQUEUE_TYPED_H
+
+/*
+ * Compile-time typed dequeues.
+ *
+ * DEQUEUE_DEFINE(T) generates `dequeue_T_t`, a ring of `T`s stored by value,
+ * along with `static inline` functions mirroring dequeue.h: the size of an
+ * element is `sizeof(T)`, and elements are moved in and out with plain
+ * assignments the compiler can inline and vectorize. The functions return
+ * dequeue_error_t codes and follow the same growth policy as dequeue_t.
+ *
+ * Elements are values, so the parts of dequeue.h about owning element
+ * pointers (pointer storage, arenas, pools, element_free) have no typed
+ * counterpart; pop_front_into and pop_back_into are the only way to pop, and
+ * push_front and push_back take the element by value.
+ *
+ * DEQUEUE_DEFINE_NAMED(name, T) does the same for types that are not a
+ * single identifier, e.g. DEQUEUE_DEFINE_NAMED(dequeue_u64, unsigned long).
+ */
+
+/**
+ * @brief Generate a typed dequeue named `dequeue_T`.
+ *
+ * @param T the type of the elements, a single identifier
+ */
+#define DEQUEUE_DEFINE(T) DEQUEUE_DEFINE_NAMED(dequeue_##T, T)
+
+/**
+ * @brief Generate a typed dequeue with the given name.
+ *
+ * @param name the prefix of the generated type and functions
+ * @param T the type of the elements
+ */
+#define DEQUEUE_DEFINE_NAMED(name, T) \
+\
+typedef struct name##_t { \
+    /* the ring of elements */ \
+    T * elements; \
+    /* the index of the front element in the ring */ \
+    size_t head; \
+    /* the number of elements */ \
+    size_t len; \
+    /* the number of elements the ring can hold */ \
+    size_t capacity; \
+    /* the factor the capacity is multiplied by when the ring is full */ \
+    double growth_factor; \
+    /* the maximum capacity, or DEQUEUE_UNBOUNDED_CAPACITY */ \
+    size_t max_capacity; \
+    /* the allocator the ring is allocated from */ \
+    allocator_t allocator; \
+} name##_t; \
+\
+typedef name##_t * name##_ptr; \
+\
+static inline size_t name##_index(name##_ptr dequeue, size_t pos) { \
+    size_t index = dequeue->head + pos; \
+    return index >= dequeue->capacity ? index - dequeue->capacity : index; \
+} \
+\
+static inline dequeue_error_t name##_new_with_allocator( \
+        name##_ptr dequeue, \
+        size_t capacity, \
+        allocator_ptr allocator) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (capacity > SIZE_MAX / sizeof(T)) { \
+        return DEQUEUE_ERROR_ALLOC_FAILED; \
+    } \
+    dequeue->allocator = allocator != NULL ? *allocator : allocator_default(); \
+    dequeue->elements = allocator_alloc(&dequeue->allocator, \
+                                        capacity * sizeof(T)); \
+    if (dequeue->elements == NULL) { \
+        return DEQUEUE_ERROR_ALLOC_FAILED; \
+    } \
+    dequeue->head = 0; \
+    dequeue->len = 0; \
+    dequeue->capacity = capacity; \
+    dequeue->growth_factor = DEQUEUE_DEFAULT_GROWTH_FACTOR; \
+    dequeue->max_capacity = DEQUEUE_UNBOUNDED_CAPACITY; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_new_with_capacity(name##_ptr dequeue, \
+                                                       size_t capacity) { \
+    return name##_new_with_allocator(dequeue, capacity, NULL); \
+} \
+\
+static inline dequeue_error_t name##_new(name##_ptr dequeue) { \
+    return name##_new_with_allocator(dequeue, DEQUEUE_DEFAULT_CAPACITY, NULL); \
+} \
+\
+static inline dequeue_error_t name##_new_ptr_with_capacity( \
+        name##_ptr * dequeue, \
+        size_t capacity) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    *dequeue = allocator_alloc(NULL, sizeof(name##_t)); \
+    if (*dequeue == NULL) { \
+        return DEQUEUE_ERROR_ALLOC_FAILED; \
+    } \
+    dequeue_error_t err = name##_new_with_capacity(*dequeue, capacity); \
+    if (!DEQUEUE_ERROR_IS_OK(err)) { \
+        allocator_free(NULL, *dequeue, sizeof(name##_t)); \
+        *dequeue = NULL; \
+    } \
+    return err; \
+} \
+\
+static inline dequeue_error_t name##_new_ptr(name##_ptr * dequeue) { \
+    return name##_new_ptr_with_capacity(dequeue, DEQUEUE_DEFAULT_CAPACITY); \
+} \
+\
+static inline T * name##_get(name##_ptr dequeue, size_t pos) { \
+    if (dequeue == NULL || pos >= dequeue->len) { \
+        return NULL; \
+    } \
+    return &dequeue->elements[name##_index(dequeue, pos)]; \
+} \
+\
+static inline T * name##_front(name##_ptr dequeue) { \
+    return name##_get(dequeue, 0); \
+} \
+\
+static inline T * name##_back(name##_ptr dequeue) { \
+    if (dequeue == NULL || dequeue->len == 0) { \
+        return NULL; \
+    } \
+    return &dequeue->elements[name##_index(dequeue, dequeue->len - 1)]; \
+} \
+\
+static inline dequeue_error_t name##_resize(name##_ptr dequeue, \
+                                            size_t capacity) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (capacity == 0) { \
+        return DEQUEUE_ERROR_ZERO_CAPACITY_RESIZE; \
+    } \
+    if (capacity == dequeue->capacity) { \
+        return DEQUEUE_ERROR_OK; \
+    } \
+    if (capacity > SIZE_MAX / sizeof(T)) { \
+        return DEQUEUE_ERROR_ALLOC_FAILED; \
+    } \
+    size_t head_len = dequeue->capacity - dequeue->head; \
+    if (capacity < dequeue->capacity) { \
+        /* shrinking drops the surplus elements at the back */ \
+        T * elements = allocator_alloc(&dequeue->allocator, \
+                                       capacity * sizeof(T)); \
+        if (elements == NULL) { \
+            return DEQUEUE_ERROR_ALLOC_FAILED; \
+        } \
+        if (dequeue->len > capacity) { \
+            dequeue->len = capacity; \
+        } \
+        if (dequeue->len <= head_len) { \
+            memcpy(elements, \
+                   dequeue->elements + dequeue->head, \
+                   dequeue->len * sizeof(T)); \
+        } else { \
+            memcpy(elements, \
+                   dequeue->elements + dequeue->head, \
+                   head_len * sizeof(T)); \
+            memcpy(elements + head_len, \
+                   dequeue->elements, \
+                   (dequeue->len - head_len) * sizeof(T)); \
+        } \
+        allocator_free(&dequeue->allocator, \
+                       dequeue->elements, \
+                       dequeue->capacity * sizeof(T)); \
+        dequeue->elements = elements; \
+        dequeue->head = 0; \
+        dequeue->capacity = capacity; \
+        return DEQUEUE_ERROR_OK; \
+    } \
+    T * elements = allocator_realloc(&dequeue->allocator, \
+                                     dequeue->elements, \
+                                     dequeue->capacity * sizeof(T), \
+                                     capacity * sizeof(T)); \
+    if (elements == NULL) { \
+        return DEQUEUE_ERROR_ALLOC_FAILED; \
+    } \
+    size_t old_capacity = dequeue->capacity; \
+    dequeue->elements = elements; \
+    dequeue->capacity = capacity; \
+    if (dequeue->len > head_len) { \
+        /* move whichever of the wrapped parts is shorter */ \
+        size_t tail_len = dequeue->len - head_len; \
+        if (tail_len <= head_len && tail_len <= capacity - old_capacity) { \
+            memcpy(elements + old_capacity, elements, tail_len * sizeof(T)); \
+        } else { \
+            memmove(elements + (capacity - head_len), \
+                    elements + dequeue->head, \
+                    head_len * sizeof(T)); \
+            dequeue->head = capacity - head_len; \
+        } \
+    } \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_grow(name##_ptr dequeue, \
+                                          size_t min_capacity) { \
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY \
+            && min_capacity > dequeue->max_capacity) { \
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED; \
+    } \
+    double grown = (double) dequeue->capacity * dequeue->growth_factor; \
+    size_t capacity = grown < (double) SIZE_MAX ? (size_t) grown : SIZE_MAX; \
+    if (capacity < min_capacity) { \
+        capacity = min_capacity; \
+    } \
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY \
+            && capacity > dequeue->max_capacity) { \
+        capacity = dequeue->max_capacity; \
+    } \
+    return name##_resize(dequeue, capacity); \
+} \
+\
+static inline dequeue_error_t name##_push_front(name##_ptr dequeue, T elem) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (dequeue->len == dequeue->capacity) { \
+        dequeue_error_t err = name##_grow(dequeue, dequeue->capacity + 1); \
+        if (!DEQUEUE_ERROR_IS_OK(err)) { \
+            return err; \
+        } \
+    } \
+    dequeue->head = dequeue->head == 0 \
+            ? dequeue->capacity - 1 \
+            : dequeue->head - 1; \
+    dequeue->elements[dequeue->head] = elem; \
+    dequeue->len += 1; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_push_back(name##_ptr dequeue, T elem) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (dequeue->len == dequeue->capacity) { \
+        dequeue_error_t err = name##_grow(dequeue, dequeue->capacity + 1); \
+        if (!DEQUEUE_ERROR_IS_OK(err)) { \
+            return err; \
+        } \
+    } \
+    dequeue->elements[name##_index(dequeue, dequeue->len)] = elem; \
+    dequeue->len += 1; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_pop_front_into(name##_ptr dequeue, \
+                                                    T * dst) { \
+    if (dequeue == NULL || dst == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (dequeue->len == 0) { \
+        return DEQUEUE_ERROR_EMPTY; \
+    } \
+    *dst = dequeue->elements[dequeue->head]; \
+    dequeue->head = name##_index(dequeue, 1); \
+    dequeue->len -= 1; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_pop_back_into(name##_ptr dequeue, \
+                                                   T * dst) { \
+    if (dequeue == NULL || dst == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (dequeue->len == 0) { \
+        return DEQUEUE_ERROR_EMPTY; \
+    } \
+    dequeue->len -= 1; \
+    *dst = dequeue->elements[name##_index(dequeue, dequeue->len)]; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_set_growth(name##_ptr dequeue, \
+                                                double growth_factor, \
+                                                size_t max_capacity) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (!(growth_factor > 1.0)) { \
+        return DEQUEUE_ERROR_INVALID_GROWTH_FACTOR; \
+    } \
+    dequeue->growth_factor = growth_factor; \
+    dequeue->max_capacity = max_capacity; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_reserve(name##_ptr dequeue, \
+                                             size_t additional) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    if (additional > SIZE_MAX - dequeue->len) { \
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED; \
+    } \
+    size_t capacity = dequeue->len + additional; \
+    if (capacity <= dequeue->capacity) { \
+        return DEQUEUE_ERROR_OK; \
+    } \
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY \
+            && capacity > dequeue->max_capacity) { \
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED; \
+    } \
+    return name##_resize(dequeue, capacity); \
+} \
+\
+static inline dequeue_error_t name##_shrink_to_fit(name##_ptr dequeue) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    return name##_resize(dequeue, dequeue->len != 0 ? dequeue->len : 1); \
+} \
+\
+static inline dequeue_error_t name##_empty(name##_ptr dequeue) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    dequeue->head = 0; \
+    dequeue->len = 0; \
+    return DEQUEUE_ERROR_OK; \
+} \
+\
+static inline dequeue_error_t name##_free(name##_ptr dequeue) { \
+    if (dequeue == NULL) { \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED; \
+    } \
+    allocator_free(&dequeue->allocator, \
+                   dequeue->elements, \
+                   dequeue->capacity * sizeof(T)); \
+    dequeue->elements = NULL; \
+    dequeue->head = 0; \
+    dequeue->len = 0; \
+    dequeue->capacity = 0; \
+    return DEQUEUE_ERROR_OK; \
+}
+
+#endif //UNILIB_DEQUEUE_TYPED_H
@@ -23,9 +23,22 @@
 
 #include <stdint.h>
 
+#include "alloc.h"
+
 #ifndef UNILIB_ITER_H
 #define UNILIB_ITER_H
 
+/**
+ * The number of element pointers consumers fetch at once from iterators that
+ * fill batches.
+ */
+#define ITER_BATCH_SIZE 64
+
+/**
+ * The maximum number of map and filter stages fused into one iterator.
+ */
+#define ITER_MAX_STAGES 8
+
 /**
  * Pointer to the `next` function of an iterator.
  */
@@ -36,6 +49,46 @@ typedef void * (* iter_next_ptr)(void *);
  */
 typedef void (* iter_free_ptr)(void *);
 
+/**
+ * Pointer to the `next_batch` function of an iterator.
+ * @details Receives the data of the iterator, a buffer and its capacity. Fills
+ *          the buffer with up to that many element pointers and returns how
+ *          many it wrote, 0 once the iterator is exhausted.
+ */
+typedef size_t (* iter_next_batch_ptr)(void *, void **, size_t);
+
+/**
+ * Pointer to the `next_span` function of an iterator.
+ * @details Receives the data of the iterator, the maximum number of elements
+ *          and the address of a span. Points the span at up to that many
+ *          contiguous element pointers owned by the iterator and returns how
+ *          many there are, 0 once the iterator is exhausted. The span stays
+ *          valid until the iterator is advanced again.
+ */
+typedef size_t (* iter_next_span_ptr)(void *, size_t, void ***);
+
+/**
+ * Pointer to the `size_hint` function of an iterator.
+ * @details Receives the data of the iterator and writes the bounds of the
+ *          number of remaining elements to the last two arguments, SIZE_MAX as
+ *          the upper bound meaning unknown. Equal bounds are an exact length.
+ */
+typedef void (* iter_size_hint_ptr)(void *, size_t *, size_t *);
+
+/**
+ * Pointer to the `next_back` function of an iterator.
+ * @details Receives the data of the iterator and returns the last remaining
+ *          element, or NULL if none remain.
+ */
+typedef void * (* iter_next_back_ptr)(void *);
+
+/**
+ * Pointer to the `advance` function of an iterator.
+ * @details Receives the data of the iterator and a number of elements, skips
+ *          up to that many and returns how many were skipped.
+ */
+typedef size_t (* iter_advance_ptr)(void *, size_t);
+
 /**
  * @struct iter
  * @brief A generic iterator.
@@ -47,6 +100,16 @@ typedef struct iter_t {
     iter_next_ptr next;
     // pointer to the `free` function of an iterator
     iter_free_ptr free;
+    // pointer to the `next_batch` function of an iterator, or NULL
+    iter_next_batch_ptr next_batch;
+    // pointer to the `next_span` function of an iterator, or NULL
+    iter_next_span_ptr next_span;
+    // pointer to the `size_hint` function of an iterator, or NULL
+    iter_size_hint_ptr size_hint;
+    // pointer to the `advance` function of an iterator, or NULL
+    iter_advance_ptr advance;
+    // pointer to the `next_back` function of an iterator, or NULL
+    iter_next_back_ptr next_back;
 } iter_t;
 
 /**
@@ -72,6 +135,68 @@ iter_t iter_new(void * data, iter_next_ptr next, iter_free_ptr free);
  */
 iter_ptr iter_new_ptr(void * data, iter_next_ptr next, iter_free_ptr free);
 
+/**
+ * @brief Create a new iterator, allocated from an allocator.
+ * @details The iterator pointer must be released with allocator_free.
+ * @param data pointer to the data of the iterator
+ * @param next pointer to the `next` function of the iterator
+ * @param free pointer to the `free` function of the iterator
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ * @return a new iterator, or NULL if memory could not be allocated
+ */
+iter_ptr iter_new_ptr_with_allocator(void * data,
+                                     iter_next_ptr next,
+                                     iter_free_ptr free,
+                                     allocator_ptr allocator);
+
+/**
+ * @brief Set the batch hooks of an iterator.
+ * @details Consumers prefer `next_span`, then `next_batch`, and fall back to
+ *          `next` when neither is set. Each hook must consume the elements it
+ *          returns exactly like the same number of `next` calls would.
+ * @param iter pointer to the iterator
+ * @param next_batch pointer to the `next_batch` function, or NULL
+ * @param next_span pointer to the `next_span` function, or NULL
+ */
+void iter_set_batch(iter_ptr iter,
+                    iter_next_batch_ptr next_batch,
+                    iter_next_span_ptr next_span);
+
+/**
+ * @brief Set the random-access hooks of an iterator.
+ * @details iter_count and iter_advance_by use them instead of walking the
+ *          elements, and collectors use the size hint to preallocate.
+ * @param iter pointer to the iterator
+ * @param size_hint pointer to the `size_hint` function, or NULL
+ * @param advance pointer to the `advance` function, or NULL
+ */
+void iter_set_random_access(iter_ptr iter,
+                            iter_size_hint_ptr size_hint,
+                            iter_advance_ptr advance);
+
+/**
+ * @brief Make an iterator double-ended.
+ * @param iter pointer to the iterator
+ * @param next_back pointer to the `next_back` function, or NULL
+ */
+void iter_set_double_ended(iter_ptr iter, iter_next_back_ptr next_back);
+
+/**
+ * @brief Get the bounds of the number of remaining elements.
+ * @param iter pointer to the iterator
+ * @param lower address of the lower bound
+ * @param upper address of the upper bound, SIZE_MAX if unknown
+ */
+void iter_size_hint(iter_ptr iter, size_t * lower, size_t * upper);
+
+/**
+ * @brief Get the exact number of remaining elements, if the iterator knows it.
+ * @param iter pointer to the iterator
+ * @param len address of the number of remaining elements
+ * @return 1 if the length is exact, 0 otherwise
+ */
+int iter_exact_len(iter_ptr iter, size_t * len);
+
 /**
  * @brief Get the next value in the collection.
  * @param iter pointer to the iterator
@@ -79,6 +204,35 @@ iter_ptr iter_new_ptr(void * data, iter_next_ptr next, iter_free_ptr free);
  */
 void * iter_next(iter_ptr iter);
 
+/**
+ * @brief Get the last remaining value in the collection.
+ * @param iter pointer to the iterator
+ * @return pointer to the element or NULL if none remain or the iterator is
+ *         not double-ended
+ */
+void * iter_next_back(iter_ptr iter);
+
+/**
+ * @brief Get the next values in the collection.
+ * @param iter pointer to the iterator
+ * @param buffer the buffer the element pointers are written to
+ * @param max the capacity of the buffer
+ * @return the number of element pointers written, 0 if none remain
+ */
+size_t iter_next_batch(iter_ptr iter, void ** buffer, size_t max);
+
+/**
+ * @brief Get the next values in the collection as a contiguous span.
+ * @details Iterators with a `next_span` hook point the span into their own
+ *          storage; the others fill the buffer and point the span at it.
+ * @param iter pointer to the iterator
+ * @param buffer the buffer used when the iterator cannot lend its storage
+ * @param max the capacity of the buffer
+ * @param span address of the span
+ * @return the number of element pointers in the span, 0 if none remain
+ */
+size_t iter_next_span(iter_ptr iter, void ** buffer, size_t max, void *** span);
+
 /**
  * @brief Advance the iterator by `count` elements.
  * @param iter pointer to the iterator
@@ -87,6 +241,14 @@ void * iter_next(iter_ptr iter);
  */
 size_t iter_advance_by(iter_ptr iter, size_t count);
 
+/**
+ * @brief Get the value `n` elements ahead, skipping the ones before it.
+ * @param iter pointer to the iterator
+ * @param n the number of elements to skip
+ * @return pointer to the element or NULL if fewer than `n + 1` remain
+ */
+void * iter_nth(iter_ptr iter, size_t n);
+
 /**
  * @brief Consume the iterator, returning the number of items.
  * @param iter pointer to the iterator
@@ -102,4 +264,181 @@ size_t iter_count(iter_ptr iter);
  */
 void iter_free(iter_ptr iter);
 
+/**
+ * Pointer to the function of a map stage.
+ * @details Receives an element and the context of the stage, returns the
+ *          mapped element. Returning NULL ends the iteration.
+ */
+typedef void * (* iter_map_ptr)(void *, void *);
+
+/**
+ * Pointer to the function of a filter stage.
+ * @details Receives an element and the context of the stage, returns non-zero
+ *          to keep the element.
+ */
+typedef int (* iter_filter_ptr)(void *, void *);
+
+/**
+ * @struct iter_stage
+ * @brief A map or filter stage of a fused pipeline.
+ */
+typedef struct iter_stage_t {
+    // the map function of the stage, or NULL for a filter stage
+    iter_map_ptr map;
+    // the filter function of the stage, or NULL for a map stage
+    iter_filter_ptr filter;
+    // pointer passed to the function of the stage
+    void * ctx;
+} iter_stage_t;
+
+/**
+ * @struct iter_stages
+ * @brief The state of a pipeline of fused map and filter stages.
+ */
+typedef struct iter_stages_t {
+    // the iterator the pipeline pulls elements from
+    iter_t source;
+    // the number of stages
+    size_t len;
+    // the stages, in the order they run
+    iter_stage_t stages[ITER_MAX_STAGES];
+    // set once the source is exhausted or a map ended the iteration, so the
+    // pipeline stays ended
+    int done;
+} iter_stages_t;
+
+/**
+ * Pointer to the state of a pipeline.
+ */
+typedef iter_stages_t * iter_stages_ptr;
+
+/**
+ * @struct iter_limit
+ * @brief The state of a take or skip adapter.
+ */
+typedef struct iter_limit_t {
+    // the iterator the adapter pulls elements from
+    iter_t source;
+    // the number of elements left to take, or to skip
+    size_t n;
+} iter_limit_t;
+
+/**
+ * Pointer to the state of a take or skip adapter.
+ */
+typedef iter_limit_t * iter_limit_ptr;
+
+/**
+ * @struct iter_chain
+ * @brief The state of a chain adapter.
+ */
+typedef struct iter_chain_t {
+    // the iterator walked first
+    iter_t first;
+    // the iterator walked once the first one is exhausted
+    iter_t second;
+    // set once the first iterator is exhausted
+    int on_second;
+} iter_chain_t;
+
+/**
+ * Pointer to the state of a chain adapter.
+ */
+typedef iter_chain_t * iter_chain_ptr;
+
+/**
+ * @struct iter_zip
+ * @brief The state of a zip adapter.
+ */
+typedef struct iter_zip_t {
+    // the iterator providing the first element of every pair
+    iter_t first;
+    // the iterator providing the second element of every pair
+    iter_t second;
+    // the last pair returned
+    void * pair[2];
+} iter_zip_t;
+
+/**
+ * Pointer to the state of a zip adapter.
+ */
+typedef iter_zip_t * iter_zip_ptr;
+
+/**
+ * @brief Map the elements of an iterator.
+ * @details The state of the adapter lives in `storage`, so nothing is
+ *          allocated. Mapping a map or filter adapter fuses the new stage into
+ *          a copy of its pipeline, so the whole pipeline runs in a single
+ *          `next` call; the source adapter must not be used afterwards.
+ *          A map returning NULL ends the pipeline for good, so the number of
+ *          elements left is never known exactly, and skipped elements still
+ *          run through every stage. Freeing the adapter frees its source.
+ * @param source pointer to the iterator to map
+ * @param map the function mapping the elements
+ * @param ctx pointer passed to the function
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_map(iter_ptr source,
+                iter_map_ptr map,
+                void * ctx,
+                iter_stages_ptr storage);
+
+/**
+ * @brief Keep the elements of an iterator that pass a filter.
+ * @see iter_map
+ * @param source pointer to the iterator to filter
+ * @param filter the function deciding which elements to keep
+ * @param ctx pointer passed to the function
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_filter(iter_ptr source,
+                   iter_filter_ptr filter,
+                   void * ctx,
+                   iter_stages_ptr storage);
+
+/**
+ * @brief Take the first `n` elements of an iterator.
+ * @details Freeing the adapter frees its source.
+ * @param source pointer to the iterator
+ * @param n the number of elements to take
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_take(iter_ptr source, size_t n, iter_limit_ptr storage);
+
+/**
+ * @brief Skip the first `n` elements of an iterator.
+ * @details The elements are skipped with iter_advance_by on the first use of
+ *          the adapter. Freeing the adapter frees its source.
+ * @param source pointer to the iterator
+ * @param n the number of elements to skip
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_skip(iter_ptr source, size_t n, iter_limit_ptr storage);
+
+/**
+ * @brief Walk an iterator, then another one.
+ * @details Freeing the adapter frees both iterators.
+ * @param first pointer to the iterator walked first
+ * @param second pointer to the iterator walked next
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_chain(iter_ptr first, iter_ptr second, iter_chain_ptr storage);
+
+/**
+ * @brief Walk two iterators in lockstep.
+ * @details The elements are `void *[2]` pairs, valid until the next call.
+ *          The iteration ends with the shorter iterator. Freeing the adapter
+ *          frees both iterators.
+ * @param first pointer to the iterator providing the first elements
+ * @param second pointer to the iterator providing the second elements
+ * @param storage the state of the adapter, which must outlive it
+ * @return a new iterator
+ */
+iter_t iter_zip(iter_ptr first, iter_ptr second, iter_zip_ptr storage);
+
 #endif //UNILIB_ITER_H
@@ -0,0 +1,206 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dequeue.h"
+
+#ifndef UNILIB_ITER_INLINE_H
+#define UNILIB_ITER_INLINE_H
+
+/*
+ * Header-only iteration over sources whose layout is known at compile time.
+ *
+ * iter_t dispatches every element through a function pointer, which keeps it
+ * type-erased but stops the compiler from inlining or vectorizing the loop.
+ * The cursors and loops below are `static inline` functions and macros over
+ * dequeues, arrays and ranges: a pipeline written as the body of one of them
+ * compiles to a plain loop over contiguous memory.
+ */
+
+/**
+ * @struct dequeue_segment
+ * @brief A run of slots of a dequeue that is contiguous in memory.
+ */
+typedef struct dequeue_segment_t {
+    // the first slot of the run
+    void * slots;
+    // the number of slots in the run, 0 past the last run
+    size_t len;
+    // the position of the first slot of the run in the dequeue
+    size_t pos;
+} dequeue_segment_t;
+
+/**
+ * @brief Get the longest contiguous run of slots starting at a position.
+ * @details A dequeue has at most two runs: from the front to the end of the
+ *          ring, then from the start of the ring to the back. With inline
+ *          storage a slot is an element, otherwise it is an element pointer.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param pos the position of the first slot
+ *
+ * @return the run, empty if pos is past the back of the dequeue
+ */
+static inline dequeue_segment_t dequeue_segment_at(dequeue_ptr dequeue,
+                                                   size_t pos) {
+    dequeue_segment_t segment = {NULL, 0, pos};
+    if (pos >= dequeue->len) {
+        return segment;
+    }
+    size_t slot_size = dequeue->storage == DEQUEUE_STORAGE_INLINE
+                       ? dequeue->element_size
+                       : sizeof(void *);
+    size_t index = dequeue->head + pos;
+    if (index >= dequeue->capacity) {
+        index -= dequeue->capacity;
+    }
+    segment.len = dequeue->len - pos;
+    if (segment.len > dequeue->capacity - index) {
+        segment.len = dequeue->capacity - index;
+    }
+    segment.slots = (char *) dequeue->elements + index * slot_size;
+    return segment;
+}
+
+/**
+ * @brief Get the run of slots that follows another one.
+ *
+ * @param dequeue pointer to the dequeue
+ * @param segment the current run
+ *
+ * @return the next run, empty after the last one
+ */
+static inline dequeue_segment_t dequeue_segment_next(
+        dequeue_ptr dequeue,
+        dequeue_segment_t segment) {
+    return dequeue_segment_at(dequeue, segment.pos + segment.len);
+}
+
+/**
+ * @brief Loop over the slots of a dequeue.
+ * @details `var` is declared as a `T *` pointing at every slot in turn, front
+ *          to back: the element itself with inline storage of `T`s, the
+ *          element pointer with pointer storage and `T` = `void *`. The
+ *          dequeue must not be modified inside the loop. `break` and
+ *          `continue` behave as in a single loop.
+ *
+ *          Each contiguous run of slots is walked by a plain inner loop, so
+ *          the compiler can vectorize the body. The inner condition records
+ *          whether it was left by running out of slots; after a `break` it
+ *          was last true, which stops the loop over runs as well.
+ *
+ * @param T the type of a slot
+ * @param var the name of the slot pointer
+ * @param dequeue pointer to the dequeue
+ */
+#define DEQUEUE_FOR_EACH(T, var, dequeue) \
+    for (int unilib_broken_ = 0; !unilib_broken_; unilib_broken_ = 1) \
+        for (dequeue_segment_t unilib_segment_ = \
+                     dequeue_segment_at(dequeue, 0); \
+             !unilib_broken_ && unilib_segment_.len != 0; \
+             unilib_segment_ = dequeue_segment_next(dequeue, \
+                                                    unilib_segment_)) \
+            for (T * var = (T *) unilib_segment_.slots, \
+                     * unilib_end_ = var + unilib_segment_.len; \
+                 (unilib_broken_ = (var != unilib_end_)); \
+                 var++)
+
+/**
+ * @brief Loop over the elements of an array.
+ *
+ * @param T the type of an element
+ * @param var the name of the element pointer
+ * @param array pointer to the first element
+ * @param len the number of elements
+ */
+#define ITER_ARRAY_FOR_EACH(T, var, array, len) \
+    for (T * var = (array), * unilib_end_ = var + (len); \
+         var != unilib_end_; \
+         var++)
+
+/**
+ * @brief Loop over the values of the range [start, end).
+ *
+ * @param var the name of the `size_t` value
+ * @param start the first value
+ * @param end the value past the last one
+ */
+#define ITER_RANGE_FOR_EACH(var, start, end) \
+    for (size_t var = (start), unilib_end_ = (end); var < unilib_end_; var++)
+
+/**
+ * @struct dequeue_cursor
+ * @brief A header-only forward cursor over the elements of a dequeue.
+ */
+typedef struct dequeue_cursor_t {
+    // the dequeue being walked
+    dequeue_ptr dequeue;
+    // the run of slots being walked
+    dequeue_segment_t segment;
+    // the offset of the next slot in the run
+    size_t offset;
+} dequeue_cursor_t;
+
+/**
+ * @brief Start a cursor at the front of a dequeue.
+ *
+ * @param dequeue pointer to the dequeue
+ *
+ * @return a new cursor
+ */
+static inline dequeue_cursor_t dequeue_cursor(dequeue_ptr dequeue) {
+    dequeue_cursor_t cursor = {dequeue, dequeue_segment_at(dequeue, 0), 0};
+    return cursor;
+}
+
+/**
+ * @brief Get the next element of a cursor.
+ * @details Returns the same pointers as dequeue_get.
+ *
+ * @param cursor pointer to the cursor
+ *
+ * @return pointer to the element or NULL if none remain
+ */
+static inline void * dequeue_cursor_next(dequeue_cursor_t * cursor) {
+    if (cursor->offset == cursor->segment.len) {
+        if (cursor->segment.len == 0) {
+            return NULL;
+        }
+        cursor->segment = dequeue_segment_next(cursor->dequeue,
+                                               cursor->segment);
+        cursor->offset = 0;
+        if (cursor->segment.len == 0) {
+            return NULL;
+        }
+    }
+    size_t i = cursor->offset++;
+    if (cursor->dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return (char *) cursor->segment.slots
+               + i * cursor->dequeue->element_size;
+    }
+    return ((void **) cursor->segment.slots)[i];
+}
+
+#endif //UNILIB_ITER_INLINE_H
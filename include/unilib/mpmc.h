@@ -0,0 +1,203 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "config.h"
+#include "notify.h"
+
+#ifndef UNILIB_MPMC_H
+#define UNILIB_MPMC_H
+
+/**
+ * Error type return by mpmc functions.
+ */
+typedef uint8_t mpmc_error_t;
+
+/**
+ * No error.
+ */
+#define MPMC_ERROR_OK                    ((mpmc_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define MPMC_ERROR_NULL_POINTER_RECEIVED ((mpmc_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define MPMC_ERROR_ALLOC_FAILED          ((mpmc_error_t) 2)
+/**
+ * The queue cannot be created with a capacity below 2.
+ */
+#define MPMC_ERROR_CAPACITY_TOO_SMALL    ((mpmc_error_t) 3)
+/**
+ * There is no room left in the queue.
+ */
+#define MPMC_ERROR_FULL                  ((mpmc_error_t) 4)
+/**
+ * There are no items in the queue.
+ */
+#define MPMC_ERROR_EMPTY                 ((mpmc_error_t) 5)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define MPMC_ERROR_IS_OK(err) (err == MPMC_ERROR_OK)
+
+/**
+ * @struct mpmc_cell
+ * @brief A slot of a mpmc queue.
+ */
+typedef struct mpmc_cell_t {
+    // tells producers and consumers which lap of the ring the cell is on
+    atomic_size_t sequence;
+    // the element held by the cell
+    void * elem;
+} mpmc_cell_t;
+
+/**
+ * @struct mpmc
+ * @brief A bounded, lock-free, multi-producer multi-consumer queue.
+ * @details Like a dequeue, the queue holds pointers to elements, in a ring
+ *          whose capacity is a power of two. Every cell carries a sequence
+ *          number: a producer may fill the cell at position `pos` once its
+ *          sequence equals `pos`, and a consumer may empty it once its
+ *          sequence equals `pos + 1`. Producers and consumers each claim
+ *          positions with a CAS on their own index, so they only contend with
+ *          their own kind, and never on a lock.
+ */
+typedef struct mpmc_t {
+    // ring of cells
+    mpmc_cell_t * cells;
+    // the capacity of the queue, a power of two
+    size_t capacity;
+    // capacity - 1, to map a position onto the ring
+    size_t mask;
+    // the allocator the ring is allocated from
+    allocator_t allocator;
+    // the notifier signalled when a push finds the queue empty, or NULL
+    notify_ptr notify;
+    char pad_enqueue[UNILIB_CACHE_LINE_SIZE];
+    // the next position to push to, claimed by producers
+    atomic_size_t enqueue_pos;
+    char pad_dequeue[UNILIB_CACHE_LINE_SIZE];
+    // the next position to pop from, claimed by consumers
+    atomic_size_t dequeue_pos;
+    char pad_end[UNILIB_CACHE_LINE_SIZE];
+} mpmc_t;
+
+/**
+ * @brief Pointer to a mpmc queue.
+ */
+typedef mpmc_t * mpmc_ptr;
+
+/**
+ * @brief Create a new mpmc queue.
+ * @details The capacity is rounded up to the next power of two.
+ *
+ * @param mpmc address to the queue that should be created
+ * @param capacity the minimum capacity of the queue, at least 2
+ * @param allocator pointer to the allocator the ring is allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return MPMC_ERROR_OK on success,
+ *         MPMC_ERROR_NULL_POINTER_RECEIVED if mpmc is a NULL pointer,
+ *         MPMC_ERROR_CAPACITY_TOO_SMALL if capacity is below 2,
+ *         MPMC_ERROR_ALLOC_FAILED if the queue failed to allocate
+ */
+mpmc_error_t mpmc_new(mpmc_ptr mpmc, size_t capacity, allocator_ptr allocator);
+
+/**
+ * @brief Push an item at the back of the queue.
+ * @details Any number of threads may push at the same time. The queue does
+ *          not take ownership of the element.
+ *
+ * @param mpmc pointer to the queue
+ * @param elem the element to be added to the queue
+ *
+ * @return MPMC_ERROR_OK on success,
+ *         MPMC_ERROR_NULL_POINTER_RECEIVED if mpmc is a NULL pointer,
+ *         MPMC_ERROR_FULL if there is no room left in the queue
+ */
+mpmc_error_t mpmc_try_push(mpmc_ptr mpmc, void * elem);
+
+/**
+ * @brief Pop an item from the front of the queue.
+ * @details Any number of threads may pop at the same time.
+ *
+ * @param mpmc pointer to the queue
+ * @param elem address where to place the element removed from the queue
+ *
+ * @return MPMC_ERROR_OK on success,
+ *         MPMC_ERROR_NULL_POINTER_RECEIVED if mpmc or elem is a NULL pointer,
+ *         MPMC_ERROR_EMPTY if there are no items in the queue
+ */
+mpmc_error_t mpmc_try_pop(mpmc_ptr mpmc, void ** elem);
+
+/**
+ * @brief Signal a notifier whenever a push finds the queue empty.
+ * @details This lets consumers wait for items on the descriptor of the
+ *          notifier, following the protocol described in notify_t. With a
+ *          notifier, a push also reads the position of the consumers, and a
+ *          pop that finds the queue empty looks again after a fence, so that
+ *          a push racing with the last pop before the consumers wait is never
+ *          missed. Must be called before the queue is shared. The notifier is
+ *          signalled right away if the queue already holds items, and it
+ *          must outlive the queue.
+ * @see notify_t
+ *
+ * @param mpmc pointer to the queue
+ * @param notify pointer to the notifier, or NULL to stop signalling
+ *
+ * @return MPMC_ERROR_OK on success,
+ *         MPMC_ERROR_NULL_POINTER_RECEIVED if mpmc is a NULL pointer
+ */
+mpmc_error_t mpmc_set_notify(mpmc_ptr mpmc, notify_ptr notify);
+
+/**
+ * @brief Get the number of items in the queue.
+ * @details The result is only a snapshot if the queue is being used by other
+ *          threads.
+ *
+ * @param mpmc pointer to the queue
+ *
+ * @return the number of items in the queue, or 0 if mpmc is a NULL pointer
+ */
+size_t mpmc_len(mpmc_ptr mpmc);
+
+/**
+ * @brief Release the memory used by the queue.
+ * @details The elements left in the queue are not released. If the queue was
+ *          allocated on the heap, it must be de-allocated manually.
+ *
+ * @param mpmc pointer to the queue
+ *
+ * @return MPMC_ERROR_OK on success,
+ *         MPMC_ERROR_NULL_POINTER_RECEIVED if mpmc is a NULL pointer
+ */
+mpmc_error_t mpmc_free(mpmc_ptr mpmc);
+
+#endif //UNILIB_MPMC_H
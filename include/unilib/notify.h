@@ -0,0 +1,145 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef UNILIB_NOTIFY_H
+#define UNILIB_NOTIFY_H
+
+/**
+ * Error type return by notify functions.
+ */
+typedef uint8_t notify_error_t;
+
+/**
+ * No error.
+ */
+#define NOTIFY_ERROR_OK                    ((notify_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define NOTIFY_ERROR_NULL_POINTER_RECEIVED ((notify_error_t) 1)
+/**
+ * A system call failed; errno tells why.
+ */
+#define NOTIFY_ERROR_SYSTEM                ((notify_error_t) 2)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define NOTIFY_ERROR_IS_OK(err) (err == NOTIFY_ERROR_OK)
+
+/**
+ * @struct notify
+ * @brief A readiness notifier that an event loop can wait on.
+ * @details Wraps an eventfd (a non-blocking pipe where eventfd is not
+ *          available) whose descriptor can be registered with epoll, poll or
+ *          select. Queues with a notifier attached signal it when a push
+ *          finds them empty, and the descriptor then stays readable until
+ *          the consumer calls notify_consume. Signals in between are
+ *          coalesced: at most one write is made per consume, so a busy
+ *          producer does not pay a syscall per push.
+ *
+ *          The consumer must call notify_consume before draining the queue,
+ *          and drain it until it reports empty before waiting again; a push
+ *          that races with the drain then either is seen by the drain or
+ *          signals the notifier again.
+ */
+typedef struct notify_t {
+    // the descriptor to wait on, readable while the notifier is signalled
+    int fd;
+    // the descriptor written to, the same as fd with eventfd
+    int write_fd;
+    // set by the first signal after a consume
+    atomic_bool pending;
+} notify_t;
+
+/**
+ * @brief Pointer to a notifier.
+ */
+typedef notify_t * notify_ptr;
+
+/**
+ * @brief Create a new notifier.
+ * @details The descriptors are non-blocking and close-on-exec.
+ *
+ * @param notify address to the notifier that should be created
+ *
+ * @return NOTIFY_ERROR_OK on success,
+ *         NOTIFY_ERROR_NULL_POINTER_RECEIVED if notify is a NULL pointer,
+ *         NOTIFY_ERROR_SYSTEM if the descriptors could not be created
+ */
+notify_error_t notify_new(notify_ptr notify);
+
+/**
+ * @brief Get the descriptor to wait on.
+ *
+ * @param notify pointer to the notifier
+ *
+ * @return the descriptor, readable while the notifier is signalled, or -1 if
+ *         notify is a NULL pointer
+ */
+int notify_fd(notify_ptr notify);
+
+/**
+ * @brief Signal the notifier.
+ * @details Only writes to the descriptor if the notifier was not already
+ *          signalled since the last consume. Safe to call from any thread.
+ *
+ * @param notify pointer to the notifier
+ *
+ * @return NOTIFY_ERROR_OK on success,
+ *         NOTIFY_ERROR_NULL_POINTER_RECEIVED if notify is a NULL pointer,
+ *         NOTIFY_ERROR_SYSTEM if the descriptor could not be written
+ */
+notify_error_t notify_signal(notify_ptr notify);
+
+/**
+ * @brief Reset the notifier, before draining the queues it watches.
+ * @details The descriptor is drained first and the notifier re-armed after,
+ *          so a signal racing with the reset is either still readable or
+ *          made for a push the following drain of the queues sees.
+ *
+ * @param notify pointer to the notifier
+ *
+ * @return NOTIFY_ERROR_OK on success,
+ *         NOTIFY_ERROR_NULL_POINTER_RECEIVED if notify is a NULL pointer,
+ *         NOTIFY_ERROR_SYSTEM if the descriptor could not be read
+ */
+notify_error_t notify_consume(notify_ptr notify);
+
+/**
+ * @brief Close the descriptors of the notifier.
+ * @details No queue may still signal it. If the notifier was allocated on the
+ *          heap, it must be de-allocated manually.
+ *
+ * @param notify pointer to the notifier
+ *
+ * @return NOTIFY_ERROR_OK on success,
+ *         NOTIFY_ERROR_NULL_POINTER_RECEIVED if notify is a NULL pointer
+ */
+notify_error_t notify_free(notify_ptr notify);
+
+#endif //UNILIB_NOTIFY_H
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include "alloc.h"
+
 #ifndef UNILIB_OPTION_H
 #define UNILIB_OPTION_H
 
@@ -59,10 +61,22 @@ option_t option_new(option_status_t status, void * value);
  * Create a new optional value, allocated on the heap.
  * @param status the status of the optional value
  * @param value the value (can be NULL if the status is OPTION_NONE)
- * @return an optional value
+ * @return an optional value, or NULL if memory could not be allocated
  */
 option_ptr option_new_ptr(option_status_t status, void * value);
 
+/**
+ * Create a new optional value, allocated from an allocator.
+ * @details The optional value must be released with allocator_free.
+ * @param status the status of the optional value
+ * @param value the value (can be NULL if the status is OPTION_NONE)
+ * @param allocator pointer to the allocator, or NULL for the default allocator
+ * @return an optional value, or NULL if memory could not be allocated
+ */
+option_ptr option_new_ptr_with_allocator(option_status_t status,
+                                         void * value,
+                                         allocator_ptr allocator);
+
 /**
  * Create an empty optional value.
  * @return an empty optional value
@@ -109,4 +123,15 @@ uint8_t option_is_some(option_ptr option);
  */
 void option_free(option_ptr option);
 
+/**
+ * Free the memory occupied by an optional value, through an allocator.
+ * @param option the optional value
+ * @param size the size of the value
+ * @param allocator pointer to the allocator the value was allocated from, or
+ *        NULL for the default allocator
+ */
+void option_free_with_allocator(option_ptr option,
+                                size_t size,
+                                allocator_ptr allocator);
+
 #endif //UNILIB_OPTION_H
@@ -0,0 +1,215 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dequeue.h"
+#include "threadpool.h"
+
+#ifndef UNILIB_PAR_H
+#define UNILIB_PAR_H
+
+/**
+ * @brief The default minimum number of elements a chunk of work holds.
+ */
+#define PAR_DEFAULT_GRAIN 1024
+
+/**
+ * @brief How many chunks are cut per worker, so that stealing can even out
+ *        uneven chunks.
+ */
+#define PAR_CHUNKS_PER_WORKER 4
+
+/**
+ * Error type return by par functions.
+ */
+typedef uint8_t par_error_t;
+
+/**
+ * No error.
+ */
+#define PAR_ERROR_OK                    ((par_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define PAR_ERROR_NULL_POINTER_RECEIVED ((par_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define PAR_ERROR_ALLOC_FAILED          ((par_error_t) 2)
+/**
+ * The operations are missing a reduce or combine function, or a size.
+ */
+#define PAR_ERROR_INVALID_OPS           ((par_error_t) 3)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define PAR_ERROR_IS_OK(err) (err == PAR_ERROR_OK)
+
+/**
+ * Pointer to the `get` function of a splittable iterator.
+ * @details Receives the data of the iterator, the index of the element and a
+ *          scratch buffer of `scratch_size` bytes that the element may be
+ *          materialized into. Returns a pointer to the element.
+ */
+typedef void * (* par_iter_get_ptr)(void *, size_t, void *);
+
+/**
+ * @struct par_iter
+ * @brief A random-access source that can be split into chunks and walked by
+ *        several threads at once.
+ */
+typedef struct par_iter_t {
+    // pointer to the data of the iterator
+    void * data;
+    // the index of the first element passed to `get`
+    size_t offset;
+    // the number of elements
+    size_t len;
+    // pointer to the `get` function of the iterator
+    par_iter_get_ptr get;
+    // the size of the scratch buffer `get` may use
+    size_t scratch_size;
+} par_iter_t;
+
+/**
+ * Pointer to a splittable iterator.
+ */
+typedef par_iter_t * par_iter_ptr;
+
+/**
+ * @struct par_ops
+ * @brief The stages of a parallel filter/map/reduce pipeline.
+ * @details Every chunk of the input folds its elements into an accumulator
+ *          started from `identity`; the accumulators of the chunks are then
+ *          merged in input order with `combine`, which must be associative.
+ */
+typedef struct par_ops_t {
+    // keeps an element when it returns non-zero, or NULL to keep all of them
+    int (* filter)(const void * elem, void * ctx);
+    // writes the mapped value of an element, or NULL to reduce the elements
+    void (* map)(void * out, const void * elem, void * ctx);
+    // the size of a mapped value
+    size_t mapped_size;
+    // folds a value into an accumulator
+    void (* reduce)(void * acc, const void * value, void * ctx);
+    // merges the accumulator `other` into `acc`
+    void (* combine)(void * acc, const void * other, void * ctx);
+    // the initial value of every accumulator
+    const void * identity;
+    // the size of an accumulator
+    size_t acc_size;
+    // the minimum number of elements in a chunk, or 0 for the default
+    size_t grain;
+} par_ops_t;
+
+/**
+ * Pointer to the stages of a pipeline.
+ */
+typedef par_ops_t * par_ops_ptr;
+
+/**
+ * @brief Create a new splittable iterator.
+ * @param data pointer to the data of the iterator
+ * @param len the number of elements
+ * @param get pointer to the `get` function of the iterator
+ * @param scratch_size the size of the scratch buffer `get` may use
+ * @return a new iterator
+ */
+par_iter_t par_iter_new(void * data,
+                        size_t len,
+                        par_iter_get_ptr get,
+                        size_t scratch_size);
+
+/**
+ * @brief Create a splittable iterator over the elements of a dequeue.
+ * @details The dequeue must not be modified while the iterator is in use.
+ * @param dequeue pointer to the dequeue
+ * @return a new iterator, empty if dequeue is a NULL pointer
+ */
+par_iter_t par_iter_dequeue(dequeue_ptr dequeue);
+
+/**
+ * @brief Create a splittable iterator over the range [start, end).
+ * @details The elements are `size_t` values.
+ * @param start the first value
+ * @param end the value past the last one
+ * @return a new iterator, empty if end is not past start
+ */
+par_iter_t par_iter_range(size_t start, size_t end);
+
+/**
+ * @brief Split an iterator in two.
+ * @param iter pointer to the iterator
+ * @param at the number of elements that go to the left half
+ * @param left address of the iterator over the first `at` elements
+ * @param right address of the iterator over the remaining elements
+ * @return PAR_ERROR_OK on success,
+ *         PAR_ERROR_NULL_POINTER_RECEIVED if any pointer is NULL
+ */
+par_error_t par_iter_split(par_iter_ptr iter,
+                           size_t at,
+                           par_iter_ptr left,
+                           par_iter_ptr right);
+
+/**
+ * @brief Run a filter/map/reduce pipeline over an iterator on a thread pool.
+ * @details The input is cut into chunks of at least `grain` elements that
+ *          run as tasks on the pool. The calling thread runs tasks too until
+ *          the pipeline completes.
+ * @param pool pointer to the pool
+ * @param iter pointer to the iterator
+ * @param ops pointer to the stages of the pipeline
+ * @param ctx pointer passed to every stage
+ * @param result address the final accumulator is written to
+ * @return PAR_ERROR_OK on success,
+ *         PAR_ERROR_NULL_POINTER_RECEIVED if pool, iter, ops or result is a
+ *         NULL pointer,
+ *         PAR_ERROR_INVALID_OPS if a required stage or size is missing,
+ *         PAR_ERROR_ALLOC_FAILED if the chunks failed to allocate
+ */
+par_error_t par_reduce(threadpool_ptr pool,
+                       par_iter_ptr iter,
+                       par_ops_ptr ops,
+                       void * ctx,
+                       void * result);
+
+/**
+ * @brief Count the elements of an iterator that pass a filter, in parallel.
+ * @param pool pointer to the pool
+ * @param iter pointer to the iterator
+ * @param filter keeps an element when it returns non-zero, or NULL to count
+ *        every element
+ * @param ctx pointer passed to the filter
+ * @param count address the count is written to
+ * @return the same errors as par_reduce
+ */
+par_error_t par_count(threadpool_ptr pool,
+                      par_iter_ptr iter,
+                      int (* filter)(const void * elem, void * ctx),
+                      void * ctx,
+                      size_t * count);
+
+#endif //UNILIB_PAR_H
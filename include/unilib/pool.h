@@ -0,0 +1,164 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+
+#ifndef UNILIB_POOL_H
+#define UNILIB_POOL_H
+
+/**
+ * @brief Default size of a pool slab, one page on most systems.
+ */
+#define POOL_DEFAULT_SLAB_SIZE 4096
+
+/**
+ * @brief Minimum number of objects in a slab.
+ * @details Slabs are made larger than POOL_DEFAULT_SLAB_SIZE for objects too
+ *          large to fit this many in a page.
+ */
+#define POOL_MIN_OBJECTS_PER_SLAB 8
+
+/**
+ * Error type return by pool functions.
+ */
+typedef uint8_t pool_error_t;
+
+/**
+ * No error.
+ */
+#define POOL_ERROR_OK                    ((pool_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define POOL_ERROR_NULL_POINTER_RECEIVED ((pool_error_t) 1)
+/**
+ * The objects of the pool are too large.
+ */
+#define POOL_ERROR_OBJECT_TOO_LARGE      ((pool_error_t) 2)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define POOL_ERROR_IS_OK(err) (err == POOL_ERROR_OK)
+
+/**
+ * @struct pool_slab
+ * @brief A slab of memory objects are carved out of.
+ */
+typedef struct pool_slab_t {
+    // the next slab in the chain
+    struct pool_slab_t * next;
+} pool_slab_t;
+
+/**
+ * @struct pool
+ * @brief A fixed-size object allocator.
+ * @details Objects are carved out of slabs of memory and recycled through a
+ *          free list, so allocating and freeing an object is a couple of
+ *          pointer operations. Freed objects are handed out again first, while
+ *          they are still hot in the cache. Slabs are only released when the
+ *          pool is freed.
+ */
+typedef struct pool_t {
+    // the objects that were freed, linked through their first bytes
+    void * free_list;
+    // the slabs of the pool
+    pool_slab_t * slabs;
+    // the next object that was never handed out in the current slab
+    char * cursor;
+    // the end of the current slab
+    char * end;
+    // the size of an object, rounded up to hold a free list link
+    size_t object_size;
+    // the size of a slab
+    size_t slab_size;
+    // the allocator the slabs are allocated from
+    allocator_t allocator;
+} pool_t;
+
+/**
+ * @brief Pointer to a pool.
+ */
+typedef pool_t * pool_ptr;
+
+/**
+ * @brief Create a new pool.
+ * @details No memory is allocated until the first allocation.
+ *
+ * @param pool address to the pool that should be created
+ * @param object_size the size of the objects handed out by the pool
+ * @param allocator pointer to the allocator the slabs are allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return POOL_ERROR_OK on success,
+ *         POOL_ERROR_NULL_POINTER_RECEIVED if pool is a NULL pointer,
+ *         POOL_ERROR_OBJECT_TOO_LARGE if a slab of objects would not fit in
+ *         memory
+ */
+pool_error_t pool_new(pool_ptr pool, size_t object_size, allocator_ptr allocator);
+
+/**
+ * @brief Allocate an object from the pool.
+ *
+ * @param pool pointer to the pool
+ *
+ * @return pointer to the object, or NULL if memory could not be allocated
+ */
+void * pool_alloc(pool_ptr pool);
+
+/**
+ * @brief Give an object back to the pool.
+ *
+ * @param pool pointer to the pool
+ * @param object the object, which must have been allocated from this pool,
+ *        can be NULL
+ */
+void pool_dealloc(pool_ptr pool, void * object);
+
+/**
+ * @brief Get an allocator that allocates from the pool.
+ * @details Every allocation made through the allocator must fit in an object
+ *          of the pool.
+ *
+ * @param pool pointer to the pool
+ *
+ * @return an allocator backed by the pool
+ */
+allocator_t pool_allocator(pool_ptr pool);
+
+/**
+ * @brief Release the memory used by the pool.
+ * @details Every object allocated from the pool becomes invalid. If the pool
+ *          was allocated on the heap, it must be de-allocated manually.
+ *
+ * @param pool pointer to the pool
+ *
+ * @return POOL_ERROR_OK on success,
+ *         POOL_ERROR_NULL_POINTER_RECEIVED if pool is a NULL pointer
+ */
+pool_error_t pool_free(pool_ptr pool);
+
+#endif //UNILIB_POOL_H
@@ -0,0 +1,304 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "dequeue.h"
+
+#ifndef UNILIB_PQUEUE_H
+#define UNILIB_PQUEUE_H
+
+/**
+ * Error type return by pqueue functions.
+ */
+typedef uint8_t pqueue_error_t;
+
+/**
+ * No error.
+ */
+#define PQUEUE_ERROR_OK                    ((pqueue_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define PQUEUE_ERROR_NULL_POINTER_RECEIVED ((pqueue_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define PQUEUE_ERROR_ALLOC_FAILED          ((pqueue_error_t) 2)
+/**
+ * The arity of the heap must be at least 2.
+ */
+#define PQUEUE_ERROR_INVALID_ARITY         ((pqueue_error_t) 3)
+/**
+ * There are no items in the queue.
+ */
+#define PQUEUE_ERROR_EMPTY                 ((pqueue_error_t) 4)
+/**
+ * The handle does not refer to an element of the queue.
+ */
+#define PQUEUE_ERROR_INVALID_HANDLE        ((pqueue_error_t) 5)
+/**
+ * The new element orders after the one it replaces.
+ */
+#define PQUEUE_ERROR_KEY_INCREASED         ((pqueue_error_t) 6)
+/**
+ * The dequeue does not store its elements inline.
+ */
+#define PQUEUE_ERROR_ELEMENT_MISMATCH      ((pqueue_error_t) 7)
+/**
+ * The queue cannot grow past the maximum capacity of its dequeue.
+ */
+#define PQUEUE_ERROR_CAPACITY_EXCEEDED     ((pqueue_error_t) 8)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define PQUEUE_ERROR_IS_OK(err) (err == PQUEUE_ERROR_OK)
+
+/**
+ * The arity of a binary heap.
+ */
+#define PQUEUE_BINARY_ARITY 2
+
+/**
+ * The default arity: the four children of a node are usually on the same
+ * cache line, and the heap is half as deep as a binary one.
+ */
+#define PQUEUE_DEFAULT_ARITY 4
+
+/**
+ * Refers to an element of a queue for as long as it is in the queue.
+ * Handles of removed elements are reused by later pushes.
+ */
+typedef size_t pqueue_handle_t;
+
+/**
+ * @struct pqueue
+ * @brief A priority queue: a d-ary min-heap of elements stored inline.
+ * @details The heap is laid out in a dequeue with inline storage that is
+ *          only ever pushed and popped at the back, so it grows the same way
+ *          as any dequeue and its elements stay contiguous. Two parallel
+ *          dequeues map heap positions to handles and back, so that any
+ *          element can be found again after it moved. Removing an element
+ *          never allocates.
+ */
+typedef struct pqueue_t {
+    // the elements, in heap order
+    dequeue_t elements;
+    // the handle of the element at each heap position
+    dequeue_t handles;
+    // the heap position of each handle; unused handles are flagged and
+    // chained to the next unused one instead
+    dequeue_t positions;
+    // the first unused handle, reused before new ones are made
+    size_t free_handle;
+    // the number of children of a node
+    size_t arity;
+    // orders the elements: the smallest one is popped first
+    dequeue_compare_ptr compare;
+    // room for the element being moved through the heap
+    void * scratch;
+} pqueue_t;
+
+/**
+ * @brief Pointer to a priority queue.
+ */
+typedef pqueue_t * pqueue_ptr;
+
+/**
+ * @brief Create a new priority queue.
+ *
+ * @param pqueue address to the queue that should be created
+ * @param element_size the size of an element
+ * @param arity the number of children of a node, at least 2
+ * @param compare the comparison function, which receives the addresses of
+ *        two elements
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue or compare is a NULL
+ *         pointer,
+ *         PQUEUE_ERROR_INVALID_ARITY if arity is less than 2,
+ *         PQUEUE_ERROR_ALLOC_FAILED if the queue failed to allocate
+ */
+pqueue_error_t pqueue_new(pqueue_ptr pqueue,
+                          size_t element_size,
+                          size_t arity,
+                          dequeue_compare_ptr compare);
+
+/**
+ * @brief Create a new priority queue taking its memory from an allocator.
+ * @see pqueue_new
+ *
+ * @param pqueue address to the queue that should be created
+ * @param element_size the size of an element
+ * @param arity the number of children of a node, at least 2
+ * @param compare the comparison function
+ * @param allocator pointer to the allocator, or NULL for the default
+ *        allocator
+ *
+ * @return the same errors as pqueue_new
+ */
+pqueue_error_t pqueue_new_with_allocator(pqueue_ptr pqueue,
+                                         size_t element_size,
+                                         size_t arity,
+                                         dequeue_compare_ptr compare,
+                                         allocator_ptr allocator);
+
+/**
+ * @brief Turn a dequeue into a priority queue in O(n).
+ * @details The ring of the dequeue is moved into the queue and heapified in
+ *          place, without copying the elements. The dequeue must not be used
+ *          or freed afterwards. The handle of each element is its position in
+ *          the dequeue before the call.
+ *
+ * @param pqueue address to the queue that should be created
+ * @param dequeue pointer to a dequeue storing its elements inline
+ * @param arity the number of children of a node, at least 2
+ * @param compare the comparison function
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue, dequeue or compare is
+ *         a NULL pointer,
+ *         PQUEUE_ERROR_INVALID_ARITY if arity is less than 2,
+ *         PQUEUE_ERROR_ELEMENT_MISMATCH if the dequeue stores pointers to
+ *         elements,
+ *         PQUEUE_ERROR_ALLOC_FAILED if the queue failed to allocate, in which
+ *         case the dequeue is left untouched
+ */
+pqueue_error_t pqueue_from_dequeue(pqueue_ptr pqueue,
+                                   dequeue_ptr dequeue,
+                                   size_t arity,
+                                   dequeue_compare_ptr compare);
+
+/**
+ * @brief Get the number of elements in a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ *
+ * @return the number of elements, or 0 if pqueue is a NULL pointer
+ */
+size_t pqueue_len(pqueue_ptr pqueue);
+
+/**
+ * @brief Push a copy of an element into a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ * @param elem the element to copy
+ * @param handle where to store the handle of the element, or NULL
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue or elem is a NULL
+ *         pointer,
+ *         PQUEUE_ERROR_ALLOC_FAILED if the queue failed to grow,
+ *         PQUEUE_ERROR_CAPACITY_EXCEEDED if the queue was made from a bounded
+ *         dequeue that is full
+ */
+pqueue_error_t pqueue_push(pqueue_ptr pqueue,
+                           const void * elem,
+                           pqueue_handle_t * handle);
+
+/**
+ * @brief Get the smallest element of a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ *
+ * @return the address of the element inside the queue, valid until the
+ *         queue is next modified, or NULL if the queue is empty or pqueue is
+ *         a NULL pointer
+ */
+void * pqueue_peek(pqueue_ptr pqueue);
+
+/**
+ * @brief Remove the smallest element of a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ * @param dst buffer of at least element_size bytes the element is copied
+ *        into, or NULL to drop it
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue is a NULL pointer,
+ *         PQUEUE_ERROR_EMPTY if there are no items in the queue
+ */
+pqueue_error_t pqueue_pop(pqueue_ptr pqueue, void * dst);
+
+/**
+ * @brief Get the element a handle refers to.
+ *
+ * @param pqueue pointer to the queue
+ * @param handle the handle of the element
+ *
+ * @return the address of the element inside the queue, valid until the
+ *         queue is next modified, or NULL if the handle is not in use or
+ *         pqueue is a NULL pointer
+ */
+void * pqueue_get(pqueue_ptr pqueue, pqueue_handle_t handle);
+
+/**
+ * @brief Replace an element with one that orders no later.
+ * @details The element moves up the heap to its new place in O(log n), and
+ *          keeps its handle.
+ *
+ * @param pqueue pointer to the queue
+ * @param handle the handle of the element
+ * @param elem the new element to copy
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue or elem is a NULL
+ *         pointer,
+ *         PQUEUE_ERROR_INVALID_HANDLE if the handle is not in use,
+ *         PQUEUE_ERROR_KEY_INCREASED if the new element orders after the old
+ *         one, in which case the queue is left untouched
+ */
+pqueue_error_t pqueue_decrease_key(pqueue_ptr pqueue,
+                                   pqueue_handle_t handle,
+                                   const void * elem);
+
+/**
+ * @brief Remove any element of a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ * @param handle the handle of the element
+ * @param dst buffer of at least element_size bytes the element is copied
+ *        into, or NULL to drop it
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue is a NULL pointer,
+ *         PQUEUE_ERROR_INVALID_HANDLE if the handle is not in use
+ */
+pqueue_error_t pqueue_remove(pqueue_ptr pqueue,
+                             pqueue_handle_t handle,
+                             void * dst);
+
+/**
+ * @brief Free a priority queue.
+ *
+ * @param pqueue pointer to the queue
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_NULL_POINTER_RECEIVED if pqueue is a NULL pointer
+ */
+pqueue_error_t pqueue_free(pqueue_ptr pqueue);
+
+#endif //UNILIB_PQUEUE_H
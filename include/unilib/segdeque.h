@@ -0,0 +1,272 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "iter.h"
+
+#ifndef UNILIB_SEGDEQUE_H
+#define UNILIB_SEGDEQUE_H
+
+/**
+ * Error type return by segdeque functions.
+ */
+typedef uint8_t segdeque_error_t;
+
+/**
+ * No error.
+ */
+#define SEGDEQUE_ERROR_OK                    ((segdeque_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define SEGDEQUE_ERROR_NULL_POINTER_RECEIVED ((segdeque_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define SEGDEQUE_ERROR_ALLOC_FAILED          ((segdeque_error_t) 2)
+/**
+ * The number of elements per block must be a power of two.
+ */
+#define SEGDEQUE_ERROR_INVALID_BLOCK_LEN     ((segdeque_error_t) 3)
+/**
+ * There are no items in the deque.
+ */
+#define SEGDEQUE_ERROR_EMPTY                 ((segdeque_error_t) 4)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define SEGDEQUE_ERROR_IS_OK(err) (err == SEGDEQUE_ERROR_OK)
+
+/**
+ * The size in bytes the blocks are cut to by default.
+ */
+#define SEGDEQUE_DEFAULT_BLOCK_SIZE 4096
+
+/**
+ * @struct segdeque
+ * @brief A double-ended queue made of fixed-size blocks.
+ * @details The elements are stored inline in blocks of `block_len` elements,
+ *          and a map holds the pointers to the blocks in order. The deque
+ *          grows at either end by adding a block and shrinks by releasing
+ *          one, so existing elements never move: their addresses stay valid
+ *          until they are popped, and no push copies more than the map of
+ *          block pointers, which is `block_len` times smaller than the
+ *          elements. One released block is kept aside so that a queue
+ *          hovering around a block boundary does not keep allocating.
+ */
+typedef struct segdeque_t {
+    // the map of blocks, used from first_block for block_count entries
+    char ** blocks;
+    // the number of entries of the map
+    size_t map_capacity;
+    // the index in the map of the block holding the front element
+    size_t first_block;
+    // the number of blocks in use
+    size_t block_count;
+    // the index of the front element in its block
+    size_t head;
+    // the length of the deque
+    size_t len;
+    // the size of an element
+    size_t element_size;
+    // the number of elements in a block, a power of two
+    size_t block_len;
+    // log2(block_len), to map a position onto a block
+    size_t block_shift;
+    // a released block kept for the next growth, or NULL
+    char * spare;
+    // the allocator used for the blocks and the map
+    allocator_t allocator;
+} segdeque_t;
+
+/**
+ * @brief Pointer to a segmented deque.
+ */
+typedef segdeque_t * segdeque_ptr;
+
+/**
+ * @brief Create a new segmented deque.
+ * @details The blocks hold as many elements as fit in
+ *          SEGDEQUE_DEFAULT_BLOCK_SIZE bytes, rounded down to a power of two,
+ *          and at least one. No memory is allocated until the first push.
+ *
+ * @param segdeque address to the deque that should be created
+ * @param element_size the size of an element
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer
+ */
+segdeque_error_t segdeque_new(segdeque_ptr segdeque, size_t element_size);
+
+/**
+ * @brief Create a new segmented deque with blocks of a given length.
+ * @see segdeque_new
+ *
+ * @param segdeque address to the deque that should be created
+ * @param element_size the size of an element
+ * @param block_len the number of elements in a block, a power of two
+ * @param allocator pointer to the allocator, or NULL for the default
+ *        allocator; the allocator is copied into the deque
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer,
+ *         SEGDEQUE_ERROR_INVALID_BLOCK_LEN if block_len is not a power of two
+ */
+segdeque_error_t segdeque_new_with_block_len(segdeque_ptr segdeque,
+                                             size_t element_size,
+                                             size_t block_len,
+                                             allocator_ptr allocator);
+
+/**
+ * @brief Get the element at a position of the deque.
+ *
+ * @param segdeque pointer to the deque
+ * @param pos the position, relative to the front of the deque
+ *
+ * @return the address of the element, valid until it is popped, or NULL if
+ *         pos is out of bounds or segdeque is a NULL pointer
+ */
+void * segdeque_get(segdeque_ptr segdeque, size_t pos);
+
+/**
+ * @brief Get the front element of the deque.
+ * @see segdeque_get
+ */
+void * segdeque_front(segdeque_ptr segdeque);
+
+/**
+ * @brief Get the back element of the deque.
+ * @see segdeque_get
+ */
+void * segdeque_back(segdeque_ptr segdeque);
+
+/**
+ * @brief Copy an element at the back of the deque.
+ * @details At most one block is allocated, and the map of blocks may be
+ *          reallocated; the elements themselves never move.
+ *
+ * @param segdeque pointer to the deque
+ * @param elem the element to copy
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque or elem is a NULL
+ *         pointer,
+ *         SEGDEQUE_ERROR_ALLOC_FAILED if the deque failed to grow
+ */
+segdeque_error_t segdeque_push_back(segdeque_ptr segdeque, const void * elem);
+
+/**
+ * @brief Copy an element at the front of the deque.
+ * @see segdeque_push_back
+ */
+segdeque_error_t segdeque_push_front(segdeque_ptr segdeque, const void * elem);
+
+/**
+ * @brief Pop the back element of the deque.
+ * @details A block left empty is released.
+ *
+ * @param segdeque pointer to the deque
+ * @param dst buffer of at least element_size bytes the element is copied
+ *        into, or NULL to drop it
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer,
+ *         SEGDEQUE_ERROR_EMPTY if there are no items in the deque
+ */
+segdeque_error_t segdeque_pop_back(segdeque_ptr segdeque, void * dst);
+
+/**
+ * @brief Pop the front element of the deque.
+ * @see segdeque_pop_back
+ */
+segdeque_error_t segdeque_pop_front(segdeque_ptr segdeque, void * dst);
+
+/**
+ * @brief Release the block kept aside for growth.
+ *
+ * @param segdeque pointer to the deque
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer
+ */
+segdeque_error_t segdeque_shrink_to_fit(segdeque_ptr segdeque);
+
+/**
+ * @brief Empty a deque, releasing its blocks.
+ * @details As when the deque drains, one block is kept aside for growth. The
+ *          map of blocks is kept as well.
+ *
+ * @param segdeque pointer to the deque
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer
+ */
+segdeque_error_t segdeque_empty(segdeque_ptr segdeque);
+
+/**
+ * @brief Free a deque.
+ *
+ * @param segdeque pointer to the deque
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_NULL_POINTER_RECEIVED if segdeque is a NULL pointer
+ */
+segdeque_error_t segdeque_free(segdeque_ptr segdeque);
+
+/**
+ * @struct segdeque_iter
+ * @brief The state of an iterator over a segmented deque.
+ */
+typedef struct segdeque_iter_t {
+    // the deque being iterated
+    segdeque_ptr segdeque;
+    // the position of the next element taken from the front
+    size_t front;
+    // the position past the next element taken from the back
+    size_t back;
+} segdeque_iter_t;
+
+/**
+ * @brief Pointer to the state of an iterator over a segmented deque.
+ */
+typedef segdeque_iter_t * segdeque_iter_ptr;
+
+/**
+ * @brief Create an iterator over the elements of a deque, front to back.
+ * @details As with dequeue_iter, the state lives in `state` and nothing is
+ *          allocated. The iterator yields the addresses of the elements, is
+ *          double-ended, knows its exact length and skips in constant time.
+ *          The deque must not be modified while the iterator is in use.
+ *
+ * @param segdeque pointer to the deque, or NULL for an empty iterator
+ * @param state the state of the iterator, which must outlive it
+ *
+ * @return a new iterator
+ */
+iter_t segdeque_iter(segdeque_ptr segdeque, segdeque_iter_ptr state);
+
+#endif //UNILIB_SEGDEQUE_H
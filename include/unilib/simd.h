@@ -0,0 +1,203 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef UNILIB_SIMD_H
+#define UNILIB_SIMD_H
+
+/**
+ * @enum simd_level
+ * @brief The instruction sets the kernels can be dispatched to.
+ */
+typedef enum simd_level_t {
+    // plain C loops
+    SIMD_LEVEL_SCALAR = 0,
+    // 128-bit SSE2 vectors
+    SIMD_LEVEL_SSE2 = 1,
+    // 256-bit AVX2 vectors
+    SIMD_LEVEL_AVX2 = 2,
+    // 512-bit AVX-512 vectors (AVX-512F, with AVX-512BW for byte search)
+    SIMD_LEVEL_AVX512 = 3,
+} simd_level_t;
+
+/**
+ * @brief Get the best level the CPU supports.
+ * @details Always SIMD_LEVEL_SCALAR on non-x86 targets.
+ *
+ * @return the best supported level
+ */
+simd_level_t simd_detect(void);
+
+/**
+ * @brief Get the level the kernels are dispatched to.
+ * @details Defaults to the best level the CPU supports.
+ *
+ * @return the active level
+ */
+simd_level_t simd_level(void);
+
+/**
+ * @brief Change the level the kernels are dispatched to.
+ * @details Mostly useful to compare levels. Levels the CPU does not support
+ *          are lowered to the best supported one.
+ *
+ * @param level the requested level
+ *
+ * @return the level now active
+ */
+simd_level_t simd_set_level(simd_level_t level);
+
+/**
+ * @brief Add up an array of int32_t.
+ *
+ * @param elems the array
+ * @param n the number of elements
+ *
+ * @return the sum, without overflow below 2^32 elements
+ */
+int64_t simd_sum_i32(const int32_t * elems, size_t n);
+
+/**
+ * @brief Add up an array of int64_t, wrapping on overflow.
+ */
+int64_t simd_sum_i64(const int64_t * elems, size_t n);
+
+/**
+ * @brief Add up an array of floats.
+ * @details The additions are reordered across vector lanes, so the rounding
+ *          may differ from a sequential loop.
+ */
+float simd_sum_f32(const float * elems, size_t n);
+
+/**
+ * @brief Add up an array of doubles.
+ * @see simd_sum_f32
+ */
+double simd_sum_f64(const double * elems, size_t n);
+
+/**
+ * @brief Get the smallest and largest elements of an array of int32_t.
+ *
+ * @param elems the array
+ * @param n the number of elements
+ * @param min address the smallest element is written to
+ * @param max address the largest element is written to
+ *
+ * @return 1 on success, 0 if the array is empty
+ */
+int simd_min_max_i32(const int32_t * elems,
+                     size_t n,
+                     int32_t * min,
+                     int32_t * max);
+
+/**
+ * @brief Get the smallest and largest elements of an array of int64_t.
+ * @see simd_min_max_i32
+ */
+int simd_min_max_i64(const int64_t * elems,
+                     size_t n,
+                     int64_t * min,
+                     int64_t * max);
+
+/**
+ * @brief Get the smallest and largest elements of an array of floats.
+ * @details The result is unspecified if the array holds NaNs.
+ * @see simd_min_max_i32
+ */
+int simd_min_max_f32(const float * elems, size_t n, float * min, float * max);
+
+/**
+ * @brief Get the smallest and largest elements of an array of doubles.
+ * @see simd_min_max_f32
+ */
+int simd_min_max_f64(const double * elems,
+                     size_t n,
+                     double * min,
+                     double * max);
+
+/**
+ * @brief Count the elements of an array of int32_t equal to a value.
+ *
+ * @param elems the array
+ * @param n the number of elements
+ * @param value the value to count
+ *
+ * @return the number of elements equal to the value
+ */
+size_t simd_count_eq_i32(const int32_t * elems, size_t n, int32_t value);
+
+/**
+ * @brief Count the elements of an array of int64_t equal to a value.
+ */
+size_t simd_count_eq_i64(const int64_t * elems, size_t n, int64_t value);
+
+/**
+ * @brief Count the elements of an array of floats equal to a value.
+ */
+size_t simd_count_eq_f32(const float * elems, size_t n, float value);
+
+/**
+ * @brief Count the elements of an array of doubles equal to a value.
+ */
+size_t simd_count_eq_f64(const double * elems, size_t n, double value);
+
+/**
+ * @brief Find the first element of an array of int32_t equal to a value.
+ *
+ * @param elems the array
+ * @param n the number of elements
+ * @param value the value to find
+ *
+ * @return the index of the element, or n if no element is equal to the value
+ */
+size_t simd_find_i32(const int32_t * elems, size_t n, int32_t value);
+
+/**
+ * @brief Find the first element of an array of int64_t equal to a value.
+ */
+size_t simd_find_i64(const int64_t * elems, size_t n, int64_t value);
+
+/**
+ * @brief Find the first element of an array of floats equal to a value.
+ */
+size_t simd_find_f32(const float * elems, size_t n, float value);
+
+/**
+ * @brief Find the first element of an array of doubles equal to a value.
+ */
+size_t simd_find_f64(const double * elems, size_t n, double value);
+
+/**
+ * @brief Find the first occurrence of a byte, like memchr.
+ *
+ * @param bytes the bytes to search
+ * @param n the number of bytes
+ * @param byte the byte to find
+ *
+ * @return the offset of the byte, or n if it does not occur
+ */
+size_t simd_find_byte(const void * bytes, size_t n, uint8_t byte);
+
+#endif //UNILIB_SIMD_H
@@ -0,0 +1,302 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "dequeue.h"
+
+#ifndef UNILIB_SPILLDEQUE_H
+#define UNILIB_SPILLDEQUE_H
+
+/**
+ * Error type return by spilldeque functions.
+ */
+typedef uint8_t spilldeque_error_t;
+
+/**
+ * No error.
+ */
+#define SPILLDEQUE_ERROR_OK                    ((spilldeque_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED ((spilldeque_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define SPILLDEQUE_ERROR_ALLOC_FAILED          ((spilldeque_error_t) 2)
+/**
+ * The number of elements per block must be a power of two.
+ */
+#define SPILLDEQUE_ERROR_INVALID_BLOCK_LEN     ((spilldeque_error_t) 3)
+/**
+ * The memory budget must hold at least SPILLDEQUE_MIN_BUDGET_BLOCKS blocks.
+ */
+#define SPILLDEQUE_ERROR_BUDGET_TOO_SMALL      ((spilldeque_error_t) 4)
+/**
+ * There are no items in the deque.
+ */
+#define SPILLDEQUE_ERROR_EMPTY                 ((spilldeque_error_t) 5)
+/**
+ * A system call on the scratch file failed; errno tells why.
+ */
+#define SPILLDEQUE_ERROR_IO                    ((spilldeque_error_t) 6)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define SPILLDEQUE_ERROR_IS_OK(err) (err == SPILLDEQUE_ERROR_OK)
+
+/**
+ * The size in bytes the blocks are cut to by default.
+ */
+#define SPILLDEQUE_DEFAULT_BLOCK_SIZE 65536
+
+/**
+ * The fewest blocks the memory budget must hold: one for each end of the
+ * deque, and one more to spill from.
+ */
+#define SPILLDEQUE_MIN_BUDGET_BLOCKS 3
+
+/**
+ * @struct spilldeque_block
+ * @brief A block of a spilling deque, in memory or in the scratch file.
+ */
+typedef struct spilldeque_block_t {
+    // the elements of the block while it is in memory, or NULL
+    char * data;
+    // the slot of the scratch file holding the block while it is spilled
+    size_t slot;
+} spilldeque_block_t;
+
+/**
+ * @struct spilldeque
+ * @brief A double-ended queue that spills to disk past a memory budget.
+ * @details The elements are stored inline in blocks of `block_len` elements,
+ *          like in a segdeque, and the blocks are kept in a dequeue. Blocks
+ *          in memory form two runs, one at the front and one at the back of
+ *          the deque. When a new block would take the deque past its memory
+ *          budget, the innermost block of the longer run is copied into a
+ *          slot of a scratch file through a shared mapping and released, so
+ *          the middle of a backlog lives on disk while both ends stay in
+ *          memory. When a consumer reaches a spilled block, it is copied
+ *          back and its slot is reused.
+ *
+ *          The scratch file is created in the given directory and unlinked
+ *          right away, so it disappears with the deque or the process. Its
+ *          space is reserved as it grows, so a full disk is reported as
+ *          SPILLDEQUE_ERROR_IO rather than as a fault on the mapping. The
+ *          budget covers the blocks only, not the dequeue of blocks and the
+ *          list of free slots, which take a few words per block.
+ */
+typedef struct spilldeque_t {
+    // the blocks, as spilldeque_block_t, the one holding the front first
+    dequeue_t blocks;
+    // the index of the front element in its block
+    size_t head;
+    // the length of the deque
+    size_t len;
+    // the size of an element
+    size_t element_size;
+    // the number of elements in a block, a power of two
+    size_t block_len;
+    // log2(block_len), to map a position onto a block
+    size_t block_shift;
+    // the size of a block in bytes
+    size_t block_size;
+    // the distance between two slots of the scratch file, a multiple of the
+    // page size
+    size_t slot_size;
+    // the most blocks kept in memory at once
+    size_t budget_blocks;
+    // the number of blocks in memory at the front of the deque
+    size_t front_hot;
+    // the number of blocks in memory at the back of the deque
+    size_t back_hot;
+    // the scratch file, already unlinked
+    int fd;
+    // the number of slots the scratch file has room for
+    size_t file_capacity;
+    // the number of slots of the scratch file handed out so far
+    size_t file_slots;
+    // the slots handed out and free again, as size_t
+    dequeue_t free_slots;
+    // the allocator used for the blocks
+    allocator_t allocator;
+} spilldeque_t;
+
+/**
+ * @brief Pointer to a spilling deque.
+ */
+typedef spilldeque_t * spilldeque_ptr;
+
+/**
+ * @brief Create a new spilling deque.
+ * @details The blocks hold as many elements as fit in
+ *          SPILLDEQUE_DEFAULT_BLOCK_SIZE bytes, rounded down to a power of
+ *          two, and at least one.
+ *
+ * @param spilldeque address to the deque that should be created
+ * @param element_size the size of an element
+ * @param memory_budget the most bytes of elements kept in memory
+ * @param dir the directory the scratch file is created in, or NULL for
+ *        $TMPDIR, or /tmp if it is not set
+ *
+ * @return the same errors as spilldeque_new_with_block_len
+ */
+spilldeque_error_t spilldeque_new(spilldeque_ptr spilldeque,
+                                  size_t element_size,
+                                  size_t memory_budget,
+                                  const char * dir);
+
+/**
+ * @brief Create a new spilling deque with the given number of elements per
+ *        block.
+ *
+ * @param spilldeque address to the deque that should be created
+ * @param element_size the size of an element
+ * @param block_len the number of elements per block, a power of two
+ * @param memory_budget the most bytes of elements kept in memory
+ * @param dir the directory the scratch file is created in, or NULL for
+ *        $TMPDIR, or /tmp if it is not set
+ * @param allocator pointer to the allocator, or NULL for the default
+ *        allocator; the allocator is copied into the deque
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED if spilldeque is a NULL
+ *         pointer,
+ *         SPILLDEQUE_ERROR_INVALID_BLOCK_LEN if block_len is not a power of
+ *         two,
+ *         SPILLDEQUE_ERROR_BUDGET_TOO_SMALL if the budget holds fewer than
+ *         SPILLDEQUE_MIN_BUDGET_BLOCKS blocks,
+ *         SPILLDEQUE_ERROR_ALLOC_FAILED if the deque failed to allocate,
+ *         SPILLDEQUE_ERROR_IO if the scratch file could not be created
+ */
+spilldeque_error_t spilldeque_new_with_block_len(spilldeque_ptr spilldeque,
+                                                 size_t element_size,
+                                                 size_t block_len,
+                                                 size_t memory_budget,
+                                                 const char * dir,
+                                                 allocator_ptr allocator);
+
+/**
+ * @brief Get the front element of the deque.
+ * @details The front block is read back from the scratch file if needed. The
+ *          pointer stays valid until the next push or pop.
+ *
+ * @return a pointer to the element, or NULL if the deque is empty or the
+ *         block could not be read back
+ */
+void * spilldeque_front(spilldeque_ptr spilldeque);
+
+/**
+ * @brief Get the back element of the deque.
+ * @see spilldeque_front
+ */
+void * spilldeque_back(spilldeque_ptr spilldeque);
+
+/**
+ * @brief Copy an element at the back of the deque.
+ * @details Adding a block past the memory budget spills one first.
+ *
+ * @param spilldeque pointer to the deque
+ * @param elem the element to be copied into the deque
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED if spilldeque or elem is a
+ *         NULL pointer,
+ *         SPILLDEQUE_ERROR_ALLOC_FAILED if a block could not be allocated,
+ *         SPILLDEQUE_ERROR_IO if a block could not be spilled or read back
+ */
+spilldeque_error_t spilldeque_push_back(spilldeque_ptr spilldeque,
+                                        const void * elem);
+
+/**
+ * @brief Copy an element at the front of the deque.
+ * @see spilldeque_push_back
+ */
+spilldeque_error_t spilldeque_push_front(spilldeque_ptr spilldeque,
+                                         const void * elem);
+
+/**
+ * @brief Pop the element at the back of the deque.
+ * @details The back block is read back from the scratch file first if
+ *          needed.
+ *
+ * @param spilldeque pointer to the deque
+ * @param dst address the element is copied to, or NULL to drop it
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED if spilldeque is a NULL
+ *         pointer,
+ *         SPILLDEQUE_ERROR_EMPTY if there are no items in the deque,
+ *         SPILLDEQUE_ERROR_ALLOC_FAILED if a block could not be allocated,
+ *         SPILLDEQUE_ERROR_IO if a block could not be spilled or read back
+ */
+spilldeque_error_t spilldeque_pop_back(spilldeque_ptr spilldeque, void * dst);
+
+/**
+ * @brief Pop the element at the front of the deque.
+ * @see spilldeque_pop_back
+ */
+spilldeque_error_t spilldeque_pop_front(spilldeque_ptr spilldeque,
+                                        void * dst);
+
+/**
+ * @brief Get the number of blocks currently spilled to the scratch file.
+ *
+ * @param spilldeque pointer to the deque
+ *
+ * @return the number of spilled blocks, or 0 if spilldeque is a NULL pointer
+ */
+size_t spilldeque_spilled(spilldeque_ptr spilldeque);
+
+/**
+ * @brief Remove every element of the deque.
+ * @details Every block is released and every slot of the scratch file is
+ *          free again.
+ *
+ * @param spilldeque pointer to the deque
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED if spilldeque is a NULL
+ *         pointer
+ */
+spilldeque_error_t spilldeque_empty(spilldeque_ptr spilldeque);
+
+/**
+ * @brief Release the memory and the scratch file used by the deque.
+ * @details If the deque was allocated on the heap, it must be de-allocated
+ *          manually.
+ *
+ * @param spilldeque pointer to the deque
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED if spilldeque is a NULL
+ *         pointer
+ */
+spilldeque_error_t spilldeque_free(spilldeque_ptr spilldeque);
+
+#endif //UNILIB_SPILLDEQUE_H
@@ -0,0 +1,195 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "config.h"
+#include "notify.h"
+
+#ifndef UNILIB_SPSC_H
+#define UNILIB_SPSC_H
+
+/**
+ * Error type return by spsc functions.
+ */
+typedef uint8_t spsc_error_t;
+
+/**
+ * No error.
+ */
+#define SPSC_ERROR_OK                    ((spsc_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define SPSC_ERROR_NULL_POINTER_RECEIVED ((spsc_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define SPSC_ERROR_ALLOC_FAILED          ((spsc_error_t) 2)
+/**
+ * The queue cannot be created with a capacity of 0.
+ */
+#define SPSC_ERROR_ZERO_CAPACITY         ((spsc_error_t) 3)
+/**
+ * There is no room left in the queue.
+ */
+#define SPSC_ERROR_FULL                  ((spsc_error_t) 4)
+/**
+ * There are no items in the queue.
+ */
+#define SPSC_ERROR_EMPTY                 ((spsc_error_t) 5)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define SPSC_ERROR_IS_OK(err) (err == SPSC_ERROR_OK)
+
+/**
+ * @struct spsc
+ * @brief A bounded, lock-free, single-producer single-consumer queue.
+ * @details Like a dequeue, the queue holds pointers to elements, in a ring
+ *          whose capacity is a power of two. Exactly one thread may push and
+ *          exactly one thread may pop at a time; pushing and popping never
+ *          block and never allocate. The consumer index and the producer index
+ *          live on separate cache lines, and each side keeps a cached copy of
+ *          the other side's index so that it only reads the shared one when
+ *          the queue looks full (or empty).
+ */
+typedef struct spsc_t {
+    // ring of elements
+    void ** elements;
+    // the capacity of the queue, a power of two
+    size_t capacity;
+    // capacity - 1, to map an index onto the ring
+    size_t mask;
+    // the allocator the ring is allocated from
+    allocator_t allocator;
+    // the notifier signalled when a push finds the queue empty, or NULL
+    notify_ptr notify;
+    char pad_head[UNILIB_CACHE_LINE_SIZE];
+    // the index of the next element to pop, written by the consumer
+    atomic_size_t head;
+    // the last tail seen by the consumer
+    size_t cached_tail;
+    char pad_tail[UNILIB_CACHE_LINE_SIZE];
+    // the index of the next element to push, written by the producer
+    atomic_size_t tail;
+    // the last head seen by the producer
+    size_t cached_head;
+    char pad_end[UNILIB_CACHE_LINE_SIZE];
+} spsc_t;
+
+/**
+ * @brief Pointer to a spsc queue.
+ */
+typedef spsc_t * spsc_ptr;
+
+/**
+ * @brief Create a new spsc queue.
+ * @details The capacity is rounded up to the next power of two.
+ *
+ * @param spsc address to the queue that should be created
+ * @param capacity the minimum capacity of the queue
+ * @param allocator pointer to the allocator the ring is allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return SPSC_ERROR_OK on success,
+ *         SPSC_ERROR_NULL_POINTER_RECEIVED if spsc is a NULL pointer,
+ *         SPSC_ERROR_ZERO_CAPACITY if capacity is 0,
+ *         SPSC_ERROR_ALLOC_FAILED if the queue failed to allocate
+ */
+spsc_error_t spsc_new(spsc_ptr spsc, size_t capacity, allocator_ptr allocator);
+
+/**
+ * @brief Push an item at the back of the queue, from the producer thread.
+ * @details The queue does not take ownership of the element, it is only
+ *          handed over to the consumer.
+ *
+ * @param spsc pointer to the queue
+ * @param elem the element to be added to the queue
+ *
+ * @return SPSC_ERROR_OK on success,
+ *         SPSC_ERROR_NULL_POINTER_RECEIVED if spsc is a NULL pointer,
+ *         SPSC_ERROR_FULL if there is no room left in the queue
+ */
+spsc_error_t spsc_try_push(spsc_ptr spsc, void * elem);
+
+/**
+ * @brief Pop an item from the front of the queue, from the consumer thread.
+ *
+ * @param spsc pointer to the queue
+ * @param elem address where to place the element removed from the queue
+ *
+ * @return SPSC_ERROR_OK on success,
+ *         SPSC_ERROR_NULL_POINTER_RECEIVED if spsc or elem is a NULL pointer,
+ *         SPSC_ERROR_EMPTY if there are no items in the queue
+ */
+spsc_error_t spsc_try_pop(spsc_ptr spsc, void ** elem);
+
+/**
+ * @brief Signal a notifier whenever a push finds the queue empty.
+ * @details This lets the consumer wait for items on the descriptor of the
+ *          notifier, following the protocol described in notify_t. With a
+ *          notifier, a push also reads the index of the consumer, and a pop
+ *          that finds the queue empty looks again after a fence, so that a
+ *          push racing with the last pop before the consumer waits is never
+ *          missed. Must be called before the queue is shared. The notifier is
+ *          signalled right away if the queue already holds items, and it
+ *          must outlive the queue.
+ * @see notify_t
+ *
+ * @param spsc pointer to the queue
+ * @param notify pointer to the notifier, or NULL to stop signalling
+ *
+ * @return SPSC_ERROR_OK on success,
+ *         SPSC_ERROR_NULL_POINTER_RECEIVED if spsc is a NULL pointer
+ */
+spsc_error_t spsc_set_notify(spsc_ptr spsc, notify_ptr notify);
+
+/**
+ * @brief Get the number of items in the queue.
+ * @details The result is only a snapshot if the queue is being used by other
+ *          threads.
+ *
+ * @param spsc pointer to the queue
+ *
+ * @return the number of items in the queue, or 0 if spsc is a NULL pointer
+ */
+size_t spsc_len(spsc_ptr spsc);
+
+/**
+ * @brief Release the memory used by the queue.
+ * @details The elements left in the queue are not released. If the queue was
+ *          allocated on the heap, it must be de-allocated manually.
+ *
+ * @param spsc pointer to the queue
+ *
+ * @return SPSC_ERROR_OK on success,
+ *         SPSC_ERROR_NULL_POINTER_RECEIVED if spsc is a NULL pointer
+ */
+spsc_error_t spsc_free(spsc_ptr spsc);
+
+#endif //UNILIB_SPSC_H
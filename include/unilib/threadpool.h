@@ -0,0 +1,234 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "mpmc.h"
+#include "wsdeque.h"
+
+#ifndef UNILIB_THREADPOOL_H
+#define UNILIB_THREADPOOL_H
+
+/**
+ * @brief Capacity of the queue tasks submitted from outside the pool go
+ *        through.
+ */
+#define THREADPOOL_INJECTOR_CAPACITY 4096
+
+/**
+ * Error type return by threadpool functions.
+ */
+typedef uint8_t threadpool_error_t;
+
+/**
+ * No error.
+ */
+#define THREADPOOL_ERROR_OK                    ((threadpool_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define THREADPOOL_ERROR_NULL_POINTER_RECEIVED ((threadpool_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define THREADPOOL_ERROR_ALLOC_FAILED          ((threadpool_error_t) 2)
+/**
+ * A worker thread could not be started.
+ */
+#define THREADPOOL_ERROR_THREAD_FAILED         ((threadpool_error_t) 3)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define THREADPOOL_ERROR_IS_OK(err) (err == THREADPOOL_ERROR_OK)
+
+/**
+ * Pointer to the function run by a task.
+ */
+typedef void (* threadpool_task_fn)(void *);
+
+/**
+ * @struct threadpool_latch
+ * @brief Counts the tasks a thread is waiting for.
+ */
+typedef struct threadpool_latch_t {
+    // the number of tasks that have not finished yet
+    atomic_size_t count;
+} threadpool_latch_t;
+
+/**
+ * @brief Pointer to a latch.
+ */
+typedef threadpool_latch_t * threadpool_latch_ptr;
+
+/**
+ * @struct threadpool_task
+ * @brief A unit of work run by the pool.
+ * @details Tasks live in memory owned by the submitter, which must keep them
+ *          alive until they have run.
+ */
+typedef struct threadpool_task_t {
+    // the function run by the task
+    threadpool_task_fn fn;
+    // the argument passed to the function
+    void * arg;
+    // the latch counted down when the task finishes, or NULL
+    threadpool_latch_ptr latch;
+} threadpool_task_t;
+
+/**
+ * @brief Pointer to a task.
+ */
+typedef threadpool_task_t * threadpool_task_ptr;
+
+/**
+ * @struct threadpool_worker
+ * @brief A worker thread of a pool, with its own deque of tasks.
+ */
+typedef struct threadpool_worker_t {
+    // the tasks of the worker, stolen from by the other workers
+    wsdeque_t tasks;
+    // the pool the worker belongs to
+    struct threadpool_t * pool;
+    // the thread of the worker
+    pthread_t thread;
+    // state of the generator used to pick victims to steal from
+    uint64_t seed;
+} threadpool_worker_t;
+
+/**
+ * @struct threadpool
+ * @brief A work-stealing thread pool.
+ * @details Every worker keeps its own deque of tasks: tasks submitted from a
+ *          worker go to the back of its deque, and idle workers steal from
+ *          the front of the others'. Tasks submitted from outside the pool go
+ *          through a shared queue. Threads waiting for tasks to finish run
+ *          tasks themselves in the meantime, so tasks may submit and wait for
+ *          sub-tasks (fork/join) without starving the pool.
+ */
+typedef struct threadpool_t {
+    // the workers of the pool
+    threadpool_worker_t * workers;
+    // the number of workers
+    size_t len;
+    // the queue of tasks submitted from outside the pool
+    mpmc_t injector;
+    // the number of tasks submitted but not yet picked up
+    atomic_size_t queued;
+    // the number of workers sleeping while waiting for tasks
+    atomic_size_t sleepers;
+    // set when the pool is shutting down
+    atomic_bool stop;
+    // protects the sleep of idle workers
+    pthread_mutex_t lock;
+    // signalled when tasks are submitted to a pool with sleeping workers
+    pthread_cond_t wakeup;
+    // the allocator the workers are allocated from
+    allocator_t allocator;
+} threadpool_t;
+
+/**
+ * @brief Pointer to a thread pool.
+ */
+typedef threadpool_t * threadpool_ptr;
+
+/**
+ * @brief Create a new thread pool and start its workers.
+ *
+ * @param pool address to the pool that should be created
+ * @param threads the number of workers, or 0 for one per online CPU
+ * @param allocator pointer to the allocator the pool is allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return THREADPOOL_ERROR_OK on success,
+ *         THREADPOOL_ERROR_NULL_POINTER_RECEIVED if pool is a NULL pointer,
+ *         THREADPOOL_ERROR_ALLOC_FAILED if the pool failed to allocate,
+ *         THREADPOOL_ERROR_THREAD_FAILED if a worker could not be started
+ */
+threadpool_error_t threadpool_new(threadpool_ptr pool,
+                                  size_t threads,
+                                  allocator_ptr allocator);
+
+/**
+ * @brief Initialize a task.
+ *
+ * @param task the task to initialize
+ * @param fn the function run by the task
+ * @param arg the argument passed to the function
+ * @param latch the latch counted down when the task finishes, or NULL
+ */
+void threadpool_task_init(threadpool_task_ptr task,
+                          threadpool_task_fn fn,
+                          void * arg,
+                          threadpool_latch_ptr latch);
+
+/**
+ * @brief Initialize a latch.
+ *
+ * @param latch the latch to initialize
+ * @param count the number of tasks the latch waits for
+ */
+void threadpool_latch_init(threadpool_latch_ptr latch, size_t count);
+
+/**
+ * @brief Submit a task to the pool.
+ * @details Can be called from any thread, including from tasks.
+ *
+ * @param pool pointer to the pool
+ * @param task the task to run, which must stay alive until it has run
+ *
+ * @return THREADPOOL_ERROR_OK on success,
+ *         THREADPOOL_ERROR_NULL_POINTER_RECEIVED if pool or task is a NULL
+ *         pointer,
+ *         THREADPOOL_ERROR_ALLOC_FAILED if the deque of the worker failed to
+ *         grow
+ */
+threadpool_error_t threadpool_submit(threadpool_ptr pool,
+                                     threadpool_task_ptr task);
+
+/**
+ * @brief Wait until every task counted by a latch has finished.
+ * @details The calling thread runs pending tasks while it waits.
+ *
+ * @param pool pointer to the pool
+ * @param latch the latch to wait for
+ */
+void threadpool_wait(threadpool_ptr pool, threadpool_latch_ptr latch);
+
+/**
+ * @brief Stop the workers and release the memory used by the pool.
+ * @details Tasks still pending are not run. If the pool was allocated on the
+ *          heap, it must be de-allocated manually.
+ *
+ * @param pool pointer to the pool
+ *
+ * @return THREADPOOL_ERROR_OK on success,
+ *         THREADPOOL_ERROR_NULL_POINTER_RECEIVED if pool is a NULL pointer
+ */
+threadpool_error_t threadpool_free(threadpool_ptr pool);
+
+#endif //UNILIB_THREADPOOL_H
@@ -0,0 +1,192 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "config.h"
+
+#ifndef UNILIB_WSDEQUE_H
+#define UNILIB_WSDEQUE_H
+
+/**
+ * Error type return by wsdeque functions.
+ */
+typedef uint8_t wsdeque_error_t;
+
+/**
+ * No error.
+ */
+#define WSDEQUE_ERROR_OK                    ((wsdeque_error_t) 0)
+/**
+ * The function was provided with a null pointer.
+ */
+#define WSDEQUE_ERROR_NULL_POINTER_RECEIVED ((wsdeque_error_t) 1)
+/**
+ * The function could not allocate the required memory.
+ */
+#define WSDEQUE_ERROR_ALLOC_FAILED          ((wsdeque_error_t) 2)
+/**
+ * There are no items in the deque.
+ */
+#define WSDEQUE_ERROR_EMPTY                 ((wsdeque_error_t) 3)
+/**
+ * The steal lost a race with another thread and may be retried.
+ */
+#define WSDEQUE_ERROR_ABORT                 ((wsdeque_error_t) 4)
+
+/**
+ * Check whether the result of a function is okay or not.
+ */
+#define WSDEQUE_ERROR_IS_OK(err) (err == WSDEQUE_ERROR_OK)
+
+/**
+ * @struct wsdeque_array
+ * @brief A ring of elements of a work-stealing deque.
+ */
+typedef struct wsdeque_array_t {
+    // the capacity of the ring, a power of two
+    size_t capacity;
+    // the ring this one replaced, kept alive until the deque is freed
+    struct wsdeque_array_t * prev;
+    // the elements of the ring
+    _Atomic(void *) elements[];
+} wsdeque_array_t;
+
+/**
+ * @struct wsdeque
+ * @brief A Chase-Lev work-stealing deque.
+ * @details The owning thread pushes and pops elements at the back of the
+ *          deque without taking any lock, while any number of thieves steal
+ *          elements from the front with a CAS. When the owner runs out of
+ *          room it copies the elements into a ring twice as large; thieves
+ *          keep reading from the old ring until they see the new one, which
+ *          is why replaced rings are only released with the deque.
+ *          This follows "Correct and Efficient Work-Stealing for Weak Memory
+ *          Models" (Lê et al., 2013).
+ */
+typedef struct wsdeque_t {
+    // the current ring of elements
+    _Atomic(wsdeque_array_t *) array;
+    // the allocator the rings are allocated from
+    allocator_t allocator;
+    char pad_top[UNILIB_CACHE_LINE_SIZE];
+    // the index of the front element, advanced by thieves and by the owner
+    // when it takes the last element
+    atomic_llong top;
+    char pad_bottom[UNILIB_CACHE_LINE_SIZE];
+    // the index past the back element, only written by the owner
+    atomic_llong bottom;
+    char pad_end[UNILIB_CACHE_LINE_SIZE];
+} wsdeque_t;
+
+/**
+ * @brief Pointer to a work-stealing deque.
+ */
+typedef wsdeque_t * wsdeque_ptr;
+
+/**
+ * @brief Create a new work-stealing deque.
+ * @details The capacity is rounded up to the next power of two, and grows as
+ *          needed.
+ *
+ * @param wsdeque address to the deque that should be created
+ * @param capacity the initial capacity of the deque
+ * @param allocator pointer to the allocator the rings are allocated from, or
+ *        NULL for the default allocator
+ *
+ * @return WSDEQUE_ERROR_OK on success,
+ *         WSDEQUE_ERROR_NULL_POINTER_RECEIVED if wsdeque is a NULL pointer,
+ *         WSDEQUE_ERROR_ALLOC_FAILED if the deque failed to allocate
+ */
+wsdeque_error_t wsdeque_new(wsdeque_ptr wsdeque,
+                            size_t capacity,
+                            allocator_ptr allocator);
+
+/**
+ * @brief Push an item at the back of the deque, from the owning thread.
+ * @details The deque does not take ownership of the element.
+ *
+ * @param wsdeque pointer to the deque
+ * @param elem the element to be added to the deque
+ *
+ * @return WSDEQUE_ERROR_OK on success,
+ *         WSDEQUE_ERROR_NULL_POINTER_RECEIVED if wsdeque is a NULL pointer,
+ *         WSDEQUE_ERROR_ALLOC_FAILED if the deque failed to grow
+ */
+wsdeque_error_t wsdeque_push_back(wsdeque_ptr wsdeque, void * elem);
+
+/**
+ * @brief Pop an item from the back of the deque, from the owning thread.
+ *
+ * @param wsdeque pointer to the deque
+ * @param elem address where to place the element removed from the deque
+ *
+ * @return WSDEQUE_ERROR_OK on success,
+ *         WSDEQUE_ERROR_NULL_POINTER_RECEIVED if wsdeque or elem is a NULL
+ *         pointer,
+ *         WSDEQUE_ERROR_EMPTY if there are no items in the deque
+ */
+wsdeque_error_t wsdeque_pop_back(wsdeque_ptr wsdeque, void ** elem);
+
+/**
+ * @brief Steal an item from the front of the deque, from any thread.
+ *
+ * @param wsdeque pointer to the deque
+ * @param elem address where to place the element removed from the deque
+ *
+ * @return WSDEQUE_ERROR_OK on success,
+ *         WSDEQUE_ERROR_NULL_POINTER_RECEIVED if wsdeque or elem is a NULL
+ *         pointer,
+ *         WSDEQUE_ERROR_EMPTY if there are no items in the deque,
+ *         WSDEQUE_ERROR_ABORT if another thread took the item first
+ */
+wsdeque_error_t wsdeque_steal(wsdeque_ptr wsdeque, void ** elem);
+
+/**
+ * @brief Get the number of items in the deque.
+ * @details The result is only a snapshot if the deque is being used by other
+ *          threads.
+ *
+ * @param wsdeque pointer to the deque
+ *
+ * @return the number of items in the deque, or 0 if wsdeque is a NULL pointer
+ */
+size_t wsdeque_len(wsdeque_ptr wsdeque);
+
+/**
+ * @brief Release the memory used by the deque.
+ * @details No other thread may use the deque anymore. The elements left in
+ *          the deque are not released. If the deque was allocated on the
+ *          heap, it must be de-allocated manually.
+ *
+ * @param wsdeque pointer to the deque
+ *
+ * @return WSDEQUE_ERROR_OK on success,
+ *         WSDEQUE_ERROR_NULL_POINTER_RECEIVED if wsdeque is a NULL pointer
+ */
+wsdeque_error_t wsdeque_free(wsdeque_ptr wsdeque);
+
+#endif //UNILIB_WSDEQUE_H
@@ -0,0 +1,90 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "alloc.h"
+
+static void * libc_alloc(void * ctx, size_t size) {
+    (void) ctx;
+    return malloc(size);
+}
+
+static void * libc_realloc(void * ctx,
+                           void * ptr,
+                           size_t old_size,
+                           size_t new_size) {
+    (void) ctx;
+    (void) old_size;
+    return realloc(ptr, new_size);
+}
+
+static void libc_free(void * ctx, void * ptr, size_t size) {
+    (void) ctx;
+    (void) size;
+    free(ptr);
+}
+
+allocator_t allocator_new(void * ctx,
+                          alloc_alloc_ptr alloc,
+                          alloc_realloc_ptr realloc,
+                          alloc_free_ptr free) {
+    allocator_t allocator;
+    allocator.ctx = ctx;
+    allocator.alloc = alloc;
+    allocator.realloc = realloc;
+    allocator.free = free;
+    return allocator;
+}
+
+allocator_t allocator_default() {
+    return allocator_new(NULL, libc_alloc, libc_realloc, libc_free);
+}
+
+void * allocator_alloc(allocator_ptr allocator, size_t size) {
+    if (allocator == NULL) {
+        return malloc(size);
+    }
+    return allocator->alloc(allocator->ctx, size);
+}
+
+void * allocator_realloc(allocator_ptr allocator,
+                         void * ptr,
+                         size_t old_size,
+                         size_t new_size) {
+    if (allocator == NULL) {
+        return realloc(ptr, new_size);
+    }
+    return allocator->realloc(allocator->ctx, ptr, old_size, new_size);
+}
+
+void allocator_free(allocator_ptr allocator, void * ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (allocator == NULL) {
+        free(ptr);
+        return;
+    }
+    allocator->free(allocator->ctx, ptr, size);
+}
@@ -0,0 +1,212 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ * The size of a block header, rounded up so that the data of the block is
+ * aligned.
+ */
+#define ARENA_BLOCK_HEADER_SIZE \
+    ((sizeof(arena_block_t) + ARENA_ALIGNMENT - 1) \
+     & ~((size_t) ARENA_ALIGNMENT - 1))
+
+/**
+ * Round a size up to the alignment of the arena.
+ */
+static size_t arena_align(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * Get the start of the data of a block.
+ */
+static char * arena_block_data(arena_block_t * block) {
+    return (char *) block + ARENA_BLOCK_HEADER_SIZE;
+}
+
+/**
+ * Allocate a new block, large enough for at least `size` bytes.
+ *
+ * @param arena the arena
+ * @param size the minimum number of bytes in the block
+ *
+ * @return the new block, or NULL if memory could not be allocated
+ */
+static arena_block_t * arena_block_new(arena_ptr arena, size_t size) {
+    if (size < arena->block_size) {
+        size = arena->block_size;
+    }
+    if (size > SIZE_MAX - ARENA_BLOCK_HEADER_SIZE) {
+        return NULL;
+    }
+    arena_block_t * block = allocator_alloc(&arena->allocator,
+                                            ARENA_BLOCK_HEADER_SIZE + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void * arena_allocator_alloc(void * ctx, size_t size) {
+    return arena_alloc(ctx, size);
+}
+
+static void * arena_allocator_realloc(void * ctx,
+                                      void * ptr,
+                                      size_t old_size,
+                                      size_t new_size) {
+    arena_ptr arena = ctx;
+    arena_block_t * block = arena->current;
+    if (ptr != NULL && block != NULL) {
+        char * data = arena_block_data(block);
+        size_t offset = (size_t) ((char *) ptr - data);
+        // the last allocation of the current block can be resized in place
+        if ((char *) ptr >= data
+                && offset + arena_align(old_size) == block->used
+                && new_size <= block->size - offset) {
+            size_t used = offset + arena_align(new_size);
+            block->used = used < block->size ? used : block->size;
+            return ptr;
+        }
+    }
+    void * new_ptr = arena_alloc(arena, new_size);
+    if (new_ptr != NULL && ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return new_ptr;
+}
+
+static void arena_allocator_free(void * ctx, void * ptr, size_t size) {
+    (void) ctx;
+    (void) ptr;
+    (void) size;
+}
+
+arena_error_t arena_new(arena_ptr arena,
+                        size_t block_size,
+                        allocator_ptr allocator) {
+    if (arena == NULL) {
+        return ARENA_ERROR_NULL_POINTER_RECEIVED;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size;
+    arena->allocator = allocator != NULL ? *allocator : allocator_default();
+    return ARENA_ERROR_OK;
+}
+
+void * arena_alloc(arena_ptr arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    if (size > SIZE_MAX - ARENA_ALIGNMENT) {
+        return NULL;
+    }
+    size = arena_align(size);
+
+    arena_block_t * block = arena->current;
+    if (block != NULL && block->size - block->used >= size) {
+        void * ptr = arena_block_data(block) + block->used;
+        block->used += size;
+        return ptr;
+    }
+
+    // move on to the next block left over from before a reset, if it is large
+    // enough, otherwise insert a new block after the current one
+    arena_block_t * next = block != NULL ? block->next : arena->first;
+    if (next == NULL || next->size < size) {
+        arena_block_t * new_block = arena_block_new(arena, size);
+        if (new_block == NULL) {
+            return NULL;
+        }
+        new_block->next = next;
+        if (block != NULL) {
+            block->next = new_block;
+        } else {
+            arena->first = new_block;
+        }
+        next = new_block;
+    }
+    next->used = size;
+    arena->current = next;
+    return arena_block_data(next);
+}
+
+arena_mark_t arena_mark(arena_ptr arena) {
+    arena_mark_t mark;
+    mark.block = arena->current;
+    mark.used = arena->current != NULL ? arena->current->used : 0;
+    return mark;
+}
+
+void arena_rewind(arena_ptr arena, arena_mark_t mark) {
+    if (arena == NULL) {
+        return;
+    }
+    if (mark.block == NULL) {
+        arena_reset(arena);
+        return;
+    }
+    // the blocks after the marked one are reset lazily, when they become
+    // current again
+    mark.block->used = mark.used;
+    arena->current = mark.block;
+}
+
+void arena_reset(arena_ptr arena) {
+    if (arena == NULL) {
+        return;
+    }
+    arena->current = NULL;
+}
+
+allocator_t arena_allocator(arena_ptr arena) {
+    return allocator_new(arena,
+                         arena_allocator_alloc,
+                         arena_allocator_realloc,
+                         arena_allocator_free);
+}
+
+arena_error_t arena_free(arena_ptr arena) {
+    if (arena == NULL) {
+        return ARENA_ERROR_NULL_POINTER_RECEIVED;
+    }
+    arena_block_t * block = arena->first;
+    while (block != NULL) {
+        arena_block_t * next = block->next;
+        allocator_free(&arena->allocator,
+                       block,
+                       ARENA_BLOCK_HEADER_SIZE + block->size);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+    return ARENA_ERROR_OK;
+}
@@ -0,0 +1,390 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "bqueue.h"
+
+/**
+ * How many times a waiting thread checks its condition before parking.
+ */
+#define BQUEUE_SPIN_ROUNDS 128
+
+#ifdef __linux__
+_Static_assert(sizeof(atomic_uint) == sizeof(uint32_t),
+               "futex words must be 32 bits wide");
+#endif
+
+/**
+ * Tell the CPU we are spinning.
+ */
+static void bqueue_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * Get the time of the monotonic clock, in nanoseconds.
+ */
+static int64_t bqueue_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Turn a timeout into a deadline on the monotonic clock.
+ *
+ * @return the deadline, or -1 to wait forever
+ */
+static int64_t bqueue_deadline(int64_t timeout_ns) {
+    if (timeout_ns < 0) {
+        return -1;
+    }
+    int64_t now = bqueue_now_ns();
+    return timeout_ns > INT64_MAX - now ? INT64_MAX : now + timeout_ns;
+}
+
+/**
+ * Park the calling thread while a futex word holds `expected`.
+ * @details Returns when the word is woken, when the deadline passes, or
+ *          spuriously; callers check their condition again either way.
+ *
+ * @param word the futex word
+ * @param expected the value the word held when the caller decided to wait
+ * @param deadline the deadline on the monotonic clock, or -1
+ */
+static void bqueue_futex_wait(atomic_uint * word,
+                              unsigned expected,
+                              int64_t deadline) {
+#ifdef __linux__
+    struct timespec timeout;
+    struct timespec * timeout_ptr = NULL;
+    if (deadline >= 0) {
+        int64_t left = deadline - bqueue_now_ns();
+        if (left <= 0) {
+            return;
+        }
+        timeout.tv_sec = (time_t) (left / 1000000000);
+        timeout.tv_nsec = (long) (left % 1000000000);
+        timeout_ptr = &timeout;
+    }
+    syscall(SYS_futex, (uint32_t *) word, FUTEX_WAIT_PRIVATE, expected,
+            timeout_ptr, NULL, 0);
+#else
+    (void) deadline;
+    if (atomic_load_explicit(word, memory_order_relaxed) == expected) {
+        sched_yield();
+    }
+#endif
+}
+
+/**
+ * Wake up to `count` threads parked on a futex word.
+ */
+static void bqueue_futex_wake(atomic_uint * word, size_t count) {
+#ifdef __linux__
+    int waiters = count > INT_MAX ? INT_MAX : (int) count;
+    syscall(SYS_futex, (uint32_t *) word, FUTEX_WAKE_PRIVATE, waiters,
+            NULL, NULL, 0);
+#else
+    (void) word;
+    (void) count;
+#endif
+}
+
+/**
+ * Take the lock of the queue, spinning for a while before parking.
+ */
+static void bqueue_lock(bqueue_ptr bqueue) {
+    unsigned state = 0;
+    if (atomic_compare_exchange_strong_explicit(&bqueue->lock, &state, 1,
+                                                memory_order_acquire,
+                                                memory_order_relaxed)) {
+        return;
+    }
+    for (size_t i = 0; i < BQUEUE_SPIN_ROUNDS; i++) {
+        bqueue_relax();
+        state = 0;
+        if (atomic_load_explicit(&bqueue->lock, memory_order_relaxed) == 0
+            && atomic_compare_exchange_weak_explicit(&bqueue->lock, &state, 1,
+                                                     memory_order_acquire,
+                                                     memory_order_relaxed)) {
+            return;
+        }
+    }
+    // mark the lock contended so that whoever releases it wakes us
+    while (atomic_exchange_explicit(&bqueue->lock, 2,
+                                    memory_order_acquire) != 0) {
+        bqueue_futex_wait(&bqueue->lock, 2, -1);
+    }
+}
+
+/**
+ * Release the lock of the queue, waking a parked thread if there is one.
+ */
+static void bqueue_unlock(bqueue_ptr bqueue) {
+    if (atomic_exchange_explicit(&bqueue->lock, 0,
+                                 memory_order_release) == 2) {
+        bqueue_futex_wake(&bqueue->lock, 1);
+    }
+}
+
+/**
+ * Wait for a futex word to move away from `seq`, spinning for a while
+ * before parking. Called without the lock.
+ */
+static void bqueue_await(atomic_uint * word, unsigned seq, int64_t deadline) {
+    for (size_t i = 0; i < BQUEUE_SPIN_ROUNDS; i++) {
+        if (atomic_load_explicit(word, memory_order_acquire) != seq) {
+            return;
+        }
+        bqueue_relax();
+    }
+    bqueue_futex_wait(word, seq, deadline);
+}
+
+/**
+ * Stop counting the calling thread as a waiter, under the lock.
+ * @details Whoever wakes waiters counts them off and bumps the futex word,
+ *          so that a waiter that was woken but has not run yet does not draw
+ *          another wakeup from every following push or pop. A waiter that
+ *          returns while the word still holds `seq` (on timeout, or while
+ *          spinning) was not counted off and removes itself.
+ */
+static void bqueue_leave(size_t * waiters, atomic_uint * word, unsigned seq) {
+    if (atomic_load_explicit(word, memory_order_relaxed) == seq) {
+        (*waiters)--;
+    }
+}
+
+/**
+ * Check whether a wait with the given timeout and deadline is over.
+ */
+static bool bqueue_expired(int64_t timeout_ns, int64_t deadline) {
+    return timeout_ns == 0 || (deadline >= 0 && bqueue_now_ns() >= deadline);
+}
+
+bqueue_error_t bqueue_new(bqueue_ptr bqueue,
+                          size_t capacity,
+                          size_t element_size,
+                          allocator_ptr allocator) {
+    if (bqueue == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (capacity == 0) {
+        return BQUEUE_ERROR_CAPACITY_TOO_SMALL;
+    }
+    if (!DEQUEUE_ERROR_IS_OK(dequeue_new_with_allocator(&bqueue->ring,
+                                                        capacity,
+                                                        element_size,
+                                                        DEQUEUE_STORAGE_INLINE,
+                                                        allocator))) {
+        return BQUEUE_ERROR_ALLOC_FAILED;
+    }
+    bqueue->capacity = capacity;
+    bqueue->pop_waiters = 0;
+    bqueue->push_waiters = 0;
+    bqueue->closed = false;
+    atomic_init(&bqueue->lock, 0);
+    atomic_init(&bqueue->not_empty, 0);
+    atomic_init(&bqueue->not_full, 0);
+    return BQUEUE_ERROR_OK;
+}
+
+bqueue_error_t bqueue_push(bqueue_ptr bqueue,
+                           const void * elem,
+                           int64_t timeout_ns) {
+    if (bqueue == NULL || elem == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    int64_t deadline = timeout_ns != 0 ? bqueue_deadline(timeout_ns) : 0;
+    bool waiting = false;
+    unsigned seq = 0;
+    bqueue_lock(bqueue);
+    for (;;) {
+        if (waiting) {
+            bqueue_leave(&bqueue->push_waiters, &bqueue->not_full, seq);
+            waiting = false;
+        }
+        if (bqueue->closed) {
+            bqueue_unlock(bqueue);
+            return BQUEUE_ERROR_CLOSED;
+        }
+        if (bqueue->ring.len < bqueue->capacity) {
+            break;
+        }
+        if (bqueue_expired(timeout_ns, deadline)) {
+            bqueue_unlock(bqueue);
+            return BQUEUE_ERROR_TIMEOUT;
+        }
+        // read under the lock, so a pop cannot slip in before we wait on it
+        seq = atomic_load_explicit(&bqueue->not_full, memory_order_relaxed);
+        bqueue->push_waiters++;
+        waiting = true;
+        bqueue_unlock(bqueue);
+        bqueue_await(&bqueue->not_full, seq, deadline);
+        bqueue_lock(bqueue);
+    }
+    // the ring was created with room for capacity items, so this never
+    // grows; it signals the notifier, if any, when it was empty
+    dequeue_push_back(&bqueue->ring, (void *) elem);
+    bool wake = bqueue->pop_waiters > 0;
+    if (wake) {
+        bqueue->pop_waiters--;
+        atomic_fetch_add_explicit(&bqueue->not_empty, 1, memory_order_release);
+    }
+    bqueue_unlock(bqueue);
+    if (wake) {
+        bqueue_futex_wake(&bqueue->not_empty, 1);
+    }
+    return BQUEUE_ERROR_OK;
+}
+
+bqueue_error_t bqueue_pop(bqueue_ptr bqueue, void * dst, int64_t timeout_ns) {
+    return bqueue_pop_batch(bqueue, dst, 1, NULL, timeout_ns);
+}
+
+bqueue_error_t bqueue_pop_batch(bqueue_ptr bqueue,
+                                void * dst,
+                                size_t n,
+                                size_t * popped,
+                                int64_t timeout_ns) {
+    if (popped != NULL) {
+        *popped = 0;
+    }
+    if (bqueue == NULL || dst == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (n == 0) {
+        return BQUEUE_ERROR_OK;
+    }
+    int64_t deadline = timeout_ns != 0 ? bqueue_deadline(timeout_ns) : 0;
+    bool waiting = false;
+    unsigned seq = 0;
+    bqueue_lock(bqueue);
+    for (;;) {
+        if (waiting) {
+            bqueue_leave(&bqueue->pop_waiters, &bqueue->not_empty, seq);
+            waiting = false;
+        }
+        if (bqueue->ring.len > 0) {
+            break;
+        }
+        if (bqueue->closed) {
+            bqueue_unlock(bqueue);
+            return BQUEUE_ERROR_CLOSED;
+        }
+        if (bqueue_expired(timeout_ns, deadline)) {
+            bqueue_unlock(bqueue);
+            return BQUEUE_ERROR_TIMEOUT;
+        }
+        seq = atomic_load_explicit(&bqueue->not_empty, memory_order_relaxed);
+        bqueue->pop_waiters++;
+        waiting = true;
+        bqueue_unlock(bqueue);
+        bqueue_await(&bqueue->not_empty, seq, deadline);
+        bqueue_lock(bqueue);
+    }
+    size_t taken;
+    dequeue_pop_front_n(&bqueue->ring, dst, n, &taken);
+    // one producer per freed slot at most, and none if nobody waits
+    size_t wake = bqueue->push_waiters < taken ? bqueue->push_waiters : taken;
+    if (wake > 0) {
+        bqueue->push_waiters -= wake;
+        atomic_fetch_add_explicit(&bqueue->not_full, 1, memory_order_release);
+    }
+    bqueue_unlock(bqueue);
+    if (wake > 0) {
+        bqueue_futex_wake(&bqueue->not_full, wake);
+    }
+    if (popped != NULL) {
+        *popped = taken;
+    }
+    return BQUEUE_ERROR_OK;
+}
+
+bqueue_error_t bqueue_close(bqueue_ptr bqueue) {
+    if (bqueue == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    bqueue_lock(bqueue);
+    bqueue->closed = true;
+    bqueue->pop_waiters = 0;
+    bqueue->push_waiters = 0;
+    if (bqueue->ring.notify != NULL) {
+        notify_signal(bqueue->ring.notify);
+    }
+    atomic_fetch_add_explicit(&bqueue->not_empty, 1, memory_order_release);
+    atomic_fetch_add_explicit(&bqueue->not_full, 1, memory_order_release);
+    bqueue_unlock(bqueue);
+    bqueue_futex_wake(&bqueue->not_empty, INT_MAX);
+    bqueue_futex_wake(&bqueue->not_full, INT_MAX);
+    return BQUEUE_ERROR_OK;
+}
+
+bqueue_error_t bqueue_set_notify(bqueue_ptr bqueue, notify_ptr notify) {
+    if (bqueue == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    bqueue_lock(bqueue);
+    dequeue_set_notify(&bqueue->ring, notify);
+    if (notify != NULL && bqueue->closed) {
+        notify_signal(notify);
+    }
+    bqueue_unlock(bqueue);
+    return BQUEUE_ERROR_OK;
+}
+
+size_t bqueue_len(bqueue_ptr bqueue) {
+    if (bqueue == NULL) {
+        return 0;
+    }
+    bqueue_lock(bqueue);
+    size_t len = bqueue->ring.len;
+    bqueue_unlock(bqueue);
+    return len;
+}
+
+bqueue_error_t bqueue_free(bqueue_ptr bqueue) {
+    if (bqueue == NULL) {
+        return BQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_free(&bqueue->ring);
+    bqueue->capacity = 0;
+    return BQUEUE_ERROR_OK;
+}
@@ -21,11 +21,153 @@
  * SOFTWARE.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "dequeue.h"
 
+/**
+ * Get the size of a slot in the ring of a dequeue.
+ *
+ * @param dequeue the dequeue
+ *
+ * @return the size of an element pointer, or the size of an element if the
+ *         elements are stored inline
+ */
+static size_t dequeue_slot_size(dequeue_ptr dequeue) {
+    return dequeue->storage == DEQUEUE_STORAGE_INLINE
+            ? dequeue->element_size
+            : sizeof(void *);
+}
+
+/**
+ * Translate a position in the dequeue into an index in the ring.
+ *
+ * @param dequeue the dequeue
+ * @param pos the position, relative to the front of the dequeue
+ *
+ * @return the index of the slot holding the element at that position
+ */
+static size_t dequeue_index(dequeue_ptr dequeue, size_t pos) {
+    size_t index = dequeue->head + pos;
+    return index >= dequeue->capacity ? index - dequeue->capacity : index;
+}
+
+/**
+ * Get the address of a slot in the ring of a dequeue.
+ *
+ * @param dequeue the dequeue
+ * @param index the index of the slot in the ring
+ *
+ * @return the address of the slot
+ */
+static char * dequeue_slot(dequeue_ptr dequeue, size_t index) {
+    return (char *) dequeue->elements + index * dequeue_slot_size(dequeue);
+}
+
+/**
+ * Get the element stored in a slot of a dequeue.
+ *
+ * @param dequeue the dequeue
+ * @param index the index of the slot in the ring
+ *
+ * @return the element pointer held by the slot, or the address of the slot
+ *         itself if the elements are stored inline
+ */
+static void * dequeue_slot_get(dequeue_ptr dequeue, size_t index) {
+    char * slot = dequeue_slot(dequeue, index);
+    return dequeue->storage == DEQUEUE_STORAGE_INLINE
+            ? (void *) slot
+            : *((void **) slot);
+}
+
+/**
+ * Store an element in a slot of a dequeue.
+ *
+ * @param dequeue the dequeue
+ * @param index the index of the slot in the ring
+ * @param elem the element pointer, or the element to be copied in the slot if
+ *        the elements are stored inline
+ */
+static void dequeue_slot_set(dequeue_ptr dequeue, size_t index, void * elem) {
+    char * slot = dequeue_slot(dequeue, index);
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        memcpy(slot, elem, dequeue->element_size);
+    } else {
+        *((void **) slot) = elem;
+    }
+}
+
+/**
+ * Copy the elements of the dequeue, in order, at the start of a new ring.
+ *
+ * @details The old ring is left untouched.
+ *
+ * @param dequeue the dequeue
+ * @param dst the new ring, large enough to hold all the elements
+ */
+static void dequeue_linearize_into(dequeue_ptr dequeue, char * dst) {
+    size_t slot_size = dequeue_slot_size(dequeue);
+    size_t head_len = dequeue->capacity - dequeue->head;
+    if (dequeue->len <= head_len) {
+        memcpy(dst,
+               dequeue_slot(dequeue, dequeue->head),
+               dequeue->len * slot_size);
+    } else {
+        memcpy(dst, dequeue_slot(dequeue, dequeue->head), head_len * slot_size);
+        memcpy(dst + head_len * slot_size,
+               dequeue->elements,
+               (dequeue->len - head_len) * slot_size);
+    }
+}
+
+/**
+ * Release the elements owned by a dequeue.
+ *
+ * @details The length of the dequeue is left untouched.
+ *
+ * @param dequeue the dequeue
+ */
+static void dequeue_release_elements(dequeue_ptr dequeue) {
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return;
+    }
+    if (dequeue->arena != NULL) {
+        arena_rewind(dequeue->arena, dequeue->arena_mark);
+        return;
+    }
+    for (size_t i = 0; i < dequeue->len; i++) {
+        dequeue_element_free(dequeue,
+                             dequeue_slot_get(dequeue,
+                                              dequeue_index(dequeue, i)));
+    }
+}
+
+/**
+ * Release the ring of a dequeue, unmapping it if it lives in a snapshot file.
+ *
+ * @param dequeue the dequeue
+ */
+static void dequeue_release_ring(dequeue_ptr dequeue) {
+    if (dequeue->mapping != NULL) {
+        munmap(dequeue->mapping, dequeue->mapping_size);
+        dequeue->mapping = NULL;
+        dequeue->mapping_size = 0;
+        return;
+    }
+    allocator_free(&dequeue->allocator,
+                   dequeue->elements,
+                   dequeue->capacity * dequeue_slot_size(dequeue));
+}
+
 /**
  * Initialize a dequeue.
  *
@@ -34,6 +176,8 @@
  * @param dequeue the dequeue to initialize
  * @param capacity the capacity of the dequeue
  * @param element_size the size of each element in the dequeue
+ * @param storage how the elements are stored
+ * @param allocator the allocator used by the dequeue
  *
  * @return DEQUEUE_ERROR_OK if successful,
  *         DEQUEUE_ERROR_NULL_POINTER_RECEIVED if the dequeue pointer is NULL,
@@ -41,17 +185,165 @@
  */
 static dequeue_error_t dequeue_init(dequeue_ptr dequeue,
                                     size_t capacity,
-                                    size_t element_size) {
-    dequeue->elements = calloc(capacity, sizeof(void *));
+                                    size_t element_size,
+                                    dequeue_storage_t storage,
+                                    allocator_t allocator) {
+    dequeue->storage = storage;
+    dequeue->element_size = element_size;
+    dequeue->allocator = allocator;
+    size_t slot_size = dequeue_slot_size(dequeue);
+    if (slot_size != 0 && capacity > SIZE_MAX / slot_size) {
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
+    dequeue->elements = allocator_alloc(&dequeue->allocator,
+                                        capacity * slot_size);
     if (dequeue->elements == NULL) {
         return DEQUEUE_ERROR_ALLOC_FAILED;
     }
+    memset(dequeue->elements, 0, capacity * slot_size);
+    dequeue->head = 0;
     dequeue->capacity = capacity;
     dequeue->len = 0;
-    dequeue->element_size = element_size;
+    dequeue->growth_factor = DEQUEUE_DEFAULT_GROWTH_FACTOR;
+    dequeue->max_capacity = DEQUEUE_UNBOUNDED_CAPACITY;
+    dequeue->arena = NULL;
+    dequeue->pool = NULL;
+    dequeue->notify = NULL;
+    dequeue->mapping = NULL;
+    dequeue->mapping_size = 0;
     return DEQUEUE_ERROR_OK;
 }
 
+/**
+ * Grow a dequeue according to its growth policy.
+ *
+ * @param dequeue the dequeue to grow
+ * @param min_capacity the minimum capacity the dequeue needs
+ *
+ * @return DEQUEUE_ERROR_OK if successful,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the minimum capacity is larger
+ *         than the maximum capacity of the dequeue
+ */
+static dequeue_error_t dequeue_grow(dequeue_ptr dequeue, size_t min_capacity) {
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY
+            && min_capacity > dequeue->max_capacity) {
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED;
+    }
+    double grown = (double) dequeue->capacity * dequeue->growth_factor;
+    size_t capacity = grown < (double) SIZE_MAX ? (size_t) grown : SIZE_MAX;
+    if (capacity < min_capacity) {
+        capacity = min_capacity;
+    }
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY
+            && capacity > dequeue->max_capacity) {
+        capacity = dequeue->max_capacity;
+    }
+    return dequeue_resize(dequeue, capacity);
+}
+
+/**
+ * Copy an element into a new memory location.
+ *
+ * @param dequeue the dequeue the element will be pushed into
+ * @param elem the element to copy
+ *
+ * @return the copy of the element, or NULL if memory could not be allocated
+ */
+static void * dequeue_copy_element(dequeue_ptr dequeue, void * elem) {
+    void * elem_copy;
+    if (dequeue->arena != NULL) {
+        elem_copy = arena_alloc(dequeue->arena, dequeue->element_size);
+    } else if (dequeue->pool != NULL) {
+        elem_copy = pool_alloc(dequeue->pool);
+    } else {
+        elem_copy = allocator_alloc(&dequeue->allocator, dequeue->element_size);
+    }
+    if (elem_copy == NULL) {
+        return NULL;
+    }
+    memcpy(elem_copy, elem, dequeue->element_size);
+    return elem_copy;
+}
+
+/**
+ * Make room for more items in a dequeue, growing it according to its growth
+ * policy.
+ *
+ * @param dequeue the dequeue
+ * @param n the number of items that will be pushed
+ *
+ * @return DEQUEUE_ERROR_OK if successful,
+ *         DEQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated,
+ *         DEQUEUE_ERROR_CAPACITY_EXCEEDED if the items do not fit in the
+ *         maximum capacity of the dequeue
+ */
+static dequeue_error_t dequeue_make_room(dequeue_ptr dequeue, size_t n) {
+    if (n > SIZE_MAX - dequeue->len) {
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED;
+    }
+    if (dequeue->len + n <= dequeue->capacity) {
+        return DEQUEUE_ERROR_OK;
+    }
+    return dequeue_grow(dequeue, dequeue->len + n);
+}
+
+/**
+ * Copy a packed array of slots into a dequeue, starting at a position.
+ *
+ * @param dequeue the dequeue
+ * @param pos the position of the first slot, relative to the front
+ * @param src the slots to copy
+ * @param n the number of slots, which must fit in the ring
+ */
+static void dequeue_copy_in(dequeue_ptr dequeue,
+                            size_t pos,
+                            const char * src,
+                            size_t n) {
+    if (n == 0) {
+        return;
+    }
+    size_t slot_size = dequeue_slot_size(dequeue);
+    size_t index = dequeue_index(dequeue, pos);
+    size_t run = dequeue->capacity - index < n ? dequeue->capacity - index : n;
+    memcpy(dequeue_slot(dequeue, index), src, run * slot_size);
+    memcpy(dequeue->elements, src + run * slot_size, (n - run) * slot_size);
+}
+
+/**
+ * Copy slots of a dequeue into a packed array, starting at a position.
+ *
+ * @param dequeue the dequeue
+ * @param pos the position of the first slot, relative to the front
+ * @param dst the array the slots are copied to
+ * @param n the number of slots, at most the length of the dequeue
+ */
+static void dequeue_copy_out(dequeue_ptr dequeue,
+                             size_t pos,
+                             char * dst,
+                             size_t n) {
+    if (n == 0) {
+        return;
+    }
+    size_t slot_size = dequeue_slot_size(dequeue);
+    size_t index = dequeue_index(dequeue, pos);
+    size_t run = dequeue->capacity - index < n ? dequeue->capacity - index : n;
+    memcpy(dst, dequeue_slot(dequeue, index), run * slot_size);
+    memcpy(dst + run * slot_size, dequeue->elements, (n - run) * slot_size);
+}
+
+/**
+ * Signal the notifier of a dequeue if a push made it non-empty.
+ *
+ * @param dequeue the dequeue that was pushed to
+ * @param old_len the length of the dequeue before the push
+ */
+static void dequeue_notify_filled(dequeue_ptr dequeue, size_t old_len) {
+    if (dequeue->notify != NULL && old_len == 0 && dequeue->len != 0) {
+        notify_signal(dequeue->notify);
+    }
+}
+
 dequeue_error_t dequeue_new(dequeue_ptr dequeue, size_t element_size) {
     return dequeue_new_with_capacity(dequeue,
                                      DEQUEUE_DEFAULT_CAPACITY,
@@ -67,24 +359,80 @@ dequeue_error_t dequeue_new_ptr(dequeue_ptr * dequeue, size_t element_size) {
 dequeue_error_t dequeue_new_with_capacity(dequeue_ptr dequeue,
                                           size_t capacity,
                                           size_t element_size) {
-    if (dequeue == NULL) {
-        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
-    }
-    return dequeue_init(dequeue, capacity, element_size);
+    return dequeue_new_with_storage(dequeue,
+                                    capacity,
+                                    element_size,
+                                    DEQUEUE_STORAGE_POINTERS);
 }
 
 dequeue_error_t dequeue_new_ptr_with_capacity(dequeue_ptr * dequeue,
                                               size_t capacity,
                                               size_t element_size) {
+    return dequeue_new_ptr_with_storage(dequeue,
+                                        capacity,
+                                        element_size,
+                                        DEQUEUE_STORAGE_POINTERS);
+}
+
+dequeue_error_t dequeue_new_with_storage(dequeue_ptr dequeue,
+                                         size_t capacity,
+                                         size_t element_size,
+                                         dequeue_storage_t storage) {
+    return dequeue_new_with_allocator(dequeue,
+                                      capacity,
+                                      element_size,
+                                      storage,
+                                      NULL);
+}
+
+dequeue_error_t dequeue_new_ptr_with_storage(dequeue_ptr * dequeue,
+                                             size_t capacity,
+                                             size_t element_size,
+                                             dequeue_storage_t storage) {
+    return dequeue_new_ptr_with_allocator(dequeue,
+                                          capacity,
+                                          element_size,
+                                          storage,
+                                          NULL);
+}
+
+dequeue_error_t dequeue_new_with_allocator(dequeue_ptr dequeue,
+                                           size_t capacity,
+                                           size_t element_size,
+                                           dequeue_storage_t storage,
+                                           allocator_ptr allocator) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    return dequeue_init(dequeue,
+                        capacity,
+                        element_size,
+                        storage,
+                        allocator != NULL ? *allocator : allocator_default());
+}
+
+dequeue_error_t dequeue_new_ptr_with_allocator(dequeue_ptr * dequeue,
+                                               size_t capacity,
+                                               size_t element_size,
+                                               dequeue_storage_t storage,
+                                               allocator_ptr allocator) {
     if (dequeue == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    dequeue_ptr new_dequeue = malloc(sizeof(dequeue_t));
+    allocator_t dequeue_allocator = allocator != NULL
+            ? *allocator
+            : allocator_default();
+    dequeue_ptr new_dequeue = allocator_alloc(&dequeue_allocator,
+                                              sizeof(dequeue_t));
     if (new_dequeue == NULL) {
         *dequeue = NULL;
         return DEQUEUE_ERROR_ALLOC_FAILED;
     }
-    dequeue_error_t result = dequeue_init(new_dequeue, capacity, element_size);
+    dequeue_error_t result = dequeue_init(new_dequeue,
+                                          capacity,
+                                          element_size,
+                                          storage,
+                                          dequeue_allocator);
     switch(result) {
         case DEQUEUE_ERROR_OK:
             *dequeue = new_dequeue;
@@ -93,7 +441,7 @@ dequeue_error_t dequeue_new_ptr_with_capacity(dequeue_ptr * dequeue,
             *dequeue = NULL;
             break;
         case DEQUEUE_ERROR_ALLOC_FAILED:
-            free(new_dequeue);
+            allocator_free(&dequeue_allocator, new_dequeue, sizeof(dequeue_t));
             *dequeue = NULL;
             break;
         default:
@@ -104,11 +452,21 @@ dequeue_error_t dequeue_new_ptr_with_capacity(dequeue_ptr * dequeue,
     return result;
 }
 
+void * dequeue_get(dequeue_ptr dequeue, size_t pos) {
+    if (dequeue == NULL) {
+        return NULL;
+    }
+    if (pos >= dequeue->len) {
+        return NULL;
+    }
+    return dequeue_slot_get(dequeue, dequeue_index(dequeue, pos));
+}
+
 void * dequeue_front(dequeue_ptr dequeue) {
     if (dequeue == NULL) {
         return NULL;
     }
-    return dequeue->len != 0 ? dequeue->elements[0] : NULL;
+    return dequeue->len != 0 ? dequeue_slot_get(dequeue, dequeue->head) : NULL;
 }
 
 dequeue_error_t dequeue_push_front(dequeue_ptr dequeue, void * elem) {
@@ -118,18 +476,19 @@ dequeue_error_t dequeue_push_front(dequeue_ptr dequeue, void * elem) {
     if (elem == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    // if the dequeue is full, allocate for one more element
+    // if the dequeue is full, grow it according to the growth policy
     if (dequeue->len == dequeue->capacity) {
-        dequeue_error_t err = dequeue_resize(dequeue, dequeue->capacity + 1);
+        dequeue_error_t err = dequeue_grow(dequeue, dequeue->capacity + 1);
         if (!DEQUEUE_ERROR_IS_OK(err)) {
             return err;
         }
     }
-    memmove(dequeue->elements + sizeof(void *),
-            dequeue->elements,
-            dequeue->len);
-    dequeue->elements[0] = elem;
+    dequeue->head = dequeue->head == 0
+            ? dequeue->capacity - 1
+            : dequeue->head - 1;
+    dequeue_slot_set(dequeue, dequeue->head, elem);
     dequeue->len += 1;
+    dequeue_notify_filled(dequeue, dequeue->len - 1);
     return DEQUEUE_ERROR_OK;
 }
 
@@ -140,14 +499,16 @@ dequeue_error_t dequeue_push_front_copy(dequeue_ptr dequeue, void * elem) {
     if (elem == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    void * elem_copy = malloc(sizeof(dequeue->element_size));
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return dequeue_push_front(dequeue, elem);
+    }
+    void * elem_copy = dequeue_copy_element(dequeue, elem);
     if (elem_copy == NULL) {
         return DEQUEUE_ERROR_ALLOC_FAILED;
     }
-    memcpy(elem_copy, elem, dequeue->element_size);
     dequeue_error_t err = dequeue_push_front(dequeue, elem_copy);
     if (!DEQUEUE_ERROR_IS_OK(err)) {
-        free(elem_copy);
+        dequeue_element_free(dequeue, elem_copy);
         return err;
     }
     return DEQUEUE_ERROR_OK;
@@ -160,22 +521,42 @@ void * dequeue_pop_front(dequeue_ptr dequeue) {
     if (dequeue->len == 0) {
         return NULL;
     }
-    void * elem = dequeue->elements[0];
-    if (dequeue->len > 1) {
-        memmove(dequeue->elements,
-                dequeue->elements + sizeof(void *),
-                dequeue->len - 1);
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return NULL;
     }
-    dequeue->elements[dequeue->len - 1] = NULL;
+    void * elem = dequeue_slot_get(dequeue, dequeue->head);
+    dequeue->head = dequeue_index(dequeue, 1);
     dequeue->len -= 1;
     return elem;
 }
 
+dequeue_error_t dequeue_pop_front_into(dequeue_ptr dequeue, void * dst) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dst == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dequeue->len == 0) {
+        return DEQUEUE_ERROR_EMPTY;
+    }
+    void * elem = dequeue_slot_get(dequeue, dequeue->head);
+    memcpy(dst, elem, dequeue->element_size);
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+        dequeue_element_free(dequeue, elem);
+    }
+    dequeue->head = dequeue_index(dequeue, 1);
+    dequeue->len -= 1;
+    return DEQUEUE_ERROR_OK;
+}
+
 void * dequeue_back(dequeue_ptr dequeue) {
     if (dequeue == NULL) {
         return NULL;
     }
-    return dequeue->len != 0 ? dequeue->elements[dequeue->len - 1] : NULL;
+    return dequeue->len != 0
+            ? dequeue_slot_get(dequeue, dequeue_index(dequeue, dequeue->len - 1))
+            : NULL;
 }
 
 dequeue_error_t dequeue_push_back(dequeue_ptr dequeue, void * elem) {
@@ -185,15 +566,16 @@ dequeue_error_t dequeue_push_back(dequeue_ptr dequeue, void * elem) {
     if (elem == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    // if the dequeue is full, allocate for one more element
+    // if the dequeue is full, grow it according to the growth policy
     if (dequeue->len == dequeue->capacity) {
-        dequeue_error_t err = dequeue_resize(dequeue, dequeue->capacity + 1);
+        dequeue_error_t err = dequeue_grow(dequeue, dequeue->capacity + 1);
         if (!DEQUEUE_ERROR_IS_OK(err)) {
             return err;
         }
     }
-    dequeue->elements[dequeue->len] = elem;
+    dequeue_slot_set(dequeue, dequeue_index(dequeue, dequeue->len), elem);
     dequeue->len += 1;
+    dequeue_notify_filled(dequeue, dequeue->len - 1);
     return DEQUEUE_ERROR_OK;
 }
 
@@ -204,14 +586,16 @@ dequeue_error_t dequeue_push_back_copy(dequeue_ptr dequeue, void * elem) {
     if (elem == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    void * elem_copy = malloc(sizeof(dequeue->element_size));
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return dequeue_push_back(dequeue, elem);
+    }
+    void * elem_copy = dequeue_copy_element(dequeue, elem);
     if (elem_copy == NULL) {
         return DEQUEUE_ERROR_ALLOC_FAILED;
     }
-    memcpy(elem_copy, elem, dequeue->element_size);
     dequeue_error_t err = dequeue_push_back(dequeue, elem_copy);
     if (!DEQUEUE_ERROR_IS_OK(err)) {
-        free(elem_copy);
+        dequeue_element_free(dequeue, elem_copy);
         return err;
     }
     return DEQUEUE_ERROR_OK;
@@ -224,10 +608,236 @@ void * dequeue_pop_back(dequeue_ptr dequeue) {
     if (dequeue->len == 0) {
         return NULL;
     }
-    void * elem = dequeue->elements[dequeue->len - 1];
-    dequeue->elements[dequeue->len - 1] = NULL;
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return NULL;
+    }
     dequeue->len -= 1;
-    return elem;
+    return dequeue_slot_get(dequeue, dequeue_index(dequeue, dequeue->len));
+}
+
+dequeue_error_t dequeue_pop_back_into(dequeue_ptr dequeue, void * dst) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dst == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dequeue->len == 0) {
+        return DEQUEUE_ERROR_EMPTY;
+    }
+    dequeue->len -= 1;
+    void * elem = dequeue_slot_get(dequeue,
+                                   dequeue_index(dequeue, dequeue->len));
+    memcpy(dst, elem, dequeue->element_size);
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+        dequeue_element_free(dequeue, elem);
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+/**
+ * Check the items passed to a bulk push, before any room is made for them.
+ *
+ * @param dequeue the dequeue
+ * @param elems the array of items
+ * @param n the number of items
+ *
+ * @return false if elems is NULL while n is not 0, or if one of the element
+ *         pointers is NULL with pointer storage, like the single pushes
+ *         reject
+ */
+static bool dequeue_elems_valid(dequeue_ptr dequeue,
+                                const void * elems,
+                                size_t n) {
+    if (n == 0) {
+        return true;
+    }
+    if (elems == NULL) {
+        return false;
+    }
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+        void * const * pointers = elems;
+        for (size_t i = 0; i < n; i++) {
+            if (pointers[i] == NULL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+dequeue_error_t dequeue_push_back_n(dequeue_ptr dequeue,
+                                    const void * elems,
+                                    size_t n) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (!dequeue_elems_valid(dequeue, elems, n)) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_error_t err = dequeue_make_room(dequeue, n);
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    dequeue_copy_in(dequeue, dequeue->len, elems, n);
+    dequeue->len += n;
+    dequeue_notify_filled(dequeue, dequeue->len - n);
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_push_front_n(dequeue_ptr dequeue,
+                                     const void * elems,
+                                     size_t n) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (!dequeue_elems_valid(dequeue, elems, n)) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_error_t err = dequeue_make_room(dequeue, n);
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    dequeue->head = dequeue->head >= n
+            ? dequeue->head - n
+            : dequeue->head + dequeue->capacity - n;
+    dequeue->len += n;
+    dequeue_copy_in(dequeue, 0, elems, n);
+    dequeue_notify_filled(dequeue, dequeue->len - n);
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_push_back_copy_n(dequeue_ptr dequeue,
+                                         const void * elems,
+                                         size_t n) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dequeue->storage == DEQUEUE_STORAGE_INLINE) {
+        return dequeue_push_back_n(dequeue, elems, n);
+    }
+    if (elems == NULL && n != 0) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_error_t err = dequeue_make_room(dequeue, n);
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    const char * src = elems;
+    for (size_t i = 0; i < n; i++) {
+        void * elem_copy = dequeue_copy_element(
+                dequeue,
+                (void *) (src + i * dequeue->element_size));
+        if (elem_copy == NULL) {
+            // nothing is pushed unless every copy succeeds
+            for (size_t j = 0; j < i; j++) {
+                size_t index = dequeue_index(dequeue, dequeue->len + j);
+                dequeue_element_free(dequeue, dequeue_slot_get(dequeue, index));
+            }
+            return DEQUEUE_ERROR_ALLOC_FAILED;
+        }
+        dequeue_slot_set(dequeue,
+                         dequeue_index(dequeue, dequeue->len + i),
+                         elem_copy);
+    }
+    dequeue->len += n;
+    dequeue_notify_filled(dequeue, dequeue->len - n);
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_pop_front_n(dequeue_ptr dequeue,
+                                    void * dst,
+                                    size_t n,
+                                    size_t * popped) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dst == NULL && n != 0) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (n > dequeue->len) {
+        n = dequeue->len;
+    }
+    dequeue_copy_out(dequeue, 0, dst, n);
+    if (n != 0) {
+        dequeue->head = dequeue_index(dequeue, n);
+    }
+    dequeue->len -= n;
+    if (popped != NULL) {
+        *popped = n;
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_pop_back_n(dequeue_ptr dequeue,
+                                   void * dst,
+                                   size_t n,
+                                   size_t * popped) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dst == NULL && n != 0) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (n > dequeue->len) {
+        n = dequeue->len;
+    }
+    dequeue_copy_out(dequeue, dequeue->len - n, dst, n);
+    dequeue->len -= n;
+    if (popped != NULL) {
+        *popped = n;
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+/**
+ * Push the elements of an iterator, for dequeue_extend.
+ */
+static dequeue_error_t dequeue_extend_from(dequeue_ptr dequeue,
+                                           iter_ptr iter) {
+    size_t lower;
+    size_t upper;
+    iter_size_hint(iter, &lower, &upper);
+    dequeue_error_t err = dequeue_make_room(dequeue, lower);
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    void * buffer[ITER_BATCH_SIZE];
+    // spans are not limited by the size of the buffer
+    size_t max = iter->next_span != NULL ? SIZE_MAX : ITER_BATCH_SIZE;
+    void ** span;
+    size_t len;
+    while ((len = iter_next_span(iter, buffer, max, &span)) != 0) {
+        err = dequeue_make_room(dequeue, len);
+        if (!DEQUEUE_ERROR_IS_OK(err)) {
+            return err;
+        }
+        for (size_t i = 0; i < len; i++) {
+            void * elem = span[i];
+            if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+                elem = dequeue_copy_element(dequeue, elem);
+                if (elem == NULL) {
+                    return DEQUEUE_ERROR_ALLOC_FAILED;
+                }
+            }
+            dequeue_slot_set(dequeue,
+                             dequeue_index(dequeue, dequeue->len),
+                             elem);
+            dequeue->len += 1;
+        }
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_extend(dequeue_ptr dequeue, iter_ptr iter) {
+    if (dequeue == NULL || iter == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t old_len = dequeue->len;
+    dequeue_error_t err = dequeue_extend_from(dequeue, iter);
+    // elements pushed before an error stay in the dequeue, so they count
+    dequeue_notify_filled(dequeue, old_len);
+    return err;
 }
 
 dequeue_error_t dequeue_resize(dequeue_ptr dequeue, size_t capacity) {
@@ -240,70 +850,176 @@ dequeue_error_t dequeue_resize(dequeue_ptr dequeue, size_t capacity) {
     if (capacity == dequeue->capacity) {
         return DEQUEUE_ERROR_OK;
     }
+    size_t slot_size = dequeue_slot_size(dequeue);
+    if (capacity > SIZE_MAX / slot_size) {
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
 
-    // intermediate buffer for either truncated items or extension items
-    void ** buf = NULL;
-    // if the length is < -1 then the items must be freed
-    // otherwise, the items must be added at the end of the future dequeue
-    ssize_t buf_len = 0;
-
-    // if the future capacity is less than the current length of the dequeue,
-    // add items that shall be removed in the intermediate buffer
-    if (capacity < dequeue->len) {
-        buf_len = dequeue->len - capacity;
-        buf = malloc(buf_len * sizeof(void *));
-        if (buf == NULL) {
+    if (capacity < dequeue->capacity || dequeue->mapping != NULL) {
+        // shrinking: move the surviving items at the start of a new, smaller
+        // ring and release the surplus items at the back; a mapped ring
+        // cannot be reallocated, so it moves out of the snapshot this way too
+        char * elements_new = allocator_alloc(&dequeue->allocator,
+                                              capacity * slot_size);
+        if (elements_new == NULL) {
             return DEQUEUE_ERROR_ALLOC_FAILED;
         }
-        void ** surplus_start = dequeue->elements
-                + (capacity - 1) * sizeof(void *);
-        memcpy(buf, surplus_start, buf_len * sizeof(void *));
-        buf_len *= (-1);
-    } else if (capacity > dequeue->capacity) {
-        buf_len = capacity - dequeue->capacity;
-        buf = malloc(buf_len * sizeof(void *));
-        if (buf == NULL) {
-            return DEQUEUE_ERROR_ALLOC_FAILED;
+        while (dequeue->len > capacity) {
+            dequeue->len -= 1;
+            size_t index = dequeue_index(dequeue, dequeue->len);
+            if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+                dequeue_element_free(dequeue, dequeue_slot_get(dequeue, index));
+            }
         }
-        memset(buf, 0, buf_len * sizeof(void *));
+        dequeue_linearize_into(dequeue, elements_new);
+        dequeue_release_ring(dequeue);
+        dequeue->elements = (void **) elements_new;
+        dequeue->head = 0;
+        dequeue->capacity = capacity;
+        return DEQUEUE_ERROR_OK;
     }
 
-    void ** elements_new = realloc(dequeue->elements,
-                                   capacity * sizeof(void *));
+    // growing: extend the ring in place, then fix up the wrapped part
+    char * elements_new = allocator_realloc(&dequeue->allocator,
+                                            dequeue->elements,
+                                            dequeue->capacity * slot_size,
+                                            capacity * slot_size);
     if (elements_new == NULL) {
-        if (buf != NULL) {
-            free(buf);
-        }
         return DEQUEUE_ERROR_ALLOC_FAILED;
     }
-    dequeue->elements = elements_new;
+    size_t old_capacity = dequeue->capacity;
+    size_t head_len = old_capacity - dequeue->head;
+    dequeue->elements = (void **) elements_new;
     dequeue->capacity = capacity;
-
-    if (buf_len < 0) {
-        dequeue->len = capacity;
-        buf_len *= (-1);
-        for (size_t i = 0; i < buf_len; i++) {
-            free(buf[i]);
+    if (dequeue->len > head_len) {
+        // the items wrap around the end of the old ring, so either the tail
+        // (which starts at index 0) is moved right after the head part, or
+        // the head part is moved at the end of the new ring, whichever is
+        // shorter
+        size_t tail_len = dequeue->len - head_len;
+        if (tail_len <= head_len && tail_len <= capacity - old_capacity) {
+            memcpy(elements_new + old_capacity * slot_size,
+                   elements_new,
+                   tail_len * slot_size);
+        } else {
+            memmove(elements_new + (capacity - head_len) * slot_size,
+                    elements_new + dequeue->head * slot_size,
+                    head_len * slot_size);
+            dequeue->head = capacity - head_len;
         }
-        free(buf);
-    } else if (buf_len > 0) {
-        memcpy(dequeue->elements + dequeue->len, buf, buf_len * sizeof(void *));
-        free(buf);
     }
 
     return DEQUEUE_ERROR_OK;
 }
 
-dequeue_error_t dequeue_empty(dequeue_ptr dequeue) {
+dequeue_error_t dequeue_set_arena(dequeue_ptr dequeue, arena_ptr arena) {
     if (dequeue == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    if (dequeue->len == 0) {
-        return DEQUEUE_ERROR_OK;
+    if (dequeue->len != 0) {
+        return DEQUEUE_ERROR_NOT_EMPTY;
     }
-    for (size_t i = 0; i < dequeue->len; i++) {
-        memset(dequeue->elements[i], 0, dequeue->element_size);
+    dequeue->arena = arena;
+    if (arena != NULL) {
+        dequeue->arena_mark = arena_mark(arena);
     }
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_use_pool(dequeue_ptr dequeue) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dequeue->pool != NULL) {
+        return DEQUEUE_ERROR_OK;
+    }
+    if (dequeue->len != 0) {
+        return DEQUEUE_ERROR_NOT_EMPTY;
+    }
+    pool_ptr pool = allocator_alloc(&dequeue->allocator, sizeof(pool_t));
+    if (pool == NULL) {
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
+    if (!POOL_ERROR_IS_OK(pool_new(pool,
+                                   dequeue->element_size,
+                                   &dequeue->allocator))) {
+        allocator_free(&dequeue->allocator, pool, sizeof(pool_t));
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
+    dequeue->pool = pool;
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_set_notify(dequeue_ptr dequeue, notify_ptr notify) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue->notify = notify;
+    if (notify != NULL && dequeue->len != 0) {
+        notify_signal(notify);
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+void dequeue_element_free(dequeue_ptr dequeue, void * elem) {
+    if (dequeue == NULL) {
+        return;
+    }
+    if (dequeue->arena != NULL) {
+        return;
+    }
+    if (dequeue->pool != NULL) {
+        pool_dealloc(dequeue->pool, elem);
+        return;
+    }
+    allocator_free(&dequeue->allocator, elem, dequeue->element_size);
+}
+
+dequeue_error_t dequeue_set_growth(dequeue_ptr dequeue,
+                                   double growth_factor,
+                                   size_t max_capacity) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (!(growth_factor > 1.0)) {
+        return DEQUEUE_ERROR_INVALID_GROWTH_FACTOR;
+    }
+    dequeue->growth_factor = growth_factor;
+    dequeue->max_capacity = max_capacity;
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_reserve(dequeue_ptr dequeue, size_t additional) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (additional > SIZE_MAX - dequeue->len) {
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED;
+    }
+    size_t capacity = dequeue->len + additional;
+    if (capacity <= dequeue->capacity) {
+        return DEQUEUE_ERROR_OK;
+    }
+    if (dequeue->max_capacity != DEQUEUE_UNBOUNDED_CAPACITY
+            && capacity > dequeue->max_capacity) {
+        return DEQUEUE_ERROR_CAPACITY_EXCEEDED;
+    }
+    return dequeue_resize(dequeue, capacity);
+}
+
+dequeue_error_t dequeue_shrink_to_fit(dequeue_ptr dequeue) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    return dequeue_resize(dequeue, dequeue->len != 0 ? dequeue->len : 1);
+}
+
+dequeue_error_t dequeue_empty(dequeue_ptr dequeue) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_release_elements(dequeue);
+    dequeue->head = 0;
     dequeue->len = 0;
     return DEQUEUE_ERROR_OK;
 }
@@ -312,11 +1028,1122 @@ dequeue_error_t dequeue_free(dequeue_ptr dequeue) {
     if (dequeue == NULL) {
         return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
     }
-    for (size_t i = 0; i < dequeue->len; i++) {
-        free(dequeue->elements[i]);
+    // elements taken from a pool go away along with its slabs
+    if (dequeue->pool == NULL || dequeue->arena != NULL) {
+        dequeue_release_elements(dequeue);
+    }
+    if (dequeue->pool != NULL) {
+        pool_free(dequeue->pool);
+        allocator_free(&dequeue->allocator, dequeue->pool, sizeof(pool_t));
+        dequeue->pool = NULL;
     }
-    free(dequeue->elements);
+    dequeue_release_ring(dequeue);
+    dequeue->elements = NULL;
+    dequeue->head = 0;
     dequeue->capacity = 0;
     dequeue->len = 0;
     return DEQUEUE_ERROR_OK;
 }
+
+/**
+ * The magic number a snapshot file starts with.
+ */
+#define DEQUEUE_SNAPSHOT_MAGIC "UNILIBDQ"
+
+/**
+ * The version of the snapshot format.
+ */
+#define DEQUEUE_SNAPSHOT_VERSION 1
+
+/**
+ * The header of a snapshot file, in the byte order of the machine.
+ */
+typedef struct dequeue_snapshot_header_t {
+    // DEQUEUE_SNAPSHOT_MAGIC, without its terminating null byte
+    char magic[8];
+    // DEQUEUE_SNAPSHOT_VERSION, which also tells the byte order apart
+    uint32_t version;
+    // always 0
+    uint32_t reserved;
+    // the size of an element
+    uint64_t element_size;
+    // the number of elements
+    uint64_t len;
+    // the checksum of the elements
+    uint64_t checksum;
+    // zeroes up to DEQUEUE_SNAPSHOT_HEADER_SIZE
+    char padding[DEQUEUE_SNAPSHOT_HEADER_SIZE - 40];
+} dequeue_snapshot_header_t;
+
+/**
+ * The state of a checksum fed with the elements one run at a time.
+ * @details Bytes are mixed in eight at a time, so the checksum does not
+ *          depend on how the elements are cut into runs.
+ */
+typedef struct dequeue_checksum_t {
+    // the hash of the words mixed in so far
+    uint64_t hash;
+    // the bytes not mixed in yet
+    char word[8];
+    // the number of bytes in word
+    size_t word_len;
+    // the number of bytes fed so far
+    uint64_t total;
+} dequeue_checksum_t;
+
+/**
+ * Mix a word into a checksum.
+ */
+static uint64_t dequeue_checksum_mix(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15u;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Feed bytes to a checksum.
+ */
+static void dequeue_checksum_update(dequeue_checksum_t * checksum,
+                                    const char * data,
+                                    size_t size) {
+    checksum->total += size;
+    while (size > 0 && checksum->word_len != 0) {
+        checksum->word[checksum->word_len++] = *data++;
+        size -= 1;
+        if (checksum->word_len == 8) {
+            uint64_t word;
+            memcpy(&word, checksum->word, 8);
+            checksum->hash = dequeue_checksum_mix(checksum->hash, word);
+            checksum->word_len = 0;
+        }
+    }
+    if (size == 0) {
+        // the whole chunk went into the unfinished word, which is kept
+        return;
+    }
+    uint64_t hash = checksum->hash;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        hash = dequeue_checksum_mix(hash, word);
+    }
+    checksum->hash = hash;
+    memcpy(checksum->word, data, size);
+    checksum->word_len = size;
+}
+
+/**
+ * Get the value of a checksum once every byte was fed to it.
+ */
+static uint64_t dequeue_checksum_final(dequeue_checksum_t * checksum) {
+    uint64_t hash = checksum->hash;
+    if (checksum->word_len != 0) {
+        uint64_t word = 0;
+        memcpy(&word, checksum->word, checksum->word_len);
+        hash = dequeue_checksum_mix(hash, word);
+    }
+    hash = dequeue_checksum_mix(hash, checksum->total);
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/**
+ * A function fed with the elements of a dequeue, one run of packed elements
+ * at a time. Returns false to stop.
+ */
+typedef bool (* dequeue_snapshot_visit_ptr)(void *, const char *, size_t);
+
+/**
+ * Feed the elements of a dequeue, in order, to a function.
+ * @details Elements stored inline are fed in at most two runs; elements
+ *          stored as pointers are fed one by one.
+ *
+ * @return false if the function stopped early
+ */
+static bool dequeue_snapshot_visit(dequeue_ptr dequeue,
+                                   dequeue_snapshot_visit_ptr visit,
+                                   void * ctx) {
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+        for (size_t pos = 0; pos < dequeue->len; pos++) {
+            if (!visit(ctx, dequeue_get(dequeue, pos), dequeue->element_size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    size_t head_len = dequeue->capacity - dequeue->head;
+    size_t len = dequeue->len <= head_len ? dequeue->len : head_len;
+    if (len != 0 && !visit(ctx,
+                           dequeue_slot(dequeue, dequeue->head),
+                           len * dequeue->element_size)) {
+        return false;
+    }
+    len = dequeue->len - len;
+    return len == 0 || visit(ctx,
+                             (char *) dequeue->elements,
+                             len * dequeue->element_size);
+}
+
+static bool dequeue_snapshot_checksum(void * ctx,
+                                      const char * data,
+                                      size_t size) {
+    dequeue_checksum_update(ctx, data, size);
+    return true;
+}
+
+static bool dequeue_snapshot_write(void * ctx, const char * data, size_t size) {
+    return fwrite(data, 1, size, ctx) == size;
+}
+
+/**
+ * Check the header of a snapshot against the expected element size and the
+ * size of the file.
+ *
+ * @return DEQUEUE_ERROR_OK if the snapshot can be loaded,
+ *         DEQUEUE_ERROR_BAD_SNAPSHOT if the header is not valid or does not
+ *         match the size of the file,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the element sizes differ
+ */
+static dequeue_error_t dequeue_snapshot_check(
+        const dequeue_snapshot_header_t * header,
+        size_t element_size,
+        off_t file_size) {
+    if (memcmp(header->magic, DEQUEUE_SNAPSHOT_MAGIC, 8) != 0
+        || header->version != DEQUEUE_SNAPSHOT_VERSION) {
+        return DEQUEUE_ERROR_BAD_SNAPSHOT;
+    }
+    if (header->element_size != element_size) {
+        return DEQUEUE_ERROR_ELEMENT_MISMATCH;
+    }
+    if (element_size != 0
+        && header->len > (SIZE_MAX - DEQUEUE_SNAPSHOT_HEADER_SIZE)
+                         / element_size) {
+        return DEQUEUE_ERROR_BAD_SNAPSHOT;
+    }
+    uint64_t expected = DEQUEUE_SNAPSHOT_HEADER_SIZE
+                        + header->len * element_size;
+    if (file_size < 0 || (uint64_t) file_size != expected) {
+        return DEQUEUE_ERROR_BAD_SNAPSHOT;
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_save(dequeue_ptr dequeue, const char * path) {
+    if (dequeue == NULL || path == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    dequeue_checksum_t checksum = {0};
+    dequeue_snapshot_visit(dequeue, dequeue_snapshot_checksum, &checksum);
+    dequeue_snapshot_header_t header = {0};
+    memcpy(header.magic, DEQUEUE_SNAPSHOT_MAGIC, 8);
+    header.version = DEQUEUE_SNAPSHOT_VERSION;
+    header.element_size = dequeue->element_size;
+    header.len = dequeue->len;
+    header.checksum = dequeue_checksum_final(&checksum);
+
+    FILE * file = fopen(path, "wb");
+    if (file == NULL) {
+        return DEQUEUE_ERROR_IO;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                   && dequeue_snapshot_visit(dequeue,
+                                             dequeue_snapshot_write,
+                                             file);
+    // a failed close may be the first to report a failed write
+    if (fclose(file) != 0 || !written) {
+        return DEQUEUE_ERROR_IO;
+    }
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_load(dequeue_ptr dequeue,
+                             const char * path,
+                             size_t element_size) {
+    if (dequeue == NULL || path == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        return DEQUEUE_ERROR_IO;
+    }
+    dequeue_error_t err = DEQUEUE_ERROR_OK;
+    struct stat st;
+    dequeue_snapshot_header_t header;
+    if (fstat(fileno(file), &st) != 0) {
+        err = DEQUEUE_ERROR_IO;
+    } else if (fread(&header, sizeof(header), 1, file) != 1) {
+        err = ferror(file) ? DEQUEUE_ERROR_IO : DEQUEUE_ERROR_BAD_SNAPSHOT;
+    } else {
+        err = dequeue_snapshot_check(&header, element_size, st.st_size);
+    }
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        fclose(file);
+        return err;
+    }
+    size_t len = (size_t) header.len;
+    err = dequeue_init(dequeue,
+                       len != 0 ? len : DEQUEUE_DEFAULT_CAPACITY,
+                       element_size,
+                       DEQUEUE_STORAGE_INLINE,
+                       allocator_default());
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        fclose(file);
+        return err;
+    }
+    dequeue_checksum_t checksum = {0};
+    if (fread(dequeue->elements, element_size, len, file) != len) {
+        err = ferror(file) ? DEQUEUE_ERROR_IO : DEQUEUE_ERROR_BAD_SNAPSHOT;
+    } else {
+        dequeue_checksum_update(&checksum,
+                                (char *) dequeue->elements,
+                                len * element_size);
+        if (dequeue_checksum_final(&checksum) != header.checksum) {
+            err = DEQUEUE_ERROR_BAD_SNAPSHOT;
+        }
+    }
+    if (DEQUEUE_ERROR_IS_OK(err)) {
+        dequeue->len = len;
+    } else {
+        dequeue_free(dequeue);
+    }
+    fclose(file);
+    return err;
+}
+
+dequeue_error_t dequeue_load_mapped(dequeue_ptr dequeue,
+                                    const char * path,
+                                    size_t element_size,
+                                    bool verify) {
+    if (dequeue == NULL || path == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return DEQUEUE_ERROR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return DEQUEUE_ERROR_IO;
+    }
+    if (st.st_size < DEQUEUE_SNAPSHOT_HEADER_SIZE) {
+        close(fd);
+        return DEQUEUE_ERROR_BAD_SNAPSHOT;
+    }
+    // a private mapping lets the dequeue write to its ring without touching
+    // the file, and stays valid once the descriptor is closed
+    size_t size = (size_t) st.st_size;
+    char * map = mmap(NULL,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE,
+                      fd,
+                      0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return DEQUEUE_ERROR_IO;
+    }
+    const dequeue_snapshot_header_t * header =
+            (const dequeue_snapshot_header_t *) map;
+    dequeue_error_t err = dequeue_snapshot_check(header,
+                                                 element_size,
+                                                 st.st_size);
+    size_t len = (size_t) header->len;
+    if (DEQUEUE_ERROR_IS_OK(err) && verify) {
+        dequeue_checksum_t checksum = {0};
+        dequeue_checksum_update(&checksum,
+                                map + DEQUEUE_SNAPSHOT_HEADER_SIZE,
+                                len * element_size);
+        if (dequeue_checksum_final(&checksum) != header->checksum) {
+            err = DEQUEUE_ERROR_BAD_SNAPSHOT;
+        }
+    }
+    if (DEQUEUE_ERROR_IS_OK(err)) {
+        err = dequeue_init(dequeue,
+                           DEQUEUE_DEFAULT_CAPACITY,
+                           element_size,
+                           DEQUEUE_STORAGE_INLINE,
+                           allocator_default());
+    }
+    if (!DEQUEUE_ERROR_IS_OK(err) || len == 0) {
+        // an empty snapshot has no ring to serve, so it is not kept mapped
+        munmap(map, size);
+        return err;
+    }
+    // swap the ring dequeue_init allocated for the elements of the snapshot
+    dequeue_release_ring(dequeue);
+    dequeue->elements = (void **) (map + DEQUEUE_SNAPSHOT_HEADER_SIZE);
+    dequeue->capacity = len;
+    dequeue->len = len;
+    dequeue->mapping = map;
+    dequeue->mapping_size = size;
+    return DEQUEUE_ERROR_OK;
+}
+
+/**
+ * Take the next element from the front of a dequeue iterator.
+ */
+static void * dequeue_iter_next_front(void * data) {
+    dequeue_iter_ptr state = data;
+    if (state->front == state->back) {
+        return NULL;
+    }
+    return dequeue_slot_get(state->dequeue,
+                            dequeue_index(state->dequeue, state->front++));
+}
+
+/**
+ * Take the next element from the back of a dequeue iterator.
+ */
+static void * dequeue_iter_next_back(void * data) {
+    dequeue_iter_ptr state = data;
+    if (state->front == state->back) {
+        return NULL;
+    }
+    return dequeue_slot_get(state->dequeue,
+                            dequeue_index(state->dequeue, --state->back));
+}
+
+/**
+ * Get the exact number of elements left in a dequeue iterator.
+ */
+static void dequeue_iter_size_hint(void * data,
+                                   size_t * lower,
+                                   size_t * upper) {
+    dequeue_iter_ptr state = data;
+    *lower = state->back - state->front;
+    *upper = *lower;
+}
+
+/**
+ * Skip elements at the front of a dequeue iterator.
+ */
+static size_t dequeue_iter_advance_front(void * data, size_t count) {
+    dequeue_iter_ptr state = data;
+    size_t remaining = state->back - state->front;
+    if (count > remaining) {
+        count = remaining;
+    }
+    state->front += count;
+    return count;
+}
+
+/**
+ * Skip elements at the back of a dequeue iterator.
+ */
+static size_t dequeue_iter_advance_back(void * data, size_t count) {
+    dequeue_iter_ptr state = data;
+    size_t remaining = state->back - state->front;
+    if (count > remaining) {
+        count = remaining;
+    }
+    state->back -= count;
+    return count;
+}
+
+/**
+ * Fill a batch from the front of a dequeue iterator.
+ */
+static size_t dequeue_iter_batch_front(void * data,
+                                       void ** buffer,
+                                       size_t max) {
+    dequeue_iter_ptr state = data;
+    size_t len = state->back - state->front;
+    if (len > max) {
+        len = max;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    dequeue_ptr dequeue = state->dequeue;
+    size_t index = dequeue_index(dequeue, state->front);
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = dequeue_slot_get(dequeue, index);
+        if (++index == dequeue->capacity) {
+            index = 0;
+        }
+    }
+    state->front += len;
+    return len;
+}
+
+/**
+ * Fill a batch from the back of a dequeue iterator.
+ */
+static size_t dequeue_iter_batch_back(void * data,
+                                      void ** buffer,
+                                      size_t max) {
+    dequeue_iter_ptr state = data;
+    size_t len = state->back - state->front;
+    if (len > max) {
+        len = max;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    dequeue_ptr dequeue = state->dequeue;
+    size_t index = dequeue_index(dequeue, state->back - 1);
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = dequeue_slot_get(dequeue, index);
+        index = index == 0 ? dequeue->capacity - 1 : index - 1;
+    }
+    state->back -= len;
+    return len;
+}
+
+/**
+ * Lend the longest run of element pointers at the front of a dequeue iterator
+ * that does not wrap around the end of the ring.
+ */
+static size_t dequeue_iter_span_front(void * data, size_t max, void *** span) {
+    dequeue_iter_ptr state = data;
+    size_t len = state->back - state->front;
+    if (len > max) {
+        len = max;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    dequeue_ptr dequeue = state->dequeue;
+    size_t index = dequeue_index(dequeue, state->front);
+    if (len > dequeue->capacity - index) {
+        len = dequeue->capacity - index;
+    }
+    *span = dequeue->elements + index;
+    state->front += len;
+    return len;
+}
+
+/**
+ * Nothing to release, the state of the iterator belongs to the caller.
+ */
+static void dequeue_iter_free(void * data) {
+    (void) data;
+}
+
+/**
+ * Point the state of an iterator at all the elements of a dequeue.
+ */
+static void dequeue_iter_init(dequeue_ptr dequeue, dequeue_iter_ptr state) {
+    state->dequeue = dequeue;
+    state->front = 0;
+    state->back = dequeue != NULL ? dequeue->len : 0;
+}
+
+iter_t dequeue_iter(dequeue_ptr dequeue, dequeue_iter_ptr state) {
+    dequeue_iter_init(dequeue, state);
+    iter_t iter = iter_new(state, dequeue_iter_next_front, dequeue_iter_free);
+    iter_set_double_ended(&iter, dequeue_iter_next_back);
+    iter_set_random_access(&iter,
+                           dequeue_iter_size_hint,
+                           dequeue_iter_advance_front);
+    // inline elements have no pointers to lend
+    int spans = dequeue != NULL && dequeue->storage == DEQUEUE_STORAGE_POINTERS;
+    iter_set_batch(&iter,
+                   dequeue_iter_batch_front,
+                   spans ? dequeue_iter_span_front : NULL);
+    return iter;
+}
+
+iter_t dequeue_iter_rev(dequeue_ptr dequeue, dequeue_iter_ptr state) {
+    dequeue_iter_init(dequeue, state);
+    iter_t iter = iter_new(state, dequeue_iter_next_back, dequeue_iter_free);
+    iter_set_double_ended(&iter, dequeue_iter_next_front);
+    iter_set_random_access(&iter,
+                           dequeue_iter_size_hint,
+                           dequeue_iter_advance_back);
+    iter_set_batch(&iter, dequeue_iter_batch_back, NULL);
+    return iter;
+}
+
+/**
+ * Get the contiguous segments of the ring of a dequeue storing elements of a
+ * given size inline.
+ *
+ * @param dequeue the dequeue
+ * @param element_size the expected size of an element
+ * @param segments where to store the start of both segments
+ * @param lens where to store the number of elements in both segments
+ *
+ * @return DEQUEUE_ERROR_OK on success,
+ *         DEQUEUE_ERROR_ELEMENT_MISMATCH if the dequeue does not store
+ *         elements of that size inline
+ */
+static dequeue_error_t dequeue_segments(dequeue_ptr dequeue,
+                                        size_t element_size,
+                                        const void * segments[2],
+                                        size_t lens[2]) {
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE
+        || dequeue->element_size != element_size) {
+        return DEQUEUE_ERROR_ELEMENT_MISMATCH;
+    }
+    size_t first = dequeue->capacity - dequeue->head;
+    if (first > dequeue->len) {
+        first = dequeue->len;
+    }
+    segments[0] = dequeue_slot(dequeue, dequeue->head);
+    lens[0] = first;
+    segments[1] = dequeue_slot(dequeue, 0);
+    lens[1] = dequeue->len - first;
+    return DEQUEUE_ERROR_OK;
+}
+
+#define DEQUEUE_SIMD_SUM(suffix, T, R)                                        \
+dequeue_error_t dequeue_sum_##suffix(dequeue_ptr dequeue, R * sum) {          \
+    if (dequeue == NULL || sum == NULL) {                                     \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;                           \
+    }                                                                         \
+    const void * segments[2];                                                 \
+    size_t lens[2];                                                           \
+    dequeue_error_t err = dequeue_segments(dequeue, sizeof(T), segments, lens);\
+    if (!DEQUEUE_ERROR_IS_OK(err)) {                                          \
+        return err;                                                           \
+    }                                                                         \
+    *sum = simd_sum_##suffix(segments[0], lens[0])                            \
+           + simd_sum_##suffix(segments[1], lens[1]);                         \
+    return DEQUEUE_ERROR_OK;                                                  \
+}
+
+#define DEQUEUE_SIMD_MIN_MAX(suffix, T)                                       \
+dequeue_error_t dequeue_min_max_##suffix(dequeue_ptr dequeue,                 \
+                                         T * min,                             \
+                                         T * max) {                           \
+    if (dequeue == NULL || min == NULL || max == NULL) {                      \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;                           \
+    }                                                                         \
+    const void * segments[2];                                                 \
+    size_t lens[2];                                                           \
+    dequeue_error_t err = dequeue_segments(dequeue, sizeof(T), segments, lens);\
+    if (!DEQUEUE_ERROR_IS_OK(err)) {                                          \
+        return err;                                                           \
+    }                                                                         \
+    if (!simd_min_max_##suffix(segments[0], lens[0], min, max)) {             \
+        return DEQUEUE_ERROR_EMPTY;                                           \
+    }                                                                         \
+    T tail_min;                                                               \
+    T tail_max;                                                               \
+    if (simd_min_max_##suffix(segments[1], lens[1], &tail_min, &tail_max)) {  \
+        *min = tail_min < *min ? tail_min : *min;                             \
+        *max = tail_max > *max ? tail_max : *max;                             \
+    }                                                                         \
+    return DEQUEUE_ERROR_OK;                                                  \
+}
+
+#define DEQUEUE_SIMD_COUNT_EQ(suffix, T)                                      \
+dequeue_error_t dequeue_count_eq_##suffix(dequeue_ptr dequeue,                \
+                                          T value,                            \
+                                          size_t * count) {                   \
+    if (dequeue == NULL || count == NULL) {                                   \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;                           \
+    }                                                                         \
+    const void * segments[2];                                                 \
+    size_t lens[2];                                                           \
+    dequeue_error_t err = dequeue_segments(dequeue, sizeof(T), segments, lens);\
+    if (!DEQUEUE_ERROR_IS_OK(err)) {                                          \
+        return err;                                                           \
+    }                                                                         \
+    *count = simd_count_eq_##suffix(segments[0], lens[0], value)              \
+             + simd_count_eq_##suffix(segments[1], lens[1], value);           \
+    return DEQUEUE_ERROR_OK;                                                  \
+}
+
+#define DEQUEUE_SIMD_FIND(suffix, T)                                          \
+dequeue_error_t dequeue_find_##suffix(dequeue_ptr dequeue,                    \
+                                      T value,                                \
+                                      size_t * pos) {                         \
+    if (dequeue == NULL || pos == NULL) {                                     \
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;                           \
+    }                                                                         \
+    const void * segments[2];                                                 \
+    size_t lens[2];                                                           \
+    dequeue_error_t err = dequeue_segments(dequeue, sizeof(T), segments, lens);\
+    if (!DEQUEUE_ERROR_IS_OK(err)) {                                          \
+        return err;                                                           \
+    }                                                                         \
+    *pos = simd_find_##suffix(segments[0], lens[0], value);                   \
+    if (*pos == lens[0]) {                                                    \
+        *pos += simd_find_##suffix(segments[1], lens[1], value);              \
+    }                                                                         \
+    return DEQUEUE_ERROR_OK;                                                  \
+}
+
+DEQUEUE_SIMD_SUM(i32, int32_t, int64_t)
+DEQUEUE_SIMD_SUM(i64, int64_t, int64_t)
+DEQUEUE_SIMD_SUM(f32, float, float)
+DEQUEUE_SIMD_SUM(f64, double, double)
+
+DEQUEUE_SIMD_MIN_MAX(i32, int32_t)
+DEQUEUE_SIMD_MIN_MAX(i64, int64_t)
+DEQUEUE_SIMD_MIN_MAX(f32, float)
+DEQUEUE_SIMD_MIN_MAX(f64, double)
+
+DEQUEUE_SIMD_COUNT_EQ(i32, int32_t)
+DEQUEUE_SIMD_COUNT_EQ(i64, int64_t)
+DEQUEUE_SIMD_COUNT_EQ(f32, float)
+DEQUEUE_SIMD_COUNT_EQ(f64, double)
+
+DEQUEUE_SIMD_FIND(i32, int32_t)
+DEQUEUE_SIMD_FIND(i64, int64_t)
+DEQUEUE_SIMD_FIND(f32, float)
+DEQUEUE_SIMD_FIND(f64, double)
+DEQUEUE_SIMD_FIND(byte, uint8_t)
+
+#undef DEQUEUE_SIMD_SUM
+#undef DEQUEUE_SIMD_MIN_MAX
+#undef DEQUEUE_SIMD_COUNT_EQ
+#undef DEQUEUE_SIMD_FIND
+
+/**
+ * Ranges this short are sorted by insertion.
+ */
+#define DEQUEUE_SORT_INSERTION_MAX 16
+
+/**
+ * @struct dequeue_sort
+ * @brief What the sorting routines need to know about the slots they move.
+ */
+typedef struct dequeue_sort_t {
+    // the comparison function
+    dequeue_compare_ptr compare;
+    // the size of a slot
+    size_t size;
+    // whether the slots hold element pointers rather than the elements
+    int indirect;
+} dequeue_sort_t;
+
+/**
+ * Check whether the element in a slot orders before the one in another.
+ */
+static int dequeue_sort_less(const dequeue_sort_t * sort,
+                             const char * a,
+                             const char * b) {
+    if (sort->indirect) {
+        return sort->compare(*(void * const *) a, *(void * const *) b) < 0;
+    }
+    return sort->compare(a, b) < 0;
+}
+
+/**
+ * Swap the contents of two slots.
+ */
+static void dequeue_sort_swap(char * a, char * b, size_t size) {
+    // fixed sizes let the compiler turn the copies into plain moves
+    if (size == sizeof(uint64_t)) {
+        uint64_t tmp;
+        memcpy(&tmp, a, sizeof(tmp));
+        memcpy(a, b, sizeof(tmp));
+        memcpy(b, &tmp, sizeof(tmp));
+        return;
+    }
+    if (size == sizeof(uint32_t)) {
+        uint32_t tmp;
+        memcpy(&tmp, a, sizeof(tmp));
+        memcpy(a, b, sizeof(tmp));
+        memcpy(b, &tmp, sizeof(tmp));
+        return;
+    }
+    char tmp[64];
+    while (size > 0) {
+        size_t chunk = size < sizeof(tmp) ? size : sizeof(tmp);
+        memcpy(tmp, a, chunk);
+        memcpy(a, b, chunk);
+        memcpy(b, tmp, chunk);
+        a += chunk;
+        b += chunk;
+        size -= chunk;
+    }
+}
+
+/**
+ * Reverse the order of a range of slots.
+ */
+static void dequeue_reverse(char * base, size_t n, size_t size) {
+    if (n < 2) {
+        return;
+    }
+    char * lo = base;
+    char * hi = base + (n - 1) * size;
+    while (lo < hi) {
+        dequeue_sort_swap(lo, hi, size);
+        lo += size;
+        hi -= size;
+    }
+}
+
+void * dequeue_make_contiguous(dequeue_ptr dequeue) {
+    if (dequeue == NULL) {
+        return NULL;
+    }
+    size_t size = dequeue_slot_size(dequeue);
+    char * ring = (char *) dequeue->elements;
+    if (dequeue->head + dequeue->len > dequeue->capacity) {
+        // rotate the whole ring left by head with three reversals, which
+        // needs no memory beyond a slot
+        dequeue_reverse(ring, dequeue->head, size);
+        dequeue_reverse(ring + dequeue->head * size,
+                        dequeue->capacity - dequeue->head,
+                        size);
+        dequeue_reverse(ring, dequeue->capacity, size);
+    } else if (dequeue->head != 0) {
+        memmove(ring, ring + dequeue->head * size, dequeue->len * size);
+    }
+    dequeue->head = 0;
+    return ring;
+}
+
+/**
+ * Sort a range of slots by insertion, keeping equivalent elements in order.
+ */
+static void dequeue_insertion_sort(const dequeue_sort_t * sort,
+                                   char * base,
+                                   size_t n) {
+    size_t size = sort->size;
+    for (size_t i = 1; i < n; i++) {
+        char * cur = base + i * size;
+        while (cur > base && dequeue_sort_less(sort, cur, cur - size)) {
+            dequeue_sort_swap(cur, cur - size, size);
+            cur -= size;
+        }
+    }
+}
+
+/**
+ * Move the slot at the root of a binary max-heap down to its place.
+ */
+static void dequeue_sift_down(const dequeue_sort_t * sort,
+                              char * base,
+                              size_t root,
+                              size_t n) {
+    size_t size = sort->size;
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n) {
+            return;
+        }
+        if (child + 1 < n && dequeue_sort_less(sort,
+                                               base + child * size,
+                                               base + (child + 1) * size)) {
+            child += 1;
+        }
+        if (!dequeue_sort_less(sort, base + root * size, base + child * size)) {
+            return;
+        }
+        dequeue_sort_swap(base + root * size, base + child * size, size);
+        root = child;
+    }
+}
+
+/**
+ * Sort a range of slots with heapsort.
+ */
+static void dequeue_heapsort(const dequeue_sort_t * sort,
+                             char * base,
+                             size_t n) {
+    for (size_t i = n / 2; i-- > 0;) {
+        dequeue_sift_down(sort, base, i, n);
+    }
+    for (size_t end = n; end-- > 1;) {
+        dequeue_sort_swap(base, base + end * sort->size, sort->size);
+        dequeue_sift_down(sort, base, 0, end);
+    }
+}
+
+/**
+ * Sort a range of slots with quicksort, falling back to heapsort once the
+ * depth budget runs out.
+ */
+static void dequeue_introsort(const dequeue_sort_t * sort,
+                              char * base,
+                              size_t n,
+                              size_t depth) {
+    size_t size = sort->size;
+    while (n > DEQUEUE_SORT_INSERTION_MAX) {
+        if (depth == 0) {
+            dequeue_heapsort(sort, base, n);
+            return;
+        }
+        depth -= 1;
+        // order the first, middle and last slots, then move the median to
+        // the front as the pivot; the last slot bounds the partition scan
+        char * mid = base + n / 2 * size;
+        char * last = base + (n - 1) * size;
+        if (dequeue_sort_less(sort, mid, base)) {
+            dequeue_sort_swap(mid, base, size);
+        }
+        if (dequeue_sort_less(sort, last, mid)) {
+            dequeue_sort_swap(last, mid, size);
+            if (dequeue_sort_less(sort, mid, base)) {
+                dequeue_sort_swap(mid, base, size);
+            }
+        }
+        dequeue_sort_swap(base, mid, size);
+        // stop on elements equal to the pivot on both sides, so that runs of
+        // equal elements split evenly
+        size_t i = 1;
+        size_t j = n - 1;
+        for (;;) {
+            while (i <= j && dequeue_sort_less(sort, base + i * size, base)) {
+                i += 1;
+            }
+            while (i <= j && dequeue_sort_less(sort, base, base + j * size)) {
+                j -= 1;
+            }
+            if (i >= j) {
+                break;
+            }
+            dequeue_sort_swap(base + i * size, base + j * size, size);
+            i += 1;
+            j -= 1;
+        }
+        dequeue_sort_swap(base, base + j * size, size);
+        // recurse into the smaller side and loop on the larger one, which
+        // bounds the stack to O(log n)
+        size_t right = n - j - 1;
+        if (j < right) {
+            dequeue_introsort(sort, base, j, depth);
+            base += (j + 1) * size;
+            n = right;
+        } else {
+            dequeue_introsort(sort, base + (j + 1) * size, right, depth);
+            n = j;
+        }
+    }
+    dequeue_insertion_sort(sort, base, n);
+}
+
+/**
+ * Merge two sorted runs of slots into dst, taking from the left run on ties.
+ */
+static void dequeue_merge(const dequeue_sort_t * sort,
+                          const char * left,
+                          size_t left_len,
+                          const char * right,
+                          size_t right_len,
+                          char * dst) {
+    size_t size = sort->size;
+    const char * left_end = left + left_len * size;
+    const char * right_end = right + right_len * size;
+    while (left < left_end && right < right_end) {
+        if (dequeue_sort_less(sort, right, left)) {
+            memcpy(dst, right, size);
+            right += size;
+        } else {
+            memcpy(dst, left, size);
+            left += size;
+        }
+        dst += size;
+    }
+    memcpy(dst, left, (size_t) (left_end - left));
+    dst += left_end - left;
+    memcpy(dst, right, (size_t) (right_end - right));
+}
+
+dequeue_error_t dequeue_sort(dequeue_ptr dequeue, dequeue_compare_ptr compare) {
+    if (dequeue == NULL || compare == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (dequeue->len < 2) {
+        return DEQUEUE_ERROR_OK;
+    }
+    dequeue_sort_t sort = {
+        compare,
+        dequeue_slot_size(dequeue),
+        dequeue->storage != DEQUEUE_STORAGE_INLINE,
+    };
+    size_t depth = 0;
+    for (size_t n = dequeue->len; n > 1; n >>= 1) {
+        depth += 2;
+    }
+    dequeue_introsort(&sort,
+                      dequeue_make_contiguous(dequeue),
+                      dequeue->len,
+                      depth);
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_stable_sort(dequeue_ptr dequeue,
+                                    dequeue_compare_ptr compare) {
+    if (dequeue == NULL || compare == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t n = dequeue->len;
+    if (n < 2) {
+        return DEQUEUE_ERROR_OK;
+    }
+    dequeue_sort_t sort = {
+        compare,
+        dequeue_slot_size(dequeue),
+        dequeue->storage != DEQUEUE_STORAGE_INLINE,
+    };
+    size_t size = sort.size;
+    char * base = dequeue_make_contiguous(dequeue);
+    if (n <= DEQUEUE_SORT_INSERTION_MAX) {
+        dequeue_insertion_sort(&sort, base, n);
+        return DEQUEUE_ERROR_OK;
+    }
+    char * buffer = allocator_alloc(&dequeue->allocator, n * size);
+    if (buffer == NULL) {
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
+    for (size_t start = 0; start < n; start += DEQUEUE_SORT_INSERTION_MAX) {
+        size_t run = n - start < DEQUEUE_SORT_INSERTION_MAX
+                ? n - start
+                : DEQUEUE_SORT_INSERTION_MAX;
+        dequeue_insertion_sort(&sort, base + start * size, run);
+    }
+    // merge runs of doubling width back and forth between the ring and the
+    // buffer
+    char * src = base;
+    char * dst = buffer;
+    for (size_t width = DEQUEUE_SORT_INSERTION_MAX; width < n; width *= 2) {
+        for (size_t start = 0; start < n; start += 2 * width) {
+            size_t mid = n - start < width ? n : start + width;
+            size_t end = n - mid < width ? n : mid + width;
+            dequeue_merge(&sort,
+                          src + start * size,
+                          mid - start,
+                          src + mid * size,
+                          end - mid,
+                          dst + start * size);
+        }
+        char * tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != base) {
+        memcpy(base, src, n * size);
+    }
+    allocator_free(&dequeue->allocator, buffer, n * size);
+    return DEQUEUE_ERROR_OK;
+}
+
+/**
+ * Read an inline integer element as an unsigned key.
+ */
+static uint64_t dequeue_radix_key(const char * elem, size_t size) {
+    switch (size) {
+        case sizeof(uint8_t):
+            return (uint8_t) *elem;
+        case sizeof(uint16_t): {
+            uint16_t key;
+            memcpy(&key, elem, sizeof(key));
+            return key;
+        }
+        case sizeof(uint32_t): {
+            uint32_t key;
+            memcpy(&key, elem, sizeof(key));
+            return key;
+        }
+        default: {
+            uint64_t key;
+            memcpy(&key, elem, sizeof(key));
+            return key;
+        }
+    }
+}
+
+dequeue_error_t dequeue_radix_sort(dequeue_ptr dequeue, dequeue_key_t key) {
+    if (dequeue == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t size = dequeue->element_size;
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE
+        || (size != 1 && size != 2 && size != 4 && size != 8)) {
+        return DEQUEUE_ERROR_ELEMENT_MISMATCH;
+    }
+    size_t n = dequeue->len;
+    if (n < 2) {
+        return DEQUEUE_ERROR_OK;
+    }
+    char * base = dequeue_make_contiguous(dequeue);
+    char * buffer = allocator_alloc(&dequeue->allocator, n * size);
+    if (buffer == NULL) {
+        return DEQUEUE_ERROR_ALLOC_FAILED;
+    }
+    // flipping the sign bit orders two's complement keys as unsigned ones
+    uint64_t flip = key == DEQUEUE_KEY_SIGNED
+            ? (uint64_t) 1 << (size * 8 - 1)
+            : 0;
+    // count the digits of every pass in a single read of the keys
+    size_t counts[sizeof(uint64_t)][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        uint64_t k = dequeue_radix_key(base + i * size, size) ^ flip;
+        for (size_t digit = 0; digit < size; digit++) {
+            counts[digit][(k >> (digit * 8)) & 0xff] += 1;
+        }
+    }
+    char * src = base;
+    char * dst = buffer;
+    uint64_t first = dequeue_radix_key(base, size) ^ flip;
+    for (size_t digit = 0; digit < size; digit++) {
+        size_t * count = counts[digit];
+        // a digit shared by every key would leave the order unchanged
+        if (count[(first >> (digit * 8)) & 0xff] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < 256; bucket++) {
+            size_t bucket_len = count[bucket];
+            count[bucket] = offset;
+            offset += bucket_len;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const char * elem = src + i * size;
+            uint64_t k = dequeue_radix_key(elem, size) ^ flip;
+            size_t bucket = (k >> (digit * 8)) & 0xff;
+            memcpy(dst + count[bucket] * size, elem, size);
+            count[bucket] += 1;
+        }
+        char * tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != base) {
+        memcpy(base, src, n * size);
+    }
+    allocator_free(&dequeue->allocator, buffer, n * size);
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_lower_bound(dequeue_ptr dequeue,
+                                    const void * key,
+                                    dequeue_compare_ptr compare,
+                                    size_t * pos) {
+    if (dequeue == NULL || compare == NULL || pos == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t lo = 0;
+    size_t hi = dequeue->len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        void * elem = dequeue_slot_get(dequeue, dequeue_index(dequeue, mid));
+        if (compare(elem, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *pos = lo;
+    return DEQUEUE_ERROR_OK;
+}
+
+dequeue_error_t dequeue_upper_bound(dequeue_ptr dequeue,
+                                    const void * key,
+                                    dequeue_compare_ptr compare,
+                                    size_t * pos) {
+    if (dequeue == NULL || compare == NULL || pos == NULL) {
+        return DEQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t lo = 0;
+    size_t hi = dequeue->len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        void * elem = dequeue_slot_get(dequeue, dequeue_index(dequeue, mid));
+        if (compare(key, elem) < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    *pos = lo;
+    return DEQUEUE_ERROR_OK;
+}
@@ -22,6 +22,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "iter.h"
 
@@ -30,26 +31,145 @@ iter_t iter_new(void * data, iter_next_ptr next, iter_free_ptr free) {
     iter.data = data;
     iter.next = next;
     iter.free = free;
+    iter.next_batch = NULL;
+    iter.next_span = NULL;
+    iter.size_hint = NULL;
+    iter.advance = NULL;
+    iter.next_back = NULL;
     return iter;
 }
 
 iter_ptr iter_new_ptr(void * data, iter_next_ptr next, iter_free_ptr free) {
-    iter_ptr iter = malloc(sizeof(iter_t));
+    return iter_new_ptr_with_allocator(data, next, free, NULL);
+}
+
+iter_ptr iter_new_ptr_with_allocator(void * data,
+                                     iter_next_ptr next,
+                                     iter_free_ptr free,
+                                     allocator_ptr allocator) {
+    iter_ptr iter = allocator_alloc(allocator, sizeof(iter_t));
     if (iter == NULL) {
         return NULL;
     }
     iter->data = data;
     iter->next = next;
     iter->free = free;
+    iter->next_batch = NULL;
+    iter->next_span = NULL;
+    iter->size_hint = NULL;
+    iter->advance = NULL;
+    iter->next_back = NULL;
     return iter;
 }
 
+void iter_set_batch(iter_ptr iter,
+                    iter_next_batch_ptr next_batch,
+                    iter_next_span_ptr next_span) {
+    iter->next_batch = next_batch;
+    iter->next_span = next_span;
+}
+
+void iter_set_random_access(iter_ptr iter,
+                            iter_size_hint_ptr size_hint,
+                            iter_advance_ptr advance) {
+    iter->size_hint = size_hint;
+    iter->advance = advance;
+}
+
+void iter_set_double_ended(iter_ptr iter, iter_next_back_ptr next_back) {
+    iter->next_back = next_back;
+}
+
+void iter_size_hint(iter_ptr iter, size_t * lower, size_t * upper) {
+    if (iter->size_hint != NULL) {
+        iter->size_hint(iter->data, lower, upper);
+    } else {
+        *lower = 0;
+        *upper = SIZE_MAX;
+    }
+}
+
+int iter_exact_len(iter_ptr iter, size_t * len) {
+    size_t lower;
+    size_t upper;
+    iter_size_hint(iter, &lower, &upper);
+    if (lower != upper) {
+        return 0;
+    }
+    *len = lower;
+    return 1;
+}
+
 void * iter_next(iter_ptr iter) {
     return iter->next(iter->data);
 }
 
+void * iter_next_back(iter_ptr iter) {
+    return iter->next_back != NULL ? iter->next_back(iter->data) : NULL;
+}
+
+size_t iter_next_batch(iter_ptr iter, void ** buffer, size_t max) {
+    if (iter->next_batch != NULL) {
+        return iter->next_batch(iter->data, buffer, max);
+    }
+    if (iter->next_span != NULL) {
+        void ** span;
+        size_t len = iter->next_span(iter->data, max, &span);
+        memcpy(buffer, span, len * sizeof(void *));
+        return len;
+    }
+    size_t len = 0;
+    while (len < max) {
+        void * elem = iter_next(iter);
+        if (elem == NULL) {
+            break;
+        }
+        buffer[len++] = elem;
+    }
+    return len;
+}
+
+size_t iter_next_span(iter_ptr iter,
+                      void ** buffer,
+                      size_t max,
+                      void *** span) {
+    if (iter->next_span != NULL) {
+        return iter->next_span(iter->data, max, span);
+    }
+    *span = buffer;
+    return iter_next_batch(iter, buffer, max);
+}
+
 size_t iter_advance_by(iter_ptr iter, size_t count) {
+    if (iter->advance != NULL) {
+        return iter->advance(iter->data, count);
+    }
     size_t advanced_by = 0;
+    if (iter->next_span != NULL) {
+        void ** span;
+        while (advanced_by < count) {
+            size_t len = iter->next_span(iter->data, count - advanced_by, &span);
+            if (len == 0) {
+                break;
+            }
+            advanced_by += len;
+        }
+        return advanced_by;
+    }
+    if (iter->next_batch != NULL) {
+        void * buffer[ITER_BATCH_SIZE];
+        while (advanced_by < count) {
+            size_t max = count - advanced_by < ITER_BATCH_SIZE
+                         ? count - advanced_by
+                         : ITER_BATCH_SIZE;
+            size_t len = iter->next_batch(iter->data, buffer, max);
+            if (len == 0) {
+                break;
+            }
+            advanced_by += len;
+        }
+        return advanced_by;
+    }
     while (advanced_by < count) {
         if (iter_next(iter) != NULL) {
             advanced_by += 1;
@@ -60,8 +180,37 @@ size_t iter_advance_by(iter_ptr iter, size_t count) {
     return advanced_by;
 }
 
+void * iter_nth(iter_ptr iter, size_t n) {
+    if (iter_advance_by(iter, n) != n) {
+        return NULL;
+    }
+    return iter_next(iter);
+}
+
 size_t iter_count(iter_ptr iter) {
     size_t count = 0;
+    if (iter->advance != NULL && iter_exact_len(iter, &count)) {
+        // still consume the iterator, like walking it would
+        iter->advance(iter->data, count);
+        return count;
+    }
+    if (iter->next_span != NULL) {
+        void ** span;
+        size_t len;
+        while ((len = iter->next_span(iter->data, SIZE_MAX, &span)) != 0) {
+            count += len;
+        }
+        return count;
+    }
+    if (iter->next_batch != NULL) {
+        void * buffer[ITER_BATCH_SIZE];
+        size_t len;
+        while ((len = iter->next_batch(iter->data, buffer, ITER_BATCH_SIZE))
+               != 0) {
+            count += len;
+        }
+        return count;
+    }
     while (iter_next(iter) != NULL) {
         count += 1;
     }
@@ -71,3 +220,464 @@ size_t iter_count(iter_ptr iter) {
 void iter_free(iter_ptr iter) {
     iter->free(iter->data);
 }
+
+/**
+ * Run an element through the stages of a pipeline.
+ *
+ * @param state the pipeline
+ * @param elem address of the element, replaced by the mapped element
+ *
+ * @return 1 if the element is kept, 0 if a filter dropped it, -1 if a map
+ *         ended the iteration
+ */
+static int iter_stages_run(iter_stages_ptr state, void ** elem) {
+    for (size_t i = 0; i < state->len; i++) {
+        iter_stage_t * stage = &state->stages[i];
+        if (stage->map != NULL) {
+            *elem = stage->map(*elem, stage->ctx);
+            if (*elem == NULL) {
+                return -1;
+            }
+        } else if (!stage->filter(*elem, stage->ctx)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Count the filter stages of a pipeline.
+ */
+static size_t iter_stages_filters(iter_stages_ptr state) {
+    size_t filters = 0;
+    for (size_t i = 0; i < state->len; i++) {
+        if (state->stages[i].filter != NULL) {
+            filters += 1;
+        }
+    }
+    return filters;
+}
+
+/**
+ * Get the next element that makes it through a pipeline.
+ */
+static void * iter_stages_next(void * data) {
+    iter_stages_ptr state = data;
+    if (state->done) {
+        return NULL;
+    }
+    void * elem;
+    while ((elem = iter_next(&state->source)) != NULL) {
+        int kept = iter_stages_run(state, &elem);
+        if (kept > 0) {
+            return elem;
+        }
+        if (kept < 0) {
+            break;
+        }
+    }
+    state->done = 1;
+    return NULL;
+}
+
+/**
+ * Fill a batch with the elements that make it through a filter-only pipeline.
+ */
+static size_t iter_stages_next_batch(void * data, void ** buffer, size_t max) {
+    iter_stages_ptr state = data;
+    size_t len = 0;
+    while (len == 0 && !state->done) {
+        size_t pulled = iter_next_batch(&state->source, buffer, max);
+        if (pulled == 0) {
+            state->done = 1;
+            return 0;
+        }
+        // compacts the kept elements to the front of the buffer
+        for (size_t i = 0; i < pulled; i++) {
+            void * elem = buffer[i];
+            if (iter_stages_run(state, &elem) > 0) {
+                buffer[len++] = elem;
+            }
+        }
+    }
+    return len;
+}
+
+/**
+ * Get the bounds of the number of elements left in a pipeline.
+ * @details Any stage may end up with fewer elements than the source, a
+ *          filter by dropping them and a map by ending the iteration, so
+ *          only the upper bound of the source carries over.
+ */
+static void iter_stages_size_hint(void * data, size_t * lower, size_t * upper) {
+    iter_stages_ptr state = data;
+    if (state->done) {
+        *lower = 0;
+        *upper = 0;
+        return;
+    }
+    iter_size_hint(&state->source, lower, upper);
+    *lower = 0;
+}
+
+/**
+ * Free the source of a pipeline.
+ */
+static void iter_stages_free(void * data) {
+    iter_stages_ptr state = data;
+    iter_free(&state->source);
+}
+
+/**
+ * Add a stage to a pipeline, fusing it with the source if the source is a
+ * pipeline with room for another stage.
+ */
+static iter_t iter_stages_push(iter_ptr source,
+                               iter_stage_t stage,
+                               iter_stages_ptr storage) {
+    if (source->next == iter_stages_next
+        && ((iter_stages_ptr) source->data)->len < ITER_MAX_STAGES) {
+        if (source->data != storage) {
+            *storage = *((iter_stages_ptr) source->data);
+        }
+    } else {
+        storage->source = *source;
+        storage->len = 0;
+        storage->done = 0;
+    }
+    storage->stages[storage->len++] = stage;
+
+    iter_t iter = iter_new(storage, iter_stages_next, iter_stages_free);
+    // every element has to run through the stages to be skipped, since a
+    // map may end the iteration, so there is no shortcut to advance
+    iter_set_random_access(&iter, iter_stages_size_hint, NULL);
+    // mapped elements may share storage, so only filters are batched
+    if (iter_stages_filters(storage) == storage->len) {
+        iter_set_batch(&iter, iter_stages_next_batch, NULL);
+    }
+    return iter;
+}
+
+iter_t iter_map(iter_ptr source,
+                iter_map_ptr map,
+                void * ctx,
+                iter_stages_ptr storage) {
+    iter_stage_t stage = {map, NULL, ctx};
+    return iter_stages_push(source, stage, storage);
+}
+
+iter_t iter_filter(iter_ptr source,
+                   iter_filter_ptr filter,
+                   void * ctx,
+                   iter_stages_ptr storage) {
+    iter_stage_t stage = {NULL, filter, ctx};
+    return iter_stages_push(source, stage, storage);
+}
+
+/**
+ * Take the next element of a take adapter.
+ */
+static void * iter_take_next(void * data) {
+    iter_limit_ptr state = data;
+    if (state->n == 0) {
+        return NULL;
+    }
+    void * elem = iter_next(&state->source);
+    state->n = elem != NULL ? state->n - 1 : 0;
+    return elem;
+}
+
+/**
+ * Fill a batch from a take adapter.
+ */
+static size_t iter_take_next_batch(void * data, void ** buffer, size_t max) {
+    iter_limit_ptr state = data;
+    size_t len = iter_next_batch(&state->source,
+                                 buffer,
+                                 max < state->n ? max : state->n);
+    state->n -= len;
+    return len;
+}
+
+/**
+ * Lend a span from a take adapter over an iterator that lends spans.
+ */
+static size_t iter_take_next_span(void * data, size_t max, void *** span) {
+    iter_limit_ptr state = data;
+    size_t len = iter_next_span(&state->source,
+                                NULL,
+                                max < state->n ? max : state->n,
+                                span);
+    state->n -= len;
+    return len;
+}
+
+/**
+ * Get the bounds of the number of elements left in a take adapter.
+ */
+static void iter_take_size_hint(void * data, size_t * lower, size_t * upper) {
+    iter_limit_ptr state = data;
+    iter_size_hint(&state->source, lower, upper);
+    if (*lower > state->n) {
+        *lower = state->n;
+    }
+    if (*upper > state->n) {
+        *upper = state->n;
+    }
+}
+
+/**
+ * Skip elements of a take adapter.
+ */
+static size_t iter_take_advance(void * data, size_t count) {
+    iter_limit_ptr state = data;
+    size_t advanced_by = iter_advance_by(&state->source,
+                                         count < state->n ? count : state->n);
+    state->n -= advanced_by;
+    return advanced_by;
+}
+
+/**
+ * Free the source of a take or skip adapter.
+ */
+static void iter_limit_free(void * data) {
+    iter_limit_ptr state = data;
+    iter_free(&state->source);
+}
+
+iter_t iter_take(iter_ptr source, size_t n, iter_limit_ptr storage) {
+    storage->source = *source;
+    storage->n = n;
+    iter_t iter = iter_new(storage, iter_take_next, iter_limit_free);
+    iter_set_random_access(&iter, iter_take_size_hint, iter_take_advance);
+    iter_set_batch(&iter,
+                   iter_take_next_batch,
+                   source->next_span != NULL ? iter_take_next_span : NULL);
+    return iter;
+}
+
+/**
+ * Skip the elements a skip adapter starts with, if not done yet.
+ */
+static void iter_skip_start(iter_limit_ptr state) {
+    if (state->n != 0) {
+        iter_advance_by(&state->source, state->n);
+        state->n = 0;
+    }
+}
+
+/**
+ * Take the next element of a skip adapter.
+ */
+static void * iter_skip_next(void * data) {
+    iter_limit_ptr state = data;
+    iter_skip_start(state);
+    return iter_next(&state->source);
+}
+
+/**
+ * Fill a batch from a skip adapter.
+ */
+static size_t iter_skip_next_batch(void * data, void ** buffer, size_t max) {
+    iter_limit_ptr state = data;
+    iter_skip_start(state);
+    return iter_next_batch(&state->source, buffer, max);
+}
+
+/**
+ * Lend a span from a skip adapter over an iterator that lends spans.
+ */
+static size_t iter_skip_next_span(void * data, size_t max, void *** span) {
+    iter_limit_ptr state = data;
+    iter_skip_start(state);
+    return iter_next_span(&state->source, NULL, max, span);
+}
+
+/**
+ * Get the bounds of the number of elements left in a skip adapter.
+ */
+static void iter_skip_size_hint(void * data, size_t * lower, size_t * upper) {
+    iter_limit_ptr state = data;
+    iter_size_hint(&state->source, lower, upper);
+    *lower = *lower > state->n ? *lower - state->n : 0;
+    if (*upper != SIZE_MAX) {
+        *upper = *upper > state->n ? *upper - state->n : 0;
+    }
+}
+
+/**
+ * Skip elements of a skip adapter.
+ */
+static size_t iter_skip_advance(void * data, size_t count) {
+    iter_limit_ptr state = data;
+    iter_skip_start(state);
+    return iter_advance_by(&state->source, count);
+}
+
+iter_t iter_skip(iter_ptr source, size_t n, iter_limit_ptr storage) {
+    storage->source = *source;
+    storage->n = n;
+    iter_t iter = iter_new(storage, iter_skip_next, iter_limit_free);
+    iter_set_random_access(&iter, iter_skip_size_hint, iter_skip_advance);
+    iter_set_batch(&iter,
+                   iter_skip_next_batch,
+                   source->next_span != NULL ? iter_skip_next_span : NULL);
+    return iter;
+}
+
+/**
+ * Take the next element of a chain adapter.
+ */
+static void * iter_chain_next(void * data) {
+    iter_chain_ptr state = data;
+    if (!state->on_second) {
+        void * elem = iter_next(&state->first);
+        if (elem != NULL) {
+            return elem;
+        }
+        state->on_second = 1;
+    }
+    return iter_next(&state->second);
+}
+
+/**
+ * Take the last element of a chain adapter over double-ended iterators.
+ */
+static void * iter_chain_next_back(void * data) {
+    iter_chain_ptr state = data;
+    void * elem = iter_next_back(&state->second);
+    if (elem != NULL || state->on_second) {
+        return elem;
+    }
+    return iter_next_back(&state->first);
+}
+
+/**
+ * Fill a batch from a chain adapter.
+ */
+static size_t iter_chain_next_batch(void * data, void ** buffer, size_t max) {
+    iter_chain_ptr state = data;
+    if (!state->on_second) {
+        size_t len = iter_next_batch(&state->first, buffer, max);
+        if (len != 0) {
+            return len;
+        }
+        state->on_second = 1;
+    }
+    return iter_next_batch(&state->second, buffer, max);
+}
+
+/**
+ * Get the bounds of the number of elements left in a chain adapter.
+ */
+static void iter_chain_size_hint(void * data, size_t * lower, size_t * upper) {
+    iter_chain_ptr state = data;
+    size_t first_lower = 0;
+    size_t first_upper = 0;
+    if (!state->on_second) {
+        iter_size_hint(&state->first, &first_lower, &first_upper);
+    }
+    iter_size_hint(&state->second, lower, upper);
+    *lower = *lower > SIZE_MAX - first_lower ? SIZE_MAX : *lower + first_lower;
+    *upper = *upper > SIZE_MAX - first_upper ? SIZE_MAX : *upper + first_upper;
+}
+
+/**
+ * Skip elements of a chain adapter.
+ */
+static size_t iter_chain_advance(void * data, size_t count) {
+    iter_chain_ptr state = data;
+    size_t advanced_by = 0;
+    if (!state->on_second) {
+        advanced_by = iter_advance_by(&state->first, count);
+        if (advanced_by == count) {
+            return advanced_by;
+        }
+        state->on_second = 1;
+    }
+    return advanced_by + iter_advance_by(&state->second, count - advanced_by);
+}
+
+/**
+ * Free both iterators of a chain adapter.
+ */
+static void iter_chain_free(void * data) {
+    iter_chain_ptr state = data;
+    iter_free(&state->first);
+    iter_free(&state->second);
+}
+
+iter_t iter_chain(iter_ptr first, iter_ptr second, iter_chain_ptr storage) {
+    storage->first = *first;
+    storage->second = *second;
+    storage->on_second = 0;
+    iter_t iter = iter_new(storage, iter_chain_next, iter_chain_free);
+    iter_set_random_access(&iter, iter_chain_size_hint, iter_chain_advance);
+    iter_set_batch(&iter, iter_chain_next_batch, NULL);
+    if (first->next_back != NULL && second->next_back != NULL) {
+        iter_set_double_ended(&iter, iter_chain_next_back);
+    }
+    return iter;
+}
+
+/**
+ * Take the next pair of a zip adapter.
+ */
+static void * iter_zip_next(void * data) {
+    iter_zip_ptr state = data;
+    void * first = iter_next(&state->first);
+    if (first == NULL) {
+        return NULL;
+    }
+    void * second = iter_next(&state->second);
+    if (second == NULL) {
+        return NULL;
+    }
+    state->pair[0] = first;
+    state->pair[1] = second;
+    return state->pair;
+}
+
+/**
+ * Get the bounds of the number of pairs left in a zip adapter.
+ */
+static void iter_zip_size_hint(void * data, size_t * lower, size_t * upper) {
+    iter_zip_ptr state = data;
+    size_t second_lower;
+    size_t second_upper;
+    iter_size_hint(&state->first, lower, upper);
+    iter_size_hint(&state->second, &second_lower, &second_upper);
+    if (*lower > second_lower) {
+        *lower = second_lower;
+    }
+    if (*upper > second_upper) {
+        *upper = second_upper;
+    }
+}
+
+/**
+ * Skip pairs of a zip adapter.
+ */
+static size_t iter_zip_advance(void * data, size_t count) {
+    iter_zip_ptr state = data;
+    size_t first = iter_advance_by(&state->first, count);
+    size_t second = iter_advance_by(&state->second, count);
+    return first < second ? first : second;
+}
+
+/**
+ * Free both iterators of a zip adapter.
+ */
+static void iter_zip_free(void * data) {
+    iter_zip_ptr state = data;
+    iter_free(&state->first);
+    iter_free(&state->second);
+}
+
+iter_t iter_zip(iter_ptr first, iter_ptr second, iter_zip_ptr storage) {
+    storage->first = *first;
+    storage->second = *second;
+    iter_t iter = iter_new(storage, iter_zip_next, iter_zip_free);
+    iter_set_random_access(&iter, iter_zip_size_hint, iter_zip_advance);
+    return iter;
+}
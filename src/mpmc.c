@@ -0,0 +1,206 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "mpmc.h"
+
+/**
+ * Round a capacity up to the next power of two.
+ *
+ * @return the rounded capacity, or 0 if it would overflow
+ */
+static size_t mpmc_round_capacity(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        if (rounded > SIZE_MAX / 2) {
+            return 0;
+        }
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+/**
+ * Signal the notifier of a queue if the element just pushed at `pos` is the
+ * first one the consumers have not claimed yet.
+ * @details The fence pairs with the one taken by a pop that finds the queue
+ *          empty: either the pop sees the element, or we see that the
+ *          consumers have reached `pos` and signal.
+ */
+static void mpmc_notify_pushed(mpmc_ptr mpmc, size_t pos) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&mpmc->dequeue_pos, memory_order_relaxed) == pos) {
+        notify_signal(mpmc->notify);
+    }
+}
+
+mpmc_error_t mpmc_new(mpmc_ptr mpmc, size_t capacity, allocator_ptr allocator) {
+    if (mpmc == NULL) {
+        return MPMC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (capacity < 2) {
+        return MPMC_ERROR_CAPACITY_TOO_SMALL;
+    }
+    capacity = mpmc_round_capacity(capacity);
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(mpmc_cell_t)) {
+        return MPMC_ERROR_ALLOC_FAILED;
+    }
+    mpmc->allocator = allocator != NULL ? *allocator : allocator_default();
+    mpmc->cells = allocator_alloc(&mpmc->allocator,
+                                  capacity * sizeof(mpmc_cell_t));
+    if (mpmc->cells == NULL) {
+        return MPMC_ERROR_ALLOC_FAILED;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&mpmc->cells[i].sequence, i);
+        mpmc->cells[i].elem = NULL;
+    }
+    mpmc->capacity = capacity;
+    mpmc->mask = capacity - 1;
+    atomic_init(&mpmc->enqueue_pos, 0);
+    atomic_init(&mpmc->dequeue_pos, 0);
+    mpmc->notify = NULL;
+    return MPMC_ERROR_OK;
+}
+
+mpmc_error_t mpmc_try_push(mpmc_ptr mpmc, void * elem) {
+    if (mpmc == NULL) {
+        return MPMC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t pos = atomic_load_explicit(&mpmc->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        mpmc_cell_t * cell = &mpmc->cells[pos & mpmc->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence,
+                                               memory_order_acquire);
+        intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+        if (diff == 0) {
+            // the cell is free on this lap, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&mpmc->enqueue_pos,
+                                                      &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->elem = elem;
+                atomic_store_explicit(&cell->sequence,
+                                      pos + 1,
+                                      memory_order_release);
+                if (mpmc->notify != NULL) {
+                    mpmc_notify_pushed(mpmc, pos);
+                }
+                return MPMC_ERROR_OK;
+            }
+        } else if (diff < 0) {
+            // the cell still holds an element from the previous lap
+            return MPMC_ERROR_FULL;
+        } else {
+            // another producer claimed the position, catch up
+            pos = atomic_load_explicit(&mpmc->enqueue_pos,
+                                       memory_order_relaxed);
+        }
+    }
+}
+
+mpmc_error_t mpmc_try_pop(mpmc_ptr mpmc, void ** elem) {
+    if (mpmc == NULL || elem == NULL) {
+        return MPMC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t pos = atomic_load_explicit(&mpmc->dequeue_pos, memory_order_relaxed);
+    bool rechecked = false;
+    for (;;) {
+        mpmc_cell_t * cell = &mpmc->cells[pos & mpmc->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence,
+                                               memory_order_acquire);
+        intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+        if (diff == 0) {
+            // the cell was filled on this lap, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&mpmc->dequeue_pos,
+                                                      &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *elem = cell->elem;
+                // hand the cell over to the producers of the next lap
+                atomic_store_explicit(&cell->sequence,
+                                      pos + mpmc->mask + 1,
+                                      memory_order_release);
+                return MPMC_ERROR_OK;
+            }
+        } else if (diff < 0) {
+            // the cell has not been filled yet
+            if (mpmc->notify == NULL || rechecked) {
+                return MPMC_ERROR_EMPTY;
+            }
+            // pairs with the fence in mpmc_notify_pushed; the exchange
+            // publishes the position we found empty even if another
+            // consumer moved it there
+            if (!atomic_compare_exchange_strong(&mpmc->dequeue_pos,
+                                                &pos,
+                                                pos)) {
+                continue;
+            }
+            atomic_thread_fence(memory_order_seq_cst);
+            rechecked = true;
+        } else {
+            // another consumer claimed the position, catch up
+            pos = atomic_load_explicit(&mpmc->dequeue_pos,
+                                       memory_order_relaxed);
+        }
+    }
+}
+
+mpmc_error_t mpmc_set_notify(mpmc_ptr mpmc, notify_ptr notify) {
+    if (mpmc == NULL) {
+        return MPMC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    mpmc->notify = notify;
+    if (notify != NULL && mpmc_len(mpmc) != 0) {
+        notify_signal(notify);
+    }
+    return MPMC_ERROR_OK;
+}
+
+size_t mpmc_len(mpmc_ptr mpmc) {
+    if (mpmc == NULL) {
+        return 0;
+    }
+    size_t dequeue_pos = atomic_load_explicit(&mpmc->dequeue_pos,
+                                              memory_order_acquire);
+    size_t enqueue_pos = atomic_load_explicit(&mpmc->enqueue_pos,
+                                              memory_order_acquire);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+mpmc_error_t mpmc_free(mpmc_ptr mpmc) {
+    if (mpmc == NULL) {
+        return MPMC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    allocator_free(&mpmc->allocator,
+                   mpmc->cells,
+                   mpmc->capacity * sizeof(mpmc_cell_t));
+    mpmc->cells = NULL;
+    mpmc->capacity = 0;
+    mpmc->mask = 0;
+    return MPMC_ERROR_OK;
+}
@@ -0,0 +1,133 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include "notify.h"
+
+notify_error_t notify_new(notify_ptr notify) {
+    if (notify == NULL) {
+        return NOTIFY_ERROR_NULL_POINTER_RECEIVED;
+    }
+#ifdef __linux__
+    notify->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify->fd < 0) {
+        return NOTIFY_ERROR_SYSTEM;
+    }
+    notify->write_fd = notify->fd;
+#else
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return NOTIFY_ERROR_SYSTEM;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (fcntl(fds[i], F_SETFL, O_NONBLOCK) != 0
+            || fcntl(fds[i], F_SETFD, FD_CLOEXEC) != 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return NOTIFY_ERROR_SYSTEM;
+        }
+    }
+    notify->fd = fds[0];
+    notify->write_fd = fds[1];
+#endif
+    atomic_init(&notify->pending, false);
+    return NOTIFY_ERROR_OK;
+}
+
+int notify_fd(notify_ptr notify) {
+    return notify != NULL ? notify->fd : -1;
+}
+
+notify_error_t notify_signal(notify_ptr notify) {
+    if (notify == NULL) {
+        return NOTIFY_ERROR_NULL_POINTER_RECEIVED;
+    }
+    // the common case while the consumer has not caught up: no write at all
+    if (atomic_load_explicit(&notify->pending, memory_order_relaxed)
+        || atomic_exchange(&notify->pending, true)) {
+        return NOTIFY_ERROR_OK;
+    }
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = write(notify->write_fd, &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t written = write(notify->write_fd, &one, sizeof(one));
+#endif
+    // a full counter or pipe is still readable, which is all that matters
+    if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        return NOTIFY_ERROR_SYSTEM;
+    }
+    return NOTIFY_ERROR_OK;
+}
+
+notify_error_t notify_consume(notify_ptr notify) {
+    if (notify == NULL) {
+        return NOTIFY_ERROR_NULL_POINTER_RECEIVED;
+    }
+    char buffer[64];
+    for (;;) {
+        ssize_t len = read(notify->fd, buffer, sizeof(buffer));
+        if (len > 0 && (size_t) len == sizeof(buffer)) {
+            continue;
+        }
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NOTIFY_ERROR_SYSTEM;
+        }
+        break;
+    }
+    // cleared only once drained: a signal whose write was drained above saw
+    // the flag before this store, so its push is seen by the drain the
+    // consumer runs next, and any later signal writes again. Clearing first
+    // would let such a write be drained while leaving the flag set, which
+    // silences every signal after it.
+    atomic_store(&notify->pending, false);
+    // pairs with the fences the queues take before checking the notifier
+    atomic_thread_fence(memory_order_seq_cst);
+    return NOTIFY_ERROR_OK;
+}
+
+notify_error_t notify_free(notify_ptr notify) {
+    if (notify == NULL) {
+        return NOTIFY_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (notify->write_fd != notify->fd) {
+        close(notify->write_fd);
+    }
+    close(notify->fd);
+    notify->fd = -1;
+    notify->write_fd = -1;
+    return NOTIFY_ERROR_OK;
+}
@@ -25,21 +25,26 @@
 
 #include "option.h"
 
-option_t option_new(option_e type, void * value) {
+option_t option_new(option_status_t status, void * value) {
     option_t option;
-    option.type = type;
-    if (type == OPTION_SOME) {
-        option.value = value;
-    }
+    option.status = status;
+    option.value = status == OPTION_SOME ? value : NULL;
     return option;
 }
 
-option_ptr option_new_ptr(option_e type, void * value) {
-    option_ptr option = malloc(sizeof(option_t));
-    option->type = type;
-    if (type == OPTION_SOME) {
-        option->value = value;
+option_ptr option_new_ptr(option_status_t status, void * value) {
+    return option_new_ptr_with_allocator(status, value, NULL);
+}
+
+option_ptr option_new_ptr_with_allocator(option_status_t status,
+                                         void * value,
+                                         allocator_ptr allocator) {
+    option_ptr option = allocator_alloc(allocator, sizeof(option_t));
+    if (option == NULL) {
+        return NULL;
     }
+    option->status = status;
+    option->value = status == OPTION_SOME ? value : NULL;
     return option;
 }
 
@@ -60,15 +65,21 @@ option_ptr option_ptr_some(void * value) {
 }
 
 uint8_t option_is_none(option_ptr option) {
-    return option->type == OPTION_NONE;
+    return option->status == OPTION_NONE;
 }
 
 uint8_t option_is_some(option_ptr option) {
-    return option->type == OPTION_SOME;
+    return option->status == OPTION_SOME;
 }
 
 void option_free(option_ptr option) {
+    option_free_with_allocator(option, 0, NULL);
+}
+
+void option_free_with_allocator(option_ptr option,
+                                size_t size,
+                                allocator_ptr allocator) {
     if (option_is_some(option)) {
-        free(option->value);
+        allocator_free(allocator, option->value, size);
     }
 }
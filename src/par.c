@@ -0,0 +1,261 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "par.h"
+
+/**
+ * The alignment of the buffers handed to the stages of a pipeline.
+ */
+#define PAR_ALIGNMENT 16
+
+/**
+ * @struct par_chunk
+ * @brief A slice of the input run as one task.
+ */
+typedef struct par_chunk_t {
+    // the elements of the chunk
+    par_iter_t iter;
+    // the stages of the pipeline
+    par_ops_ptr ops;
+    // pointer passed to every stage
+    void * ctx;
+    // the accumulator of the chunk
+    void * acc;
+    // the scratch buffer of the iterator
+    void * scratch;
+    // the buffer mapped values are written to
+    void * mapped;
+    // the task running the chunk
+    threadpool_task_t task;
+} par_chunk_t;
+
+/**
+ * Round a size up to the alignment of the pipeline buffers.
+ */
+static size_t par_align(size_t size) {
+    return (size + PAR_ALIGNMENT - 1) & ~((size_t) PAR_ALIGNMENT - 1);
+}
+
+/**
+ * Get an element of a dequeue.
+ */
+static void * par_dequeue_get(void * data, size_t index, void * scratch) {
+    (void) scratch;
+    return dequeue_get(data, index);
+}
+
+/**
+ * Get a value of a range.
+ */
+static void * par_range_get(void * data, size_t index, void * scratch) {
+    (void) data;
+    *((size_t *) scratch) = index;
+    return scratch;
+}
+
+/**
+ * Fold the elements of a chunk into its accumulator.
+ */
+static void par_chunk_run(void * arg) {
+    par_chunk_t * chunk = arg;
+    par_iter_ptr iter = &chunk->iter;
+    par_ops_ptr ops = chunk->ops;
+    for (size_t i = 0; i < iter->len; i++) {
+        void * elem = iter->get(iter->data, iter->offset + i, chunk->scratch);
+        if (ops->filter != NULL && !ops->filter(elem, chunk->ctx)) {
+            continue;
+        }
+        if (ops->map != NULL) {
+            ops->map(chunk->mapped, elem, chunk->ctx);
+            elem = chunk->mapped;
+        }
+        ops->reduce(chunk->acc, elem, chunk->ctx);
+    }
+}
+
+par_iter_t par_iter_new(void * data,
+                        size_t len,
+                        par_iter_get_ptr get,
+                        size_t scratch_size) {
+    par_iter_t iter = {
+        .data = data,
+        .offset = 0,
+        .len = len,
+        .get = get,
+        .scratch_size = scratch_size,
+    };
+    return iter;
+}
+
+par_iter_t par_iter_dequeue(dequeue_ptr dequeue) {
+    return par_iter_new(dequeue,
+                        dequeue != NULL ? dequeue->len : 0,
+                        par_dequeue_get,
+                        0);
+}
+
+par_iter_t par_iter_range(size_t start, size_t end) {
+    par_iter_t iter = par_iter_new(NULL,
+                                   end > start ? end - start : 0,
+                                   par_range_get,
+                                   sizeof(size_t));
+    iter.offset = start;
+    return iter;
+}
+
+par_error_t par_iter_split(par_iter_ptr iter,
+                           size_t at,
+                           par_iter_ptr left,
+                           par_iter_ptr right) {
+    if (iter == NULL || left == NULL || right == NULL) {
+        return PAR_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (at > iter->len) {
+        at = iter->len;
+    }
+    par_iter_t whole = *iter;
+    *left = whole;
+    left->len = at;
+    *right = whole;
+    right->offset = whole.offset + at;
+    right->len = whole.len - at;
+    return PAR_ERROR_OK;
+}
+
+par_error_t par_reduce(threadpool_ptr pool,
+                       par_iter_ptr iter,
+                       par_ops_ptr ops,
+                       void * ctx,
+                       void * result) {
+    if (pool == NULL || iter == NULL || ops == NULL || result == NULL) {
+        return PAR_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (ops->reduce == NULL || ops->combine == NULL || ops->identity == NULL
+        || ops->acc_size == 0 || (ops->map != NULL && ops->mapped_size == 0)) {
+        return PAR_ERROR_INVALID_OPS;
+    }
+    memcpy(result, ops->identity, ops->acc_size);
+    if (iter->len == 0) {
+        return PAR_ERROR_OK;
+    }
+
+    size_t grain = ops->grain != 0 ? ops->grain : PAR_DEFAULT_GRAIN;
+    size_t chunks = pool->len * PAR_CHUNKS_PER_WORKER;
+    if (chunks > (iter->len + grain - 1) / grain) {
+        chunks = (iter->len + grain - 1) / grain;
+    }
+    if (chunks == 0) {
+        chunks = 1;
+    }
+    size_t chunk_len = iter->len / chunks;
+    size_t remainder = iter->len % chunks;
+
+    size_t stride = par_align(ops->acc_size)
+                    + par_align(iter->scratch_size)
+                    + (ops->map != NULL ? par_align(ops->mapped_size) : 0);
+    size_t header = par_align(chunks * sizeof(par_chunk_t));
+    if (chunks > (SIZE_MAX - header) / stride) {
+        return PAR_ERROR_ALLOC_FAILED;
+    }
+    size_t size = header + chunks * stride;
+    char * memory = allocator_alloc(&pool->allocator, size);
+    if (memory == NULL) {
+        return PAR_ERROR_ALLOC_FAILED;
+    }
+    par_chunk_t * chunk = (par_chunk_t *) memory;
+
+    threadpool_latch_t latch;
+    threadpool_latch_init(&latch, chunks - 1);
+    par_iter_t rest = *iter;
+    for (size_t i = 0; i < chunks; i++) {
+        char * buffer = memory + header + i * stride;
+        // the first `remainder` chunks take one element more
+        par_iter_split(&rest,
+                       chunk_len + (i < remainder ? 1 : 0),
+                       &chunk[i].iter,
+                       &rest);
+        chunk[i].ops = ops;
+        chunk[i].ctx = ctx;
+        chunk[i].acc = buffer;
+        chunk[i].scratch = buffer + par_align(ops->acc_size);
+        chunk[i].mapped = buffer + par_align(ops->acc_size)
+                          + par_align(iter->scratch_size);
+        memcpy(chunk[i].acc, ops->identity, ops->acc_size);
+        threadpool_task_init(&chunk[i].task, par_chunk_run, &chunk[i], &latch);
+    }
+    // the calling thread runs the first chunk itself
+    for (size_t i = 1; i < chunks; i++) {
+        if (!THREADPOOL_ERROR_IS_OK(threadpool_submit(pool, &chunk[i].task))) {
+            threadpool_task_init(&chunk[i].task, par_chunk_run, &chunk[i], NULL);
+            par_chunk_run(&chunk[i]);
+            atomic_fetch_sub(&latch.count, 1);
+        }
+    }
+    par_chunk_run(&chunk[0]);
+    threadpool_wait(pool, &latch);
+
+    for (size_t i = 0; i < chunks; i++) {
+        ops->combine(result, chunk[i].acc, ctx);
+    }
+    allocator_free(&pool->allocator, memory, size);
+    return PAR_ERROR_OK;
+}
+
+/**
+ * Count an element.
+ */
+static void par_count_reduce(void * acc, const void * value, void * ctx) {
+    (void) value;
+    (void) ctx;
+    *((size_t *) acc) += 1;
+}
+
+/**
+ * Add up two counts.
+ */
+static void par_count_combine(void * acc, const void * other, void * ctx) {
+    (void) ctx;
+    *((size_t *) acc) += *((const size_t *) other);
+}
+
+par_error_t par_count(threadpool_ptr pool,
+                      par_iter_ptr iter,
+                      int (* filter)(const void * elem, void * ctx),
+                      void * ctx,
+                      size_t * count) {
+    static const size_t zero = 0;
+    par_ops_t ops = {
+        .filter = filter,
+        .map = NULL,
+        .mapped_size = 0,
+        .reduce = par_count_reduce,
+        .combine = par_count_combine,
+        .identity = &zero,
+        .acc_size = sizeof(size_t),
+        .grain = 0,
+    };
+    return par_reduce(pool, iter, &ops, ctx, count);
+}
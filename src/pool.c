@@ -0,0 +1,149 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+/**
+ * The alignment of the objects of a pool.
+ */
+#define POOL_ALIGNMENT 16
+
+/**
+ * The size of a slab header, rounded up so that the objects are aligned.
+ */
+#define POOL_SLAB_HEADER_SIZE \
+    ((sizeof(pool_slab_t) + POOL_ALIGNMENT - 1) \
+     & ~((size_t) POOL_ALIGNMENT - 1))
+
+static void * pool_allocator_alloc(void * ctx, size_t size) {
+    pool_ptr pool = ctx;
+    if (size > pool->object_size) {
+        return NULL;
+    }
+    return pool_alloc(pool);
+}
+
+static void * pool_allocator_realloc(void * ctx,
+                                     void * ptr,
+                                     size_t old_size,
+                                     size_t new_size) {
+    pool_ptr pool = ctx;
+    (void) old_size;
+    if (new_size > pool->object_size) {
+        return NULL;
+    }
+    return ptr != NULL ? ptr : pool_alloc(pool);
+}
+
+static void pool_allocator_free(void * ctx, void * ptr, size_t size) {
+    (void) size;
+    pool_dealloc(ctx, ptr);
+}
+
+pool_error_t pool_new(pool_ptr pool, size_t object_size, allocator_ptr allocator) {
+    if (pool == NULL) {
+        return POOL_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (object_size < sizeof(void *)) {
+        object_size = sizeof(void *);
+    }
+    if (object_size > (SIZE_MAX - POOL_SLAB_HEADER_SIZE)
+                      / POOL_MIN_OBJECTS_PER_SLAB - POOL_ALIGNMENT) {
+        return POOL_ERROR_OBJECT_TOO_LARGE;
+    }
+    object_size = (object_size + POOL_ALIGNMENT - 1)
+            & ~((size_t) POOL_ALIGNMENT - 1);
+    size_t slab_size = POOL_SLAB_HEADER_SIZE
+            + object_size * POOL_MIN_OBJECTS_PER_SLAB;
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    pool->object_size = object_size;
+    pool->slab_size = slab_size > POOL_DEFAULT_SLAB_SIZE
+            ? slab_size
+            : POOL_DEFAULT_SLAB_SIZE;
+    pool->allocator = allocator != NULL ? *allocator : allocator_default();
+    return POOL_ERROR_OK;
+}
+
+void * pool_alloc(pool_ptr pool) {
+    if (pool == NULL) {
+        return NULL;
+    }
+    // recycle the most recently freed object first
+    if (pool->free_list != NULL) {
+        void * object = pool->free_list;
+        memcpy(&pool->free_list, object, sizeof(void *));
+        return object;
+    }
+    // otherwise carve a new object out of the current slab
+    if ((size_t) (pool->end - pool->cursor) < pool->object_size) {
+        pool_slab_t * slab = allocator_alloc(&pool->allocator, pool->slab_size);
+        if (slab == NULL) {
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->cursor = (char *) slab + POOL_SLAB_HEADER_SIZE;
+        pool->end = (char *) slab + pool->slab_size;
+    }
+    void * object = pool->cursor;
+    pool->cursor += pool->object_size;
+    return object;
+}
+
+void pool_dealloc(pool_ptr pool, void * object) {
+    if (pool == NULL || object == NULL) {
+        return;
+    }
+    memcpy(object, &pool->free_list, sizeof(void *));
+    pool->free_list = object;
+}
+
+allocator_t pool_allocator(pool_ptr pool) {
+    return allocator_new(pool,
+                         pool_allocator_alloc,
+                         pool_allocator_realloc,
+                         pool_allocator_free);
+}
+
+pool_error_t pool_free(pool_ptr pool) {
+    if (pool == NULL) {
+        return POOL_ERROR_NULL_POINTER_RECEIVED;
+    }
+    pool_slab_t * slab = pool->slabs;
+    while (slab != NULL) {
+        pool_slab_t * next = slab->next;
+        allocator_free(&pool->allocator, slab, pool->slab_size);
+        slab = next;
+    }
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    pool->cursor = NULL;
+    pool->end = NULL;
+    return POOL_ERROR_OK;
+}
@@ -0,0 +1,408 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "pqueue.h"
+
+/**
+ * Flags the entries of positions that belong to unused handles.
+ */
+#define PQUEUE_FREE ((size_t) 1 << (sizeof(size_t) * CHAR_BIT - 1))
+
+/**
+ * Ends the chain of unused handles.
+ */
+#define PQUEUE_NO_HANDLE (~PQUEUE_FREE)
+
+/**
+ * Get the address of the element at a heap position.
+ */
+static char * pqueue_slot(pqueue_ptr pqueue, size_t pos) {
+    return (char *) pqueue->elements.elements
+           + pos * pqueue->elements.element_size;
+}
+
+/**
+ * Get the handle of the element at each heap position.
+ */
+static size_t * pqueue_handles(pqueue_ptr pqueue) {
+    return (size_t *) pqueue->handles.elements;
+}
+
+/**
+ * Get the heap position of each handle.
+ */
+static size_t * pqueue_positions(pqueue_ptr pqueue) {
+    return (size_t *) pqueue->positions.elements;
+}
+
+/**
+ * Check whether a handle refers to an element of the queue.
+ */
+static int pqueue_valid(pqueue_ptr pqueue, pqueue_handle_t handle) {
+    return handle < pqueue->positions.len
+           && (pqueue_positions(pqueue)[handle] & PQUEUE_FREE) == 0;
+}
+
+/**
+ * Map a pqueue error from a dequeue error.
+ */
+static pqueue_error_t pqueue_error(dequeue_error_t err) {
+    switch (err) {
+        case DEQUEUE_ERROR_OK:
+            return PQUEUE_ERROR_OK;
+        case DEQUEUE_ERROR_CAPACITY_EXCEEDED:
+            return PQUEUE_ERROR_CAPACITY_EXCEEDED;
+        default:
+            return PQUEUE_ERROR_ALLOC_FAILED;
+    }
+}
+
+/**
+ * Move the element at a heap position to another one, along with its handle.
+ */
+static void pqueue_move(pqueue_ptr pqueue, size_t dst, size_t src) {
+    memcpy(pqueue_slot(pqueue, dst),
+           pqueue_slot(pqueue, src),
+           pqueue->elements.element_size);
+    size_t handle = pqueue_handles(pqueue)[src];
+    pqueue_handles(pqueue)[dst] = handle;
+    pqueue_positions(pqueue)[handle] = dst;
+}
+
+/**
+ * Store the element held in scratch at a heap position.
+ */
+static void pqueue_place(pqueue_ptr pqueue,
+                         size_t pos,
+                         pqueue_handle_t handle) {
+    memcpy(pqueue_slot(pqueue, pos),
+           pqueue->scratch,
+           pqueue->elements.element_size);
+    pqueue_handles(pqueue)[pos] = handle;
+    pqueue_positions(pqueue)[handle] = pos;
+}
+
+/**
+ * Move the element held in scratch up from a hole at a heap position.
+ * Parents are shifted down into the hole instead of being swapped, so each
+ * level costs a single copy.
+ */
+static void pqueue_sift_up(pqueue_ptr pqueue,
+                           size_t pos,
+                           pqueue_handle_t handle) {
+    while (pos > 0) {
+        size_t parent = (pos - 1) / pqueue->arity;
+        char * parent_slot = pqueue_slot(pqueue, parent);
+        if (pqueue->compare(pqueue->scratch, parent_slot) >= 0) {
+            break;
+        }
+        pqueue_move(pqueue, pos, parent);
+        pos = parent;
+    }
+    pqueue_place(pqueue, pos, handle);
+}
+
+/**
+ * Move the element held in scratch down from a hole at a heap position.
+ */
+static void pqueue_sift_down(pqueue_ptr pqueue,
+                             size_t pos,
+                             pqueue_handle_t handle) {
+    size_t len = pqueue->elements.len;
+    for (;;) {
+        size_t first = pos * pqueue->arity + 1;
+        if (first >= len) {
+            break;
+        }
+        size_t end = len - first < pqueue->arity ? len : first + pqueue->arity;
+        size_t best = first;
+        for (size_t child = first + 1; child < end; child++) {
+            if (pqueue->compare(pqueue_slot(pqueue, child),
+                                pqueue_slot(pqueue, best)) < 0) {
+                best = child;
+            }
+        }
+        if (pqueue->compare(pqueue_slot(pqueue, best), pqueue->scratch) >= 0) {
+            break;
+        }
+        pqueue_move(pqueue, pos, best);
+        pos = best;
+    }
+    pqueue_place(pqueue, pos, handle);
+}
+
+/**
+ * Create everything but the elements of a queue.
+ *
+ * @param pqueue the queue
+ * @param element_size the size of an element
+ * @param capacity the initial capacity of the handle maps
+ * @param allocator the allocator, or NULL for the default allocator
+ *
+ * @return PQUEUE_ERROR_OK on success,
+ *         PQUEUE_ERROR_ALLOC_FAILED if memory could not be allocated, in
+ *         which case nothing is left allocated
+ */
+static pqueue_error_t pqueue_init_index(pqueue_ptr pqueue,
+                                        size_t element_size,
+                                        size_t capacity,
+                                        allocator_ptr allocator) {
+    pqueue->scratch = allocator_alloc(allocator, element_size);
+    if (pqueue->scratch == NULL) {
+        return PQUEUE_ERROR_ALLOC_FAILED;
+    }
+    if (!DEQUEUE_ERROR_IS_OK(dequeue_new_with_allocator(&pqueue->handles,
+                                                        capacity,
+                                                        sizeof(size_t),
+                                                        DEQUEUE_STORAGE_INLINE,
+                                                        allocator))) {
+        allocator_free(allocator, pqueue->scratch, element_size);
+        return PQUEUE_ERROR_ALLOC_FAILED;
+    }
+    if (!DEQUEUE_ERROR_IS_OK(dequeue_new_with_allocator(&pqueue->positions,
+                                                        capacity,
+                                                        sizeof(size_t),
+                                                        DEQUEUE_STORAGE_INLINE,
+                                                        allocator))) {
+        dequeue_free(&pqueue->handles);
+        allocator_free(allocator, pqueue->scratch, element_size);
+        return PQUEUE_ERROR_ALLOC_FAILED;
+    }
+    pqueue->free_handle = PQUEUE_NO_HANDLE;
+    return PQUEUE_ERROR_OK;
+}
+
+pqueue_error_t pqueue_new(pqueue_ptr pqueue,
+                          size_t element_size,
+                          size_t arity,
+                          dequeue_compare_ptr compare) {
+    return pqueue_new_with_allocator(pqueue,
+                                     element_size,
+                                     arity,
+                                     compare,
+                                     NULL);
+}
+
+pqueue_error_t pqueue_new_with_allocator(pqueue_ptr pqueue,
+                                         size_t element_size,
+                                         size_t arity,
+                                         dequeue_compare_ptr compare,
+                                         allocator_ptr allocator) {
+    if (pqueue == NULL || compare == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (arity < 2) {
+        return PQUEUE_ERROR_INVALID_ARITY;
+    }
+    dequeue_error_t dequeue_err = dequeue_new_with_allocator(
+            &pqueue->elements,
+            DEQUEUE_DEFAULT_CAPACITY,
+            element_size,
+            DEQUEUE_STORAGE_INLINE,
+            allocator);
+    if (!DEQUEUE_ERROR_IS_OK(dequeue_err)) {
+        return PQUEUE_ERROR_ALLOC_FAILED;
+    }
+    pqueue_error_t err = pqueue_init_index(pqueue,
+                                           element_size,
+                                           DEQUEUE_DEFAULT_CAPACITY,
+                                           allocator);
+    if (!PQUEUE_ERROR_IS_OK(err)) {
+        dequeue_free(&pqueue->elements);
+        return err;
+    }
+    pqueue->arity = arity;
+    pqueue->compare = compare;
+    return PQUEUE_ERROR_OK;
+}
+
+pqueue_error_t pqueue_from_dequeue(pqueue_ptr pqueue,
+                                   dequeue_ptr dequeue,
+                                   size_t arity,
+                                   dequeue_compare_ptr compare) {
+    if (pqueue == NULL || dequeue == NULL || compare == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (arity < 2) {
+        return PQUEUE_ERROR_INVALID_ARITY;
+    }
+    if (dequeue->storage != DEQUEUE_STORAGE_INLINE) {
+        return PQUEUE_ERROR_ELEMENT_MISMATCH;
+    }
+    size_t len = dequeue->len;
+    pqueue_error_t err = pqueue_init_index(pqueue,
+                                           dequeue->element_size,
+                                           len > 0 ? len : 1,
+                                           &dequeue->allocator);
+    if (!PQUEUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    for (size_t handle = 0; handle < len; handle++) {
+        // the capacity reserved above makes these pushes infallible
+        dequeue_push_back_copy(&pqueue->handles, &handle);
+        dequeue_push_back_copy(&pqueue->positions, &handle);
+    }
+    pqueue->elements = *dequeue;
+    pqueue->arity = arity;
+    pqueue->compare = compare;
+    dequeue_make_contiguous(&pqueue->elements);
+    // sift down every parent, last first: O(n) in total
+    if (len > 1) {
+        for (size_t pos = (len - 2) / arity + 1; pos-- > 0;) {
+            memcpy(pqueue->scratch,
+                   pqueue_slot(pqueue, pos),
+                   dequeue->element_size);
+            pqueue_sift_down(pqueue, pos, pqueue_handles(pqueue)[pos]);
+        }
+    }
+    return PQUEUE_ERROR_OK;
+}
+
+size_t pqueue_len(pqueue_ptr pqueue) {
+    return pqueue == NULL ? 0 : pqueue->elements.len;
+}
+
+pqueue_error_t pqueue_push(pqueue_ptr pqueue,
+                           const void * elem,
+                           pqueue_handle_t * handle) {
+    if (pqueue == NULL || elem == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    // reserve everything upfront so that a failure leaves the queue intact
+    dequeue_error_t err = dequeue_reserve(&pqueue->elements, 1);
+    if (DEQUEUE_ERROR_IS_OK(err)) {
+        err = dequeue_reserve(&pqueue->handles, 1);
+    }
+    if (DEQUEUE_ERROR_IS_OK(err) && pqueue->free_handle == PQUEUE_NO_HANDLE) {
+        err = dequeue_reserve(&pqueue->positions, 1);
+    }
+    if (!DEQUEUE_ERROR_IS_OK(err)) {
+        return pqueue_error(err);
+    }
+    size_t new_handle = pqueue->free_handle;
+    if (new_handle != PQUEUE_NO_HANDLE) {
+        pqueue->free_handle = pqueue_positions(pqueue)[new_handle]
+                              & ~PQUEUE_FREE;
+    } else {
+        new_handle = pqueue->positions.len;
+        dequeue_push_back_copy(&pqueue->positions, &new_handle);
+    }
+    memcpy(pqueue->scratch, elem, pqueue->elements.element_size);
+    dequeue_push_back_copy(&pqueue->elements, pqueue->scratch);
+    dequeue_push_back_copy(&pqueue->handles, &new_handle);
+    pqueue_sift_up(pqueue, pqueue->elements.len - 1, new_handle);
+    if (handle != NULL) {
+        *handle = new_handle;
+    }
+    return PQUEUE_ERROR_OK;
+}
+
+void * pqueue_peek(pqueue_ptr pqueue) {
+    if (pqueue == NULL || pqueue->elements.len == 0) {
+        return NULL;
+    }
+    return pqueue_slot(pqueue, 0);
+}
+
+pqueue_error_t pqueue_pop(pqueue_ptr pqueue, void * dst) {
+    if (pqueue == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (pqueue->elements.len == 0) {
+        return PQUEUE_ERROR_EMPTY;
+    }
+    return pqueue_remove(pqueue, pqueue_handles(pqueue)[0], dst);
+}
+
+void * pqueue_get(pqueue_ptr pqueue, pqueue_handle_t handle) {
+    if (pqueue == NULL || !pqueue_valid(pqueue, handle)) {
+        return NULL;
+    }
+    return pqueue_slot(pqueue, pqueue_positions(pqueue)[handle]);
+}
+
+pqueue_error_t pqueue_decrease_key(pqueue_ptr pqueue,
+                                   pqueue_handle_t handle,
+                                   const void * elem) {
+    if (pqueue == NULL || elem == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (!pqueue_valid(pqueue, handle)) {
+        return PQUEUE_ERROR_INVALID_HANDLE;
+    }
+    size_t pos = pqueue_positions(pqueue)[handle];
+    if (pqueue->compare(pqueue_slot(pqueue, pos), elem) < 0) {
+        return PQUEUE_ERROR_KEY_INCREASED;
+    }
+    memcpy(pqueue->scratch, elem, pqueue->elements.element_size);
+    pqueue_sift_up(pqueue, pos, handle);
+    return PQUEUE_ERROR_OK;
+}
+
+pqueue_error_t pqueue_remove(pqueue_ptr pqueue,
+                             pqueue_handle_t handle,
+                             void * dst) {
+    if (pqueue == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (!pqueue_valid(pqueue, handle)) {
+        return PQUEUE_ERROR_INVALID_HANDLE;
+    }
+    size_t pos = pqueue_positions(pqueue)[handle];
+    if (dst != NULL) {
+        memcpy(dst, pqueue_slot(pqueue, pos), pqueue->elements.element_size);
+    }
+    // the last element fills the hole, from where it moves up or down
+    size_t moved;
+    dequeue_pop_back_into(&pqueue->elements, pqueue->scratch);
+    dequeue_pop_back_into(&pqueue->handles, &moved);
+    if (pos < pqueue->elements.len) {
+        if (pos > 0
+            && pqueue->compare(pqueue->scratch,
+                               pqueue_slot(pqueue, (pos - 1) / pqueue->arity))
+               < 0) {
+            pqueue_sift_up(pqueue, pos, moved);
+        } else {
+            pqueue_sift_down(pqueue, pos, moved);
+        }
+    }
+    pqueue_positions(pqueue)[handle] = PQUEUE_FREE | pqueue->free_handle;
+    pqueue->free_handle = handle;
+    return PQUEUE_ERROR_OK;
+}
+
+pqueue_error_t pqueue_free(pqueue_ptr pqueue) {
+    if (pqueue == NULL) {
+        return PQUEUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    allocator_free(&pqueue->elements.allocator,
+                   pqueue->scratch,
+                   pqueue->elements.element_size);
+    dequeue_free(&pqueue->elements);
+    dequeue_free(&pqueue->handles);
+    dequeue_free(&pqueue->positions);
+    return PQUEUE_ERROR_OK;
+}
@@ -0,0 +1,428 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "segdeque.h"
+
+/**
+ * The number of entries a map of blocks starts with.
+ */
+#define SEGDEQUE_MIN_MAP_CAPACITY 8
+
+/**
+ * Get the address of an element from its index relative to the start of
+ * the first block.
+ */
+static char * segdeque_slot(segdeque_ptr segdeque, size_t index) {
+    char * block = segdeque->blocks[segdeque->first_block
+                                    + (index >> segdeque->block_shift)];
+    return block + (index & (segdeque->block_len - 1)) * segdeque->element_size;
+}
+
+/**
+ * Get a block for the deque, reusing the spare one if there is one.
+ *
+ * @return the block, or NULL if memory could not be allocated
+ */
+static char * segdeque_block_alloc(segdeque_ptr segdeque) {
+    char * block = segdeque->spare;
+    if (block != NULL) {
+        segdeque->spare = NULL;
+        return block;
+    }
+    return allocator_alloc(&segdeque->allocator,
+                           segdeque->block_len * segdeque->element_size);
+}
+
+/**
+ * Give back a block the deque no longer uses, keeping it as the spare one if
+ * there is none.
+ */
+static void segdeque_block_release(segdeque_ptr segdeque, char * block) {
+    if (segdeque->spare == NULL) {
+        segdeque->spare = block;
+        return;
+    }
+    allocator_free(&segdeque->allocator,
+                   block,
+                   segdeque->block_len * segdeque->element_size);
+}
+
+/**
+ * Release every block in use, once the deque is empty.
+ */
+static void segdeque_release_blocks(segdeque_ptr segdeque) {
+    for (size_t i = 0; i < segdeque->block_count; i++) {
+        segdeque_block_release(segdeque,
+                               segdeque->blocks[segdeque->first_block + i]);
+    }
+    segdeque->block_count = 0;
+    segdeque->head = 0;
+}
+
+/**
+ * Make room in the map for more blocks before the first one and after the
+ * last one.
+ *
+ * @param segdeque the deque
+ * @param front the number of entries needed before the first block
+ * @param back the number of entries needed after the last block
+ *
+ * @return SEGDEQUE_ERROR_OK on success,
+ *         SEGDEQUE_ERROR_ALLOC_FAILED if memory could not be allocated
+ */
+static segdeque_error_t segdeque_map_reserve(segdeque_ptr segdeque,
+                                             size_t front,
+                                             size_t back) {
+    size_t used_end = segdeque->first_block + segdeque->block_count;
+    if (segdeque->first_block >= front
+        && segdeque->map_capacity - used_end >= back) {
+        return SEGDEQUE_ERROR_OK;
+    }
+    size_t needed = segdeque->block_count + front + back;
+    if (needed <= segdeque->map_capacity / 2) {
+        // the map is mostly free on the other side: center the blocks again
+        // rather than growing it, which keeps a deque that only moves
+        // forward from growing its map forever
+        size_t first = (segdeque->map_capacity - needed) / 2 + front;
+        memmove(segdeque->blocks + first,
+                segdeque->blocks + segdeque->first_block,
+                segdeque->block_count * sizeof(char *));
+        segdeque->first_block = first;
+        return SEGDEQUE_ERROR_OK;
+    }
+    size_t capacity = segdeque->map_capacity * 2;
+    if (capacity < SEGDEQUE_MIN_MAP_CAPACITY) {
+        capacity = SEGDEQUE_MIN_MAP_CAPACITY;
+    }
+    if (capacity < needed) {
+        capacity = needed;
+    }
+    char ** blocks = allocator_alloc(&segdeque->allocator,
+                                     capacity * sizeof(char *));
+    if (blocks == NULL) {
+        return SEGDEQUE_ERROR_ALLOC_FAILED;
+    }
+    size_t first = (capacity - needed) / 2 + front;
+    if (segdeque->block_count > 0) {
+        memcpy(blocks + first,
+               segdeque->blocks + segdeque->first_block,
+               segdeque->block_count * sizeof(char *));
+    }
+    if (segdeque->blocks != NULL) {
+        allocator_free(&segdeque->allocator,
+                       segdeque->blocks,
+                       segdeque->map_capacity * sizeof(char *));
+    }
+    segdeque->blocks = blocks;
+    segdeque->map_capacity = capacity;
+    segdeque->first_block = first;
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_new(segdeque_ptr segdeque, size_t element_size) {
+    size_t block_len = 1;
+    while (block_len < SEGDEQUE_DEFAULT_BLOCK_SIZE
+           && block_len * 2 * element_size <= SEGDEQUE_DEFAULT_BLOCK_SIZE) {
+        block_len *= 2;
+    }
+    return segdeque_new_with_block_len(segdeque, element_size, block_len, NULL);
+}
+
+segdeque_error_t segdeque_new_with_block_len(segdeque_ptr segdeque,
+                                             size_t element_size,
+                                             size_t block_len,
+                                             allocator_ptr allocator) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (block_len == 0 || (block_len & (block_len - 1)) != 0) {
+        return SEGDEQUE_ERROR_INVALID_BLOCK_LEN;
+    }
+    segdeque->blocks = NULL;
+    segdeque->map_capacity = 0;
+    segdeque->first_block = 0;
+    segdeque->block_count = 0;
+    segdeque->head = 0;
+    segdeque->len = 0;
+    segdeque->element_size = element_size;
+    segdeque->block_len = block_len;
+    segdeque->block_shift = 0;
+    while (((size_t) 1 << segdeque->block_shift) < block_len) {
+        segdeque->block_shift += 1;
+    }
+    segdeque->spare = NULL;
+    segdeque->allocator = allocator != NULL
+            ? *allocator
+            : allocator_default();
+    return SEGDEQUE_ERROR_OK;
+}
+
+void * segdeque_get(segdeque_ptr segdeque, size_t pos) {
+    if (segdeque == NULL || pos >= segdeque->len) {
+        return NULL;
+    }
+    return segdeque_slot(segdeque, segdeque->head + pos);
+}
+
+void * segdeque_front(segdeque_ptr segdeque) {
+    return segdeque_get(segdeque, 0);
+}
+
+void * segdeque_back(segdeque_ptr segdeque) {
+    if (segdeque == NULL || segdeque->len == 0) {
+        return NULL;
+    }
+    return segdeque_get(segdeque, segdeque->len - 1);
+}
+
+segdeque_error_t segdeque_push_back(segdeque_ptr segdeque, const void * elem) {
+    if (segdeque == NULL || elem == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t end = segdeque->head + segdeque->len;
+    if (end == segdeque->block_count << segdeque->block_shift) {
+        segdeque_error_t err = segdeque_map_reserve(segdeque, 0, 1);
+        if (!SEGDEQUE_ERROR_IS_OK(err)) {
+            return err;
+        }
+        char * block = segdeque_block_alloc(segdeque);
+        if (block == NULL) {
+            return SEGDEQUE_ERROR_ALLOC_FAILED;
+        }
+        segdeque->blocks[segdeque->first_block + segdeque->block_count] = block;
+        segdeque->block_count += 1;
+    }
+    memcpy(segdeque_slot(segdeque, end), elem, segdeque->element_size);
+    segdeque->len += 1;
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_push_front(segdeque_ptr segdeque, const void * elem) {
+    if (segdeque == NULL || elem == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (segdeque->head == 0) {
+        segdeque_error_t err = segdeque_map_reserve(segdeque, 1, 0);
+        if (!SEGDEQUE_ERROR_IS_OK(err)) {
+            return err;
+        }
+        char * block = segdeque_block_alloc(segdeque);
+        if (block == NULL) {
+            return SEGDEQUE_ERROR_ALLOC_FAILED;
+        }
+        segdeque->first_block -= 1;
+        segdeque->blocks[segdeque->first_block] = block;
+        segdeque->block_count += 1;
+        segdeque->head = segdeque->block_len;
+    }
+    segdeque->head -= 1;
+    memcpy(segdeque_slot(segdeque, segdeque->head),
+           elem,
+           segdeque->element_size);
+    segdeque->len += 1;
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_pop_back(segdeque_ptr segdeque, void * dst) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (segdeque->len == 0) {
+        return SEGDEQUE_ERROR_EMPTY;
+    }
+    segdeque->len -= 1;
+    size_t end = segdeque->head + segdeque->len;
+    if (dst != NULL) {
+        memcpy(dst, segdeque_slot(segdeque, end), segdeque->element_size);
+    }
+    if (segdeque->len == 0) {
+        segdeque_release_blocks(segdeque);
+    } else if (end <= (segdeque->block_count - 1) << segdeque->block_shift) {
+        segdeque->block_count -= 1;
+        segdeque_block_release(
+                segdeque,
+                segdeque->blocks[segdeque->first_block
+                                 + segdeque->block_count]);
+    }
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_pop_front(segdeque_ptr segdeque, void * dst) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (segdeque->len == 0) {
+        return SEGDEQUE_ERROR_EMPTY;
+    }
+    if (dst != NULL) {
+        memcpy(dst,
+               segdeque_slot(segdeque, segdeque->head),
+               segdeque->element_size);
+    }
+    segdeque->head += 1;
+    segdeque->len -= 1;
+    if (segdeque->len == 0) {
+        segdeque_release_blocks(segdeque);
+    } else if (segdeque->head == segdeque->block_len) {
+        segdeque_block_release(segdeque,
+                               segdeque->blocks[segdeque->first_block]);
+        segdeque->first_block += 1;
+        segdeque->block_count -= 1;
+        segdeque->head = 0;
+    }
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_shrink_to_fit(segdeque_ptr segdeque) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (segdeque->spare != NULL) {
+        allocator_free(&segdeque->allocator,
+                       segdeque->spare,
+                       segdeque->block_len * segdeque->element_size);
+        segdeque->spare = NULL;
+    }
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_empty(segdeque_ptr segdeque) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    segdeque_release_blocks(segdeque);
+    segdeque->len = 0;
+    return SEGDEQUE_ERROR_OK;
+}
+
+segdeque_error_t segdeque_free(segdeque_ptr segdeque) {
+    if (segdeque == NULL) {
+        return SEGDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    segdeque_empty(segdeque);
+    segdeque_shrink_to_fit(segdeque);
+    if (segdeque->blocks != NULL) {
+        allocator_free(&segdeque->allocator,
+                       segdeque->blocks,
+                       segdeque->map_capacity * sizeof(char *));
+    }
+    segdeque->blocks = NULL;
+    segdeque->map_capacity = 0;
+    return SEGDEQUE_ERROR_OK;
+}
+
+/**
+ * Take the next element from the front of a segdeque iterator.
+ */
+static void * segdeque_iter_next_front(void * data) {
+    segdeque_iter_ptr state = data;
+    if (state->front == state->back) {
+        return NULL;
+    }
+    return segdeque_get(state->segdeque, state->front++);
+}
+
+/**
+ * Take the next element from the back of a segdeque iterator.
+ */
+static void * segdeque_iter_next_back(void * data) {
+    segdeque_iter_ptr state = data;
+    if (state->front == state->back) {
+        return NULL;
+    }
+    return segdeque_get(state->segdeque, --state->back);
+}
+
+/**
+ * Get the exact number of elements left in a segdeque iterator.
+ */
+static void segdeque_iter_size_hint(void * data,
+                                    size_t * lower,
+                                    size_t * upper) {
+    segdeque_iter_ptr state = data;
+    *lower = state->back - state->front;
+    *upper = *lower;
+}
+
+/**
+ * Skip elements at the front of a segdeque iterator.
+ */
+static size_t segdeque_iter_advance(void * data, size_t count) {
+    segdeque_iter_ptr state = data;
+    size_t remaining = state->back - state->front;
+    if (count > remaining) {
+        count = remaining;
+    }
+    state->front += count;
+    return count;
+}
+
+/**
+ * Fill a batch from the front of a segdeque iterator, a block at a time.
+ */
+static size_t segdeque_iter_batch(void * data, void ** buffer, size_t max) {
+    segdeque_iter_ptr state = data;
+    segdeque_ptr segdeque = state->segdeque;
+    size_t len = state->back - state->front;
+    if (len > max) {
+        len = max;
+    }
+    size_t filled = 0;
+    while (filled < len) {
+        size_t index = segdeque->head + state->front + filled;
+        char * slot = segdeque_slot(segdeque, index);
+        // the rest of the block is contiguous
+        size_t run = segdeque->block_len - (index & (segdeque->block_len - 1));
+        if (run > len - filled) {
+            run = len - filled;
+        }
+        for (size_t i = 0; i < run; i++) {
+            buffer[filled + i] = slot + i * segdeque->element_size;
+        }
+        filled += run;
+    }
+    state->front += len;
+    return len;
+}
+
+/**
+ * Nothing to release, the state of the iterator belongs to the caller.
+ */
+static void segdeque_iter_free(void * data) {
+    (void) data;
+}
+
+iter_t segdeque_iter(segdeque_ptr segdeque, segdeque_iter_ptr state) {
+    state->segdeque = segdeque;
+    state->front = 0;
+    state->back = segdeque != NULL ? segdeque->len : 0;
+    iter_t iter = iter_new(state, segdeque_iter_next_front, segdeque_iter_free);
+    iter_set_double_ended(&iter, segdeque_iter_next_back);
+    iter_set_random_access(&iter,
+                           segdeque_iter_size_hint,
+                           segdeque_iter_advance);
+    iter_set_batch(&iter, segdeque_iter_batch, NULL);
+    return iter;
+}
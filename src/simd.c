@@ -0,0 +1,1440 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "simd.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+// every CPU with AVX2 also has popcnt
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,popcnt")))
+#define SIMD_TARGET_AVX512BW __attribute__((target("avx512f,avx512bw")))
+#endif
+
+/**
+ * @struct simd_kernels
+ * @brief The kernels of one dispatch level.
+ * @details The min/max kernels are only called with at least one element.
+ */
+typedef struct simd_kernels_t {
+    int64_t (* sum_i32)(const int32_t *, size_t);
+    int64_t (* sum_i64)(const int64_t *, size_t);
+    float (* sum_f32)(const float *, size_t);
+    double (* sum_f64)(const double *, size_t);
+    void (* min_max_i32)(const int32_t *, size_t, int32_t *, int32_t *);
+    void (* min_max_i64)(const int64_t *, size_t, int64_t *, int64_t *);
+    void (* min_max_f32)(const float *, size_t, float *, float *);
+    void (* min_max_f64)(const double *, size_t, double *, double *);
+    size_t (* count_eq_i32)(const int32_t *, size_t, int32_t);
+    size_t (* count_eq_i64)(const int64_t *, size_t, int64_t);
+    size_t (* count_eq_f32)(const float *, size_t, float);
+    size_t (* count_eq_f64)(const double *, size_t, double);
+    size_t (* find_i32)(const int32_t *, size_t, int32_t);
+    size_t (* find_i64)(const int64_t *, size_t, int64_t);
+    size_t (* find_f32)(const float *, size_t, float);
+    size_t (* find_f64)(const double *, size_t, double);
+    size_t (* find_byte)(const uint8_t *, size_t, uint8_t);
+} simd_kernels_t;
+
+/*
+ * Scalar kernels, also used for the tails the vector kernels leave over.
+ */
+
+static int64_t simd_scalar_sum_i32(const int32_t * elems, size_t n) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += elems[i];
+    }
+    return sum;
+}
+
+static int64_t simd_scalar_sum_i64(const int64_t * elems, size_t n) {
+    // unsigned arithmetic wraps instead of overflowing
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (uint64_t) elems[i];
+    }
+    return (int64_t) sum;
+}
+
+static float simd_scalar_sum_f32(const float * elems, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        sum += elems[i];
+    }
+    return sum;
+}
+
+static double simd_scalar_sum_f64(const double * elems, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum += elems[i];
+    }
+    return sum;
+}
+
+static void simd_scalar_min_max_i32(const int32_t * elems,
+                                    size_t n,
+                                    int32_t * min,
+                                    int32_t * max) {
+    int32_t lo = elems[0];
+    int32_t hi = elems[0];
+    for (size_t i = 1; i < n; i++) {
+        lo = elems[i] < lo ? elems[i] : lo;
+        hi = elems[i] > hi ? elems[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void simd_scalar_min_max_i64(const int64_t * elems,
+                                    size_t n,
+                                    int64_t * min,
+                                    int64_t * max) {
+    int64_t lo = elems[0];
+    int64_t hi = elems[0];
+    for (size_t i = 1; i < n; i++) {
+        lo = elems[i] < lo ? elems[i] : lo;
+        hi = elems[i] > hi ? elems[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void simd_scalar_min_max_f32(const float * elems,
+                                    size_t n,
+                                    float * min,
+                                    float * max) {
+    float lo = elems[0];
+    float hi = elems[0];
+    for (size_t i = 1; i < n; i++) {
+        lo = elems[i] < lo ? elems[i] : lo;
+        hi = elems[i] > hi ? elems[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void simd_scalar_min_max_f64(const double * elems,
+                                    size_t n,
+                                    double * min,
+                                    double * max) {
+    double lo = elems[0];
+    double hi = elems[0];
+    for (size_t i = 1; i < n; i++) {
+        lo = elems[i] < lo ? elems[i] : lo;
+        hi = elems[i] > hi ? elems[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static size_t simd_scalar_count_eq_i32(const int32_t * elems,
+                                       size_t n,
+                                       int32_t value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += elems[i] == value;
+    }
+    return count;
+}
+
+static size_t simd_scalar_count_eq_i64(const int64_t * elems,
+                                       size_t n,
+                                       int64_t value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += elems[i] == value;
+    }
+    return count;
+}
+
+static size_t simd_scalar_count_eq_f32(const float * elems,
+                                       size_t n,
+                                       float value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += elems[i] == value;
+    }
+    return count;
+}
+
+static size_t simd_scalar_count_eq_f64(const double * elems,
+                                       size_t n,
+                                       double value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += elems[i] == value;
+    }
+    return count;
+}
+
+static size_t simd_scalar_find_i32(const int32_t * elems,
+                                   size_t n,
+                                   int32_t value) {
+    for (size_t i = 0; i < n; i++) {
+        if (elems[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t simd_scalar_find_i64(const int64_t * elems,
+                                   size_t n,
+                                   int64_t value) {
+    for (size_t i = 0; i < n; i++) {
+        if (elems[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t simd_scalar_find_f32(const float * elems, size_t n, float value) {
+    for (size_t i = 0; i < n; i++) {
+        if (elems[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t simd_scalar_find_f64(const double * elems,
+                                   size_t n,
+                                   double value) {
+    for (size_t i = 0; i < n; i++) {
+        if (elems[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t simd_scalar_find_byte(const uint8_t * bytes,
+                                    size_t n,
+                                    uint8_t byte) {
+    for (size_t i = 0; i < n; i++) {
+        if (bytes[i] == byte) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static const simd_kernels_t simd_scalar_kernels = {
+    simd_scalar_sum_i32,
+    simd_scalar_sum_i64,
+    simd_scalar_sum_f32,
+    simd_scalar_sum_f64,
+    simd_scalar_min_max_i32,
+    simd_scalar_min_max_i64,
+    simd_scalar_min_max_f32,
+    simd_scalar_min_max_f64,
+    simd_scalar_count_eq_i32,
+    simd_scalar_count_eq_i64,
+    simd_scalar_count_eq_f32,
+    simd_scalar_count_eq_f64,
+    simd_scalar_find_i32,
+    simd_scalar_find_i64,
+    simd_scalar_find_f32,
+    simd_scalar_find_f64,
+    simd_scalar_find_byte,
+};
+
+#ifdef SIMD_X86
+
+/*
+ * SSE2 kernels, 128-bit vectors. SSE2 has no 64-bit comparisons, so the
+ * int64_t min/max kernel stays scalar.
+ */
+
+SIMD_TARGET_SSE2
+static int64_t simd_sse2_sum_i32(const int32_t * elems, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (elems + i));
+        // sign-extend to 64-bit lanes by interleaving with the sign bits
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return lanes[0] + lanes[1] + simd_scalar_sum_i32(elems + i, n - i);
+}
+
+SIMD_TARGET_SSE2
+static int64_t simd_sse2_sum_i64(const int64_t * elems, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_add_epi64(acc,
+                            _mm_loadu_si128((const __m128i *) (elems + i)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return (int64_t) (lanes[0] + lanes[1]
+                      + (uint64_t) simd_scalar_sum_i64(elems + i, n - i));
+}
+
+SIMD_TARGET_SSE2
+static float simd_sse2_sum_f32(const float * elems, size_t n) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(elems + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+           + simd_scalar_sum_f32(elems + i, n - i);
+}
+
+SIMD_TARGET_SSE2
+static double simd_sse2_sum_f64(const double * elems, size_t n) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_add_pd(acc, _mm_loadu_pd(elems + i));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + simd_scalar_sum_f64(elems + i, n - i);
+}
+
+SIMD_TARGET_SSE2
+static void simd_sse2_min_max_i32(const int32_t * elems,
+                                  size_t n,
+                                  int32_t * min,
+                                  int32_t * max) {
+    __m128i lo = _mm_set1_epi32(elems[0]);
+    __m128i hi = lo;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (elems + i));
+        // SSE2 has no pminsd/pmaxsd, so select through comparison masks
+        __m128i lt = _mm_cmplt_epi32(v, lo);
+        lo = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, lo));
+        __m128i gt = _mm_cmpgt_epi32(v, hi);
+        hi = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, hi));
+    }
+    int32_t los[4];
+    int32_t his[4];
+    _mm_storeu_si128((__m128i *) los, lo);
+    _mm_storeu_si128((__m128i *) his, hi);
+    int32_t unused;
+    simd_scalar_min_max_i32(los, 4, min, &unused);
+    simd_scalar_min_max_i32(his, 4, &unused, max);
+    if (i < n) {
+        int32_t tail_min;
+        int32_t tail_max;
+        simd_scalar_min_max_i32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_SSE2
+static void simd_sse2_min_max_f32(const float * elems,
+                                  size_t n,
+                                  float * min,
+                                  float * max) {
+    __m128 lo = _mm_set1_ps(elems[0]);
+    __m128 hi = lo;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(elems + i);
+        lo = _mm_min_ps(lo, v);
+        hi = _mm_max_ps(hi, v);
+    }
+    float los[4];
+    float his[4];
+    _mm_storeu_ps(los, lo);
+    _mm_storeu_ps(his, hi);
+    float unused;
+    simd_scalar_min_max_f32(los, 4, min, &unused);
+    simd_scalar_min_max_f32(his, 4, &unused, max);
+    if (i < n) {
+        float tail_min;
+        float tail_max;
+        simd_scalar_min_max_f32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_SSE2
+static void simd_sse2_min_max_f64(const double * elems,
+                                  size_t n,
+                                  double * min,
+                                  double * max) {
+    __m128d lo = _mm_set1_pd(elems[0]);
+    __m128d hi = lo;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(elems + i);
+        lo = _mm_min_pd(lo, v);
+        hi = _mm_max_pd(hi, v);
+    }
+    double los[2];
+    double his[2];
+    _mm_storeu_pd(los, lo);
+    _mm_storeu_pd(his, hi);
+    *min = los[0] < los[1] ? los[0] : los[1];
+    *max = his[0] > his[1] ? his[0] : his[1];
+    if (i < n) {
+        double tail_min;
+        double tail_max;
+        simd_scalar_min_max_f64(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+/**
+ * The number of bits set in each 4-bit lane mask, as popcnt may be missing on
+ * CPUs without AVX2.
+ */
+static const uint8_t simd_sse2_popcount[16] = {
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+};
+
+/**
+ * Get the mask of the 32-bit lanes of a vector equal to a value.
+ */
+SIMD_TARGET_SSE2
+static int simd_sse2_eq_mask_i32(const int32_t * elems, __m128i value) {
+    __m128i v = _mm_loadu_si128((const __m128i *) elems);
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, value)));
+}
+
+/**
+ * Get the mask of the 64-bit lanes of a vector equal to a value.
+ */
+SIMD_TARGET_SSE2
+static int simd_sse2_eq_mask_i64(const int64_t * elems, __m128i value) {
+    __m128i v = _mm_loadu_si128((const __m128i *) elems);
+    // both 32-bit halves of a lane must match
+    __m128i eq = _mm_cmpeq_epi32(v, value);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_movemask_pd(_mm_castsi128_pd(eq));
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_count_eq_i32(const int32_t * elems,
+                                     size_t n,
+                                     int32_t value) {
+    __m128i needle = _mm_set1_epi32(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        count += simd_sse2_popcount[simd_sse2_eq_mask_i32(elems + i, needle)];
+    }
+    return count + simd_scalar_count_eq_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_count_eq_i64(const int64_t * elems,
+                                     size_t n,
+                                     int64_t value) {
+    __m128i needle = _mm_set1_epi64x(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        count += simd_sse2_popcount[simd_sse2_eq_mask_i64(elems + i, needle)];
+    }
+    return count + simd_scalar_count_eq_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_count_eq_f32(const float * elems,
+                                     size_t n,
+                                     float value) {
+    __m128 needle = _mm_set1_ps(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(elems + i), needle);
+        count += simd_sse2_popcount[_mm_movemask_ps(eq)];
+    }
+    return count + simd_scalar_count_eq_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_count_eq_f64(const double * elems,
+                                     size_t n,
+                                     double value) {
+    __m128d needle = _mm_set1_pd(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d eq = _mm_cmpeq_pd(_mm_loadu_pd(elems + i), needle);
+        count += simd_sse2_popcount[_mm_movemask_pd(eq)];
+    }
+    return count + simd_scalar_count_eq_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_find_i32(const int32_t * elems,
+                                 size_t n,
+                                 int32_t value) {
+    __m128i needle = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = simd_sse2_eq_mask_i32(elems + i, needle);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_find_i64(const int64_t * elems,
+                                 size_t n,
+                                 int64_t value) {
+    __m128i needle = _mm_set1_epi64x(value);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        int mask = simd_sse2_eq_mask_i64(elems + i, needle);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_find_f32(const float * elems, size_t n, float value) {
+    __m128 needle = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(elems + i),
+                                                needle));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_find_f64(const double * elems,
+                                 size_t n,
+                                 double value) {
+    __m128d needle = _mm_set1_pd(value);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(elems + i),
+                                                needle));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_SSE2
+static size_t simd_sse2_find_byte(const uint8_t * bytes,
+                                  size_t n,
+                                  uint8_t byte) {
+    __m128i needle = _mm_set1_epi8((char) byte);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (bytes + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_byte(bytes + i, n - i, byte);
+}
+
+static const simd_kernels_t simd_sse2_kernels = {
+    simd_sse2_sum_i32,
+    simd_sse2_sum_i64,
+    simd_sse2_sum_f32,
+    simd_sse2_sum_f64,
+    simd_sse2_min_max_i32,
+    simd_scalar_min_max_i64,
+    simd_sse2_min_max_f32,
+    simd_sse2_min_max_f64,
+    simd_sse2_count_eq_i32,
+    simd_sse2_count_eq_i64,
+    simd_sse2_count_eq_f32,
+    simd_sse2_count_eq_f64,
+    simd_sse2_find_i32,
+    simd_sse2_find_i64,
+    simd_sse2_find_f32,
+    simd_sse2_find_f64,
+    simd_sse2_find_byte,
+};
+
+/*
+ * AVX2 kernels, 256-bit vectors.
+ */
+
+SIMD_TARGET_AVX2
+static int64_t simd_avx2_sum_i32(const int32_t * elems, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) (elems + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *) (elems + i + 4));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(lo));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(hi));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+           + simd_scalar_sum_i32(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+static int64_t simd_avx2_sum_i64(const int64_t * elems, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_epi64(
+                acc,
+                _mm256_loadu_si256((const __m256i *) (elems + i)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return (int64_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]
+                      + (uint64_t) simd_scalar_sum_i64(elems + i, n - i));
+}
+
+SIMD_TARGET_AVX2
+static float simd_avx2_sum_f32(const float * elems, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(elems + i));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    return simd_scalar_sum_f32(lanes, 8)
+           + simd_scalar_sum_f32(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+static double simd_avx2_sum_f64(const double * elems, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(elems + i));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return simd_scalar_sum_f64(lanes, 4)
+           + simd_scalar_sum_f64(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX2
+static void simd_avx2_min_max_i32(const int32_t * elems,
+                                  size_t n,
+                                  int32_t * min,
+                                  int32_t * max) {
+    __m256i lo = _mm256_set1_epi32(elems[0]);
+    __m256i hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (elems + i));
+        lo = _mm256_min_epi32(lo, v);
+        hi = _mm256_max_epi32(hi, v);
+    }
+    // reduce in registers: spilling the lanes to an array makes GCC keep
+    // the accumulators in memory through the whole loop
+    __m128i min4 = _mm_min_epi32(_mm256_castsi256_si128(lo),
+                                 _mm256_extracti128_si256(lo, 1));
+    __m128i max4 = _mm_max_epi32(_mm256_castsi256_si128(hi),
+                                 _mm256_extracti128_si256(hi, 1));
+    for (int shift = 0; shift < 2; shift++) {
+        // fold the upper half of the remaining lanes onto the lower half
+        __m128i min_high = shift == 0 ? _mm_unpackhi_epi64(min4, min4)
+                                      : _mm_srli_epi64(min4, 32);
+        __m128i max_high = shift == 0 ? _mm_unpackhi_epi64(max4, max4)
+                                      : _mm_srli_epi64(max4, 32);
+        min4 = _mm_min_epi32(min4, min_high);
+        max4 = _mm_max_epi32(max4, max_high);
+    }
+    *min = _mm_cvtsi128_si32(min4);
+    *max = _mm_cvtsi128_si32(max4);
+    if (i < n) {
+        int32_t tail_min;
+        int32_t tail_max;
+        simd_scalar_min_max_i32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX2
+static void simd_avx2_min_max_i64(const int64_t * elems,
+                                  size_t n,
+                                  int64_t * min,
+                                  int64_t * max) {
+    __m256i lo = _mm256_set1_epi64x(elems[0]);
+    __m256i hi = lo;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (elems + i));
+        lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+        hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
+    }
+    int64_t los[4];
+    int64_t his[4];
+    _mm256_storeu_si256((__m256i *) los, lo);
+    _mm256_storeu_si256((__m256i *) his, hi);
+    int64_t unused;
+    simd_scalar_min_max_i64(los, 4, min, &unused);
+    simd_scalar_min_max_i64(his, 4, &unused, max);
+    if (i < n) {
+        int64_t tail_min;
+        int64_t tail_max;
+        simd_scalar_min_max_i64(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX2
+static void simd_avx2_min_max_f32(const float * elems,
+                                  size_t n,
+                                  float * min,
+                                  float * max) {
+    __m256 lo = _mm256_set1_ps(elems[0]);
+    __m256 hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(elems + i);
+        lo = _mm256_min_ps(lo, v);
+        hi = _mm256_max_ps(hi, v);
+    }
+    float los[8];
+    float his[8];
+    _mm256_storeu_ps(los, lo);
+    _mm256_storeu_ps(his, hi);
+    float unused;
+    simd_scalar_min_max_f32(los, 8, min, &unused);
+    simd_scalar_min_max_f32(his, 8, &unused, max);
+    if (i < n) {
+        float tail_min;
+        float tail_max;
+        simd_scalar_min_max_f32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX2
+static void simd_avx2_min_max_f64(const double * elems,
+                                  size_t n,
+                                  double * min,
+                                  double * max) {
+    __m256d lo = _mm256_set1_pd(elems[0]);
+    __m256d hi = lo;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(elems + i);
+        lo = _mm256_min_pd(lo, v);
+        hi = _mm256_max_pd(hi, v);
+    }
+    double los[4];
+    double his[4];
+    _mm256_storeu_pd(los, lo);
+    _mm256_storeu_pd(his, hi);
+    double unused;
+    simd_scalar_min_max_f64(los, 4, min, &unused);
+    simd_scalar_min_max_f64(his, 4, &unused, max);
+    if (i < n) {
+        double tail_min;
+        double tail_max;
+        simd_scalar_min_max_f64(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+/**
+ * Get the mask of the 32-bit lanes of a vector equal to a value.
+ */
+SIMD_TARGET_AVX2
+static int simd_avx2_eq_mask_i32(const int32_t * elems, __m256i value) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) elems);
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v,
+                                                                     value)));
+}
+
+/**
+ * Get the mask of the 64-bit lanes of a vector equal to a value.
+ */
+SIMD_TARGET_AVX2
+static int simd_avx2_eq_mask_i64(const int64_t * elems, __m256i value) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) elems);
+    return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v,
+                                                                     value)));
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_count_eq_i32(const int32_t * elems,
+                                     size_t n,
+                                     int32_t value) {
+    __m256i needle = _mm256_set1_epi32(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        count += (size_t) __builtin_popcount(
+                (unsigned) simd_avx2_eq_mask_i32(elems + i, needle));
+    }
+    return count + simd_scalar_count_eq_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_count_eq_i64(const int64_t * elems,
+                                     size_t n,
+                                     int64_t value) {
+    __m256i needle = _mm256_set1_epi64x(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        count += (size_t) __builtin_popcount(
+                (unsigned) simd_avx2_eq_mask_i64(elems + i, needle));
+    }
+    return count + simd_scalar_count_eq_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_count_eq_f32(const float * elems,
+                                     size_t n,
+                                     float value) {
+    __m256 needle = _mm256_set1_ps(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(elems + i),
+                                  needle,
+                                  _CMP_EQ_OQ);
+        count += (size_t) __builtin_popcount((unsigned) _mm256_movemask_ps(eq));
+    }
+    return count + simd_scalar_count_eq_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_count_eq_f64(const double * elems,
+                                     size_t n,
+                                     double value) {
+    __m256d needle = _mm256_set1_pd(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(elems + i),
+                                   needle,
+                                   _CMP_EQ_OQ);
+        count += (size_t) __builtin_popcount((unsigned) _mm256_movemask_pd(eq));
+    }
+    return count + simd_scalar_count_eq_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_find_i32(const int32_t * elems,
+                                 size_t n,
+                                 int32_t value) {
+    __m256i needle = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = simd_avx2_eq_mask_i32(elems + i, needle);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_find_i64(const int64_t * elems,
+                                 size_t n,
+                                 int64_t value) {
+    __m256i needle = _mm256_set1_epi64x(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = simd_avx2_eq_mask_i64(elems + i, needle);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_find_f32(const float * elems, size_t n, float value) {
+    __m256 needle = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(elems + i),
+                                                    needle,
+                                                    _CMP_EQ_OQ));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_find_f64(const double * elems,
+                                 size_t n,
+                                 double value) {
+    __m256d needle = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(elems + i),
+                                                    needle,
+                                                    _CMP_EQ_OQ));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + simd_scalar_find_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2
+static size_t simd_avx2_find_byte(const uint8_t * bytes,
+                                  size_t n,
+                                  uint8_t byte) {
+    __m256i needle = _mm256_set1_epi8((char) byte);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (bytes + i));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(v, needle));
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+    return i + simd_scalar_find_byte(bytes + i, n - i, byte);
+}
+
+static const simd_kernels_t simd_avx2_kernels = {
+    simd_avx2_sum_i32,
+    simd_avx2_sum_i64,
+    simd_avx2_sum_f32,
+    simd_avx2_sum_f64,
+    simd_avx2_min_max_i32,
+    simd_avx2_min_max_i64,
+    simd_avx2_min_max_f32,
+    simd_avx2_min_max_f64,
+    simd_avx2_count_eq_i32,
+    simd_avx2_count_eq_i64,
+    simd_avx2_count_eq_f32,
+    simd_avx2_count_eq_f64,
+    simd_avx2_find_i32,
+    simd_avx2_find_i64,
+    simd_avx2_find_f32,
+    simd_avx2_find_f64,
+    simd_avx2_find_byte,
+};
+
+/*
+ * AVX-512 kernels, 512-bit vectors with mask registers.
+ */
+
+SIMD_TARGET_AVX512
+static int64_t simd_avx512_sum_i32(const int32_t * elems, size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *) (elems + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *) (elems + i + 8));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(lo));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(hi));
+    }
+    return _mm512_reduce_add_epi64(acc)
+           + simd_scalar_sum_i32(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX512
+static int64_t simd_avx512_sum_i64(const int64_t * elems, size_t n) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm512_add_epi64(acc, _mm512_loadu_si512(elems + i));
+    }
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, acc);
+    uint64_t sum = (uint64_t) simd_scalar_sum_i64(elems + i, n - i);
+    for (size_t lane = 0; lane < 8; lane++) {
+        sum += lanes[lane];
+    }
+    return (int64_t) sum;
+}
+
+SIMD_TARGET_AVX512
+static float simd_avx512_sum_f32(const float * elems, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc = _mm512_add_ps(acc, _mm512_loadu_ps(elems + i));
+    }
+    return _mm512_reduce_add_ps(acc) + simd_scalar_sum_f32(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX512
+static double simd_avx512_sum_f64(const double * elems, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm512_add_pd(acc, _mm512_loadu_pd(elems + i));
+    }
+    return _mm512_reduce_add_pd(acc) + simd_scalar_sum_f64(elems + i, n - i);
+}
+
+SIMD_TARGET_AVX512
+static void simd_avx512_min_max_i32(const int32_t * elems,
+                                    size_t n,
+                                    int32_t * min,
+                                    int32_t * max) {
+    __m512i lo = _mm512_set1_epi32(elems[0]);
+    __m512i hi = lo;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(elems + i);
+        lo = _mm512_min_epi32(lo, v);
+        hi = _mm512_max_epi32(hi, v);
+    }
+    *min = _mm512_reduce_min_epi32(lo);
+    *max = _mm512_reduce_max_epi32(hi);
+    if (i < n) {
+        int32_t tail_min;
+        int32_t tail_max;
+        simd_scalar_min_max_i32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX512
+static void simd_avx512_min_max_i64(const int64_t * elems,
+                                    size_t n,
+                                    int64_t * min,
+                                    int64_t * max) {
+    __m512i lo = _mm512_set1_epi64(elems[0]);
+    __m512i hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512(elems + i);
+        lo = _mm512_min_epi64(lo, v);
+        hi = _mm512_max_epi64(hi, v);
+    }
+    *min = _mm512_reduce_min_epi64(lo);
+    *max = _mm512_reduce_max_epi64(hi);
+    if (i < n) {
+        int64_t tail_min;
+        int64_t tail_max;
+        simd_scalar_min_max_i64(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX512
+static void simd_avx512_min_max_f32(const float * elems,
+                                    size_t n,
+                                    float * min,
+                                    float * max) {
+    __m512 lo = _mm512_set1_ps(elems[0]);
+    __m512 hi = lo;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(elems + i);
+        lo = _mm512_min_ps(lo, v);
+        hi = _mm512_max_ps(hi, v);
+    }
+    *min = _mm512_reduce_min_ps(lo);
+    *max = _mm512_reduce_max_ps(hi);
+    if (i < n) {
+        float tail_min;
+        float tail_max;
+        simd_scalar_min_max_f32(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX512
+static void simd_avx512_min_max_f64(const double * elems,
+                                    size_t n,
+                                    double * min,
+                                    double * max) {
+    __m512d lo = _mm512_set1_pd(elems[0]);
+    __m512d hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(elems + i);
+        lo = _mm512_min_pd(lo, v);
+        hi = _mm512_max_pd(hi, v);
+    }
+    *min = _mm512_reduce_min_pd(lo);
+    *max = _mm512_reduce_max_pd(hi);
+    if (i < n) {
+        double tail_min;
+        double tail_max;
+        simd_scalar_min_max_f64(elems + i, n - i, &tail_min, &tail_max);
+        *min = tail_min < *min ? tail_min : *min;
+        *max = tail_max > *max ? tail_max : *max;
+    }
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_count_eq_i32(const int32_t * elems,
+                                       size_t n,
+                                       int32_t value) {
+    __m512i needle = _mm512_set1_epi32(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 eq = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(elems + i),
+                                               needle);
+        count += (size_t) __builtin_popcount((unsigned) eq);
+    }
+    return count + simd_scalar_count_eq_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_count_eq_i64(const int64_t * elems,
+                                       size_t n,
+                                       int64_t value) {
+    __m512i needle = _mm512_set1_epi64(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 eq = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(elems + i),
+                                              needle);
+        count += (size_t) __builtin_popcount((unsigned) eq);
+    }
+    return count + simd_scalar_count_eq_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_count_eq_f32(const float * elems,
+                                       size_t n,
+                                       float value) {
+    __m512 needle = _mm512_set1_ps(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 eq = _mm512_cmp_ps_mask(_mm512_loadu_ps(elems + i),
+                                          needle,
+                                          _CMP_EQ_OQ);
+        count += (size_t) __builtin_popcount((unsigned) eq);
+    }
+    return count + simd_scalar_count_eq_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_count_eq_f64(const double * elems,
+                                       size_t n,
+                                       double value) {
+    __m512d needle = _mm512_set1_pd(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 eq = _mm512_cmp_pd_mask(_mm512_loadu_pd(elems + i),
+                                         needle,
+                                         _CMP_EQ_OQ);
+        count += (size_t) __builtin_popcount((unsigned) eq);
+    }
+    return count + simd_scalar_count_eq_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_find_i32(const int32_t * elems,
+                                   size_t n,
+                                   int32_t value) {
+    __m512i needle = _mm512_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 eq = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(elems + i),
+                                               needle);
+        if (eq != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) eq);
+        }
+    }
+    return i + simd_scalar_find_i32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_find_i64(const int64_t * elems,
+                                   size_t n,
+                                   int64_t value) {
+    __m512i needle = _mm512_set1_epi64(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 eq = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(elems + i),
+                                              needle);
+        if (eq != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) eq);
+        }
+    }
+    return i + simd_scalar_find_i64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_find_f32(const float * elems,
+                                   size_t n,
+                                   float value) {
+    __m512 needle = _mm512_set1_ps(value);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 eq = _mm512_cmp_ps_mask(_mm512_loadu_ps(elems + i),
+                                          needle,
+                                          _CMP_EQ_OQ);
+        if (eq != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) eq);
+        }
+    }
+    return i + simd_scalar_find_f32(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512
+static size_t simd_avx512_find_f64(const double * elems,
+                                   size_t n,
+                                   double value) {
+    __m512d needle = _mm512_set1_pd(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 eq = _mm512_cmp_pd_mask(_mm512_loadu_pd(elems + i),
+                                         needle,
+                                         _CMP_EQ_OQ);
+        if (eq != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) eq);
+        }
+    }
+    return i + simd_scalar_find_f64(elems + i, n - i, value);
+}
+
+SIMD_TARGET_AVX512BW
+static size_t simd_avx512_find_byte(const uint8_t * bytes,
+                                    size_t n,
+                                    uint8_t byte) {
+    __m512i needle = _mm512_set1_epi8((char) byte);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __mmask64 eq = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(bytes + i),
+                                              needle);
+        if (eq != 0) {
+            return i + (size_t) __builtin_ctzll(eq);
+        }
+    }
+    return i + simd_scalar_find_byte(bytes + i, n - i, byte);
+}
+
+static const simd_kernels_t simd_avx512_kernels = {
+    simd_avx512_sum_i32,
+    simd_avx512_sum_i64,
+    simd_avx512_sum_f32,
+    simd_avx512_sum_f64,
+    simd_avx512_min_max_i32,
+    simd_avx512_min_max_i64,
+    simd_avx512_min_max_f32,
+    simd_avx512_min_max_f64,
+    simd_avx512_count_eq_i32,
+    simd_avx512_count_eq_i64,
+    simd_avx512_count_eq_f32,
+    simd_avx512_count_eq_f64,
+    simd_avx512_find_i32,
+    simd_avx512_find_i64,
+    simd_avx512_find_f32,
+    simd_avx512_find_f64,
+    simd_avx512_find_byte,
+};
+
+#endif // SIMD_X86
+
+/**
+ * The kernels calls are dispatched to, resolved on first use.
+ */
+static _Atomic(const simd_kernels_t *) simd_active = NULL;
+
+/**
+ * The level of the active kernels.
+ */
+static atomic_int simd_active_level = SIMD_LEVEL_SCALAR;
+
+simd_level_t simd_detect(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512bw")) {
+        return SIMD_LEVEL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_LEVEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_LEVEL_SSE2;
+    }
+#endif
+    return SIMD_LEVEL_SCALAR;
+}
+
+simd_level_t simd_set_level(simd_level_t level) {
+    simd_level_t supported = simd_detect();
+    if (level > supported) {
+        level = supported;
+    }
+    const simd_kernels_t * kernels = &simd_scalar_kernels;
+#ifdef SIMD_X86
+    if (level == SIMD_LEVEL_AVX512) {
+        kernels = &simd_avx512_kernels;
+    } else if (level == SIMD_LEVEL_AVX2) {
+        kernels = &simd_avx2_kernels;
+    } else if (level == SIMD_LEVEL_SSE2) {
+        kernels = &simd_sse2_kernels;
+    }
+#endif
+    atomic_store(&simd_active_level, (int) level);
+    atomic_store(&simd_active, kernels);
+    return level;
+}
+
+/**
+ * Get the active kernels, picking the best level on first use.
+ */
+static const simd_kernels_t * simd_kernels(void) {
+    const simd_kernels_t * kernels = atomic_load_explicit(&simd_active,
+                                                          memory_order_acquire);
+    if (kernels == NULL) {
+        // racing first calls all store the same kernels
+        simd_set_level(simd_detect());
+        kernels = atomic_load(&simd_active);
+    }
+    return kernels;
+}
+
+simd_level_t simd_level(void) {
+    simd_kernels();
+    return (simd_level_t) atomic_load(&simd_active_level);
+}
+
+int64_t simd_sum_i32(const int32_t * elems, size_t n) {
+    return simd_kernels()->sum_i32(elems, n);
+}
+
+int64_t simd_sum_i64(const int64_t * elems, size_t n) {
+    return simd_kernels()->sum_i64(elems, n);
+}
+
+float simd_sum_f32(const float * elems, size_t n) {
+    return simd_kernels()->sum_f32(elems, n);
+}
+
+double simd_sum_f64(const double * elems, size_t n) {
+    return simd_kernels()->sum_f64(elems, n);
+}
+
+int simd_min_max_i32(const int32_t * elems,
+                     size_t n,
+                     int32_t * min,
+                     int32_t * max) {
+    if (n == 0) {
+        return 0;
+    }
+    simd_kernels()->min_max_i32(elems, n, min, max);
+    return 1;
+}
+
+int simd_min_max_i64(const int64_t * elems,
+                     size_t n,
+                     int64_t * min,
+                     int64_t * max) {
+    if (n == 0) {
+        return 0;
+    }
+    simd_kernels()->min_max_i64(elems, n, min, max);
+    return 1;
+}
+
+int simd_min_max_f32(const float * elems, size_t n, float * min, float * max) {
+    if (n == 0) {
+        return 0;
+    }
+    simd_kernels()->min_max_f32(elems, n, min, max);
+    return 1;
+}
+
+int simd_min_max_f64(const double * elems,
+                     size_t n,
+                     double * min,
+                     double * max) {
+    if (n == 0) {
+        return 0;
+    }
+    simd_kernels()->min_max_f64(elems, n, min, max);
+    return 1;
+}
+
+size_t simd_count_eq_i32(const int32_t * elems, size_t n, int32_t value) {
+    return simd_kernels()->count_eq_i32(elems, n, value);
+}
+
+size_t simd_count_eq_i64(const int64_t * elems, size_t n, int64_t value) {
+    return simd_kernels()->count_eq_i64(elems, n, value);
+}
+
+size_t simd_count_eq_f32(const float * elems, size_t n, float value) {
+    return simd_kernels()->count_eq_f32(elems, n, value);
+}
+
+size_t simd_count_eq_f64(const double * elems, size_t n, double value) {
+    return simd_kernels()->count_eq_f64(elems, n, value);
+}
+
+size_t simd_find_i32(const int32_t * elems, size_t n, int32_t value) {
+    return simd_kernels()->find_i32(elems, n, value);
+}
+
+size_t simd_find_i64(const int64_t * elems, size_t n, int64_t value) {
+    return simd_kernels()->find_i64(elems, n, value);
+}
+
+size_t simd_find_f32(const float * elems, size_t n, float value) {
+    return simd_kernels()->find_f32(elems, n, value);
+}
+
+size_t simd_find_f64(const double * elems, size_t n, double value) {
+    return simd_kernels()->find_f64(elems, n, value);
+}
+
+size_t simd_find_byte(const void * bytes, size_t n, uint8_t byte) {
+    return simd_kernels()->find_byte(bytes, n, byte);
+}
@@ -0,0 +1,582 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "spilldeque.h"
+
+/**
+ * The number of slots the scratch file is first given room for.
+ */
+#define SPILLDEQUE_MIN_FILE_SLOTS 8
+
+/**
+ * The name of the scratch file, appended to the directory.
+ */
+#define SPILLDEQUE_FILE_TEMPLATE "/unilib-spill-XXXXXX"
+
+/**
+ * Get a block from its index, counted from the front of the deque.
+ */
+static spilldeque_block_t * spilldeque_block(spilldeque_ptr spilldeque,
+                                             size_t index) {
+    return dequeue_get(&spilldeque->blocks, index);
+}
+
+/**
+ * Get the address of an element from its index relative to the start of
+ * the first block. The block holding it must be in memory.
+ */
+static char * spilldeque_slot(spilldeque_ptr spilldeque, size_t index) {
+    spilldeque_block_t * block =
+            spilldeque_block(spilldeque, index >> spilldeque->block_shift);
+    return block->data
+           + (index & (spilldeque->block_len - 1)) * spilldeque->element_size;
+}
+
+/**
+ * Get the offset of a slot in the scratch file.
+ */
+static off_t spilldeque_slot_offset(spilldeque_ptr spilldeque, size_t slot) {
+    return (off_t) (slot * spilldeque->slot_size);
+}
+
+/**
+ * Take a free slot of the scratch file, growing the file if there is none.
+ *
+ * @return SPILLDEQUE_ERROR_OK on success,
+ *         SPILLDEQUE_ERROR_ALLOC_FAILED if the list of free slots could not
+ *         grow,
+ *         SPILLDEQUE_ERROR_IO if the file could not grow
+ */
+static spilldeque_error_t spilldeque_take_slot(spilldeque_ptr spilldeque,
+                                               size_t * slot) {
+    if (DEQUEUE_ERROR_IS_OK(dequeue_pop_back_into(&spilldeque->free_slots,
+                                                  slot))) {
+        return SPILLDEQUE_ERROR_OK;
+    }
+    if (spilldeque->file_slots == spilldeque->file_capacity) {
+        size_t capacity = spilldeque->file_capacity * 2;
+        if (capacity < SPILLDEQUE_MIN_FILE_SLOTS) {
+            capacity = SPILLDEQUE_MIN_FILE_SLOTS;
+        }
+        // every slot may come back at once, so giving one back never fails
+        if (!DEQUEUE_ERROR_IS_OK(dequeue_reserve(&spilldeque->free_slots,
+                                                 capacity))) {
+            return SPILLDEQUE_ERROR_ALLOC_FAILED;
+        }
+        // reserve the disk space, so that a full disk shows up here and not
+        // as a SIGBUS when writing to the mapping
+        int err = posix_fallocate(spilldeque->fd,
+                                  0,
+                                  spilldeque_slot_offset(spilldeque, capacity));
+        if (err != 0) {
+            errno = err;
+            return SPILLDEQUE_ERROR_IO;
+        }
+        spilldeque->file_capacity = capacity;
+    }
+    *slot = spilldeque->file_slots;
+    spilldeque->file_slots += 1;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+/**
+ * Copy a block into a slot of the scratch file and release its memory.
+ */
+static spilldeque_error_t spilldeque_spill(spilldeque_ptr spilldeque,
+                                           size_t index) {
+    spilldeque_block_t * block = spilldeque_block(spilldeque, index);
+    size_t slot;
+    spilldeque_error_t err = spilldeque_take_slot(spilldeque, &slot);
+    if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    void * map = mmap(NULL,
+                      spilldeque->block_size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED,
+                      spilldeque->fd,
+                      spilldeque_slot_offset(spilldeque, slot));
+    if (map == MAP_FAILED) {
+        dequeue_push_back(&spilldeque->free_slots, &slot);
+        return SPILLDEQUE_ERROR_IO;
+    }
+    memcpy(map, block->data, spilldeque->block_size);
+    munmap(map, spilldeque->block_size);
+    allocator_free(&spilldeque->allocator,
+                   block->data,
+                   spilldeque->block_size);
+    block->data = NULL;
+    block->slot = slot;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+/**
+ * Copy a spilled block back into memory and free its slot.
+ */
+static spilldeque_error_t spilldeque_load(spilldeque_ptr spilldeque,
+                                          size_t index) {
+    spilldeque_block_t * block = spilldeque_block(spilldeque, index);
+    char * data = allocator_alloc(&spilldeque->allocator,
+                                  spilldeque->block_size);
+    if (data == NULL) {
+        return SPILLDEQUE_ERROR_ALLOC_FAILED;
+    }
+    void * map = mmap(NULL,
+                      spilldeque->block_size,
+                      PROT_READ,
+                      MAP_SHARED,
+                      spilldeque->fd,
+                      spilldeque_slot_offset(spilldeque, block->slot));
+    if (map == MAP_FAILED) {
+        allocator_free(&spilldeque->allocator, data, spilldeque->block_size);
+        return SPILLDEQUE_ERROR_IO;
+    }
+    memcpy(data, map, spilldeque->block_size);
+    munmap(map, spilldeque->block_size);
+    dequeue_push_back(&spilldeque->free_slots, &block->slot);
+    block->data = data;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+/**
+ * Make room in the budget for one more block in memory.
+ * @details Spills the innermost block of the longer run of blocks in memory.
+ *          Since the budget holds at least three blocks, that run holds at
+ *          least two when the budget is full, so neither end of the deque is
+ *          ever spilled.
+ */
+static spilldeque_error_t spilldeque_make_room(spilldeque_ptr spilldeque) {
+    if (spilldeque->front_hot + spilldeque->back_hot
+        < spilldeque->budget_blocks) {
+        return SPILLDEQUE_ERROR_OK;
+    }
+    spilldeque_error_t err;
+    if (spilldeque->front_hot >= spilldeque->back_hot) {
+        err = spilldeque_spill(spilldeque, spilldeque->front_hot - 1);
+        if (SPILLDEQUE_ERROR_IS_OK(err)) {
+            spilldeque->front_hot -= 1;
+        }
+    } else {
+        err = spilldeque_spill(spilldeque,
+                               spilldeque->blocks.len - spilldeque->back_hot);
+        if (SPILLDEQUE_ERROR_IS_OK(err)) {
+            spilldeque->back_hot -= 1;
+        }
+    }
+    return err;
+}
+
+/**
+ * Make sure the block holding the front element is in memory.
+ */
+static spilldeque_error_t spilldeque_ensure_front(spilldeque_ptr spilldeque) {
+    if (spilldeque->front_hot > 0
+        || spilldeque->back_hot == spilldeque->blocks.len) {
+        return SPILLDEQUE_ERROR_OK;
+    }
+    spilldeque_error_t err = spilldeque_make_room(spilldeque);
+    if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    err = spilldeque_load(spilldeque, 0);
+    if (SPILLDEQUE_ERROR_IS_OK(err)) {
+        spilldeque->front_hot = 1;
+    }
+    return err;
+}
+
+/**
+ * Make sure the block holding the back element is in memory.
+ */
+static spilldeque_error_t spilldeque_ensure_back(spilldeque_ptr spilldeque) {
+    if (spilldeque->back_hot > 0
+        || spilldeque->front_hot == spilldeque->blocks.len) {
+        return SPILLDEQUE_ERROR_OK;
+    }
+    spilldeque_error_t err = spilldeque_make_room(spilldeque);
+    if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    err = spilldeque_load(spilldeque, spilldeque->blocks.len - 1);
+    if (SPILLDEQUE_ERROR_IS_OK(err)) {
+        spilldeque->back_hot = 1;
+    }
+    return err;
+}
+
+/**
+ * Allocate a block in memory, spilling another one first if the budget is
+ * full.
+ *
+ * @return the block, or NULL with the error in err
+ */
+static char * spilldeque_block_alloc(spilldeque_ptr spilldeque,
+                                     spilldeque_error_t * err) {
+    *err = spilldeque_make_room(spilldeque);
+    if (!SPILLDEQUE_ERROR_IS_OK(*err)) {
+        return NULL;
+    }
+    char * data = allocator_alloc(&spilldeque->allocator,
+                                  spilldeque->block_size);
+    if (data == NULL) {
+        *err = SPILLDEQUE_ERROR_ALLOC_FAILED;
+    }
+    return data;
+}
+
+/**
+ * Release every block, once the deque is empty or being emptied.
+ */
+static void spilldeque_release_blocks(spilldeque_ptr spilldeque) {
+    spilldeque_block_t block;
+    while (DEQUEUE_ERROR_IS_OK(dequeue_pop_back_into(&spilldeque->blocks,
+                                                     &block))) {
+        if (block.data != NULL) {
+            allocator_free(&spilldeque->allocator,
+                           block.data,
+                           spilldeque->block_size);
+        } else {
+            dequeue_push_back(&spilldeque->free_slots, &block.slot);
+        }
+    }
+    spilldeque->front_hot = 0;
+    spilldeque->back_hot = 0;
+    spilldeque->head = 0;
+}
+
+/**
+ * Release the first block, in memory, once its last element was popped.
+ */
+static void spilldeque_drop_front(spilldeque_ptr spilldeque) {
+    spilldeque_block_t block;
+    dequeue_pop_front_into(&spilldeque->blocks, &block);
+    allocator_free(&spilldeque->allocator, block.data, spilldeque->block_size);
+    if (spilldeque->front_hot > 0) {
+        spilldeque->front_hot -= 1;
+    } else {
+        spilldeque->back_hot -= 1;
+    }
+}
+
+/**
+ * Release the last block, in memory, once its last element was popped.
+ */
+static void spilldeque_drop_back(spilldeque_ptr spilldeque) {
+    spilldeque_block_t block;
+    dequeue_pop_back_into(&spilldeque->blocks, &block);
+    allocator_free(&spilldeque->allocator, block.data, spilldeque->block_size);
+    if (spilldeque->back_hot > 0) {
+        spilldeque->back_hot -= 1;
+    } else {
+        spilldeque->front_hot -= 1;
+    }
+}
+
+/**
+ * Create and unlink the scratch file.
+ *
+ * @return the descriptor of the file, or -1
+ */
+static int spilldeque_open(spilldeque_ptr spilldeque, const char * dir) {
+    if (dir == NULL) {
+        dir = getenv("TMPDIR");
+    }
+    if (dir == NULL || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+    size_t dir_len = strlen(dir);
+    size_t path_size = dir_len + sizeof(SPILLDEQUE_FILE_TEMPLATE);
+    char * path = allocator_alloc(&spilldeque->allocator, path_size);
+    if (path == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy(path, dir, dir_len);
+    memcpy(path + dir_len,
+           SPILLDEQUE_FILE_TEMPLATE,
+           sizeof(SPILLDEQUE_FILE_TEMPLATE));
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    allocator_free(&spilldeque->allocator, path, path_size);
+    return fd;
+}
+
+spilldeque_error_t spilldeque_new(spilldeque_ptr spilldeque,
+                                  size_t element_size,
+                                  size_t memory_budget,
+                                  const char * dir) {
+    size_t block_len = 1;
+    while (block_len < SPILLDEQUE_DEFAULT_BLOCK_SIZE
+           && block_len * 2 * element_size <= SPILLDEQUE_DEFAULT_BLOCK_SIZE) {
+        block_len *= 2;
+    }
+    return spilldeque_new_with_block_len(spilldeque,
+                                         element_size,
+                                         block_len,
+                                         memory_budget,
+                                         dir,
+                                         NULL);
+}
+
+spilldeque_error_t spilldeque_new_with_block_len(spilldeque_ptr spilldeque,
+                                                 size_t element_size,
+                                                 size_t block_len,
+                                                 size_t memory_budget,
+                                                 const char * dir,
+                                                 allocator_ptr allocator) {
+    if (spilldeque == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (block_len == 0 || (block_len & (block_len - 1)) != 0) {
+        return SPILLDEQUE_ERROR_INVALID_BLOCK_LEN;
+    }
+    if (element_size == 0 || block_len > SIZE_MAX / element_size) {
+        return SPILLDEQUE_ERROR_ALLOC_FAILED;
+    }
+    spilldeque->block_size = block_len * element_size;
+    spilldeque->budget_blocks = memory_budget / spilldeque->block_size;
+    if (spilldeque->budget_blocks < SPILLDEQUE_MIN_BUDGET_BLOCKS) {
+        return SPILLDEQUE_ERROR_BUDGET_TOO_SMALL;
+    }
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t page = page_size > 0 ? (size_t) page_size : 4096;
+    spilldeque->slot_size = (spilldeque->block_size + page - 1) / page * page;
+    spilldeque->head = 0;
+    spilldeque->len = 0;
+    spilldeque->element_size = element_size;
+    spilldeque->block_len = block_len;
+    spilldeque->block_shift = 0;
+    while (((size_t) 1 << spilldeque->block_shift) < block_len) {
+        spilldeque->block_shift += 1;
+    }
+    spilldeque->front_hot = 0;
+    spilldeque->back_hot = 0;
+    spilldeque->file_capacity = 0;
+    spilldeque->file_slots = 0;
+    spilldeque->allocator = allocator != NULL
+            ? *allocator
+            : allocator_default();
+    if (!DEQUEUE_ERROR_IS_OK(
+            dequeue_new_with_allocator(&spilldeque->blocks,
+                                       SPILLDEQUE_MIN_BUDGET_BLOCKS,
+                                       sizeof(spilldeque_block_t),
+                                       DEQUEUE_STORAGE_INLINE,
+                                       &spilldeque->allocator))) {
+        return SPILLDEQUE_ERROR_ALLOC_FAILED;
+    }
+    if (!DEQUEUE_ERROR_IS_OK(
+            dequeue_new_with_allocator(&spilldeque->free_slots,
+                                       SPILLDEQUE_MIN_FILE_SLOTS,
+                                       sizeof(size_t),
+                                       DEQUEUE_STORAGE_INLINE,
+                                       &spilldeque->allocator))) {
+        dequeue_free(&spilldeque->blocks);
+        return SPILLDEQUE_ERROR_ALLOC_FAILED;
+    }
+    spilldeque->fd = spilldeque_open(spilldeque, dir);
+    if (spilldeque->fd < 0) {
+        dequeue_free(&spilldeque->free_slots);
+        dequeue_free(&spilldeque->blocks);
+        return SPILLDEQUE_ERROR_IO;
+    }
+    return SPILLDEQUE_ERROR_OK;
+}
+
+void * spilldeque_front(spilldeque_ptr spilldeque) {
+    if (spilldeque == NULL || spilldeque->len == 0
+        || !SPILLDEQUE_ERROR_IS_OK(spilldeque_ensure_front(spilldeque))) {
+        return NULL;
+    }
+    return spilldeque_slot(spilldeque, spilldeque->head);
+}
+
+void * spilldeque_back(spilldeque_ptr spilldeque) {
+    if (spilldeque == NULL || spilldeque->len == 0
+        || !SPILLDEQUE_ERROR_IS_OK(spilldeque_ensure_back(spilldeque))) {
+        return NULL;
+    }
+    return spilldeque_slot(spilldeque,
+                           spilldeque->head + spilldeque->len - 1);
+}
+
+spilldeque_error_t spilldeque_push_back(spilldeque_ptr spilldeque,
+                                        const void * elem) {
+    if (spilldeque == NULL || elem == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    spilldeque_error_t err;
+    size_t end = spilldeque->head + spilldeque->len;
+    if (end == spilldeque->blocks.len << spilldeque->block_shift) {
+        spilldeque_block_t block = {spilldeque_block_alloc(spilldeque, &err),
+                                    0};
+        if (block.data == NULL) {
+            return err;
+        }
+        if (!DEQUEUE_ERROR_IS_OK(dequeue_push_back(&spilldeque->blocks,
+                                                   &block))) {
+            allocator_free(&spilldeque->allocator,
+                           block.data,
+                           spilldeque->block_size);
+            return SPILLDEQUE_ERROR_ALLOC_FAILED;
+        }
+        spilldeque->back_hot += 1;
+    } else {
+        err = spilldeque_ensure_back(spilldeque);
+        if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+            return err;
+        }
+    }
+    memcpy(spilldeque_slot(spilldeque, end), elem, spilldeque->element_size);
+    spilldeque->len += 1;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+spilldeque_error_t spilldeque_push_front(spilldeque_ptr spilldeque,
+                                         const void * elem) {
+    if (spilldeque == NULL || elem == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    spilldeque_error_t err;
+    if (spilldeque->head == 0) {
+        spilldeque_block_t block = {spilldeque_block_alloc(spilldeque, &err),
+                                    0};
+        if (block.data == NULL) {
+            return err;
+        }
+        if (!DEQUEUE_ERROR_IS_OK(dequeue_push_front(&spilldeque->blocks,
+                                                    &block))) {
+            allocator_free(&spilldeque->allocator,
+                           block.data,
+                           spilldeque->block_size);
+            return SPILLDEQUE_ERROR_ALLOC_FAILED;
+        }
+        spilldeque->front_hot += 1;
+        spilldeque->head = spilldeque->block_len;
+    } else {
+        err = spilldeque_ensure_front(spilldeque);
+        if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+            return err;
+        }
+    }
+    spilldeque->head -= 1;
+    memcpy(spilldeque_slot(spilldeque, spilldeque->head),
+           elem,
+           spilldeque->element_size);
+    spilldeque->len += 1;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+spilldeque_error_t spilldeque_pop_back(spilldeque_ptr spilldeque, void * dst) {
+    if (spilldeque == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (spilldeque->len == 0) {
+        return SPILLDEQUE_ERROR_EMPTY;
+    }
+    spilldeque_error_t err = spilldeque_ensure_back(spilldeque);
+    if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    spilldeque->len -= 1;
+    size_t end = spilldeque->head + spilldeque->len;
+    if (dst != NULL) {
+        memcpy(dst, spilldeque_slot(spilldeque, end), spilldeque->element_size);
+    }
+    if (spilldeque->len == 0) {
+        spilldeque_release_blocks(spilldeque);
+    } else if (end == (spilldeque->blocks.len - 1) << spilldeque->block_shift) {
+        spilldeque_drop_back(spilldeque);
+    }
+    return SPILLDEQUE_ERROR_OK;
+}
+
+spilldeque_error_t spilldeque_pop_front(spilldeque_ptr spilldeque,
+                                        void * dst) {
+    if (spilldeque == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (spilldeque->len == 0) {
+        return SPILLDEQUE_ERROR_EMPTY;
+    }
+    spilldeque_error_t err = spilldeque_ensure_front(spilldeque);
+    if (!SPILLDEQUE_ERROR_IS_OK(err)) {
+        return err;
+    }
+    if (dst != NULL) {
+        memcpy(dst,
+               spilldeque_slot(spilldeque, spilldeque->head),
+               spilldeque->element_size);
+    }
+    spilldeque->head += 1;
+    spilldeque->len -= 1;
+    if (spilldeque->len == 0) {
+        spilldeque_release_blocks(spilldeque);
+    } else if (spilldeque->head == spilldeque->block_len) {
+        spilldeque_drop_front(spilldeque);
+        spilldeque->head = 0;
+    }
+    return SPILLDEQUE_ERROR_OK;
+}
+
+size_t spilldeque_spilled(spilldeque_ptr spilldeque) {
+    if (spilldeque == NULL) {
+        return 0;
+    }
+    return spilldeque->blocks.len
+           - spilldeque->front_hot
+           - spilldeque->back_hot;
+}
+
+spilldeque_error_t spilldeque_empty(spilldeque_ptr spilldeque) {
+    if (spilldeque == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    spilldeque_release_blocks(spilldeque);
+    spilldeque->len = 0;
+    return SPILLDEQUE_ERROR_OK;
+}
+
+spilldeque_error_t spilldeque_free(spilldeque_ptr spilldeque) {
+    if (spilldeque == NULL) {
+        return SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    spilldeque_empty(spilldeque);
+    dequeue_free(&spilldeque->free_slots);
+    dequeue_free(&spilldeque->blocks);
+    close(spilldeque->fd);
+    spilldeque->fd = -1;
+    spilldeque->file_capacity = 0;
+    spilldeque->file_slots = 0;
+    return SPILLDEQUE_ERROR_OK;
+}
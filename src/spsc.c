@@ -0,0 +1,149 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "spsc.h"
+
+/**
+ * Round a capacity up to the next power of two.
+ *
+ * @return the rounded capacity, or 0 if it would overflow
+ */
+static size_t spsc_round_capacity(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        if (rounded > SIZE_MAX / 2) {
+            return 0;
+        }
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+spsc_error_t spsc_new(spsc_ptr spsc, size_t capacity, allocator_ptr allocator) {
+    if (spsc == NULL) {
+        return SPSC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (capacity == 0) {
+        return SPSC_ERROR_ZERO_CAPACITY;
+    }
+    capacity = spsc_round_capacity(capacity);
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(void *)) {
+        return SPSC_ERROR_ALLOC_FAILED;
+    }
+    spsc->allocator = allocator != NULL ? *allocator : allocator_default();
+    spsc->elements = allocator_alloc(&spsc->allocator,
+                                     capacity * sizeof(void *));
+    if (spsc->elements == NULL) {
+        return SPSC_ERROR_ALLOC_FAILED;
+    }
+    spsc->capacity = capacity;
+    spsc->mask = capacity - 1;
+    atomic_init(&spsc->head, 0);
+    atomic_init(&spsc->tail, 0);
+    spsc->cached_head = 0;
+    spsc->cached_tail = 0;
+    spsc->notify = NULL;
+    return SPSC_ERROR_OK;
+}
+
+spsc_error_t spsc_try_push(spsc_ptr spsc, void * elem) {
+    if (spsc == NULL) {
+        return SPSC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t tail = atomic_load_explicit(&spsc->tail, memory_order_relaxed);
+    if (tail - spsc->cached_head == spsc->capacity) {
+        spsc->cached_head = atomic_load_explicit(&spsc->head,
+                                                 memory_order_acquire);
+        if (tail - spsc->cached_head == spsc->capacity) {
+            return SPSC_ERROR_FULL;
+        }
+    }
+    spsc->elements[tail & spsc->mask] = elem;
+    atomic_store_explicit(&spsc->tail, tail + 1, memory_order_release);
+    if (spsc->notify != NULL) {
+        // pairs with the fence in spsc_try_pop: either the consumer sees the
+        // new tail, or we see that it has popped everything before it
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&spsc->head, memory_order_relaxed) == tail) {
+            notify_signal(spsc->notify);
+        }
+    }
+    return SPSC_ERROR_OK;
+}
+
+spsc_error_t spsc_try_pop(spsc_ptr spsc, void ** elem) {
+    if (spsc == NULL || elem == NULL) {
+        return SPSC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t head = atomic_load_explicit(&spsc->head, memory_order_relaxed);
+    if (head == spsc->cached_tail) {
+        spsc->cached_tail = atomic_load_explicit(&spsc->tail,
+                                                 memory_order_acquire);
+        if (head == spsc->cached_tail && spsc->notify != NULL) {
+            atomic_thread_fence(memory_order_seq_cst);
+            spsc->cached_tail = atomic_load_explicit(&spsc->tail,
+                                                     memory_order_acquire);
+        }
+        if (head == spsc->cached_tail) {
+            return SPSC_ERROR_EMPTY;
+        }
+    }
+    *elem = spsc->elements[head & spsc->mask];
+    atomic_store_explicit(&spsc->head, head + 1, memory_order_release);
+    return SPSC_ERROR_OK;
+}
+
+spsc_error_t spsc_set_notify(spsc_ptr spsc, notify_ptr notify) {
+    if (spsc == NULL) {
+        return SPSC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    spsc->notify = notify;
+    if (notify != NULL && spsc_len(spsc) != 0) {
+        notify_signal(notify);
+    }
+    return SPSC_ERROR_OK;
+}
+
+size_t spsc_len(spsc_ptr spsc) {
+    if (spsc == NULL) {
+        return 0;
+    }
+    size_t head = atomic_load_explicit(&spsc->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&spsc->tail, memory_order_acquire);
+    return tail - head;
+}
+
+spsc_error_t spsc_free(spsc_ptr spsc) {
+    if (spsc == NULL) {
+        return SPSC_ERROR_NULL_POINTER_RECEIVED;
+    }
+    allocator_free(&spsc->allocator,
+                   spsc->elements,
+                   spsc->capacity * sizeof(void *));
+    spsc->elements = NULL;
+    spsc->capacity = 0;
+    spsc->mask = 0;
+    return SPSC_ERROR_OK;
+}
@@ -0,0 +1,325 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "threadpool.h"
+
+/**
+ * How many rounds an idle worker looks for tasks before going to sleep.
+ */
+#define THREADPOOL_SPIN_ROUNDS 64
+
+/**
+ * The worker running on the current thread, or NULL outside of pools.
+ */
+static _Thread_local threadpool_worker_t * threadpool_current = NULL;
+
+/**
+ * Get the next number of a xorshift generator.
+ */
+static uint64_t threadpool_random(uint64_t * seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+    return x;
+}
+
+/**
+ * Take a task to run.
+ * @details Tries the deque of the worker first, then the tasks submitted from
+ *          outside the pool, then the deques of the other workers starting
+ *          from a random one.
+ *
+ * @param pool the pool
+ * @param worker the worker looking for a task, or NULL outside of the pool
+ * @param seed state of the generator used to pick victims
+ *
+ * @return the task, or NULL if none was found
+ */
+static threadpool_task_ptr threadpool_take(threadpool_ptr pool,
+                                           threadpool_worker_t * worker,
+                                           uint64_t * seed) {
+    void * task = NULL;
+    if (worker != NULL
+        && WSDEQUE_ERROR_IS_OK(wsdeque_pop_back(&worker->tasks, &task))) {
+        atomic_fetch_sub(&pool->queued, 1);
+        return task;
+    }
+    if (MPMC_ERROR_IS_OK(mpmc_try_pop(&pool->injector, &task))) {
+        atomic_fetch_sub(&pool->queued, 1);
+        return task;
+    }
+    size_t start = (size_t) (threadpool_random(seed) % pool->len);
+    for (size_t i = 0; i < pool->len; i++) {
+        threadpool_worker_t * victim = &pool->workers[(start + i) % pool->len];
+        if (victim == worker) {
+            continue;
+        }
+        // a lost race means there may be more to steal
+        wsdeque_error_t err;
+        do {
+            err = wsdeque_steal(&victim->tasks, &task);
+        } while (err == WSDEQUE_ERROR_ABORT);
+        if (WSDEQUE_ERROR_IS_OK(err)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run a task and count down its latch.
+ */
+static void threadpool_run(threadpool_task_ptr task) {
+    threadpool_latch_ptr latch = task->latch;
+    task->fn(task->arg);
+    // the task may be released as soon as the latch reaches zero
+    if (latch != NULL) {
+        atomic_fetch_sub_explicit(&latch->count, 1, memory_order_release);
+    }
+}
+
+/**
+ * Put an idle worker to sleep until tasks are submitted.
+ */
+static void threadpool_sleep(threadpool_ptr pool) {
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->sleepers, 1);
+    // pairs with the check of sleepers in threadpool_notify: either the
+    // submitter sees this worker counted and signals under the lock, which
+    // cannot happen before the wait below releases it, or this worker sees
+    // the task counted and does not wait, so the wait needs no timeout
+    if (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stop)) {
+        pthread_cond_wait(&pool->wakeup, &pool->lock);
+    }
+    atomic_fetch_sub(&pool->sleepers, 1);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Wake a sleeping worker, if any, after a task was submitted.
+ */
+static void threadpool_notify(threadpool_ptr pool) {
+    if (atomic_load(&pool->sleepers) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * The main loop of a worker thread.
+ */
+static void * threadpool_worker_main(void * arg) {
+    threadpool_worker_t * worker = arg;
+    threadpool_ptr pool = worker->pool;
+    threadpool_current = worker;
+    size_t idle = 0;
+    while (!atomic_load_explicit(&pool->stop, memory_order_acquire)) {
+        threadpool_task_ptr task = threadpool_take(pool, worker, &worker->seed);
+        if (task != NULL) {
+            threadpool_run(task);
+            idle = 0;
+        } else if (++idle < THREADPOOL_SPIN_ROUNDS) {
+            sched_yield();
+        } else {
+            threadpool_sleep(pool);
+        }
+    }
+    threadpool_current = NULL;
+    return NULL;
+}
+
+/**
+ * Stop and join the first workers of a pool and release their deques.
+ */
+static void threadpool_stop(threadpool_ptr pool, size_t started) {
+    pthread_mutex_lock(&pool->lock);
+    atomic_store_explicit(&pool->stop, 1, memory_order_release);
+    pthread_cond_broadcast(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    for (size_t i = 0; i < pool->len; i++) {
+        wsdeque_free(&pool->workers[i].tasks);
+    }
+}
+
+threadpool_error_t threadpool_new(threadpool_ptr pool,
+                                  size_t threads,
+                                  allocator_ptr allocator) {
+    if (pool == NULL) {
+        return THREADPOOL_ERROR_NULL_POINTER_RECEIVED;
+    }
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t) online : 1;
+    }
+    if (threads > SIZE_MAX / sizeof(threadpool_worker_t)) {
+        return THREADPOOL_ERROR_ALLOC_FAILED;
+    }
+    pool->allocator = allocator != NULL ? *allocator : allocator_default();
+    pool->workers = allocator_alloc(&pool->allocator,
+                                    threads * sizeof(threadpool_worker_t));
+    if (pool->workers == NULL) {
+        return THREADPOOL_ERROR_ALLOC_FAILED;
+    }
+    if (!MPMC_ERROR_IS_OK(mpmc_new(&pool->injector,
+                                   THREADPOOL_INJECTOR_CAPACITY,
+                                   &pool->allocator))) {
+        allocator_free(&pool->allocator,
+                       pool->workers,
+                       threads * sizeof(threadpool_worker_t));
+        return THREADPOOL_ERROR_ALLOC_FAILED;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        if (!WSDEQUE_ERROR_IS_OK(wsdeque_new(&pool->workers[i].tasks,
+                                             0,
+                                             &pool->allocator))) {
+            for (size_t j = 0; j < i; j++) {
+                wsdeque_free(&pool->workers[j].tasks);
+            }
+            mpmc_free(&pool->injector);
+            allocator_free(&pool->allocator,
+                           pool->workers,
+                           threads * sizeof(threadpool_worker_t));
+            return THREADPOOL_ERROR_ALLOC_FAILED;
+        }
+        pool->workers[i].pool = pool;
+        // xorshift needs a non-zero state
+        pool->workers[i].seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+    }
+    pool->len = threads;
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->sleepers, 0);
+    atomic_init(&pool->stop, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wakeup, NULL);
+    for (size_t i = 0; i < threads; i++) {
+        if (pthread_create(&pool->workers[i].thread,
+                           NULL,
+                           threadpool_worker_main,
+                           &pool->workers[i]) != 0) {
+            threadpool_stop(pool, i);
+            pthread_cond_destroy(&pool->wakeup);
+            pthread_mutex_destroy(&pool->lock);
+            mpmc_free(&pool->injector);
+            allocator_free(&pool->allocator,
+                           pool->workers,
+                           threads * sizeof(threadpool_worker_t));
+            return THREADPOOL_ERROR_THREAD_FAILED;
+        }
+    }
+    return THREADPOOL_ERROR_OK;
+}
+
+void threadpool_task_init(threadpool_task_ptr task,
+                          threadpool_task_fn fn,
+                          void * arg,
+                          threadpool_latch_ptr latch) {
+    task->fn = fn;
+    task->arg = arg;
+    task->latch = latch;
+}
+
+void threadpool_latch_init(threadpool_latch_ptr latch, size_t count) {
+    atomic_init(&latch->count, count);
+}
+
+threadpool_error_t threadpool_submit(threadpool_ptr pool,
+                                     threadpool_task_ptr task) {
+    if (pool == NULL || task == NULL) {
+        return THREADPOOL_ERROR_NULL_POINTER_RECEIVED;
+    }
+    // counted before it becomes visible so takers never see a negative count
+    atomic_fetch_add(&pool->queued, 1);
+    threadpool_worker_t * worker = threadpool_current;
+    if (worker != NULL && worker->pool == pool) {
+        if (!WSDEQUE_ERROR_IS_OK(wsdeque_push_back(&worker->tasks, task))) {
+            atomic_fetch_sub(&pool->queued, 1);
+            return THREADPOOL_ERROR_ALLOC_FAILED;
+        }
+    } else {
+        // the injector is bounded, help drain it while it is full
+        uint64_t seed = (uint64_t) (uintptr_t) task | 1;
+        while (!MPMC_ERROR_IS_OK(mpmc_try_push(&pool->injector, task))) {
+            threadpool_task_ptr other = threadpool_take(pool, NULL, &seed);
+            if (other != NULL) {
+                threadpool_run(other);
+            } else {
+                sched_yield();
+            }
+        }
+    }
+    threadpool_notify(pool);
+    return THREADPOOL_ERROR_OK;
+}
+
+void threadpool_wait(threadpool_ptr pool, threadpool_latch_ptr latch) {
+    if (pool == NULL || latch == NULL) {
+        return;
+    }
+    threadpool_worker_t * worker = threadpool_current;
+    if (worker != NULL && worker->pool != pool) {
+        worker = NULL;
+    }
+    uint64_t seed = (uint64_t) (uintptr_t) latch | 1;
+    while (atomic_load_explicit(&latch->count, memory_order_acquire) != 0) {
+        threadpool_task_ptr task = threadpool_take(pool,
+                                                   worker,
+                                                   worker != NULL
+                                                   ? &worker->seed
+                                                   : &seed);
+        if (task != NULL) {
+            threadpool_run(task);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+threadpool_error_t threadpool_free(threadpool_ptr pool) {
+    if (pool == NULL) {
+        return THREADPOOL_ERROR_NULL_POINTER_RECEIVED;
+    }
+    threadpool_stop(pool, pool->len);
+    pthread_cond_destroy(&pool->wakeup);
+    pthread_mutex_destroy(&pool->lock);
+    mpmc_free(&pool->injector);
+    allocator_free(&pool->allocator,
+                   pool->workers,
+                   pool->len * sizeof(threadpool_worker_t));
+    pool->workers = NULL;
+    pool->len = 0;
+    return THREADPOOL_ERROR_OK;
+}
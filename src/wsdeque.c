@@ -0,0 +1,239 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include "wsdeque.h"
+
+/**
+ * Get the size of a ring of elements.
+ */
+static size_t wsdeque_array_size(size_t capacity) {
+    return sizeof(wsdeque_array_t) + capacity * sizeof(_Atomic(void *));
+}
+
+/**
+ * Allocate a ring of elements.
+ *
+ * @param wsdeque the deque
+ * @param capacity the capacity of the ring, a power of two
+ *
+ * @return the new ring, or NULL if memory could not be allocated
+ */
+static wsdeque_array_t * wsdeque_array_new(wsdeque_ptr wsdeque,
+                                           size_t capacity) {
+    if (capacity > (SIZE_MAX - sizeof(wsdeque_array_t))
+                   / sizeof(_Atomic(void *))) {
+        return NULL;
+    }
+    wsdeque_array_t * array = allocator_alloc(&wsdeque->allocator,
+                                              wsdeque_array_size(capacity));
+    if (array == NULL) {
+        return NULL;
+    }
+    array->capacity = capacity;
+    array->prev = NULL;
+    return array;
+}
+
+/**
+ * Get the element slot at an index of the deque.
+ */
+static _Atomic(void *) * wsdeque_array_slot(wsdeque_array_t * array,
+                                            long long index) {
+    return &array->elements[(size_t) index & (array->capacity - 1)];
+}
+
+/**
+ * Replace the ring of the deque with one twice as large.
+ *
+ * @param wsdeque the deque
+ * @param array the current ring
+ * @param top the index of the front element
+ * @param bottom the index past the back element
+ *
+ * @return the new ring, or NULL if memory could not be allocated
+ */
+static wsdeque_array_t * wsdeque_grow(wsdeque_ptr wsdeque,
+                                      wsdeque_array_t * array,
+                                      long long top,
+                                      long long bottom) {
+    if (array->capacity > SIZE_MAX / 2) {
+        return NULL;
+    }
+    wsdeque_array_t * grown = wsdeque_array_new(wsdeque, array->capacity * 2);
+    if (grown == NULL) {
+        return NULL;
+    }
+    for (long long i = top; i < bottom; i++) {
+        void * elem = atomic_load_explicit(wsdeque_array_slot(array, i),
+                                           memory_order_relaxed);
+        atomic_store_explicit(wsdeque_array_slot(grown, i),
+                              elem,
+                              memory_order_relaxed);
+    }
+    // thieves may still be reading from the old ring
+    grown->prev = array;
+    atomic_store_explicit(&wsdeque->array, grown, memory_order_release);
+    return grown;
+}
+
+wsdeque_error_t wsdeque_new(wsdeque_ptr wsdeque,
+                            size_t capacity,
+                            allocator_ptr allocator) {
+    if (wsdeque == NULL) {
+        return WSDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        if (rounded > SIZE_MAX / 2) {
+            return WSDEQUE_ERROR_ALLOC_FAILED;
+        }
+        rounded <<= 1;
+    }
+    wsdeque->allocator = allocator != NULL ? *allocator : allocator_default();
+    wsdeque_array_t * array = wsdeque_array_new(wsdeque, rounded);
+    if (array == NULL) {
+        return WSDEQUE_ERROR_ALLOC_FAILED;
+    }
+    atomic_init(&wsdeque->array, array);
+    atomic_init(&wsdeque->top, 0);
+    atomic_init(&wsdeque->bottom, 0);
+    return WSDEQUE_ERROR_OK;
+}
+
+wsdeque_error_t wsdeque_push_back(wsdeque_ptr wsdeque, void * elem) {
+    if (wsdeque == NULL) {
+        return WSDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    long long bottom = atomic_load_explicit(&wsdeque->bottom,
+                                            memory_order_relaxed);
+    long long top = atomic_load_explicit(&wsdeque->top, memory_order_acquire);
+    wsdeque_array_t * array = atomic_load_explicit(&wsdeque->array,
+                                                   memory_order_relaxed);
+    if ((size_t) (bottom - top) >= array->capacity) {
+        array = wsdeque_grow(wsdeque, array, top, bottom);
+        if (array == NULL) {
+            return WSDEQUE_ERROR_ALLOC_FAILED;
+        }
+    }
+    atomic_store_explicit(wsdeque_array_slot(array, bottom),
+                          elem,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&wsdeque->bottom, bottom + 1, memory_order_relaxed);
+    return WSDEQUE_ERROR_OK;
+}
+
+wsdeque_error_t wsdeque_pop_back(wsdeque_ptr wsdeque, void ** elem) {
+    if (wsdeque == NULL || elem == NULL) {
+        return WSDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    long long bottom = atomic_load_explicit(&wsdeque->bottom,
+                                            memory_order_relaxed) - 1;
+    wsdeque_array_t * array = atomic_load_explicit(&wsdeque->array,
+                                                   memory_order_relaxed);
+    // reserve the back element before looking at what thieves are doing
+    atomic_store_explicit(&wsdeque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&wsdeque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        // the deque was empty
+        atomic_store_explicit(&wsdeque->bottom,
+                              bottom + 1,
+                              memory_order_relaxed);
+        return WSDEQUE_ERROR_EMPTY;
+    }
+    *elem = atomic_load_explicit(wsdeque_array_slot(array, bottom),
+                                 memory_order_relaxed);
+    if (top == bottom) {
+        // this is the last element, race the thieves for it
+        wsdeque_error_t result = WSDEQUE_ERROR_OK;
+        if (!atomic_compare_exchange_strong_explicit(&wsdeque->top,
+                                                     &top,
+                                                     top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            result = WSDEQUE_ERROR_EMPTY;
+        }
+        atomic_store_explicit(&wsdeque->bottom,
+                              bottom + 1,
+                              memory_order_relaxed);
+        return result;
+    }
+    return WSDEQUE_ERROR_OK;
+}
+
+wsdeque_error_t wsdeque_steal(wsdeque_ptr wsdeque, void ** elem) {
+    if (wsdeque == NULL || elem == NULL) {
+        return WSDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    long long top = atomic_load_explicit(&wsdeque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&wsdeque->bottom,
+                                            memory_order_acquire);
+    if (top >= bottom) {
+        return WSDEQUE_ERROR_EMPTY;
+    }
+    wsdeque_array_t * array = atomic_load_explicit(&wsdeque->array,
+                                                   memory_order_acquire);
+    void * stolen = atomic_load_explicit(wsdeque_array_slot(array, top),
+                                         memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&wsdeque->top,
+                                                 &top,
+                                                 top + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return WSDEQUE_ERROR_ABORT;
+    }
+    *elem = stolen;
+    return WSDEQUE_ERROR_OK;
+}
+
+size_t wsdeque_len(wsdeque_ptr wsdeque) {
+    if (wsdeque == NULL) {
+        return 0;
+    }
+    long long top = atomic_load_explicit(&wsdeque->top, memory_order_acquire);
+    long long bottom = atomic_load_explicit(&wsdeque->bottom,
+                                            memory_order_acquire);
+    return bottom > top ? (size_t) (bottom - top) : 0;
+}
+
+wsdeque_error_t wsdeque_free(wsdeque_ptr wsdeque) {
+    if (wsdeque == NULL) {
+        return WSDEQUE_ERROR_NULL_POINTER_RECEIVED;
+    }
+    wsdeque_array_t * array = atomic_load_explicit(&wsdeque->array,
+                                                   memory_order_relaxed);
+    while (array != NULL) {
+        wsdeque_array_t * prev = array->prev;
+        allocator_free(&wsdeque->allocator,
+                       array,
+                       wsdeque_array_size(array->capacity));
+        array = prev;
+    }
+    atomic_store_explicit(&wsdeque->array, NULL, memory_order_relaxed);
+    return WSDEQUE_ERROR_OK;
+}
@@ -0,0 +1,111 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+void test_arena_alloc(void) {
+    arena_t arena;
+    assert(ARENA_ERROR_IS_OK(arena_new(&arena, 256, NULL)));
+    assert(arena.first == NULL);
+
+    char * a = arena_alloc(&arena, 10);
+    char * b = arena_alloc(&arena, 10);
+    assert(a != NULL && b != NULL);
+    assert(((uintptr_t) a) % ARENA_ALIGNMENT == 0);
+    assert(((uintptr_t) b) % ARENA_ALIGNMENT == 0);
+    assert(b == a + ARENA_ALIGNMENT);
+    memset(a, 1, 10);
+    memset(b, 2, 10);
+
+    // allocations larger than a block get a block of their own
+    char * big = arena_alloc(&arena, 1000);
+    assert(big != NULL);
+    memset(big, 3, 1000);
+    assert(arena.current->size >= 1000);
+    assert(a[0] == 1 && b[0] == 2);
+
+    arena_free(&arena);
+    assert(arena.first == NULL);
+}
+
+void test_arena_rewind(void) {
+    arena_t arena;
+    assert(ARENA_ERROR_IS_OK(arena_new(&arena, 64, NULL)));
+    void * first = arena_alloc(&arena, 16);
+    arena_mark_t mark = arena_mark(&arena);
+    void * second = arena_alloc(&arena, 16);
+    for (int i = 0; i < 100; i++) {
+        assert(arena_alloc(&arena, 48) != NULL);
+    }
+    arena_rewind(&arena, mark);
+    assert(arena_alloc(&arena, 16) == second);
+
+    // blocks are reused after a reset
+    arena_block_t * block = arena.first;
+    size_t blocks = 0;
+    for (; block != NULL; block = block->next) {
+        blocks += 1;
+    }
+    arena_reset(&arena);
+    assert(arena_alloc(&arena, 16) == first);
+    for (int i = 0; i < 100; i++) {
+        assert(arena_alloc(&arena, 48) != NULL);
+    }
+    size_t blocks_after = 0;
+    for (block = arena.first; block != NULL; block = block->next) {
+        blocks_after += 1;
+    }
+    assert(blocks_after == blocks);
+    arena_free(&arena);
+}
+
+void test_arena_allocator(void) {
+    arena_t arena;
+    assert(ARENA_ERROR_IS_OK(arena_new(&arena, 1024, NULL)));
+    allocator_t allocator = arena_allocator(&arena);
+    int * values = allocator_alloc(&allocator, 4 * sizeof(int));
+    for (int i = 0; i < 4; i++) {
+        values[i] = i;
+    }
+    // the last allocation grows in place
+    int * grown = allocator_realloc(&allocator, values, 4 * sizeof(int), 8 * sizeof(int));
+    assert(grown == values);
+    void * other = allocator_alloc(&allocator, 8);
+    int * moved = allocator_realloc(&allocator, grown, 8 * sizeof(int), 16 * sizeof(int));
+    assert(moved != grown && moved != other);
+    for (int i = 0; i < 4; i++) {
+        assert(moved[i] == i);
+    }
+    allocator_free(&allocator, moved, 16 * sizeof(int));
+    arena_free(&arena);
+}
+
+int main() {
+    test_arena_alloc();
+    test_arena_rewind();
+    test_arena_allocator();
+}
@@ -0,0 +1,206 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "bqueue.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#define THREADS 4
+#define ITEMS_PER_PRODUCER 100000
+#define BATCH 16
+
+atomic_uchar seen[THREADS * ITEMS_PER_PRODUCER];
+atomic_size_t popped;
+
+typedef struct producer_arg_t {
+    bqueue_ptr bqueue;
+    uint32_t first;
+} producer_arg_t;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void test_bqueue_basic(void) {
+    bqueue_t bqueue;
+    assert(bqueue_new(&bqueue, 0, sizeof(uint32_t), NULL)
+           == BQUEUE_ERROR_CAPACITY_TOO_SMALL);
+    assert(bqueue_new(NULL, 4, sizeof(uint32_t), NULL)
+           == BQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 4, sizeof(uint32_t), NULL)));
+    uint32_t value;
+    assert(bqueue_pop(&bqueue, &value, 0) == BQUEUE_ERROR_TIMEOUT);
+    assert(bqueue_pop(&bqueue, NULL, 0) == BQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(bqueue_push(&bqueue, NULL, 0) == BQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    for (uint32_t i = 0; i < 4; i++) {
+        assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &i, 0)));
+    }
+    value = 4;
+    assert(bqueue_push(&bqueue, &value, 0) == BQUEUE_ERROR_TIMEOUT);
+    assert(bqueue_len(&bqueue) == 4);
+    // wrap around the ring, always in FIFO order
+    for (uint32_t i = 0; i < 100; i++) {
+        assert(BQUEUE_ERROR_IS_OK(bqueue_pop(&bqueue, &value, 0)));
+        assert(value == i);
+        value = i + 4;
+        assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &value, 0)));
+    }
+    uint32_t batch[8];
+    size_t count;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_pop_batch(&bqueue, batch, 0, &count, 0)));
+    assert(count == 0);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_pop_batch(&bqueue, batch, 3, &count, 0)));
+    assert(count == 3);
+    assert(batch[0] == 100 && batch[1] == 101 && batch[2] == 102);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_pop_batch(&bqueue, batch, 8, &count, 0)));
+    assert(count == 1 && batch[0] == 103);
+    assert(bqueue_pop_batch(&bqueue, batch, 8, &count, 0)
+           == BQUEUE_ERROR_TIMEOUT);
+    assert(count == 0);
+    bqueue_free(&bqueue);
+}
+
+void test_bqueue_timeout(void) {
+    bqueue_t bqueue;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 1, sizeof(uint32_t), NULL)));
+    uint32_t value = 7;
+    int64_t start = now_ns();
+    assert(bqueue_pop(&bqueue, &value, 20000000) == BQUEUE_ERROR_TIMEOUT);
+    assert(now_ns() - start >= 20000000);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &value, 0)));
+    start = now_ns();
+    assert(bqueue_push(&bqueue, &value, 20000000) == BQUEUE_ERROR_TIMEOUT);
+    assert(now_ns() - start >= 20000000);
+    bqueue_free(&bqueue);
+}
+
+void * close_waiter(void * arg) {
+    uint32_t value;
+    return (void *) (uintptr_t) bqueue_pop(arg, &value, BQUEUE_WAIT_FOREVER);
+}
+
+void test_bqueue_close(void) {
+    bqueue_t bqueue;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 4, sizeof(uint32_t), NULL)));
+    pthread_t waiters[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        assert(pthread_create(&waiters[i], NULL, close_waiter, &bqueue) == 0);
+    }
+    // give the waiters time to park
+    struct timespec delay = {0, 20000000};
+    nanosleep(&delay, NULL);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_close(&bqueue)));
+    for (int i = 0; i < THREADS; i++) {
+        void * err;
+        pthread_join(waiters[i], &err);
+        assert((bqueue_error_t) (uintptr_t) err == BQUEUE_ERROR_CLOSED);
+    }
+    uint32_t value = 1;
+    assert(bqueue_push(&bqueue, &value, BQUEUE_WAIT_FOREVER)
+           == BQUEUE_ERROR_CLOSED);
+    bqueue_free(&bqueue);
+
+    // items pushed before closing are still handed out
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 4, sizeof(uint32_t), NULL)));
+    for (uint32_t i = 0; i < 2; i++) {
+        assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &i, 0)));
+    }
+    bqueue_close(&bqueue);
+    for (uint32_t i = 0; i < 2; i++) {
+        assert(BQUEUE_ERROR_IS_OK(bqueue_pop(&bqueue, &value, 0)));
+        assert(value == i);
+    }
+    assert(bqueue_pop(&bqueue, &value, BQUEUE_WAIT_FOREVER)
+           == BQUEUE_ERROR_CLOSED);
+    bqueue_free(&bqueue);
+}
+
+void * stress_producer(void * arg) {
+    producer_arg_t * producer = arg;
+    for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        uint32_t value = producer->first + i;
+        assert(BQUEUE_ERROR_IS_OK(bqueue_push(producer->bqueue,
+                                              &value,
+                                              BQUEUE_WAIT_FOREVER)));
+    }
+    return NULL;
+}
+
+void * stress_consumer(void * arg) {
+    uint32_t batch[BATCH];
+    size_t count;
+    while (BQUEUE_ERROR_IS_OK(bqueue_pop_batch(arg, batch, BATCH, &count,
+                                               BQUEUE_WAIT_FOREVER))) {
+        for (size_t i = 0; i < count; i++) {
+            // every item comes out exactly once
+            assert(atomic_fetch_add(&seen[batch[i]], 1) == 0);
+        }
+        atomic_fetch_add(&popped, count);
+    }
+    return NULL;
+}
+
+void test_bqueue_stress(void) {
+    bqueue_t bqueue;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 8, sizeof(uint32_t), NULL)));
+    pthread_t producers[THREADS];
+    pthread_t consumers[THREADS];
+    producer_arg_t args[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        args[i].bqueue = &bqueue;
+        args[i].first = (uint32_t) i * ITEMS_PER_PRODUCER;
+        assert(pthread_create(&consumers[i], NULL, stress_consumer,
+                              &bqueue) == 0);
+        assert(pthread_create(&producers[i], NULL, stress_producer,
+                              &args[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    // consumers drain what is left, then see the queue closed
+    bqueue_close(&bqueue);
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    assert(atomic_load(&popped) == THREADS * ITEMS_PER_PRODUCER);
+    for (size_t i = 0; i < THREADS * ITEMS_PER_PRODUCER; i++) {
+        assert(atomic_load(&seen[i]) == 1);
+    }
+    assert(bqueue_len(&bqueue) == 0);
+    bqueue_free(&bqueue);
+}
+
+int main() {
+    test_bqueue_basic();
+    test_bqueue_timeout();
+    test_bqueue_close();
+    test_bqueue_stress();
+}
@@ -21,10 +21,15 @@
  * SOFTWARE.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "dequeue.h"
+#include "dequeue_typed.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #define SIZES_LEN 5
 size_t sizes[SIZES_LEN] = {
@@ -42,6 +47,916 @@ void test_dequeue_new(dequeue_ptr dequeue, size_t capacity, size_t element_size)
     assert(dequeue->element_size == element_size);
 }
 
+void test_dequeue_ring(void) {
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_capacity(&dequeue, 8, sizeof(int))));
+    // push -1..-4 at the front and 0..3 at the back, so the ring wraps around
+    for (int i = 0; i < 4; i++) {
+        int front = -(i + 1);
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_copy(&dequeue, &front)));
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &i)));
+    }
+    assert(dequeue.len == 8);
+    assert(dequeue.capacity == 8);
+    assert(*((int *) dequeue_front(&dequeue)) == -4);
+    assert(*((int *) dequeue_back(&dequeue)) == 3);
+
+    // growing a wrapped ring keeps the order of the elements
+    int value = 4;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &value)));
+    assert(dequeue.len == 9);
+    for (int expected = -4; expected <= 4; expected++) {
+        int * elem = dequeue_pop_front(&dequeue);
+        assert(*elem == expected);
+        free(elem);
+    }
+    assert(dequeue.len == 0);
+    assert(dequeue_front(&dequeue) == NULL);
+    assert(dequeue_back(&dequeue) == NULL);
+    assert(dequeue_pop_front(&dequeue) == NULL);
+    assert(dequeue_pop_back(&dequeue) == NULL);
+
+    // use the dequeue as a FIFO so that the head keeps moving around the ring
+    for (int i = 0; i < 100; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &i)));
+        if (i % 3 == 2) {
+            free(dequeue_pop_front(&dequeue));
+        }
+    }
+    // shrinking a wrapped ring drops the elements at the back
+    size_t len = dequeue.len;
+    int front = *((int *) dequeue_front(&dequeue));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_resize(&dequeue, len / 2)));
+    assert(dequeue.len == len / 2);
+    for (size_t i = 0; i < len / 2; i++) {
+        int * elem = dequeue_pop_front(&dequeue);
+        assert(*elem == front + (int) i);
+        free(elem);
+    }
+    dequeue_free(&dequeue);
+}
+
+void test_dequeue_growth(void) {
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new(&dequeue, sizeof(int))));
+    assert(dequeue_set_growth(&dequeue, 1.0, 0) == DEQUEUE_ERROR_INVALID_GROWTH_FACTOR);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_set_growth(&dequeue, 1.5, 10)));
+    size_t expected_capacities[] = {1, 2, 3, 4, 6, 6, 9, 9, 9, 10};
+    for (int i = 0; i < 10; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &i)));
+        assert(dequeue.capacity == expected_capacities[i]);
+    }
+    int value = 10;
+    assert(dequeue_push_back_copy(&dequeue, &value) == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+    assert(dequeue_push_front_copy(&dequeue, &value) == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+    assert(dequeue.len == 10);
+    assert(dequeue_reserve(&dequeue, 1) == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_set_growth(&dequeue, DEQUEUE_DEFAULT_GROWTH_FACTOR,
+                                                  DEQUEUE_UNBOUNDED_CAPACITY)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_reserve(&dequeue, 100)));
+    assert(dequeue.capacity == 110);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_reserve(&dequeue, 50)));
+    assert(dequeue.capacity == 110);
+
+    for (int i = 0; i < 5; i++) {
+        free(dequeue_pop_front(&dequeue));
+    }
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_shrink_to_fit(&dequeue)));
+    assert(dequeue.capacity == 5);
+    assert(dequeue.len == 5);
+    assert(*((int *) dequeue_front(&dequeue)) == 5);
+    assert(*((int *) dequeue_back(&dequeue)) == 9);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_empty(&dequeue)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_shrink_to_fit(&dequeue)));
+    assert(dequeue.capacity == 1);
+    dequeue_free(&dequeue);
+}
+
+void test_dequeue_inline(void) {
+    for (int i = 0; i < SIZES_LEN; i++) {
+        dequeue_t dequeue;
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_storage(&dequeue, 16, sizes[i],
+                                                            DEQUEUE_STORAGE_INLINE)));
+        assert(dequeue.storage == DEQUEUE_STORAGE_INLINE);
+        assert(dequeue.capacity == 16);
+        assert(dequeue.element_size == sizes[i]);
+        dequeue_free(&dequeue);
+    }
+
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_storage(&dequeue, 4, sizeof(double),
+                                                        DEQUEUE_STORAGE_INLINE)));
+    for (int i = 0; i < 100; i++) {
+        double value = i;
+        double front = -value - 1;
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back(&dequeue, &value)));
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_copy(&dequeue, &front)));
+    }
+    assert(dequeue.len == 200);
+    // the elements are packed contiguously in the ring
+    for (size_t i = 1; i < dequeue.len; i++) {
+        if ((dequeue.head + i) % dequeue.capacity != 0) {
+            assert((char *) dequeue_get(&dequeue, i)
+                   == (char *) dequeue_get(&dequeue, i - 1) + sizeof(double));
+        }
+    }
+    for (size_t i = 0; i < dequeue.len; i++) {
+        assert(*((double *) dequeue_get(&dequeue, i)) == (double) i - 100);
+    }
+    assert(dequeue_get(&dequeue, dequeue.len) == NULL);
+    assert(*((double *) dequeue_front(&dequeue)) == -100);
+    assert(*((double *) dequeue_back(&dequeue)) == 99);
+    assert(dequeue_pop_front(&dequeue) == NULL);
+    assert(dequeue_pop_back(&dequeue) == NULL);
+
+    double value;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_into(&dequeue, &value)));
+    assert(value == -100);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_back_into(&dequeue, &value)));
+    assert(value == 99);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_resize(&dequeue, 10)));
+    assert(dequeue.len == 10);
+    assert(*((double *) dequeue_back(&dequeue)) == -90);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_empty(&dequeue)));
+    assert(dequeue_pop_back_into(&dequeue, &value) == DEQUEUE_ERROR_EMPTY);
+    dequeue_free(&dequeue);
+
+    // popping into a buffer also works with pointer storage
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new(&dequeue, sizeof(double))));
+    value = 42;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &value)));
+    value = 0;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_into(&dequeue, &value)));
+    assert(value == 42);
+    assert(dequeue.len == 0);
+    dequeue_free(&dequeue);
+}
+
+typedef struct counting_allocator_t {
+    size_t allocs;
+    size_t frees;
+    size_t bytes;
+} counting_allocator_t;
+
+void * counting_alloc(void * ctx, size_t size) {
+    counting_allocator_t * counter = ctx;
+    counter->allocs += 1;
+    counter->bytes += size;
+    return malloc(size);
+}
+
+void * counting_realloc(void * ctx, void * ptr, size_t old_size, size_t new_size) {
+    counting_allocator_t * counter = ctx;
+    counter->bytes += new_size;
+    counter->bytes -= old_size;
+    return realloc(ptr, new_size);
+}
+
+void counting_free(void * ctx, void * ptr, size_t size) {
+    counting_allocator_t * counter = ctx;
+    counter->frees += 1;
+    counter->bytes -= size;
+    free(ptr);
+}
+
+void test_dequeue_allocator(void) {
+    counting_allocator_t counter = {0, 0, 0};
+    allocator_t allocator = allocator_new(&counter, counting_alloc, counting_realloc,
+                                          counting_free);
+    dequeue_ptr dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_ptr_with_allocator(&dequeue, 1, sizeof(int),
+                                                              DEQUEUE_STORAGE_POINTERS,
+                                                              &allocator)));
+    assert(counter.allocs == 2);
+    for (int i = 0; i < 100; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(dequeue, &i)));
+    }
+    assert(counter.allocs == 102);
+    dequeue_element_free(dequeue, dequeue_pop_front(dequeue));
+    int value;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_back_into(dequeue, &value)));
+    assert(counter.frees == 2);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_resize(dequeue, 50)));
+    assert(counter.frees == 2 + 48 + 1);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_free(dequeue)));
+    allocator_free(&allocator, dequeue, sizeof(dequeue_t));
+    assert(counter.allocs == counter.frees);
+    assert(counter.bytes == 0);
+}
+
+void test_dequeue_arena(void) {
+    arena_t arena;
+    assert(ARENA_ERROR_IS_OK(arena_new(&arena, 4096, NULL)));
+    void * before = arena_alloc(&arena, 16);
+    counting_allocator_t counter = {0, 0, 0};
+    allocator_t allocator = allocator_new(&counter, counting_alloc, counting_realloc,
+                                          counting_free);
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_allocator(&dequeue, 1024, sizeof(int),
+                                                          DEQUEUE_STORAGE_POINTERS,
+                                                          &allocator)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_set_arena(&dequeue, &arena)));
+    for (int i = 0; i < 1000; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &i)));
+    }
+    // only the ring comes from the allocator of the dequeue
+    assert(counter.allocs == 1);
+    int value = -1;
+    assert(dequeue_set_arena(&dequeue, NULL) == DEQUEUE_ERROR_NOT_EMPTY);
+    dequeue_element_free(&dequeue, dequeue_pop_front(&dequeue));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_back_into(&dequeue, &value)));
+    assert(value == 999);
+    assert(counter.frees == 0);
+
+    // emptying the dequeue rewinds the arena
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_empty(&dequeue)));
+    assert(counter.frees == 0);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &value)));
+    int * first = dequeue_front(&dequeue);
+    assert((char *) first == (char *) before + ARENA_ALIGNMENT);
+    dequeue_free(&dequeue);
+    assert(counter.frees == 1);
+    assert(arena_alloc(&arena, 16) == first);
+    arena_free(&arena);
+}
+
+void test_dequeue_pool(void) {
+    counting_allocator_t counter = {0, 0, 0};
+    allocator_t allocator = allocator_new(&counter, counting_alloc, counting_realloc,
+                                          counting_free);
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_allocator(&dequeue, 256, sizeof(int),
+                                                          DEQUEUE_STORAGE_POINTERS,
+                                                          &allocator)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_use_pool(&dequeue)));
+    assert(dequeue.pool != NULL);
+    size_t allocs = counter.allocs;
+    // steady-state push/pop loop recycles the same slots
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 200; i++) {
+            assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &i)));
+        }
+        for (int i = 0; i < 200; i++) {
+            int * elem = dequeue_pop_front(&dequeue);
+            assert(*elem == i);
+            dequeue_element_free(&dequeue, elem);
+        }
+    }
+    // only the slabs for the first round were allocated
+    size_t slabs = counter.allocs - allocs;
+    assert(slabs > 0 && slabs <= 200 / (POOL_DEFAULT_SLAB_SIZE / 16) + 1);
+
+    int value = 7;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &value)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_empty(&dequeue)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy(&dequeue, &value)));
+    assert(counter.allocs - allocs == slabs);
+    dequeue_free(&dequeue);
+    assert(counter.allocs == counter.frees);
+    assert(counter.bytes == 0);
+}
+
+void test_dequeue_iter(void) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 8, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    // wrap the ring: positions 0..7 hold 0..7 with the head at index 5
+    for (int i = 0; i < 5; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    for (int i = 0; i < 5; i++) {
+        int value;
+        dequeue_pop_front_into(&dequeue, &value);
+    }
+    for (int i = 0; i < 8; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    assert(dequeue.head == 5);
+
+    dequeue_iter_t state;
+    iter_t iter = dequeue_iter(&dequeue, &state);
+    size_t len;
+    assert(iter_exact_len(&iter, &len) && len == 8);
+    assert(*((int *) iter_next(&iter)) == 0);
+    assert(*((int *) iter_next_back(&iter)) == 7);
+    assert(*((int *) iter_nth(&iter, 2)) == 3);
+    // the batch crosses the end of the ring
+    void * buffer[8];
+    assert(iter_next_batch(&iter, buffer, 8) == 3);
+    assert(*((int *) buffer[0]) == 4 && *((int *) buffer[2]) == 6);
+    assert(iter_next(&iter) == NULL);
+    assert(iter_next_back(&iter) == NULL);
+
+    iter = dequeue_iter_rev(&dequeue, &state);
+    assert(*((int *) iter_next(&iter)) == 7);
+    assert(*((int *) iter_next_back(&iter)) == 0);
+    assert(iter_advance_by(&iter, 2) == 2);
+    assert(iter_next_batch(&iter, buffer, 8) == 4);
+    assert(*((int *) buffer[0]) == 4 && *((int *) buffer[3]) == 1);
+    assert(iter_count(&iter) == 0);
+    dequeue_free(&dequeue);
+
+    // pointer storage lends the ring itself, one run per side of the wrap
+    dequeue_new_with_capacity(&dequeue, 4, sizeof(int));
+    static int values[4] = {0, 1, 2, 3};
+    dequeue_push_back(&dequeue, &values[1]);
+    dequeue_push_back(&dequeue, &values[2]);
+    dequeue_push_back(&dequeue, &values[3]);
+    dequeue_push_front(&dequeue, &values[0]);
+    assert(dequeue.head == 3);
+    iter = dequeue_iter(&dequeue, &state);
+    void ** span;
+    assert(iter_next_span(&iter, buffer, 8, &span) == 1);
+    assert(span == dequeue.elements + 3 && span[0] == &values[0]);
+    assert(iter_next_span(&iter, buffer, 8, &span) == 3);
+    assert(span == dequeue.elements && span[2] == &values[3]);
+    assert(iter_next_span(&iter, buffer, 8, &span) == 0);
+    iter = dequeue_iter(&dequeue, &state);
+    assert(iter_count(&iter) == 4);
+    // the elements are not owned by the dequeue
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+
+    iter = dequeue_iter(NULL, &state);
+    assert(iter_next(&iter) == NULL);
+    assert(iter_count(&iter) == 0);
+}
+
+typedef struct point_t {
+    int x;
+    int y;
+} point_t;
+
+DEQUEUE_DEFINE(int)
+DEQUEUE_DEFINE_NAMED(dequeue_point, point_t)
+
+void test_dequeue_typed(void) {
+    dequeue_int_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_new(&dequeue)));
+    assert(dequeue.capacity == DEQUEUE_DEFAULT_CAPACITY);
+    int value;
+    assert(dequeue_int_pop_front_into(&dequeue, &value) == DEQUEUE_ERROR_EMPTY);
+    assert(dequeue_int_front(&dequeue) == NULL);
+    // push on both ends so the ring wraps while it grows
+    for (int i = 0; i < 100; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_int_push_back(&dequeue, i)));
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_int_push_front(&dequeue, -i - 1)));
+    }
+    assert(dequeue.len == 200);
+    assert(dequeue.capacity == 256);
+    for (int i = 0; i < 200; i++) {
+        assert(*dequeue_int_get(&dequeue, (size_t) i) == i - 100);
+    }
+    assert(dequeue_int_get(&dequeue, 200) == NULL);
+    assert(*dequeue_int_front(&dequeue) == -100);
+    assert(*dequeue_int_back(&dequeue) == 99);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_pop_front_into(&dequeue, &value)));
+    assert(value == -100);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_pop_back_into(&dequeue, &value)));
+    assert(value == 99);
+
+    // shrinking keeps the front elements
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_resize(&dequeue, 10)));
+    assert(dequeue.len == 10 && dequeue.head == 0);
+    for (int i = 0; i < 10; i++) {
+        assert(*dequeue_int_get(&dequeue, (size_t) i) == i - 99);
+    }
+    assert(dequeue_int_resize(&dequeue, 0)
+           == DEQUEUE_ERROR_ZERO_CAPACITY_RESIZE);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_set_growth(&dequeue, 1.5, 12)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_push_back(&dequeue, 1)));
+    assert(dequeue.capacity == 12);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_push_back(&dequeue, 2)));
+    assert(dequeue_int_push_back(&dequeue, 3) == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+    assert(dequeue_int_reserve(&dequeue, 1) == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+    assert(dequeue_int_set_growth(&dequeue, 1.0, 0)
+           == DEQUEUE_ERROR_INVALID_GROWTH_FACTOR);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_empty(&dequeue)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_shrink_to_fit(&dequeue)));
+    assert(dequeue.capacity == 1);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_int_free(&dequeue)));
+    assert(dequeue.elements == NULL);
+
+    dequeue_point_ptr points;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_point_new_ptr_with_capacity(&points, 4)));
+    point_t point = {1, 2};
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_point_push_back(points, point)));
+    point.x = 3;
+    assert(dequeue_point_front(points)->x == 1);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_point_pop_back_into(points, &point)));
+    assert(point.x == 1 && point.y == 2);
+    dequeue_point_free(points);
+    free(points);
+}
+
+void test_dequeue_bulk(void) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 4, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    int values[100];
+    for (int i = 0; i < 100; i++) {
+        values[i] = i;
+    }
+    // the pushes wrap around the ring and grow it
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_n(&dequeue, values + 50, 3)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_n(&dequeue, values + 47, 3)));
+    assert(dequeue.head > 0);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_n(&dequeue, values + 53, 47)));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_n(&dequeue, values, 47)));
+    assert(dequeue.len == 100);
+    for (size_t i = 0; i < 100; i++) {
+        assert(*((int *) dequeue_get(&dequeue, i)) == (int) i);
+    }
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_n(&dequeue, NULL, 0)));
+    assert(dequeue_push_back_n(&dequeue, NULL, 1)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+
+    int out[100];
+    size_t popped;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_n(&dequeue, out, 10, &popped)));
+    assert(popped == 10 && out[0] == 0 && out[9] == 9);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_back_n(&dequeue, out, 10, &popped)));
+    assert(popped == 10 && out[0] == 90 && out[9] == 99);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_n(&dequeue, out, 100, &popped)));
+    assert(popped == 80 && out[0] == 10 && out[79] == 89);
+    assert(dequeue.len == 0);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_back_n(&dequeue, out, 5, &popped)));
+    assert(popped == 0);
+
+    // extend from another dequeue, then from an adapter without spans
+    dequeue_t source;
+    dequeue_new_with_storage(&source, 8, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&source, values, 20);
+    dequeue_iter_t state;
+    iter_t iter = dequeue_iter(&source, &state);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_extend(&dequeue, &iter)));
+    iter = dequeue_iter_rev(&source, &state);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_extend(&dequeue, &iter)));
+    assert(dequeue.len == 40);
+    assert(*((int *) dequeue_get(&dequeue, 19)) == 19);
+    assert(*((int *) dequeue_get(&dequeue, 20)) == 19);
+    assert(*((int *) dequeue_back(&dequeue)) == 0);
+    dequeue_free(&source);
+    dequeue_free(&dequeue);
+
+    // with pointer storage, copies are owned by the dequeue
+    dequeue_new(&dequeue, sizeof(int));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_copy_n(&dequeue, values, 30)));
+    assert(dequeue.len == 30);
+    assert(dequeue_get(&dequeue, 5) != &values[5]);
+    assert(*((int *) dequeue_get(&dequeue, 5)) == 5);
+    iter = dequeue_iter(&dequeue, &state);
+    dequeue_t copy;
+    dequeue_new(&copy, sizeof(int));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_extend(&copy, &iter)));
+    assert(copy.len == 30 && dequeue_get(&copy, 7) != dequeue_get(&dequeue, 7));
+    assert(*((int *) dequeue_get(&copy, 7)) == 7);
+    void * ptrs[5];
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_n(&copy, ptrs, 5, NULL)));
+    for (int i = 0; i < 5; i++) {
+        assert(*((int *) ptrs[i]) == i);
+        dequeue_element_free(&copy, ptrs[i]);
+    }
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_n(&copy, ptrs, 0)));
+    // a NULL element pointer is refused as by the single pushes, before
+    // anything is pushed
+    int kept = 42;
+    void * with_null[3] = {&kept, NULL, &kept};
+    size_t capacity = copy.capacity;
+    assert(dequeue_push_back_n(&copy, with_null, 3)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(dequeue_push_front_n(&copy, with_null, 3)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(copy.len == 25 && copy.capacity == capacity);
+    dequeue_free(&copy);
+    dequeue_free(&dequeue);
+
+    // a bounded dequeue refuses bulk pushes that do not fit
+    dequeue_new_with_storage(&dequeue, 4, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    dequeue_set_growth(&dequeue, 2.0, 8);
+    assert(dequeue_push_back_n(&dequeue, values, 9)
+           == DEQUEUE_ERROR_CAPACITY_EXCEEDED);
+    assert(dequeue.len == 0);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_n(&dequeue, values, 8)));
+    dequeue_free(&dequeue);
+}
+
+void test_dequeue_simd(void) {
+    int32_t values[100];
+    for (int32_t i = 0; i < 100; i++) {
+        values[i] = i - 50;
+    }
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue,
+                             64,
+                             sizeof(int32_t),
+                             DEQUEUE_STORAGE_INLINE);
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_sum_i32(&dequeue, &sum)));
+    assert(sum == 0);
+    assert(dequeue_min_max_i32(&dequeue, &min, &max) == DEQUEUE_ERROR_EMPTY);
+
+    // wrap the elements around the end of the ring
+    int32_t discard[40];
+    dequeue_push_back_n(&dequeue, values, 40);
+    dequeue_pop_front_n(&dequeue, discard, 40, NULL);
+    dequeue_push_back_n(&dequeue, values, 60);
+    assert(dequeue.capacity == 64 && dequeue.head + dequeue.len > 64);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_sum_i32(&dequeue, &sum)));
+    assert(sum == (int64_t) (-50 + 9) * 60 / 2);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_min_max_i32(&dequeue, &min, &max)));
+    assert(min == -50 && max == 9);
+    size_t count;
+    size_t pos;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_count_eq_i32(&dequeue, 5, &count)));
+    assert(count == 1);
+    // the last element lives in the second segment of the ring
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_find_i32(&dequeue, 9, &pos)));
+    assert(pos == 59);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_find_i32(&dequeue, 42, &pos)));
+    assert(pos == dequeue.len);
+
+    // the element type must match the storage of the dequeue
+    assert(dequeue_sum_i64(&dequeue, &sum) == DEQUEUE_ERROR_ELEMENT_MISMATCH);
+    assert(dequeue_find_byte(&dequeue, 0, &pos)
+           == DEQUEUE_ERROR_ELEMENT_MISMATCH);
+    assert(dequeue_sum_i32(NULL, &sum)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    dequeue_free(&dequeue);
+
+    dequeue_new(&dequeue, sizeof(int32_t));
+    dequeue_push_back_copy(&dequeue, &values[0]);
+    assert(dequeue_sum_i32(&dequeue, &sum) == DEQUEUE_ERROR_ELEMENT_MISMATCH);
+    dequeue_free(&dequeue);
+
+    double doubles[] = {1.5, -2.0, 8.25};
+    dequeue_new_with_storage(&dequeue,
+                             2,
+                             sizeof(double),
+                             DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, doubles, 3);
+    double dsum;
+    double dmin;
+    double dmax;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_sum_f64(&dequeue, &dsum)));
+    assert(dsum == 7.75);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_min_max_f64(&dequeue, &dmin, &dmax)));
+    assert(dmin == -2.0 && dmax == 8.25);
+    dequeue_free(&dequeue);
+
+    const char * text = "find the first x in a ring of bytes";
+    dequeue_new_with_storage(&dequeue, 16, 1, DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, text, strlen(text));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_find_byte(&dequeue, 'x', &pos)));
+    assert(pos == (size_t) (strchr(text, 'x') - text));
+    dequeue_free(&dequeue);
+}
+
+typedef struct record_t {
+    int key;
+    int seq;
+} record_t;
+
+int compare_int(const void * a, const void * b) {
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+int compare_record(const void * a, const void * b) {
+    return compare_int(&((const record_t *) a)->key,
+                       &((const record_t *) b)->key);
+}
+
+int compare_i64(const void * a, const void * b) {
+    int64_t x = *(const int64_t *) a;
+    int64_t y = *(const int64_t *) b;
+    return (x > y) - (x < y);
+}
+
+int compare_u16(const void * a, const void * b) {
+    return (int) *(const uint16_t *) a - (int) *(const uint16_t *) b;
+}
+
+/**
+ * Fill a dequeue with pseudo-random values whose elements wrap around the
+ * end of its ring.
+ */
+void fill_wrapped(dequeue_ptr dequeue, size_t len, int modulo) {
+    uint32_t state = 42;
+    int discard[8];
+    dequeue_new_with_storage(dequeue, len + 8, sizeof(int),
+                             DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(dequeue, discard, 8);
+    dequeue_pop_front_n(dequeue, discard, 8, NULL);
+    for (size_t i = 0; i < len; i++) {
+        state = state * 1103515245u + 12345u;
+        int value = (int) (state >> 8) % modulo - modulo / 2;
+        dequeue_push_back_copy(dequeue, &value);
+    }
+}
+
+void assert_sorted_ints(dequeue_ptr dequeue) {
+    for (size_t i = 1; i < dequeue->len; i++) {
+        assert(*(int *) dequeue_get(dequeue, i - 1)
+               <= *(int *) dequeue_get(dequeue, i));
+    }
+}
+
+void test_dequeue_sort(void) {
+    size_t lens[] = {0, 1, 2, 15, 17, 100, 5000};
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (int modulo = 3; modulo <= 30000; modulo *= 100) {
+            dequeue_t dequeue;
+            fill_wrapped(&dequeue, lens[l], modulo);
+            int64_t sum;
+            dequeue_sum_i32(&dequeue, &sum);
+            assert(DEQUEUE_ERROR_IS_OK(dequeue_sort(&dequeue, compare_int)));
+            assert(dequeue.len == lens[l]);
+            assert_sorted_ints(&dequeue);
+            int64_t sorted_sum;
+            dequeue_sum_i32(&dequeue, &sorted_sum);
+            assert(sorted_sum == sum);
+            dequeue_free(&dequeue);
+
+            fill_wrapped(&dequeue, lens[l], modulo);
+            assert(DEQUEUE_ERROR_IS_OK(dequeue_stable_sort(&dequeue,
+                                                           compare_int)));
+            assert_sorted_ints(&dequeue);
+            dequeue_free(&dequeue);
+
+            fill_wrapped(&dequeue, lens[l], modulo);
+            assert(DEQUEUE_ERROR_IS_OK(dequeue_radix_sort(&dequeue,
+                                                          DEQUEUE_KEY_SIGNED)));
+            assert_sorted_ints(&dequeue);
+            dequeue_free(&dequeue);
+        }
+    }
+
+    // already sorted, reversed and constant inputs
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 4, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    for (int i = 0; i < 3000; i++) {
+        int value = i < 1000 ? i : (i < 2000 ? 2000 - i : 7);
+        dequeue_push_back_copy(&dequeue, &value);
+    }
+    dequeue_sort(&dequeue, compare_int);
+    assert_sorted_ints(&dequeue);
+    dequeue_sort(&dequeue, compare_int);
+    assert_sorted_ints(&dequeue);
+    dequeue_free(&dequeue);
+
+    // pointer storage sorts the element pointers
+    dequeue_new(&dequeue, sizeof(int));
+    for (int i = 0; i < 100; i++) {
+        int value = (i * 37) % 100;
+        dequeue_push_front_copy(&dequeue, &value);
+    }
+    dequeue_sort(&dequeue, compare_int);
+    for (int i = 0; i < 100; i++) {
+        assert(*(int *) dequeue_get(&dequeue, (size_t) i) == i);
+    }
+    int key = 42;
+    size_t pos;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_lower_bound(&dequeue, &key,
+                                                   compare_int, &pos)));
+    assert(pos == 42);
+    assert(dequeue_radix_sort(&dequeue, DEQUEUE_KEY_SIGNED)
+           == DEQUEUE_ERROR_ELEMENT_MISMATCH);
+    assert(dequeue_sort(&dequeue, NULL)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    dequeue_free(&dequeue);
+
+    // the stable sort keeps records with equal keys in insertion order
+    dequeue_new_with_storage(&dequeue, 8, sizeof(record_t),
+                             DEQUEUE_STORAGE_INLINE);
+    for (int i = 0; i < 1000; i++) {
+        record_t record = {(i * 7919) % 10, i};
+        dequeue_push_back_copy(&dequeue, &record);
+    }
+    dequeue_stable_sort(&dequeue, compare_record);
+    for (size_t i = 1; i < dequeue.len; i++) {
+        record_t * prev = dequeue_get(&dequeue, i - 1);
+        record_t * cur = dequeue_get(&dequeue, i);
+        assert(prev->key < cur->key
+               || (prev->key == cur->key && prev->seq < cur->seq));
+    }
+    dequeue_free(&dequeue);
+
+    // radix keys of every width, signed and unsigned
+    int64_t wide[] = {5, -3, INT64_MIN, INT64_MAX, 0, -1, 1LL << 40, -7};
+    dequeue_new_with_storage(&dequeue, 4, sizeof(int64_t),
+                             DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, wide, 8);
+    dequeue_radix_sort(&dequeue, DEQUEUE_KEY_SIGNED);
+    qsort(wide, 8, sizeof(int64_t), compare_i64);
+    for (size_t i = 0; i < 8; i++) {
+        assert(*(int64_t *) dequeue_get(&dequeue, i) == wide[i]);
+    }
+    dequeue_free(&dequeue);
+    uint16_t shorts[] = {65535, 3, 256, 0, 32768, 255, 3};
+    dequeue_new_with_storage(&dequeue, 7, sizeof(uint16_t),
+                             DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, shorts, 7);
+    dequeue_radix_sort(&dequeue, DEQUEUE_KEY_UNSIGNED);
+    qsort(shorts, 7, sizeof(uint16_t), compare_u16);
+    for (size_t i = 0; i < 7; i++) {
+        assert(*(uint16_t *) dequeue_get(&dequeue, i) == shorts[i]);
+    }
+    dequeue_free(&dequeue);
+
+    // bounds around runs of duplicates in a wrapped ring
+    int values[] = {1, 3, 3, 3, 5, 8};
+    dequeue_new_with_storage(&dequeue, 6, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&dequeue, values + 3, 3);
+    dequeue_push_front_n(&dequeue, values, 3);
+    assert(dequeue.head + dequeue.len > dequeue.capacity);
+    int keys[] = {0, 1, 3, 4, 8, 9};
+    size_t lower[] = {0, 0, 1, 4, 5, 6};
+    size_t upper[] = {0, 1, 4, 4, 6, 6};
+    for (size_t i = 0; i < 6; i++) {
+        dequeue_lower_bound(&dequeue, &keys[i], compare_int, &pos);
+        assert(pos == lower[i]);
+        dequeue_upper_bound(&dequeue, &keys[i], compare_int, &pos);
+        assert(pos == upper[i]);
+    }
+    dequeue_free(&dequeue);
+}
+
+/**
+ * Save a dequeue and check that both loads verify the checksum and give back
+ * the same elements.
+ */
+static void check_snapshot(dequeue_ptr dequeue, const char * path) {
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_save(dequeue, path)));
+    for (int mapped = 0; mapped < 2; mapped++) {
+        dequeue_t loaded;
+        dequeue_error_t err = mapped
+                ? dequeue_load_mapped(&loaded,
+                                      path,
+                                      dequeue->element_size,
+                                      true)
+                : dequeue_load(&loaded, path, dequeue->element_size);
+        assert(DEQUEUE_ERROR_IS_OK(err));
+        assert(loaded.len == dequeue->len);
+        for (size_t i = 0; i < dequeue->len; i++) {
+            assert(memcmp(dequeue_get(&loaded, i),
+                          dequeue_get(dequeue, i),
+                          dequeue->element_size) == 0);
+        }
+        dequeue_free(&loaded);
+    }
+}
+
+void test_dequeue_snapshot(void) {
+    char path[] = "/tmp/unilib-dequeue-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    // a wrapped ring is written in order
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 8, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    for (int i = 0; i < 1000; i++) {
+        dequeue_push_back(&dequeue, &i);
+        dequeue_pop_front_into(&dequeue, NULL);
+        dequeue_push_back(&dequeue, &i);
+    }
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_save(&dequeue, path)));
+
+    dequeue_t loaded;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load(&loaded, path, sizeof(int))));
+    assert(loaded.len == dequeue.len);
+    assert(loaded.mapping == NULL);
+    for (size_t i = 0; i < dequeue.len; i++) {
+        assert(*(int *) dequeue_get(&loaded, i)
+               == *(int *) dequeue_get(&dequeue, i));
+    }
+    dequeue_free(&loaded);
+
+    // the mapped ring serves the elements in place until it grows
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load_mapped(&loaded,
+                                                   path,
+                                                   sizeof(int),
+                                                   true)));
+    assert(loaded.mapping != NULL);
+    assert((char *) loaded.elements
+           == (char *) loaded.mapping + DEQUEUE_SNAPSHOT_HEADER_SIZE);
+    assert(loaded.len == dequeue.len);
+    for (size_t i = 0; i < dequeue.len; i++) {
+        assert(*(int *) dequeue_get(&loaded, i)
+               == *(int *) dequeue_get(&dequeue, i));
+    }
+    int value;
+    dequeue_pop_front_into(&loaded, &value);
+    assert(value == *(int *) dequeue_front(&dequeue));
+    dequeue_push_back(&loaded, &value);
+    assert(loaded.mapping != NULL);
+    dequeue_push_back(&loaded, &value);
+    assert(loaded.mapping == NULL);
+    assert(loaded.len == dequeue.len + 1);
+    assert(*(int *) dequeue_get(&loaded, 0)
+           == *(int *) dequeue_get(&dequeue, 1));
+    assert(*(int *) dequeue_back(&loaded) == value);
+    dequeue_free(&loaded);
+
+    // the writes above stayed private to the mapping
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load(&loaded, path, sizeof(int))));
+    assert(*(int *) dequeue_front(&loaded) == *(int *) dequeue_front(&dequeue));
+    dequeue_free(&loaded);
+    dequeue_free(&dequeue);
+
+    // pointer storage writes the elements, and loads back inline
+    dequeue_new(&dequeue, sizeof(double));
+    for (int i = 0; i < 10; i++) {
+        double d = i / 4.0;
+        dequeue_push_front_copy(&dequeue, &d);
+    }
+    dequeue_save(&dequeue, path);
+    assert(dequeue_load(&loaded, path, sizeof(int))
+           == DEQUEUE_ERROR_ELEMENT_MISMATCH);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load_mapped(&loaded,
+                                                   path,
+                                                   sizeof(double),
+                                                   true)));
+    assert(loaded.storage == DEQUEUE_STORAGE_INLINE);
+    assert(*(double *) dequeue_front(&loaded) == 9 / 4.0);
+    dequeue_free(&loaded);
+    dequeue_free(&dequeue);
+
+    // elements that do not divide a checksum word, saved one at a time from
+    // pointer storage or in two runs from a ring wrapped at an odd count,
+    // still match the checksum of the payload read back in one piece
+    for (size_t size = 1; size <= 3; size++) {
+        for (int inline_storage = 0; inline_storage < 2; inline_storage++) {
+            dequeue_new_with_storage(&dequeue,
+                                     5,
+                                     size,
+                                     inline_storage
+                                     ? DEQUEUE_STORAGE_INLINE
+                                     : DEQUEUE_STORAGE_POINTERS);
+            char elem[3];
+            for (int i = 0; i < 7; i++) {
+                memset(elem, 'a' + i, sizeof(elem));
+                dequeue_push_back_copy(&dequeue, elem);
+                if (i < 2) {
+                    dequeue_pop_front_into(&dequeue, elem);
+                }
+            }
+            assert(dequeue.len == 5 && dequeue.capacity == 5);
+            assert(!inline_storage || dequeue.head == 2);
+            check_snapshot(&dequeue, path);
+            dequeue_free(&dequeue);
+        }
+    }
+
+    // an empty dequeue round trips without a mapping
+    dequeue_new(&dequeue, sizeof(int));
+    dequeue_save(&dequeue, path);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load_mapped(&loaded,
+                                                   path,
+                                                   sizeof(int),
+                                                   true)));
+    assert(loaded.len == 0 && loaded.mapping == NULL);
+    dequeue_push_back(&loaded, &value);
+    dequeue_free(&loaded);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load(&loaded, path, sizeof(int))));
+    assert(loaded.len == 0);
+    dequeue_free(&loaded);
+
+    // a flipped bit is caught by the checksum, a missing byte by the size
+    for (int i = 0; i < 100; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    dequeue_save(&dequeue, path);
+    FILE * file = fopen(path, "r+b");
+    fseek(file, DEQUEUE_SNAPSHOT_HEADER_SIZE + 123, SEEK_SET);
+    fputc(0x40, file);
+    fclose(file);
+    assert(dequeue_load(&loaded, path, sizeof(int))
+           == DEQUEUE_ERROR_BAD_SNAPSHOT);
+    assert(dequeue_load_mapped(&loaded, path, sizeof(int), true)
+           == DEQUEUE_ERROR_BAD_SNAPSHOT);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_load_mapped(&loaded,
+                                                   path,
+                                                   sizeof(int),
+                                                   false)));
+    dequeue_free(&loaded);
+    dequeue_save(&dequeue, path);
+    assert(truncate(path, DEQUEUE_SNAPSHOT_HEADER_SIZE + 399) == 0);
+    assert(dequeue_load(&loaded, path, sizeof(int))
+           == DEQUEUE_ERROR_BAD_SNAPSHOT);
+    assert(dequeue_load_mapped(&loaded, path, sizeof(int), false)
+           == DEQUEUE_ERROR_BAD_SNAPSHOT);
+    dequeue_free(&dequeue);
+
+    unlink(path);
+    assert(dequeue_load(&loaded, path, sizeof(int)) == DEQUEUE_ERROR_IO);
+    assert(dequeue_load_mapped(&loaded, path, sizeof(int), false)
+           == DEQUEUE_ERROR_IO);
+}
+
 int main() {
     for (int i = 0; i < SIZES_LEN; i++) {
         dequeue_t dequeue;
@@ -88,4 +1003,17 @@ int main() {
     assert(dequeue.len == 0);
     assert(dequeue.capacity == 512);
     dequeue_free(&dequeue);
+
+    test_dequeue_ring();
+    test_dequeue_growth();
+    test_dequeue_inline();
+    test_dequeue_allocator();
+    test_dequeue_arena();
+    test_dequeue_pool();
+    test_dequeue_iter();
+    test_dequeue_typed();
+    test_dequeue_bulk();
+    test_dequeue_simd();
+    test_dequeue_sort();
+    test_dequeue_snapshot();
 }
@@ -0,0 +1,409 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "iter.h"
+#include "iter_inline.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#define LEN 1000
+
+typedef struct array_iter_t {
+    void ** elements;
+    size_t pos;
+    size_t len;
+    size_t calls;
+} array_iter_t;
+
+void * array_next(void * data) {
+    array_iter_t * array = data;
+    array->calls += 1;
+    return array->pos < array->len ? array->elements[array->pos++] : NULL;
+}
+
+size_t array_next_batch(void * data, void ** buffer, size_t max) {
+    array_iter_t * array = data;
+    array->calls += 1;
+    size_t len = 0;
+    while (len < max && array->pos < array->len) {
+        buffer[len++] = array->elements[array->pos++];
+    }
+    return len;
+}
+
+size_t array_next_span(void * data, size_t max, void *** span) {
+    array_iter_t * array = data;
+    array->calls += 1;
+    size_t len = array->len - array->pos;
+    if (len > max) {
+        len = max;
+    }
+    *span = array->elements + array->pos;
+    array->pos += len;
+    return len;
+}
+
+void array_size_hint(void * data, size_t * lower, size_t * upper) {
+    array_iter_t * array = data;
+    *lower = array->len - array->pos;
+    *upper = *lower;
+}
+
+size_t array_advance(void * data, size_t count) {
+    array_iter_t * array = data;
+    array->calls += 1;
+    size_t remaining = array->len - array->pos;
+    if (count > remaining) {
+        count = remaining;
+    }
+    array->pos += count;
+    return count;
+}
+
+void array_free(void * data) {
+    (void) data;
+}
+
+static void * elements[LEN];
+
+iter_t array_iter(array_iter_t * array, int mode) {
+    array->elements = elements;
+    array->pos = 0;
+    array->len = LEN;
+    array->calls = 0;
+    iter_t iter = iter_new(array, array_next, array_free);
+    if (mode == 1) {
+        iter_set_batch(&iter, array_next_batch, NULL);
+    } else if (mode == 2) {
+        iter_set_batch(&iter, NULL, array_next_span);
+    }
+    return iter;
+}
+
+void test_iter_batch(void) {
+    for (uintptr_t i = 0; i < LEN; i++) {
+        elements[i] = (void *) (i + 1);
+    }
+    for (int mode = 0; mode < 3; mode++) {
+        array_iter_t array;
+        iter_t iter = array_iter(&array, mode);
+        assert(iter_advance_by(&iter, 10) == 10);
+        assert((uintptr_t) iter_next(&iter) == 11);
+
+        // batches pick up where the iterator is and stop at the end
+        void * buffer[ITER_BATCH_SIZE];
+        size_t seen = 11;
+        size_t len;
+        while ((len = iter_next_batch(&iter, buffer, ITER_BATCH_SIZE)) != 0) {
+            assert(len <= ITER_BATCH_SIZE);
+            for (size_t i = 0; i < len; i++) {
+                assert((uintptr_t) buffer[i] == ++seen);
+            }
+        }
+        assert(seen == LEN);
+        assert(iter_next(&iter) == NULL);
+        iter_free(&iter);
+
+        iter = array_iter(&array, mode);
+        void ** span;
+        assert(iter_next_span(&iter, buffer, 5, &span) == 5);
+        assert((uintptr_t) span[0] == 1 && (uintptr_t) span[4] == 5);
+        // spans borrow the storage of iterators that have a `next_span` hook
+        assert((span == elements) == (mode == 2));
+        iter_free(&iter);
+
+        iter = array_iter(&array, mode);
+        assert(iter_advance_by(&iter, LEN + 5) == LEN);
+        iter_free(&iter);
+
+        iter = array_iter(&array, mode);
+        iter_advance_by(&iter, 1);
+        array.calls = 0;
+        assert(iter_count(&iter) == LEN - 1);
+        // spans count in one call, batches in one call per batch
+        if (mode == 0) {
+            assert(array.calls == LEN);
+        } else if (mode == 1) {
+            assert(array.calls == (LEN - 1) / ITER_BATCH_SIZE + 2);
+        } else {
+            assert(array.calls == 2);
+        }
+        iter_free(&iter);
+    }
+}
+
+void test_iter_random_access(void) {
+    array_iter_t array;
+    iter_t iter = array_iter(&array, 0);
+    size_t lower;
+    size_t upper;
+    size_t len;
+    // without hooks nothing is known
+    iter_size_hint(&iter, &lower, &upper);
+    assert(lower == 0 && upper == SIZE_MAX);
+    assert(!iter_exact_len(&iter, &len));
+    assert((uintptr_t) iter_nth(&iter, 3) == 4);
+    assert(array.calls == 4);
+    iter_free(&iter);
+
+    iter = array_iter(&array, 0);
+    iter_set_random_access(&iter, array_size_hint, array_advance);
+    assert(iter_exact_len(&iter, &len) && len == LEN);
+    assert(iter_advance_by(&iter, 100) == 100);
+    assert(array.calls == 1);
+    assert((uintptr_t) iter_nth(&iter, 9) == 110);
+    assert(array.calls == 3);
+    assert(iter_exact_len(&iter, &len) && len == LEN - 110);
+    // counting skips the remaining elements in one call
+    array.calls = 0;
+    assert(iter_count(&iter) == LEN - 110);
+    assert(array.calls == 1);
+    assert(iter_next(&iter) == NULL);
+    assert(iter_nth(&iter, 0) == NULL);
+    assert(iter_advance_by(&iter, 5) == 0);
+    iter_free(&iter);
+}
+
+void * double_it(void * elem, void * ctx) {
+    size_t * calls = ctx;
+    *calls += 1;
+    return (void *) ((uintptr_t) elem * 2);
+}
+
+/**
+ * Map the elements below a limit onto themselves plus one, and end the
+ * iteration at the limit.
+ */
+void * stop_at(void * elem, void * ctx) {
+    uintptr_t value = (uintptr_t) elem;
+    return value < *((uintptr_t *) ctx) ? (void *) (value + 1) : NULL;
+}
+
+int is_multiple(void * elem, void * ctx) {
+    return (uintptr_t) elem % *((uintptr_t *) ctx) == 0;
+}
+
+void test_iter_adapters(void) {
+    array_iter_t array;
+    iter_t source = array_iter(&array, 2);
+    iter_set_random_access(&source, array_size_hint, array_advance);
+
+    // map then filter then map fuse into one pipeline
+    size_t calls = 0;
+    uintptr_t three = 3;
+    iter_stages_t first;
+    iter_stages_t second;
+    iter_stages_t third;
+    iter_t mapped = iter_map(&source, double_it, &calls, &first);
+    iter_t filtered = iter_filter(&mapped, is_multiple, &three, &second);
+    iter_t pipeline = iter_map(&filtered, double_it, &calls, &third);
+    assert(pipeline.data == &third);
+    assert(third.len == 3);
+    assert(third.source.data == &array);
+    // 2, 4, 6 -> 6 is the first multiple of 3, mapped to 12
+    assert((uintptr_t) iter_next(&pipeline) == 12);
+    assert(calls == 4);
+    size_t lower;
+    size_t upper;
+    iter_size_hint(&pipeline, &lower, &upper);
+    assert(lower == 0 && upper == LEN - 3);
+    iter_free(&pipeline);
+
+    // filter-only pipelines are batched
+    source = array_iter(&array, 2);
+    filtered = iter_filter(&source, is_multiple, &three, &first);
+    assert(filtered.next_batch != NULL);
+    assert(iter_count(&filtered) == LEN / 3);
+    assert(array.calls < LEN / 3);
+
+    // a map may end the iteration, so even map-only pipelines map the
+    // elements they skip and only keep the upper bound of their source
+    source = array_iter(&array, 2);
+    iter_set_random_access(&source, array_size_hint, array_advance);
+    calls = 0;
+    mapped = iter_map(&source, double_it, &calls, &first);
+    size_t len;
+    assert(!iter_exact_len(&mapped, &len));
+    iter_size_hint(&mapped, &lower, &upper);
+    assert(lower == 0 && upper == LEN);
+    assert(iter_advance_by(&mapped, 10) == 10);
+    assert(calls == 10);
+    assert((uintptr_t) iter_next(&mapped) == 22);
+
+    // a map ending the iteration early stops counting there, for good
+    source = array_iter(&array, 0);
+    iter_set_random_access(&source, array_size_hint, array_advance);
+    uintptr_t stop = 4;
+    mapped = iter_map(&source, stop_at, &stop, &first);
+    assert(iter_count(&mapped) == 3);
+    assert(iter_next(&mapped) == NULL);
+    iter_size_hint(&mapped, &lower, &upper);
+    assert(lower == 0 && upper == 0);
+    source = array_iter(&array, 0);
+    mapped = iter_map(&source, stop_at, &stop, &first);
+    for (uintptr_t i = 2; i <= stop; i++) {
+        assert((uintptr_t) iter_next(&mapped) == i);
+    }
+    assert(iter_next(&mapped) == NULL);
+    // the source still has elements, but the pipeline stays ended
+    assert(iter_next(&mapped) == NULL);
+    assert(iter_advance_by(&mapped, 5) == 0);
+    assert(array.pos < LEN);
+
+    // take and skip
+    source = array_iter(&array, 2);
+    iter_set_random_access(&source, array_size_hint, array_advance);
+    iter_limit_t skip;
+    iter_limit_t take;
+    iter_t skipped = iter_skip(&source, 5, &skip);
+    assert(iter_exact_len(&skipped, &len) && len == LEN - 5);
+    iter_t taken = iter_take(&skipped, 10, &take);
+    assert(iter_exact_len(&taken, &len) && len == 10);
+    assert((uintptr_t) iter_next(&taken) == 6);
+    void ** span;
+    assert(iter_next_span(&taken, NULL, 100, &span) == 9);
+    assert((uintptr_t) span[8] == 15);
+    assert(iter_next(&taken) == NULL);
+    assert(iter_exact_len(&taken, &len) && len == 0);
+
+    // chain and zip
+    array_iter_t left;
+    array_iter_t right;
+    iter_t a = array_iter(&left, 0);
+    iter_t b = array_iter(&right, 1);
+    iter_limit_t take_a;
+    iter_limit_t take_b;
+    a = iter_take(&a, 3, &take_a);
+    b = iter_take(&b, 2, &take_b);
+    iter_chain_t chain;
+    iter_t chained = iter_chain(&a, &b, &chain);
+    assert((uintptr_t) iter_next(&chained) == 1);
+    assert(iter_advance_by(&chained, 3) == 3);
+    assert((uintptr_t) iter_next(&chained) == 2);
+    assert(iter_next(&chained) == NULL);
+
+    a = array_iter(&left, 0);
+    b = array_iter(&right, 1);
+    iter_t c = iter_skip(&b, 1, &skip);
+    iter_t d = iter_take(&c, 4, &take);
+    iter_zip_t zip;
+    iter_t zipped = iter_zip(&a, &d, &zip);
+    assert(iter_advance_by(&zipped, 1) == 1);
+    void ** pair = iter_next(&zipped);
+    assert((uintptr_t) pair[0] == 2 && (uintptr_t) pair[1] == 3);
+    assert(iter_count(&zipped) == 2);
+    iter_free(&zipped);
+}
+
+void test_iter_inline(void) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 8, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    // wrap the ring so the elements sit in two runs
+    for (int i = 0; i < 6; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    for (int i = 0; i < 6; i++) {
+        int value;
+        dequeue_pop_front_into(&dequeue, &value);
+    }
+    for (int i = 0; i < 7; i++) {
+        dequeue_push_back_copy(&dequeue, &i);
+    }
+    dequeue_segment_t segment = dequeue_segment_at(&dequeue, 0);
+    assert(segment.len == 2 && segment.pos == 0);
+    segment = dequeue_segment_next(&dequeue, segment);
+    assert(segment.len == 5 && segment.pos == 2);
+    assert(segment.slots == dequeue.elements);
+    segment = dequeue_segment_next(&dequeue, segment);
+    assert(segment.len == 0);
+
+    int expected = 0;
+    DEQUEUE_FOR_EACH(int, elem, &dequeue) {
+        assert(*elem == expected++);
+    }
+    assert(expected == 7);
+    // break leaves the whole loop, from either run, and continue skips
+    // within it
+    for (int stop = 0; stop < 7; stop++) {
+        int seen = 0;
+        DEQUEUE_FOR_EACH(int, elem, &dequeue) {
+            if (*elem == stop) {
+                break;
+            }
+            seen++;
+        }
+        assert(seen == stop);
+    }
+    int odd = 0;
+    DEQUEUE_FOR_EACH(int, elem, &dequeue) {
+        if (*elem % 2 == 0) {
+            continue;
+        }
+        odd++;
+    }
+    assert(odd == 3);
+    dequeue_cursor_t cursor = dequeue_cursor(&dequeue);
+    for (int i = 0; i < 7; i++) {
+        assert(*((int *) dequeue_cursor_next(&cursor)) == i);
+    }
+    assert(dequeue_cursor_next(&cursor) == NULL);
+    assert(dequeue_cursor_next(&cursor) == NULL);
+    dequeue_free(&dequeue);
+
+    // pointer storage walks the element pointers
+    dequeue_new(&dequeue, sizeof(int));
+    static int values[3] = {4, 5, 6};
+    for (int i = 0; i < 3; i++) {
+        dequeue_push_back(&dequeue, &values[i]);
+    }
+    expected = 4;
+    DEQUEUE_FOR_EACH(void *, slot, &dequeue) {
+        assert(*((int *) *slot) == expected++);
+    }
+    cursor = dequeue_cursor(&dequeue);
+    assert(dequeue_cursor_next(&cursor) == &values[0]);
+    dequeue.len = 0;
+    dequeue_free(&dequeue);
+
+    cursor = dequeue_cursor(&dequeue);
+    assert(dequeue_cursor_next(&cursor) == NULL);
+
+    size_t sum = 0;
+    ITER_RANGE_FOR_EACH(i, 3, 7) {
+        sum += i;
+    }
+    assert(sum == 18);
+    ITER_ARRAY_FOR_EACH(int, value, values, 3) {
+        sum += (size_t) *value;
+    }
+    assert(sum == 33);
+}
+
+int main(void) {
+    test_iter_batch();
+    test_iter_random_access();
+    test_iter_adapters();
+    test_iter_inline();
+    return 0;
+}
@@ -0,0 +1,116 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mpmc.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define THREADS 4
+#define ITEMS_PER_PRODUCER 250000
+
+atomic_uchar seen[THREADS * ITEMS_PER_PRODUCER];
+atomic_size_t popped;
+
+typedef struct producer_arg_t {
+    mpmc_ptr mpmc;
+    uintptr_t first;
+} producer_arg_t;
+
+void test_mpmc_basic(void) {
+    mpmc_t mpmc;
+    assert(mpmc_new(&mpmc, 1, NULL) == MPMC_ERROR_CAPACITY_TOO_SMALL);
+    assert(MPMC_ERROR_IS_OK(mpmc_new(&mpmc, 3, NULL)));
+    assert(mpmc.capacity == 4);
+    void * elem;
+    assert(mpmc_try_pop(&mpmc, &elem) == MPMC_ERROR_EMPTY);
+    for (uintptr_t i = 0; i < 4; i++) {
+        assert(MPMC_ERROR_IS_OK(mpmc_try_push(&mpmc, (void *) (i + 1))));
+    }
+    assert(mpmc_try_push(&mpmc, (void *) 5) == MPMC_ERROR_FULL);
+    assert(mpmc_len(&mpmc) == 4);
+    for (uintptr_t i = 0; i < 100; i++) {
+        assert(MPMC_ERROR_IS_OK(mpmc_try_pop(&mpmc, &elem)));
+        assert((uintptr_t) elem == i + 1);
+        assert(MPMC_ERROR_IS_OK(mpmc_try_push(&mpmc, (void *) (i + 5))));
+    }
+    mpmc_free(&mpmc);
+}
+
+void * stress_producer(void * arg) {
+    producer_arg_t * producer = arg;
+    for (uintptr_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        while (!MPMC_ERROR_IS_OK(mpmc_try_push(producer->mpmc,
+                                               (void *) (producer->first + i)))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void * stress_consumer(void * arg) {
+    mpmc_ptr mpmc = arg;
+    while (atomic_load(&popped) < THREADS * ITEMS_PER_PRODUCER) {
+        void * elem;
+        if (!MPMC_ERROR_IS_OK(mpmc_try_pop(mpmc, &elem))) {
+            sched_yield();
+            continue;
+        }
+        // every item comes out exactly once
+        assert(atomic_fetch_add(&seen[(uintptr_t) elem], 1) == 0);
+        atomic_fetch_add(&popped, 1);
+    }
+    return NULL;
+}
+
+void test_mpmc_stress(void) {
+    mpmc_t mpmc;
+    assert(MPMC_ERROR_IS_OK(mpmc_new(&mpmc, 128, NULL)));
+    pthread_t producers[THREADS];
+    pthread_t consumers[THREADS];
+    producer_arg_t args[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        args[i].mpmc = &mpmc;
+        args[i].first = (uintptr_t) i * ITEMS_PER_PRODUCER;
+        assert(pthread_create(&consumers[i], NULL, stress_consumer, &mpmc) == 0);
+        assert(pthread_create(&producers[i], NULL, stress_producer, &args[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+    }
+    assert(atomic_load(&popped) == THREADS * ITEMS_PER_PRODUCER);
+    for (size_t i = 0; i < THREADS * ITEMS_PER_PRODUCER; i++) {
+        assert(atomic_load(&seen[i]) == 1);
+    }
+    assert(mpmc_len(&mpmc) == 0);
+    mpmc_free(&mpmc);
+}
+
+int main() {
+    test_mpmc_basic();
+    test_mpmc_stress();
+}
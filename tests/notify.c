@@ -0,0 +1,341 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+
+#include "bqueue.h"
+#include "dequeue.h"
+#include "mpmc.h"
+#include "notify.h"
+#include "spsc.h"
+
+#include <assert.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#define ITEMS 200000
+#define PRODUCERS 3
+
+/**
+ * Check whether the descriptor of a notifier is readable, without waiting.
+ */
+static int readable(notify_ptr notify) {
+    struct pollfd fd = {notify_fd(notify), POLLIN, 0};
+    return poll(&fd, 1, 0) == 1 && (fd.revents & POLLIN) != 0;
+}
+
+/**
+ * Wait for the descriptor of a notifier to become readable.
+ */
+static void wait_readable(notify_ptr notify) {
+    struct pollfd fd = {notify_fd(notify), POLLIN, 0};
+    // a lost wakeup would hang here, so give up after a few seconds
+    assert(poll(&fd, 1, 5000) == 1);
+}
+
+void test_notify_basic(void) {
+    assert(notify_new(NULL) == NOTIFY_ERROR_NULL_POINTER_RECEIVED);
+    assert(notify_fd(NULL) == -1);
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    assert(notify_fd(&notify) >= 0);
+    assert(!readable(&notify));
+    assert(NOTIFY_ERROR_IS_OK(notify_signal(&notify)));
+    assert(readable(&notify));
+    assert(NOTIFY_ERROR_IS_OK(notify_signal(&notify)));
+    assert(NOTIFY_ERROR_IS_OK(notify_consume(&notify)));
+    // both signals were folded into a single write
+    assert(!readable(&notify));
+    assert(NOTIFY_ERROR_IS_OK(notify_consume(&notify)));
+    assert(NOTIFY_ERROR_IS_OK(notify_signal(&notify)));
+    assert(readable(&notify));
+    notify_free(&notify);
+}
+
+void test_notify_dequeue(void) {
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(
+            dequeue_new_with_storage(&dequeue, 4, sizeof(int),
+                                     DEQUEUE_STORAGE_INLINE)));
+    assert(dequeue_set_notify(NULL, &notify)
+           == DEQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_set_notify(&dequeue, &notify)));
+    assert(!readable(&notify));
+    int values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back(&dequeue, &values[0])));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    // only the empty to non-empty transition signals
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back(&dequeue, &values[1])));
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front(&dequeue, &values[2])));
+    assert(!readable(&notify));
+    int value;
+    while (DEQUEUE_ERROR_IS_OK(dequeue_pop_front_into(&dequeue, &value))) {
+    }
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front(&dequeue, &values[3])));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    dequeue_empty(&dequeue);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back_n(&dequeue, values, 8)));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    dequeue_empty(&dequeue);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_push_front_n(&dequeue, values, 2)));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    dequeue_empty(&dequeue);
+    dequeue_iter_t state;
+    dequeue_t source;
+    dequeue_new_with_storage(&source, 4, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    dequeue_push_back_n(&source, values, 3);
+    iter_t iter = dequeue_iter(&source, &state);
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_extend(&dequeue, &iter)));
+    assert(dequeue.len == 3);
+    assert(readable(&notify));
+    notify_consume(&notify);
+    // attaching to a dequeue that holds items signals straight away
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_set_notify(&source, &notify)));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    dequeue_set_notify(&dequeue, NULL);
+    dequeue_empty(&dequeue);
+    dequeue_push_back(&dequeue, &values[0]);
+    assert(!readable(&notify));
+    dequeue_free(&source);
+    dequeue_free(&dequeue);
+    notify_free(&notify);
+}
+
+void test_notify_bqueue(void) {
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    bqueue_t bqueue;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_new(&bqueue, 4, sizeof(int), NULL)));
+    assert(BQUEUE_ERROR_IS_OK(bqueue_set_notify(&bqueue, &notify)));
+    int value = 1;
+    assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &value, 0)));
+    assert(readable(&notify));
+    notify_consume(&notify);
+    assert(BQUEUE_ERROR_IS_OK(bqueue_push(&bqueue, &value, 0)));
+    assert(!readable(&notify));
+    assert(BQUEUE_ERROR_IS_OK(bqueue_pop(&bqueue, &value, 0)));
+    assert(BQUEUE_ERROR_IS_OK(bqueue_pop(&bqueue, &value, 0)));
+    // closing wakes the event loop too
+    assert(BQUEUE_ERROR_IS_OK(bqueue_close(&bqueue)));
+    assert(readable(&notify));
+    assert(bqueue_pop(&bqueue, &value, 0) == BQUEUE_ERROR_CLOSED);
+    bqueue_free(&bqueue);
+    notify_free(&notify);
+}
+
+void * spsc_producer(void * arg) {
+    spsc_ptr spsc = arg;
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        while (!SPSC_ERROR_IS_OK(spsc_try_push(spsc, (void *) i))) {
+            sched_yield();
+        }
+        // pause now and then so that the consumer catches up and waits
+        if (i % 1000 == 0) {
+            struct timespec delay = {0, 100000};
+            nanosleep(&delay, NULL);
+        }
+    }
+    return NULL;
+}
+
+void test_notify_spsc(void) {
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    spsc_t spsc;
+    assert(SPSC_ERROR_IS_OK(spsc_new(&spsc, 64, NULL)));
+    assert(SPSC_ERROR_IS_OK(spsc_set_notify(&spsc, &notify)));
+    pthread_t producer;
+    assert(pthread_create(&producer, NULL, spsc_producer, &spsc) == 0);
+    uintptr_t expected = 1;
+    size_t wakeups = 0;
+    while (expected <= ITEMS) {
+        wait_readable(&notify);
+        wakeups++;
+        notify_consume(&notify);
+        void * elem;
+        while (SPSC_ERROR_IS_OK(spsc_try_pop(&spsc, &elem))) {
+            assert((uintptr_t) elem == expected);
+            expected++;
+        }
+    }
+    pthread_join(producer, NULL);
+    // signals are coalesced rather than made for every push
+    assert(wakeups < ITEMS);
+    spsc_free(&spsc);
+    notify_free(&notify);
+}
+
+typedef struct producer_arg_t {
+    mpmc_ptr mpmc;
+    uintptr_t first;
+} producer_arg_t;
+
+void * mpmc_producer(void * arg) {
+    producer_arg_t * producer = arg;
+    for (uintptr_t i = 0; i < ITEMS; i++) {
+        void * elem = (void *) (producer->first + i);
+        while (!MPMC_ERROR_IS_OK(mpmc_try_push(producer->mpmc, elem))) {
+            sched_yield();
+        }
+        if (i % 1000 == 0) {
+            struct timespec delay = {0, 100000};
+            nanosleep(&delay, NULL);
+        }
+    }
+    return NULL;
+}
+
+void test_notify_mpmc(void) {
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    mpmc_t mpmc;
+    assert(MPMC_ERROR_IS_OK(mpmc_new(&mpmc, 64, NULL)));
+    assert(MPMC_ERROR_IS_OK(mpmc_set_notify(&mpmc, &notify)));
+#ifdef __linux__
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    assert(epoll >= 0);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = &mpmc};
+    assert(epoll_ctl(epoll, EPOLL_CTL_ADD, notify_fd(&notify), &event) == 0);
+#endif
+    pthread_t producers[PRODUCERS];
+    producer_arg_t args[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        args[i].mpmc = &mpmc;
+        args[i].first = (uintptr_t) i * ITEMS;
+        assert(pthread_create(&producers[i], NULL, mpmc_producer,
+                              &args[i]) == 0);
+    }
+    uintptr_t next[PRODUCERS] = {0};
+    size_t popped = 0;
+    while (popped < PRODUCERS * ITEMS) {
+#ifdef __linux__
+        struct epoll_event ready;
+        // a lost wakeup would hang here, so give up after a few seconds
+        assert(epoll_wait(epoll, &ready, 1, 5000) == 1);
+        assert(ready.data.ptr == &mpmc);
+#else
+        wait_readable(&notify);
+#endif
+        notify_consume(&notify);
+        void * elem;
+        while (MPMC_ERROR_IS_OK(mpmc_try_pop(&mpmc, &elem))) {
+            // each producer's items come out in order
+            uintptr_t value = (uintptr_t) elem;
+            assert(value % ITEMS == next[value / ITEMS]);
+            next[value / ITEMS]++;
+            popped++;
+        }
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+#ifdef __linux__
+    close(epoll);
+#endif
+    mpmc_free(&mpmc);
+    notify_free(&notify);
+}
+
+/**
+ * The number of rounds of signals racing with a consume.
+ */
+#define RACE_ROUNDS 20000
+
+typedef struct race_arg_t {
+    notify_ptr notify;
+    // the round the consumer started
+    atomic_int started;
+    // the last round the signaller finished
+    atomic_int finished;
+} race_arg_t;
+
+void * race_signaller(void * arg) {
+    race_arg_t * race = arg;
+    for (int round = 1; round <= RACE_ROUNDS; round++) {
+        while (atomic_load(&race->started) < round) {
+            sched_yield();
+        }
+        // a few signals spread over the consume, past its drain and its reset
+        for (int i = 0; i < round % 8; i++) {
+            notify_signal(race->notify);
+            for (volatile int spin = 0; spin < (round % 5) * 50; spin++) {
+            }
+        }
+        atomic_store(&race->finished, round);
+    }
+    return NULL;
+}
+
+void test_notify_consume_race(void) {
+    // a signal landing while the consumer resets the notifier must leave it
+    // either readable or ready to signal again, never set with nothing to
+    // read, which would silence every later signal
+    race_arg_t race;
+    notify_t notify;
+    assert(NOTIFY_ERROR_IS_OK(notify_new(&notify)));
+    race.notify = &notify;
+    atomic_init(&race.started, 0);
+    atomic_init(&race.finished, 0);
+    pthread_t signaller;
+    assert(pthread_create(&signaller, NULL, race_signaller, &race) == 0);
+    for (int round = 1; round <= RACE_ROUNDS; round++) {
+        atomic_store(&race.started, round);
+        notify_consume(&notify);
+        while (atomic_load(&race.finished) < round) {
+            sched_yield();
+        }
+        assert(!atomic_load(&notify.pending) || readable(&notify));
+        notify_consume(&notify);
+        assert(!readable(&notify));
+        notify_signal(&notify);
+        assert(readable(&notify));
+        notify_consume(&notify);
+    }
+    pthread_join(signaller, NULL);
+    notify_free(&notify);
+}
+
+int main() {
+    test_notify_basic();
+    test_notify_consume_race();
+    test_notify_dequeue();
+    test_notify_bqueue();
+    test_notify_spsc();
+    test_notify_mpmc();
+}
@@ -0,0 +1,189 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "par.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#define RANGE 1000000
+
+static void sum_reduce(void * acc, const void * value, void * ctx) {
+    (void) ctx;
+    *((uint64_t *) acc) += *((const size_t *) value);
+}
+
+static void sum_combine(void * acc, const void * other, void * ctx) {
+    (void) ctx;
+    *((uint64_t *) acc) += *((const uint64_t *) other);
+}
+
+static void square(void * out, const void * elem, void * ctx) {
+    (void) ctx;
+    size_t value = *((const size_t *) elem);
+    *((size_t *) out) = value * value;
+}
+
+static int is_multiple(const void * elem, void * ctx) {
+    return *((const size_t *) elem) % *((size_t *) ctx) == 0;
+}
+
+static void append(void * acc, const void * value, void * ctx) {
+    (void) ctx;
+    // keeps the first and last value seen, to check chunk ordering
+    size_t * bounds = acc;
+    size_t v = *((const size_t *) value);
+    if (bounds[0] == SIZE_MAX) {
+        bounds[0] = v;
+    }
+    assert(bounds[1] == SIZE_MAX || bounds[1] + 1 == v);
+    bounds[1] = v;
+}
+
+static void join_bounds(void * acc, const void * other, void * ctx) {
+    (void) ctx;
+    size_t * bounds = acc;
+    const size_t * next = other;
+    if (next[0] == SIZE_MAX) {
+        return;
+    }
+    if (bounds[0] == SIZE_MAX) {
+        bounds[0] = next[0];
+    } else {
+        assert(bounds[1] + 1 == next[0]);
+    }
+    bounds[1] = next[1];
+}
+
+void test_par_iter_split(void) {
+    par_iter_t iter = par_iter_range(10, 20);
+    assert(iter.len == 10);
+    par_iter_t left;
+    par_iter_t right;
+    assert(PAR_ERROR_IS_OK(par_iter_split(&iter, 3, &left, &right)));
+    assert(left.offset == 10 && left.len == 3);
+    assert(right.offset == 13 && right.len == 7);
+    assert(par_iter_split(&iter, 3, NULL, &right)
+           == PAR_ERROR_NULL_POINTER_RECEIVED);
+    // splitting past the end leaves the right half empty
+    assert(PAR_ERROR_IS_OK(par_iter_split(&iter, 50, &left, &right)));
+    assert(left.len == 10 && right.len == 0);
+    assert(par_iter_range(5, 5).len == 0);
+    assert(par_iter_range(6, 5).len == 0);
+}
+
+void test_par_reduce(void) {
+    threadpool_t pool;
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_new(&pool, 4, NULL)));
+    uint64_t zero = 0;
+    uint64_t sum;
+    par_iter_t iter = par_iter_range(0, RANGE);
+    par_ops_t ops = {
+        .reduce = sum_reduce,
+        .combine = sum_combine,
+        .identity = &zero,
+        .acc_size = sizeof(uint64_t),
+    };
+    assert(PAR_ERROR_IS_OK(par_reduce(&pool, &iter, &ops, NULL, &sum)));
+    assert(sum == (uint64_t) RANGE * (RANGE - 1) / 2);
+
+    // sum of the squares of the multiples of 3
+    size_t three = 3;
+    ops.filter = is_multiple;
+    ops.map = square;
+    ops.mapped_size = sizeof(size_t);
+    iter = par_iter_range(0, 3000);
+    assert(PAR_ERROR_IS_OK(par_reduce(&pool, &iter, &ops, &three, &sum)));
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < 3000; i += 3) {
+        expected += i * i;
+    }
+    assert(sum == expected);
+
+    // chunks are combined in input order
+    size_t none[2] = {SIZE_MAX, SIZE_MAX};
+    size_t bounds[2];
+    par_ops_t order = {
+        .reduce = append,
+        .combine = join_bounds,
+        .identity = none,
+        .acc_size = sizeof(none),
+        .grain = 7,
+    };
+    iter = par_iter_range(100, 100000);
+    assert(PAR_ERROR_IS_OK(par_reduce(&pool, &iter, &order, NULL, bounds)));
+    assert(bounds[0] == 100 && bounds[1] == 99999);
+
+    // an empty input gives the identity
+    iter = par_iter_range(0, 0);
+    sum = 42;
+    ops.filter = NULL;
+    assert(PAR_ERROR_IS_OK(par_reduce(&pool, &iter, &ops, NULL, &sum)));
+    assert(sum == 0);
+
+    ops.combine = NULL;
+    assert(par_reduce(&pool, &iter, &ops, NULL, &sum)
+           == PAR_ERROR_INVALID_OPS);
+    assert(par_reduce(&pool, &iter, NULL, NULL, &sum)
+           == PAR_ERROR_NULL_POINTER_RECEIVED);
+    threadpool_free(&pool);
+}
+
+void test_par_count_dequeue(void) {
+    threadpool_t pool;
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_new(&pool, 3, NULL)));
+    dequeue_t dequeue;
+    assert(DEQUEUE_ERROR_IS_OK(dequeue_new_with_storage(&dequeue,
+                                                        0,
+                                                        sizeof(size_t),
+                                                        DEQUEUE_STORAGE_INLINE)));
+    // wrap the ring around so chunks cross its end
+    for (size_t i = 0; i < 50000; i++) {
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back(&dequeue, &i)));
+    }
+    for (size_t i = 0; i < 10000; i++) {
+        size_t value;
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_pop_front_into(&dequeue, &value)));
+        size_t pushed = value + 50000;
+        assert(DEQUEUE_ERROR_IS_OK(dequeue_push_back(&dequeue, &pushed)));
+    }
+    par_iter_t iter = par_iter_dequeue(&dequeue);
+    assert(iter.len == 50000);
+    size_t count;
+    assert(PAR_ERROR_IS_OK(par_count(&pool, &iter, NULL, NULL, &count)));
+    assert(count == 50000);
+    size_t seven = 7;
+    assert(PAR_ERROR_IS_OK(par_count(&pool, &iter, is_multiple, &seven,
+                                     &count)));
+    // multiples of 7 in [10000, 60000)
+    assert(count == 59999 / 7 - 9999 / 7);
+    dequeue_free(&dequeue);
+    threadpool_free(&pool);
+}
+
+int main(void) {
+    test_par_iter_split();
+    test_par_reduce();
+    test_par_count_dequeue();
+    return 0;
+}
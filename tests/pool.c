@@ -0,0 +1,87 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pool.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+void test_pool_alloc(void) {
+    pool_t pool;
+    assert(POOL_ERROR_IS_OK(pool_new(&pool, 24, NULL)));
+    assert(pool.object_size >= 24);
+    assert(pool.slabs == NULL);
+
+    void * objects[1000];
+    for (int i = 0; i < 1000; i++) {
+        objects[i] = pool_alloc(&pool);
+        assert(objects[i] != NULL);
+        assert(((uintptr_t) objects[i]) % sizeof(void *) == 0);
+        memset(objects[i], i & 0xff, 24);
+    }
+    for (int i = 0; i < 1000; i++) {
+        for (int j = 0; j < 24; j++) {
+            assert(((unsigned char *) objects[i])[j] == (i & 0xff));
+        }
+    }
+
+    // freed objects are recycled in LIFO order
+    pool_dealloc(&pool, objects[10]);
+    pool_dealloc(&pool, objects[20]);
+    assert(pool_alloc(&pool) == objects[20]);
+    assert(pool_alloc(&pool) == objects[10]);
+
+    assert(POOL_ERROR_IS_OK(pool_free(&pool)));
+    assert(pool.slabs == NULL);
+}
+
+void test_pool_large_objects(void) {
+    pool_t pool;
+    assert(POOL_ERROR_IS_OK(pool_new(&pool, 10000, NULL)));
+    assert(pool.slab_size >= 10000 * POOL_MIN_OBJECTS_PER_SLAB);
+    void * a = pool_alloc(&pool);
+    void * b = pool_alloc(&pool);
+    assert(a != NULL && b != NULL && a != b);
+    memset(a, 1, 10000);
+    memset(b, 2, 10000);
+    pool_free(&pool);
+}
+
+void test_pool_allocator(void) {
+    pool_t pool;
+    assert(POOL_ERROR_IS_OK(pool_new(&pool, sizeof(double), NULL)));
+    allocator_t allocator = pool_allocator(&pool);
+    double * value = allocator_alloc(&allocator, sizeof(double));
+    assert(value != NULL);
+    assert(allocator_alloc(&allocator, pool.object_size + 1) == NULL);
+    allocator_free(&allocator, value, sizeof(double));
+    assert(allocator_alloc(&allocator, sizeof(double)) == value);
+    pool_free(&pool);
+}
+
+int main() {
+    test_pool_alloc();
+    test_pool_large_objects();
+    test_pool_allocator();
+}
@@ -0,0 +1,211 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pqueue.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#define LEN 2000
+
+typedef struct deadline_t {
+    uint64_t deadline;
+    int id;
+} deadline_t;
+
+int compare_int(const void * a, const void * b) {
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+int compare_deadline(const void * a, const void * b) {
+    uint64_t x = ((const deadline_t *) a)->deadline;
+    uint64_t y = ((const deadline_t *) b)->deadline;
+    return (x > y) - (x < y);
+}
+
+int next_value(uint32_t * state) {
+    *state = *state * 1103515245u + 12345u;
+    return (int) (*state >> 8) % 1000;
+}
+
+/**
+ * Pop every element and check that they come out in order.
+ */
+void drain_sorted(pqueue_ptr pqueue, size_t expected_len) {
+    assert(pqueue_len(pqueue) == expected_len);
+    int prev = -1;
+    for (size_t i = 0; i < expected_len; i++) {
+        int value;
+        assert(*(int *) pqueue_peek(pqueue) >= prev);
+        assert(PQUEUE_ERROR_IS_OK(pqueue_pop(pqueue, &value)));
+        assert(value >= prev);
+        prev = value;
+    }
+    assert(pqueue_peek(pqueue) == NULL);
+    assert(pqueue_pop(pqueue, NULL) == PQUEUE_ERROR_EMPTY);
+}
+
+void test_pqueue_order(void) {
+    size_t arities[] = {2, 3, 4, 8};
+    for (size_t a = 0; a < 4; a++) {
+        pqueue_t pqueue;
+        assert(PQUEUE_ERROR_IS_OK(pqueue_new(&pqueue,
+                                             sizeof(int),
+                                             arities[a],
+                                             compare_int)));
+        uint32_t state = 7;
+        for (size_t i = 0; i < LEN; i++) {
+            int value = next_value(&state);
+            assert(PQUEUE_ERROR_IS_OK(pqueue_push(&pqueue, &value, NULL)));
+        }
+        drain_sorted(&pqueue, LEN);
+
+        // interleave pushes and pops
+        for (size_t i = 0; i < LEN; i++) {
+            int value = next_value(&state);
+            pqueue_push(&pqueue, &value, NULL);
+            if (i % 3 == 0) {
+                pqueue_pop(&pqueue, NULL);
+            }
+        }
+        drain_sorted(&pqueue, LEN - (LEN + 2) / 3);
+        pqueue_free(&pqueue);
+    }
+}
+
+void test_pqueue_handles(void) {
+    pqueue_t pqueue;
+    pqueue_new(&pqueue, sizeof(deadline_t), PQUEUE_BINARY_ARITY,
+               compare_deadline);
+    pqueue_handle_t handles[100];
+    for (int i = 0; i < 100; i++) {
+        deadline_t timer = {(uint64_t) (1000 + (i * 37) % 100), i};
+        assert(PQUEUE_ERROR_IS_OK(pqueue_push(&pqueue, &timer, &handles[i])));
+    }
+    for (int i = 0; i < 100; i++) {
+        assert(((deadline_t *) pqueue_get(&pqueue, handles[i]))->id == i);
+    }
+
+    // bring timer 50 forward: it becomes the next to expire
+    deadline_t sooner = {10, 50};
+    assert(PQUEUE_ERROR_IS_OK(pqueue_decrease_key(&pqueue, handles[50],
+                                                  &sooner)));
+    assert(((deadline_t *) pqueue_peek(&pqueue))->id == 50);
+    deadline_t later = {5000, 50};
+    assert(pqueue_decrease_key(&pqueue, handles[50], &later)
+           == PQUEUE_ERROR_KEY_INCREASED);
+    assert(((deadline_t *) pqueue_peek(&pqueue))->deadline == 10);
+
+    // cancel every even timer
+    for (int i = 0; i < 100; i += 2) {
+        deadline_t removed;
+        assert(PQUEUE_ERROR_IS_OK(pqueue_remove(&pqueue, handles[i],
+                                                &removed)));
+        assert(removed.id == i);
+        assert(pqueue_get(&pqueue, handles[i]) == NULL);
+        assert(pqueue_remove(&pqueue, handles[i], NULL)
+               == PQUEUE_ERROR_INVALID_HANDLE);
+    }
+    assert(pqueue_len(&pqueue) == 50);
+    for (int i = 1; i < 100; i += 2) {
+        assert(((deadline_t *) pqueue_get(&pqueue, handles[i]))->id == i);
+    }
+
+    // freed handles are reused, and stay consistent with the rest
+    pqueue_handle_t reused;
+    deadline_t timer = {1, 100};
+    pqueue_push(&pqueue, &timer, &reused);
+    assert(reused < 100 && reused % 2 == 0);
+    assert(((deadline_t *) pqueue_get(&pqueue, reused))->id == 100);
+    assert(pqueue_get(&pqueue, 1000) == NULL);
+
+    uint64_t prev = 0;
+    while (pqueue_len(&pqueue) > 0) {
+        deadline_t next;
+        pqueue_pop(&pqueue, &next);
+        assert(next.deadline >= prev);
+        prev = next.deadline;
+    }
+    pqueue_free(&pqueue);
+}
+
+void test_pqueue_from_dequeue(void) {
+    dequeue_t dequeue;
+    dequeue_new_with_storage(&dequeue, 16, sizeof(int),
+                             DEQUEUE_STORAGE_INLINE);
+    uint32_t state = 3;
+    int values[LEN];
+    for (size_t i = 0; i < LEN; i++) {
+        values[i] = next_value(&state);
+        // push at the front too, so that the ring is wrapped
+        if (i % 2 == 0) {
+            dequeue_push_back_copy(&dequeue, &values[i]);
+        } else {
+            dequeue_push_front_copy(&dequeue, &values[i]);
+        }
+    }
+    int third = *(int *) dequeue_get(&dequeue, 3);
+    pqueue_t pqueue;
+    assert(PQUEUE_ERROR_IS_OK(pqueue_from_dequeue(&pqueue, &dequeue, 4,
+                                                  compare_int)));
+    // handles are the positions in the dequeue
+    assert(*(int *) pqueue_get(&pqueue, 3) == third);
+    drain_sorted(&pqueue, LEN);
+    pqueue_free(&pqueue);
+
+    dequeue_new(&dequeue, sizeof(int));
+    assert(pqueue_from_dequeue(&pqueue, &dequeue, 4, compare_int)
+           == PQUEUE_ERROR_ELEMENT_MISMATCH);
+    dequeue_free(&dequeue);
+
+    dequeue_new_with_storage(&dequeue, 1, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    assert(PQUEUE_ERROR_IS_OK(pqueue_from_dequeue(&pqueue, &dequeue, 2,
+                                                  compare_int)));
+    drain_sorted(&pqueue, 0);
+    pqueue_free(&pqueue);
+}
+
+void test_pqueue_errors(void) {
+    pqueue_t pqueue;
+    assert(pqueue_new(&pqueue, sizeof(int), 1, compare_int)
+           == PQUEUE_ERROR_INVALID_ARITY);
+    assert(pqueue_new(&pqueue, sizeof(int), 2, NULL)
+           == PQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(pqueue_new(NULL, sizeof(int), 2, compare_int)
+           == PQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    pqueue_new(&pqueue, sizeof(int), 2, compare_int);
+    assert(pqueue_push(&pqueue, NULL, NULL)
+           == PQUEUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(pqueue_decrease_key(&pqueue, 0, &pqueue)
+           == PQUEUE_ERROR_INVALID_HANDLE);
+    pqueue_free(&pqueue);
+}
+
+int main() {
+    test_pqueue_order();
+    test_pqueue_handles();
+    test_pqueue_from_dequeue();
+    test_pqueue_errors();
+}
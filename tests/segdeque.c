@@ -0,0 +1,195 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "dequeue.h"
+#include "segdeque.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+void test_segdeque_model(void) {
+    // small blocks put every operation near a block boundary
+    segdeque_t segdeque;
+    assert(SEGDEQUE_ERROR_IS_OK(segdeque_new_with_block_len(&segdeque,
+                                                            sizeof(int),
+                                                            4,
+                                                            NULL)));
+    dequeue_t model;
+    dequeue_new_with_storage(&model, 1, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    uint32_t state = 99;
+    for (int i = 0; i < 20000; i++) {
+        state = state * 1103515245u + 12345u;
+        uint32_t op = (state >> 16) % 100;
+        // drift between growing and draining phases
+        int growing = (i / 2000) % 2 == 0;
+        if (op < (growing ? 35u : 15u)) {
+            assert(SEGDEQUE_ERROR_IS_OK(segdeque_push_back(&segdeque, &i)));
+            dequeue_push_back_copy(&model, &i);
+        } else if (op < (growing ? 70u : 30u)) {
+            assert(SEGDEQUE_ERROR_IS_OK(segdeque_push_front(&segdeque, &i)));
+            dequeue_push_front_copy(&model, &i);
+        } else if (op < 85) {
+            int got;
+            int expected;
+            segdeque_error_t err = segdeque_pop_front(&segdeque, &got);
+            if (model.len == 0) {
+                assert(err == SEGDEQUE_ERROR_EMPTY);
+            } else {
+                dequeue_pop_front_into(&model, &expected);
+                assert(SEGDEQUE_ERROR_IS_OK(err) && got == expected);
+            }
+        } else {
+            int got;
+            int expected;
+            segdeque_error_t err = segdeque_pop_back(&segdeque, &got);
+            if (model.len == 0) {
+                assert(err == SEGDEQUE_ERROR_EMPTY);
+            } else {
+                dequeue_pop_back_into(&model, &expected);
+                assert(SEGDEQUE_ERROR_IS_OK(err) && got == expected);
+            }
+        }
+        assert(segdeque.len == model.len);
+        // the blocks in use cover the elements exactly
+        assert(segdeque.block_count
+               == (segdeque.head + segdeque.len + segdeque.block_len - 1)
+                  / segdeque.block_len);
+        if (i % 97 == 0) {
+            for (size_t pos = 0; pos < model.len; pos++) {
+                assert(*(int *) segdeque_get(&segdeque, pos)
+                       == *(int *) dequeue_get(&model, pos));
+            }
+        }
+    }
+    dequeue_free(&model);
+    segdeque_free(&segdeque);
+}
+
+void test_segdeque_stable_addresses(void) {
+    segdeque_t segdeque;
+    segdeque_new(&segdeque, sizeof(uint64_t));
+    assert(segdeque.block_len * sizeof(uint64_t)
+           == SEGDEQUE_DEFAULT_BLOCK_SIZE);
+    uint64_t first = 42;
+    segdeque_push_back(&segdeque, &first);
+    uint64_t * front = segdeque_front(&segdeque);
+    for (uint64_t i = 0; i < 100000; i++) {
+        segdeque_push_back(&segdeque, &i);
+        segdeque_push_front(&segdeque, &i);
+    }
+    // neither end growing moved the element
+    assert(segdeque_get(&segdeque, 100000) == front);
+    assert(*front == 42);
+    assert(*(uint64_t *) segdeque_back(&segdeque) == 99999);
+
+    // draining releases the blocks one by one
+    size_t blocks = segdeque.block_count;
+    for (size_t i = 0; i < 100000; i++) {
+        segdeque_pop_front(&segdeque, NULL);
+    }
+    assert(segdeque_front(&segdeque) == front);
+    assert(segdeque.block_count < blocks / 2 + 2);
+    while (segdeque.len > 0) {
+        segdeque_pop_back(&segdeque, NULL);
+    }
+    assert(segdeque.block_count == 0);
+    assert(segdeque.spare != NULL);
+    assert(segdeque_front(&segdeque) == NULL);
+    segdeque_shrink_to_fit(&segdeque);
+    assert(segdeque.spare == NULL);
+    segdeque_free(&segdeque);
+}
+
+void test_segdeque_queue(void) {
+    // a FIFO that only moves forward recenters its map instead of growing it
+    segdeque_t segdeque;
+    segdeque_new_with_block_len(&segdeque, sizeof(int), 2, NULL);
+    for (int i = 0; i < 8; i++) {
+        segdeque_push_back(&segdeque, &i);
+    }
+    size_t map_capacity = 0;
+    for (int i = 8; i < 100000; i++) {
+        int value;
+        segdeque_push_back(&segdeque, &i);
+        segdeque_pop_front(&segdeque, &value);
+        assert(value == i - 8);
+        if (i == 1000) {
+            map_capacity = segdeque.map_capacity;
+        }
+    }
+    assert(segdeque.map_capacity == map_capacity);
+    segdeque_free(&segdeque);
+}
+
+void test_segdeque_iter(void) {
+    segdeque_t segdeque;
+    segdeque_new_with_block_len(&segdeque, sizeof(int), 8, NULL);
+    for (int i = 0; i < 100; i++) {
+        segdeque_push_back(&segdeque, &i);
+    }
+    for (int i = -1; i >= -5; i--) {
+        segdeque_push_front(&segdeque, &i);
+    }
+    segdeque_iter_t state;
+    iter_t iter = segdeque_iter(&segdeque, &state);
+    size_t exact;
+    assert(iter_exact_len(&iter, &exact) && exact == 105);
+    assert(*(int *) iter_next(&iter) == -5);
+    assert(*(int *) iter_next_back(&iter) == 99);
+    void * batch[ITER_BATCH_SIZE];
+    size_t len = iter_next_batch(&iter, batch, ITER_BATCH_SIZE);
+    assert(len == ITER_BATCH_SIZE);
+    for (size_t i = 0; i < len; i++) {
+        assert(*(int *) batch[i] == (int) i - 4);
+    }
+    assert(iter_advance_by(&iter, 30) == 30);
+    assert(*(int *) iter_next(&iter) == 90);
+    assert(iter_count(&iter) == 8);
+    iter_free(&iter);
+    segdeque_free(&segdeque);
+}
+
+void test_segdeque_errors(void) {
+    segdeque_t segdeque;
+    assert(segdeque_new_with_block_len(&segdeque, sizeof(int), 3, NULL)
+           == SEGDEQUE_ERROR_INVALID_BLOCK_LEN);
+    assert(segdeque_new_with_block_len(&segdeque, sizeof(int), 0, NULL)
+           == SEGDEQUE_ERROR_INVALID_BLOCK_LEN);
+    assert(segdeque_new(NULL, sizeof(int))
+           == SEGDEQUE_ERROR_NULL_POINTER_RECEIVED);
+    segdeque_new(&segdeque, sizeof(int));
+    assert(segdeque_pop_front(&segdeque, NULL) == SEGDEQUE_ERROR_EMPTY);
+    assert(segdeque_pop_back(&segdeque, NULL) == SEGDEQUE_ERROR_EMPTY);
+    assert(segdeque_push_back(&segdeque, NULL)
+           == SEGDEQUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(segdeque_get(&segdeque, 0) == NULL);
+    segdeque_free(&segdeque);
+}
+
+int main() {
+    test_segdeque_model();
+    test_segdeque_stable_addresses();
+    test_segdeque_queue();
+    test_segdeque_iter();
+    test_segdeque_errors();
+}
@@ -0,0 +1,175 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "simd.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Largest array length checked, enough to leave every possible tail behind
+ * the widest vectors.
+ */
+#define LEN 300
+
+static int32_t i32s[LEN];
+static int64_t i64s[LEN];
+static float f32s[LEN];
+static double f64s[LEN];
+static uint8_t bytes[LEN];
+
+/**
+ * Fill the arrays with small pseudo-random values, so that float sums are
+ * exact in any order.
+ */
+void fill(void) {
+    uint32_t state = 12345;
+    for (size_t i = 0; i < LEN; i++) {
+        state = state * 1103515245u + 12345u;
+        int32_t value = (int32_t) (state >> 16) % 201 - 100;
+        i32s[i] = value;
+        i64s[i] = (int64_t) value * 10000000000LL;
+        f32s[i] = (float) value;
+        f64s[i] = (double) value;
+        bytes[i] = (uint8_t) (value & 0x7f);
+    }
+}
+
+void test_simd_sum(size_t n) {
+    int64_t sum_i32 = 0;
+    int64_t sum_i64 = 0;
+    double sum_f = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sum_i32 += i32s[i];
+        sum_i64 += i64s[i];
+        sum_f += f64s[i];
+    }
+    assert(simd_sum_i32(i32s, n) == sum_i32);
+    assert(simd_sum_i64(i64s, n) == sum_i64);
+    assert(simd_sum_f32(f32s, n) == (float) sum_f);
+    assert(simd_sum_f64(f64s, n) == sum_f);
+}
+
+void test_simd_min_max(size_t n) {
+    int32_t min_i32;
+    int32_t max_i32;
+    int64_t min_i64;
+    int64_t max_i64;
+    float min_f32;
+    float max_f32;
+    double min_f64;
+    double max_f64;
+    int found = n != 0;
+    assert(simd_min_max_i32(i32s, n, &min_i32, &max_i32) == found);
+    assert(simd_min_max_i64(i64s, n, &min_i64, &max_i64) == found);
+    assert(simd_min_max_f32(f32s, n, &min_f32, &max_f32) == found);
+    assert(simd_min_max_f64(f64s, n, &min_f64, &max_f64) == found);
+    if (!found) {
+        return;
+    }
+    int32_t min = i32s[0];
+    int32_t max = i32s[0];
+    for (size_t i = 1; i < n; i++) {
+        min = i32s[i] < min ? i32s[i] : min;
+        max = i32s[i] > max ? i32s[i] : max;
+    }
+    assert(min_i32 == min && max_i32 == max);
+    assert(min_i64 == (int64_t) min * 10000000000LL);
+    assert(max_i64 == (int64_t) max * 10000000000LL);
+    assert(min_f32 == (float) min && max_f32 == (float) max);
+    assert(min_f64 == (double) min && max_f64 == (double) max);
+}
+
+void test_simd_count_find(size_t n) {
+    for (int32_t value = -100; value <= 100; value += 7) {
+        size_t count = 0;
+        size_t first = n;
+        for (size_t i = 0; i < n; i++) {
+            if (i32s[i] == value) {
+                count += 1;
+                first = first == n ? i : first;
+            }
+        }
+        int64_t wide = (int64_t) value * 10000000000LL;
+        assert(simd_count_eq_i32(i32s, n, value) == count);
+        assert(simd_count_eq_i64(i64s, n, wide) == count);
+        assert(simd_count_eq_f32(f32s, n, (float) value) == count);
+        assert(simd_count_eq_f64(f64s, n, (double) value) == count);
+        assert(simd_find_i32(i32s, n, value) == first);
+        assert(simd_find_i64(i64s, n, wide) == first);
+        assert(simd_find_f32(f32s, n, (float) value) == first);
+        assert(simd_find_f64(f64s, n, (double) value) == first);
+    }
+    // only the low halves of these int64_t values match
+    assert(simd_count_eq_i64(i64s, n, 0x100000000LL) == 0);
+    assert(simd_find_i64(i64s, n, 0x100000000LL) == n);
+}
+
+void test_simd_find_byte(size_t n) {
+    for (int byte = 0; byte < 256; byte += 5) {
+        const uint8_t * hit = n == 0 ? NULL : memchr(bytes, byte, n);
+        size_t expected = hit == NULL ? n : (size_t) (hit - bytes);
+        assert(simd_find_byte(bytes, n, (uint8_t) byte) == expected);
+    }
+}
+
+void test_simd_unaligned(void) {
+    // every kernel must accept arrays that do not start on a vector boundary
+    for (size_t offset = 1; offset < 8; offset++) {
+        size_t n = LEN - offset;
+        int64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += i32s[offset + i];
+        }
+        assert(simd_sum_i32(i32s + offset, n) == sum);
+        assert(simd_find_i32(i32s + offset, n, i32s[LEN - 1]) <= n - 1);
+        assert(simd_find_byte(bytes + offset, n, bytes[LEN - 1]) <= n - 1);
+    }
+}
+
+void test_simd_levels(void) {
+    simd_level_t supported = simd_detect();
+    // the best level is picked by default
+    assert(simd_level() == supported);
+    for (int level = SIMD_LEVEL_SCALAR; level <= SIMD_LEVEL_AVX512; level++) {
+        simd_level_t set = simd_set_level((simd_level_t) level);
+        assert(set == ((simd_level_t) level > supported
+                       ? supported
+                       : (simd_level_t) level));
+        assert(simd_level() == set);
+        for (size_t n = 0; n <= LEN; n += n < 80 ? 1 : 37) {
+            test_simd_sum(n);
+            test_simd_min_max(n);
+            test_simd_count_find(n);
+            test_simd_find_byte(n);
+        }
+        test_simd_unaligned();
+    }
+    simd_set_level(supported);
+}
+
+int main(void) {
+    fill();
+    test_simd_levels();
+}
@@ -0,0 +1,192 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "dequeue.h"
+#include "spilldeque.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+
+void test_spilldeque_model(void) {
+    // small blocks and the smallest budget spill on nearly every block
+    spilldeque_t spilldeque;
+    assert(SPILLDEQUE_ERROR_IS_OK(
+            spilldeque_new_with_block_len(&spilldeque,
+                                          sizeof(int),
+                                          4,
+                                          3 * 4 * sizeof(int),
+                                          NULL,
+                                          NULL)));
+    dequeue_t model;
+    dequeue_new_with_storage(&model, 1, sizeof(int), DEQUEUE_STORAGE_INLINE);
+    uint32_t state = 7;
+    size_t max_spilled = 0;
+    for (int i = 0; i < 20000; i++) {
+        state = state * 1103515245u + 12345u;
+        uint32_t op = (state >> 16) % 100;
+        // drift between growing and draining phases
+        int growing = (i / 2000) % 2 == 0;
+        if (op < (growing ? 35u : 15u)) {
+            assert(SPILLDEQUE_ERROR_IS_OK(
+                    spilldeque_push_back(&spilldeque, &i)));
+            dequeue_push_back_copy(&model, &i);
+        } else if (op < (growing ? 70u : 30u)) {
+            assert(SPILLDEQUE_ERROR_IS_OK(
+                    spilldeque_push_front(&spilldeque, &i)));
+            dequeue_push_front_copy(&model, &i);
+        } else if (op < 85) {
+            int got;
+            int expected;
+            spilldeque_error_t err = spilldeque_pop_front(&spilldeque, &got);
+            if (model.len == 0) {
+                assert(err == SPILLDEQUE_ERROR_EMPTY);
+            } else {
+                dequeue_pop_front_into(&model, &expected);
+                assert(SPILLDEQUE_ERROR_IS_OK(err) && got == expected);
+            }
+        } else {
+            int got;
+            int expected;
+            spilldeque_error_t err = spilldeque_pop_back(&spilldeque, &got);
+            if (model.len == 0) {
+                assert(err == SPILLDEQUE_ERROR_EMPTY);
+            } else {
+                dequeue_pop_back_into(&model, &expected);
+                assert(SPILLDEQUE_ERROR_IS_OK(err) && got == expected);
+            }
+        }
+        assert(spilldeque.len == model.len);
+        assert(spilldeque.front_hot + spilldeque.back_hot
+               <= spilldeque.budget_blocks);
+        if (spilldeque_spilled(&spilldeque) > max_spilled) {
+            max_spilled = spilldeque_spilled(&spilldeque);
+        }
+        if (model.len > 0 && i % 13 == 0) {
+            assert(*(int *) spilldeque_front(&spilldeque)
+                   == *(int *) dequeue_get(&model, 0));
+            assert(*(int *) spilldeque_back(&spilldeque)
+                   == *(int *) dequeue_get(&model, model.len - 1));
+        }
+    }
+    assert(max_spilled > 0);
+    // every slot handed out is free again once the deque is emptied
+    spilldeque_empty(&spilldeque);
+    assert(spilldeque.free_slots.len == spilldeque.file_slots);
+    dequeue_free(&model);
+    spilldeque_free(&spilldeque);
+}
+
+void test_spilldeque_backlog(void) {
+    // a FIFO backlog of ten times the memory budget
+    const size_t budget = 256 * 1024;
+    const uint64_t count = 10 * budget / sizeof(uint64_t);
+    spilldeque_t spilldeque;
+    assert(SPILLDEQUE_ERROR_IS_OK(
+            spilldeque_new_with_block_len(&spilldeque,
+                                          sizeof(uint64_t),
+                                          512,
+                                          budget,
+                                          NULL,
+                                          NULL)));
+    assert(spilldeque.budget_blocks == 64);
+    for (uint64_t i = 0; i < count; i++) {
+        assert(SPILLDEQUE_ERROR_IS_OK(spilldeque_push_back(&spilldeque, &i)));
+        assert(spilldeque.front_hot + spilldeque.back_hot
+               <= spilldeque.budget_blocks);
+    }
+    assert(spilldeque.len == count);
+    assert(spilldeque_spilled(&spilldeque)
+           == spilldeque.blocks.len - spilldeque.budget_blocks);
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t value;
+        assert(SPILLDEQUE_ERROR_IS_OK(spilldeque_pop_front(&spilldeque,
+                                                           &value)));
+        assert(value == i);
+        assert(spilldeque.front_hot + spilldeque.back_hot
+               <= spilldeque.budget_blocks);
+    }
+    assert(spilldeque.blocks.len == 0);
+    assert(spilldeque_spilled(&spilldeque) == 0);
+    spilldeque_free(&spilldeque);
+}
+
+void test_spilldeque_default(void) {
+    spilldeque_t spilldeque;
+    assert(SPILLDEQUE_ERROR_IS_OK(spilldeque_new(&spilldeque,
+                                                 24,
+                                                 1 << 20,
+                                                 NULL)));
+    // 24-byte elements round down to 2048 per 64 KiB block
+    assert(spilldeque.block_len == 2048);
+    assert(spilldeque.budget_blocks == (1 << 20) / (2048 * 24));
+    char elem[24] = {0};
+    for (int i = 0; i < 100000; i++) {
+        elem[0] = (char) i;
+        spilldeque_push_front(&spilldeque, elem);
+    }
+    assert(spilldeque_spilled(&spilldeque) > 0);
+    assert(((char *) spilldeque_back(&spilldeque))[0] == 0);
+    assert(((char *) spilldeque_front(&spilldeque))[0] == (char) 99999);
+    spilldeque_free(&spilldeque);
+}
+
+void test_spilldeque_errors(void) {
+    spilldeque_t spilldeque;
+    assert(spilldeque_new(NULL, sizeof(int), 1 << 20, NULL)
+           == SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(spilldeque_new_with_block_len(&spilldeque,
+                                         sizeof(int),
+                                         3,
+                                         1 << 20,
+                                         NULL,
+                                         NULL)
+           == SPILLDEQUE_ERROR_INVALID_BLOCK_LEN);
+    assert(spilldeque_new_with_block_len(&spilldeque,
+                                         sizeof(int),
+                                         1024,
+                                         2 * 1024 * sizeof(int),
+                                         NULL,
+                                         NULL)
+           == SPILLDEQUE_ERROR_BUDGET_TOO_SMALL);
+    errno = 0;
+    assert(spilldeque_new(&spilldeque,
+                          sizeof(int),
+                          1 << 20,
+                          "/nonexistent/unilib")
+           == SPILLDEQUE_ERROR_IO);
+    assert(errno == ENOENT);
+    spilldeque_new(&spilldeque, sizeof(int), 1 << 20, NULL);
+    assert(spilldeque_pop_front(&spilldeque, NULL) == SPILLDEQUE_ERROR_EMPTY);
+    assert(spilldeque_pop_back(&spilldeque, NULL) == SPILLDEQUE_ERROR_EMPTY);
+    assert(spilldeque_push_back(&spilldeque, NULL)
+           == SPILLDEQUE_ERROR_NULL_POINTER_RECEIVED);
+    assert(spilldeque_front(&spilldeque) == NULL);
+    spilldeque_free(&spilldeque);
+}
+
+int main() {
+    test_spilldeque_model();
+    test_spilldeque_backlog();
+    test_spilldeque_default();
+    test_spilldeque_errors();
+}
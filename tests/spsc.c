@@ -0,0 +1,94 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "spsc.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define STRESS_ITEMS 2000000
+
+void test_spsc_basic(void) {
+    spsc_t spsc;
+    assert(spsc_new(&spsc, 0, NULL) == SPSC_ERROR_ZERO_CAPACITY);
+    assert(SPSC_ERROR_IS_OK(spsc_new(&spsc, 5, NULL)));
+    assert(spsc.capacity == 8);
+    void * elem;
+    assert(spsc_try_pop(&spsc, &elem) == SPSC_ERROR_EMPTY);
+    for (uintptr_t i = 0; i < 8; i++) {
+        assert(SPSC_ERROR_IS_OK(spsc_try_push(&spsc, (void *) (i + 1))));
+    }
+    assert(spsc_try_push(&spsc, (void *) 9) == SPSC_ERROR_FULL);
+    assert(spsc_len(&spsc) == 8);
+    // wrap around the ring a few times
+    for (uintptr_t i = 0; i < 100; i++) {
+        assert(SPSC_ERROR_IS_OK(spsc_try_pop(&spsc, &elem)));
+        assert((uintptr_t) elem == i + 1);
+        assert(SPSC_ERROR_IS_OK(spsc_try_push(&spsc, (void *) (i + 9))));
+    }
+    assert(spsc_len(&spsc) == 8);
+    spsc_free(&spsc);
+}
+
+void * stress_producer(void * arg) {
+    spsc_ptr spsc = arg;
+    for (uintptr_t i = 1; i <= STRESS_ITEMS; i++) {
+        while (!SPSC_ERROR_IS_OK(spsc_try_push(spsc, (void *) i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void * stress_consumer(void * arg) {
+    spsc_ptr spsc = arg;
+    for (uintptr_t i = 1; i <= STRESS_ITEMS; i++) {
+        void * elem;
+        while (!SPSC_ERROR_IS_OK(spsc_try_pop(spsc, &elem))) {
+            sched_yield();
+        }
+        // items come out exactly once and in order
+        assert((uintptr_t) elem == i);
+    }
+    return NULL;
+}
+
+void test_spsc_stress(void) {
+    spsc_t spsc;
+    assert(SPSC_ERROR_IS_OK(spsc_new(&spsc, 64, NULL)));
+    pthread_t producer;
+    pthread_t consumer;
+    assert(pthread_create(&consumer, NULL, stress_consumer, &spsc) == 0);
+    assert(pthread_create(&producer, NULL, stress_producer, &spsc) == 0);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    assert(spsc_len(&spsc) == 0);
+    spsc_free(&spsc);
+}
+
+int main() {
+    test_spsc_basic();
+    test_spsc_stress();
+}
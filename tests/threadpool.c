@@ -0,0 +1,109 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "threadpool.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define TASKS 10000
+#define DEPTH 12
+
+atomic_size_t ran;
+
+void count_task(void * arg) {
+    (void) arg;
+    atomic_fetch_add(&ran, 1);
+}
+
+void test_threadpool_submit(void) {
+    threadpool_t pool;
+    assert(threadpool_new(NULL, 1, NULL)
+           == THREADPOOL_ERROR_NULL_POINTER_RECEIVED);
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_new(&pool, 4, NULL)));
+    assert(pool.len == 4);
+    assert(threadpool_submit(&pool, NULL)
+           == THREADPOOL_ERROR_NULL_POINTER_RECEIVED);
+
+    // more tasks than the injector holds at once
+    static threadpool_task_t tasks[TASKS];
+    threadpool_latch_t latch;
+    threadpool_latch_init(&latch, TASKS);
+    atomic_store(&ran, 0);
+    for (size_t i = 0; i < TASKS; i++) {
+        threadpool_task_init(&tasks[i], count_task, NULL, &latch);
+        assert(THREADPOOL_ERROR_IS_OK(threadpool_submit(&pool, &tasks[i])));
+    }
+    threadpool_wait(&pool, &latch);
+    assert(atomic_load(&ran) == TASKS);
+    assert(atomic_load(&latch.count) == 0);
+    threadpool_free(&pool);
+}
+
+typedef struct fib_t {
+    threadpool_ptr pool;
+    unsigned n;
+    uint64_t result;
+} fib_t;
+
+void fib_task(void * arg) {
+    fib_t * fib = arg;
+    if (fib->n < 2) {
+        fib->result = fib->n;
+        return;
+    }
+    // fork one half onto the pool, run the other here, then join
+    fib_t left = {fib->pool, fib->n - 1, 0};
+    fib_t right = {fib->pool, fib->n - 2, 0};
+    threadpool_latch_t latch;
+    threadpool_latch_init(&latch, 1);
+    threadpool_task_t task;
+    threadpool_task_init(&task, fib_task, &left, &latch);
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_submit(fib->pool, &task)));
+    fib_task(&right);
+    threadpool_wait(fib->pool, &latch);
+    fib->result = left.result + right.result;
+}
+
+void test_threadpool_fork_join(void) {
+    threadpool_t pool;
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_new(&pool, 0, NULL)));
+    assert(pool.len >= 1);
+
+    fib_t fib = {&pool, DEPTH, 0};
+    threadpool_latch_t latch;
+    threadpool_latch_init(&latch, 1);
+    threadpool_task_t task;
+    threadpool_task_init(&task, fib_task, &fib, &latch);
+    assert(THREADPOOL_ERROR_IS_OK(threadpool_submit(&pool, &task)));
+    threadpool_wait(&pool, &latch);
+    assert(fib.result == 144);
+    threadpool_free(&pool);
+}
+
+int main(void) {
+    test_threadpool_submit();
+    test_threadpool_fork_join();
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Armand-Cezar Mathe <me@cezarmathe.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "wsdeque.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define THIEVES 3
+#define ITEMS 1000000
+
+atomic_uchar seen[ITEMS + 1];
+atomic_size_t taken;
+
+void test_wsdeque_basic(void) {
+    wsdeque_t wsdeque;
+    assert(WSDEQUE_ERROR_IS_OK(wsdeque_new(&wsdeque, 2, NULL)));
+    void * elem;
+    assert(wsdeque_pop_back(&wsdeque, &elem) == WSDEQUE_ERROR_EMPTY);
+    assert(wsdeque_steal(&wsdeque, &elem) == WSDEQUE_ERROR_EMPTY);
+    // grows past its initial capacity
+    for (uintptr_t i = 1; i <= 100; i++) {
+        assert(WSDEQUE_ERROR_IS_OK(wsdeque_push_back(&wsdeque, (void *) i)));
+    }
+    assert(wsdeque_len(&wsdeque) == 100);
+    // the owner pops from the back, thieves steal from the front
+    assert(WSDEQUE_ERROR_IS_OK(wsdeque_pop_back(&wsdeque, &elem)));
+    assert((uintptr_t) elem == 100);
+    assert(WSDEQUE_ERROR_IS_OK(wsdeque_steal(&wsdeque, &elem)));
+    assert((uintptr_t) elem == 1);
+    for (uintptr_t i = 99; i >= 2; i--) {
+        assert(WSDEQUE_ERROR_IS_OK(wsdeque_pop_back(&wsdeque, &elem)));
+        assert((uintptr_t) elem == i);
+    }
+    assert(wsdeque_pop_back(&wsdeque, &elem) == WSDEQUE_ERROR_EMPTY);
+    assert(wsdeque_len(&wsdeque) == 0);
+    wsdeque_free(&wsdeque);
+}
+
+void mark_taken(void * elem) {
+    assert(atomic_fetch_add(&seen[(uintptr_t) elem], 1) == 0);
+    atomic_fetch_add(&taken, 1);
+}
+
+void * thief(void * arg) {
+    wsdeque_ptr wsdeque = arg;
+    while (atomic_load(&taken) < ITEMS) {
+        void * elem;
+        wsdeque_error_t err = wsdeque_steal(wsdeque, &elem);
+        if (WSDEQUE_ERROR_IS_OK(err)) {
+            mark_taken(elem);
+        } else if (err == WSDEQUE_ERROR_EMPTY) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_wsdeque_stress(void) {
+    wsdeque_t wsdeque;
+    assert(WSDEQUE_ERROR_IS_OK(wsdeque_new(&wsdeque, 16, NULL)));
+    pthread_t thieves[THIEVES];
+    for (int i = 0; i < THIEVES; i++) {
+        assert(pthread_create(&thieves[i], NULL, thief, &wsdeque) == 0);
+    }
+    void * elem;
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        assert(WSDEQUE_ERROR_IS_OK(wsdeque_push_back(&wsdeque, (void *) i)));
+        if (i % 3 == 0 && WSDEQUE_ERROR_IS_OK(wsdeque_pop_back(&wsdeque, &elem))) {
+            mark_taken(elem);
+        }
+    }
+    while (WSDEQUE_ERROR_IS_OK(wsdeque_pop_back(&wsdeque, &elem))) {
+        mark_taken(elem);
+    }
+    for (int i = 0; i < THIEVES; i++) {
+        pthread_join(thieves[i], NULL);
+    }
+    // every item was taken exactly once, either by the owner or by a thief
+    assert(atomic_load(&taken) == ITEMS);
+    for (size_t i = 1; i <= ITEMS; i++) {
+        assert(atomic_load(&seen[i]) == 1);
+    }
+    wsdeque_free(&wsdeque);
+}
+
+int main() {
+    test_wsdeque_basic();
+    test_wsdeque_stress();
+}